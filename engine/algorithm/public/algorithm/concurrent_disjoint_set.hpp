@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace violet
+{
+/**
+ * @brief Disjoint set that can be merged and queried from several threads at once, e.g. inside
+ * parallel_for workers. Roots are linked by index, the larger root always points to the smaller
+ * one, so once all merges are done find returns the smallest element of each set regardless of
+ * the order the merges ran in.
+ */
+template <typename T>
+    requires std::is_integral_v<T>
+class concurrent_disjoint_set
+{
+public:
+    using value_type = T;
+
+    concurrent_disjoint_set(value_type size)
+        : m_parents(std::make_unique<std::atomic<value_type>[]>(size)),
+          m_size(size)
+    {
+        reset();
+    }
+
+    /**
+     * @brief Returns false if a and b were already in the same set.
+     */
+    bool merge(value_type a, value_type b) noexcept
+    {
+        while (true)
+        {
+            a = find(a);
+            b = find(b);
+
+            if (a == b)
+            {
+                return false;
+            }
+
+            if (a > b)
+            {
+                std::swap(a, b);
+            }
+
+            // Fails only if another thread linked b first, then retry from the new roots.
+            value_type expected = b;
+            if (m_parents[b].compare_exchange_strong(expected, a, std::memory_order_relaxed))
+            {
+                m_set_count.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    value_type find(value_type value) noexcept
+    {
+        // Every link points to a smaller index, so the walk always ends and stale reads only make
+        // it longer. Relaxed ordering is enough, the parallel_for join publishes the results.
+        while (true)
+        {
+            value_type parent = m_parents[value].load(std::memory_order_relaxed);
+            if (parent == value)
+            {
+                return value;
+            }
+
+            value_type grandparent = m_parents[parent].load(std::memory_order_relaxed);
+            if (grandparent != parent)
+            {
+                // Path halving, losing the race means another thread already shortened it.
+                m_parents[value].compare_exchange_weak(
+                    parent,
+                    grandparent,
+                    std::memory_order_relaxed);
+            }
+
+            value = grandparent;
+        }
+    }
+
+    std::uint32_t get_size() const noexcept
+    {
+        return static_cast<std::uint32_t>(m_size);
+    }
+
+    std::uint32_t get_set_count() const noexcept
+    {
+        return m_set_count.load(std::memory_order_relaxed);
+    }
+
+    void resize(value_type size)
+    {
+        m_parents = std::make_unique<std::atomic<value_type>[]>(size);
+        m_size = size;
+        reset();
+    }
+
+    /**
+     * @brief Not thread safe.
+     */
+    void reset()
+    {
+        for (std::size_t i = 0; i < m_size; ++i)
+        {
+            m_parents[i].store(static_cast<value_type>(i), std::memory_order_relaxed);
+        }
+        m_set_count.store(get_size(), std::memory_order_relaxed);
+    }
+
+private:
+    std::unique_ptr<std::atomic<value_type>[]> m_parents;
+    std::size_t m_size;
+
+    std::atomic<std::uint32_t> m_set_count;
+};
+} // namespace violet
\ No newline at end of file
@@ -1,89 +1,332 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <ranges>
 #include <span>
-#include <vector>
+#include <type_traits>
 
 namespace violet
 {
-template <typename Iter, typename KeyFunctor, typename CountType = std::size_t>
-void radix_sort_32(Iter begin, Iter end, KeyFunctor&& key_functor)
+/**
+ * @brief Maps a float to an unsigned key that sorts in the same order, negative values included.
+ */
+[[nodiscard]] inline std::uint32_t radix_sort_key(float value) noexcept
 {
-    using count_type = CountType;
-    using value_type = typename Iter::value_type;
+    auto bits = std::bit_cast<std::uint32_t>(value);
+    return bits ^ ((bits & 0x80000000) != 0 ? 0xFFFFFFFF : 0x80000000);
+}
 
-    std::array<count_type, 1024 + 2048 + 2048> buckets = {};
-    std::span<count_type> bucket0 = std::span<count_type>(buckets.data(), 1024);
-    std::span<count_type> bucket1 = std::span<count_type>(bucket0.data() + 1024, 2048);
-    std::span<count_type> bucket2 = std::span<count_type>(bucket1.data() + 2048, 2048);
+template <typename T>
+concept radix_sort_executor =
+    requires(T executor, std::function<void(std::size_t, std::size_t)> functor) {
+        executor.parallel_for(std::size_t(), std::size_t(), functor);
+    };
 
-    for (auto iter = begin; iter != end; ++iter)
-    {
-        std::uint32_t key = key_functor(*iter);
-        ++bucket0[key & 1023];
-        ++bucket1[(key >> 10) & 2047];
-        ++bucket2[(key >> 21) & 2047];
-    }
+namespace detail
+{
+struct radix_no_value
+{
+};
+
+/**
+ * @brief Least significant digit radix sort with 8-bit digits. Digits that are equal for every
+ * key are skipped, so keys with few significant bits sort in few passes.
+ */
+template <std::unsigned_integral Key, typename Value>
+class radix_sorter
+{
+public:
+    static constexpr std::size_t DIGIT_BITS = 8;
+    static constexpr std::size_t BUCKET_COUNT = 1 << DIGIT_BITS;
+    static constexpr std::size_t DIGIT_COUNT = sizeof(Key);
 
-    count_type sum = 0;
-    for (count_type& count : bucket0)
+    // Below this size every pass is cheaper than waking up workers.
+    static constexpr std::size_t PARALLEL_THRESHOLD = 1 << 16;
+    static constexpr std::size_t MIN_CHUNK_SIZE = 1 << 14;
+    static constexpr std::size_t MAX_CHUNK_COUNT = 16;
+
+    static constexpr bool has_value = !std::is_same_v<Value, radix_no_value>;
+
+    radix_sorter(
+        std::span<Key> keys,
+        std::span<Value> values,
+        std::span<Key> key_scratch,
+        std::span<Value> value_scratch) noexcept
+        : m_keys(keys),
+          m_values(values),
+          m_key_scratch(key_scratch),
+          m_value_scratch(value_scratch)
     {
-        count_type t = count + sum;
-        count = sum;
-        sum = t;
+        assert(key_scratch.size() >= keys.size());
+        if constexpr (has_value)
+        {
+            assert(values.size() == keys.size() && value_scratch.size() >= keys.size());
+        }
     }
 
-    sum = 0;
-    for (count_type& count : bucket1)
+    void sort()
     {
-        count_type t = count + sum;
-        count = sum;
-        sum = t;
+        std::size_t count = m_keys.size();
+        if (count < 2)
+        {
+            return;
+        }
+
+        std::array<std::array<std::size_t, BUCKET_COUNT>, DIGIT_COUNT> histograms = {};
+        for (Key key : m_keys)
+        {
+            for (std::size_t digit = 0; digit < DIGIT_COUNT; ++digit)
+            {
+                ++histograms[digit][get_digit(key, digit)];
+            }
+        }
+
+        buffer src = {m_keys.data(), m_values.data()};
+        buffer dst = {m_key_scratch.data(), m_value_scratch.data()};
+
+        for (std::size_t digit = 0; digit < DIGIT_COUNT; ++digit)
+        {
+            auto& histogram = histograms[digit];
+            if (histogram[get_digit(m_keys[0], digit)] == count)
+            {
+                continue;
+            }
+
+            std::size_t offset = 0;
+            for (std::size_t& bucket : histogram)
+            {
+                std::size_t bucket_count = bucket;
+                bucket = offset;
+                offset += bucket_count;
+            }
+
+            scatter(src, dst, 0, count, digit, histogram);
+            std::swap(src, dst);
+        }
+
+        copy_back(src);
     }
 
-    sum = 0;
-    for (count_type& count : bucket2)
+    template <radix_sort_executor Executor>
+    void sort(Executor& executor)
     {
-        count_type t = count + sum;
-        count = sum;
-        sum = t;
+        std::size_t count = m_keys.size();
+        if (count < PARALLEL_THRESHOLD)
+        {
+            sort();
+            return;
+        }
+
+        std::size_t chunk_count = std::min(MAX_CHUNK_COUNT, count / MIN_CHUNK_SIZE);
+        auto get_chunk_begin = [count, chunk_count](std::size_t chunk)
+        {
+            return count * chunk / chunk_count;
+        };
+
+        // Bits that differ from the first key, digits without any are skipped.
+        std::array<Key, MAX_CHUNK_COUNT> chunk_differences = {};
+        executor.parallel_for(
+            chunk_count,
+            1,
+            [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t chunk = begin; chunk < end; ++chunk)
+                {
+                    std::size_t chunk_end = get_chunk_begin(chunk + 1);
+
+                    Key difference = 0;
+                    for (std::size_t i = get_chunk_begin(chunk); i < chunk_end; ++i)
+                    {
+                        difference |= m_keys[i] ^ m_keys[0];
+                    }
+                    chunk_differences[chunk] = difference;
+                }
+            });
+
+        Key difference = 0;
+        for (std::size_t chunk = 0; chunk < chunk_count; ++chunk)
+        {
+            difference |= chunk_differences[chunk];
+        }
+
+        buffer src = {m_keys.data(), m_values.data()};
+        buffer dst = {m_key_scratch.data(), m_value_scratch.data()};
+
+        std::array<std::array<std::size_t, BUCKET_COUNT>, MAX_CHUNK_COUNT> histograms;
+        for (std::size_t digit = 0; digit < DIGIT_COUNT; ++digit)
+        {
+            if (get_digit(difference, digit) == 0)
+            {
+                continue;
+            }
+
+            executor.parallel_for(
+                chunk_count,
+                1,
+                [&](std::size_t begin, std::size_t end)
+                {
+                    for (std::size_t chunk = begin; chunk < end; ++chunk)
+                    {
+                        std::size_t chunk_end = get_chunk_begin(chunk + 1);
+
+                        auto& histogram = histograms[chunk];
+                        histogram.fill(0);
+                        for (std::size_t i = get_chunk_begin(chunk); i < chunk_end; ++i)
+                        {
+                            ++histogram[get_digit(src.keys[i], digit)];
+                        }
+                    }
+                });
+
+            // Chunks of the same bucket are placed in order, which keeps the sort stable.
+            std::size_t offset = 0;
+            for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+            {
+                for (std::size_t chunk = 0; chunk < chunk_count; ++chunk)
+                {
+                    std::size_t bucket_count = histograms[chunk][bucket];
+                    histograms[chunk][bucket] = offset;
+                    offset += bucket_count;
+                }
+            }
+
+            executor.parallel_for(
+                chunk_count,
+                1,
+                [&](std::size_t begin, std::size_t end)
+                {
+                    for (std::size_t chunk = begin; chunk < end; ++chunk)
+                    {
+                        scatter(
+                            src,
+                            dst,
+                            get_chunk_begin(chunk),
+                            get_chunk_begin(chunk + 1),
+                            digit,
+                            histograms[chunk]);
+                    }
+                });
+
+            std::swap(src, dst);
+        }
+
+        copy_back(src);
     }
 
-    std::vector<value_type> temp(end - begin);
+private:
+    struct buffer
+    {
+        Key* keys;
+        Value* values;
+    };
 
-    std::span<value_type> src = std::span<value_type>(begin, end);
-    std::span<value_type> dst = std::span<value_type>(temp);
-    for (count_type i = 0; i < temp.size(); ++i)
+    static std::size_t get_digit(Key key, std::size_t digit) noexcept
     {
-        std::uint32_t key = key_functor(src[i]);
-        dst[bucket0[key & 1023]++] = src[i];
+        return static_cast<std::size_t>(key >> (digit * DIGIT_BITS)) & (BUCKET_COUNT - 1);
     }
 
-    std::swap(src, dst);
-    for (count_type i = 0; i < temp.size(); ++i)
+    static void scatter(
+        const buffer& src,
+        const buffer& dst,
+        std::size_t begin,
+        std::size_t end,
+        std::size_t digit,
+        std::array<std::size_t, BUCKET_COUNT>& offsets) noexcept
     {
-        std::uint32_t key = key_functor(src[i]);
-        dst[bucket1[(key >> 10) & 2047]++] = src[i];
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            std::size_t index = offsets[get_digit(src.keys[i], digit)]++;
+            dst.keys[index] = src.keys[i];
+            if constexpr (has_value)
+            {
+                dst.values[index] = std::move(src.values[i]);
+            }
+        }
     }
 
-    std::swap(src, dst);
-    for (count_type i = 0; i < temp.size(); ++i)
+    void copy_back(const buffer& src)
     {
-        std::uint32_t key = key_functor(src[i]);
-        dst[bucket2[(key >> 21) & 2047]++] = src[i];
+        if (src.keys == m_keys.data())
+        {
+            return;
+        }
+
+        std::copy_n(src.keys, m_keys.size(), m_keys.data());
+        if constexpr (has_value)
+        {
+            std::move(src.values, src.values + m_keys.size(), m_values.data());
+        }
     }
 
-    std::copy(dst.begin(), dst.end(), begin);
+    std::span<Key> m_keys;
+    std::span<Value> m_values;
+    std::span<Key> m_key_scratch;
+    std::span<Value> m_value_scratch;
+};
+
+template <typename R>
+concept radix_key_range = std::ranges::contiguous_range<R> &&
+                          std::unsigned_integral<std::ranges::range_value_t<R>>;
+} // namespace detail
+
+/**
+ * @brief Stable sort of unsigned keys. key_scratch must hold at least keys.size() elements, no
+ * memory is allocated.
+ */
+template <detail::radix_key_range K, std::ranges::contiguous_range KS>
+void radix_sort(K&& keys, KS&& key_scratch)
+{
+    using key_type = std::ranges::range_value_t<K>;
+    detail::radix_sorter<key_type, detail::radix_no_value>(keys, {}, key_scratch, {}).sort();
 }
 
-template <typename Iter, typename CountType = std::size_t>
-void radix_sort_32(Iter begin, Iter end)
+/**
+ * @brief Stable sort of keys, values are moved along with their keys.
+ */
+template <
+    detail::radix_key_range K,
+    std::ranges::contiguous_range V,
+    std::ranges::contiguous_range KS,
+    std::ranges::contiguous_range VS>
+void radix_sort(K&& keys, V&& values, KS&& key_scratch, VS&& value_scratch)
 {
-    radix_sort_32(
-        begin,
-        end,
-        [](const auto& value)
-        {
-            return value;
-        });
+    using key_type = std::ranges::range_value_t<K>;
+    using value_type = std::ranges::range_value_t<V>;
+    detail::radix_sorter<key_type, value_type>(keys, values, key_scratch, value_scratch).sort();
+}
+
+/**
+ * @brief Same as radix_sort, large inputs build histograms and scatter in chunks on
+ * executor.parallel_for, e.g. task_executor.
+ */
+template <
+    radix_sort_executor Executor,
+    detail::radix_key_range K,
+    std::ranges::contiguous_range KS>
+void radix_sort(Executor& executor, K&& keys, KS&& key_scratch)
+{
+    using key_type = std::ranges::range_value_t<K>;
+    detail::radix_sorter<key_type, detail::radix_no_value>(keys, {}, key_scratch, {}).sort(
+        executor);
+}
+
+template <
+    radix_sort_executor Executor,
+    detail::radix_key_range K,
+    std::ranges::contiguous_range V,
+    std::ranges::contiguous_range KS,
+    std::ranges::contiguous_range VS>
+void radix_sort(Executor& executor, K&& keys, V&& values, KS&& key_scratch, VS&& value_scratch)
+{
+    using key_type = std::ranges::range_value_t<K>;
+    using value_type = std::ranges::range_value_t<V>;
+    detail::radix_sorter<key_type, value_type>(keys, values, key_scratch, value_scratch).sort(
+        executor);
 }
 } // namespace violet
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "common/frame_allocator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace violet
+{
+#ifdef VIOLET_ALLOCATION_COUNTER
+namespace
+{
+std::atomic<std::uint64_t> allocation_count;
+thread_local std::uint64_t thread_allocation_count;
+
+void* counted_allocate(std::size_t size, std::size_t alignment)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    ++thread_allocation_count;
+
+    size = std::max<std::size_t>(size, 1);
+
+    void* result = nullptr;
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        result = std::malloc(size);
+    }
+    else
+    {
+#ifdef _MSC_VER
+        result = _aligned_malloc(size, alignment);
+#else
+        result = std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+    }
+
+    if (result == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+} // namespace
+
+bool allocation_counter::is_enabled() noexcept
+{
+    return true;
+}
+
+std::uint64_t allocation_counter::get_thread_count() noexcept
+{
+    return thread_allocation_count;
+}
+
+std::uint64_t allocation_counter::get_count() noexcept
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+#else
+bool allocation_counter::is_enabled() noexcept
+{
+    return false;
+}
+
+std::uint64_t allocation_counter::get_thread_count() noexcept
+{
+    return 0;
+}
+
+std::uint64_t allocation_counter::get_count() noexcept
+{
+    return 0;
+}
+#endif
+} // namespace violet
+
+#ifdef VIOLET_ALLOCATION_COUNTER
+void* operator new(std::size_t size)
+{
+    return violet::counted_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return violet::counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t /* size */) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t alignment) noexcept
+{
+    if (static_cast<std::size_t>(alignment) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        std::free(p);
+        return;
+    }
+
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete(void* p, std::size_t /* size */, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
+#endif
\ No newline at end of file
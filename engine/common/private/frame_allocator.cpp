@@ -0,0 +1,241 @@
+#include "common/frame_allocator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace violet
+{
+namespace
+{
+constexpr std::size_t BLOCK_ALIGNMENT = 64;
+
+struct thread_frame_arena;
+
+class frame_arena_registry
+{
+public:
+    static frame_arena_registry& instance()
+    {
+        static frame_arena_registry instance;
+        return instance;
+    }
+
+    void add(thread_frame_arena* arena)
+    {
+        std::lock_guard lock(m_mutex);
+        m_arenas.push_back(arena);
+    }
+
+    void remove(thread_frame_arena* arena)
+    {
+        std::lock_guard lock(m_mutex);
+        std::erase(m_arenas, arena);
+    }
+
+    template <typename Functor>
+    void each(Functor&& functor)
+    {
+        std::lock_guard lock(m_mutex);
+        for (thread_frame_arena* arena : m_arenas)
+        {
+            functor(*arena);
+        }
+    }
+
+    void next_frame() noexcept
+    {
+        m_frame.fetch_add(1, std::memory_order_release);
+    }
+
+    std::uint64_t get_frame() const noexcept
+    {
+        return m_frame.load(std::memory_order_acquire);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<thread_frame_arena*> m_arenas;
+
+    std::atomic<std::uint64_t> m_frame{0};
+};
+
+// Only the owning thread touches the arena, other threads read the statistics.
+struct thread_frame_arena
+{
+    thread_frame_arena()
+    {
+        frame_arena_registry::instance().add(this);
+    }
+
+    ~thread_frame_arena()
+    {
+        frame_arena_registry::instance().remove(this);
+    }
+
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        std::uint64_t current_frame = frame_arena_registry::instance().get_frame();
+        if (frame.load(std::memory_order_relaxed) != current_frame)
+        {
+            arena.reset();
+            used_size.store(0, std::memory_order_relaxed);
+            frame.store(current_frame, std::memory_order_release);
+        }
+
+        void* result = arena.allocate(size, alignment);
+
+        used_size.store(arena.get_used_size(), std::memory_order_relaxed);
+        block_allocation_count.store(
+            arena.get_block_allocation_count(),
+            std::memory_order_relaxed);
+
+        return result;
+    }
+
+    linear_arena arena;
+
+    std::atomic<std::uint64_t> frame{frame_arena_registry::instance().get_frame()};
+    std::atomic<std::size_t> used_size{0};
+    std::atomic<std::size_t> block_allocation_count{0};
+};
+
+thread_frame_arena& get_thread_arena()
+{
+    thread_local thread_frame_arena thread_arena;
+    return thread_arena;
+}
+} // namespace
+
+linear_arena::linear_arena(std::size_t block_size)
+    : m_block_size(block_size)
+{
+}
+
+linear_arena::~linear_arena()
+{
+    for (block& block : m_blocks)
+    {
+        ::operator delete(block.data, std::align_val_t(BLOCK_ALIGNMENT));
+    }
+}
+
+void* linear_arena::allocate(std::size_t size, std::size_t alignment)
+{
+    assert(std::has_single_bit(alignment));
+
+    while (true)
+    {
+        if (m_block_index < m_blocks.size())
+        {
+            block& block = m_blocks[m_block_index];
+
+            auto address = reinterpret_cast<std::uintptr_t>(block.data) + m_offset;
+            std::size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+            if (m_offset + padding + size <= block.size)
+            {
+                void* result = block.data + m_offset + padding;
+                m_offset += padding + size;
+                m_used_size += size;
+                return result;
+            }
+
+            if (m_block_index + 1 < m_blocks.size())
+            {
+                ++m_block_index;
+                m_offset = 0;
+                continue;
+            }
+        }
+
+        add_block(std::max(m_block_size, size + alignment));
+    }
+}
+
+void linear_arena::reset()
+{
+    // Merge the blocks of this round into one, so the same amount of memory fits in a single
+    // block next time.
+    if (m_blocks.size() > 1)
+    {
+        std::size_t capacity = get_capacity();
+        for (block& block : m_blocks)
+        {
+            ::operator delete(block.data, std::align_val_t(BLOCK_ALIGNMENT));
+        }
+        m_blocks.clear();
+
+        add_block(capacity);
+    }
+
+    m_block_index = 0;
+    m_offset = 0;
+    m_used_size = 0;
+}
+
+std::size_t linear_arena::get_capacity() const noexcept
+{
+    std::size_t capacity = 0;
+    for (const block& block : m_blocks)
+    {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void linear_arena::add_block(std::size_t size)
+{
+    m_blocks.push_back({
+        .data = static_cast<std::uint8_t*>(
+            ::operator new(size, std::align_val_t(BLOCK_ALIGNMENT))),
+        .size = size,
+    });
+
+    m_block_index = m_blocks.size() - 1;
+    m_offset = 0;
+
+    ++m_block_allocation_count;
+}
+
+void* frame_arena::allocate(std::size_t size, std::size_t alignment)
+{
+    return get_thread_arena().allocate(size, alignment);
+}
+
+void frame_arena::reset()
+{
+    frame_arena_registry::instance().next_frame();
+}
+
+std::size_t frame_arena::get_used_size()
+{
+    std::uint64_t current_frame = frame_arena_registry::instance().get_frame();
+
+    std::size_t used_size = 0;
+    frame_arena_registry::instance().each(
+        [current_frame, &used_size](thread_frame_arena& arena)
+        {
+            // Arenas not used since the frame started are reset on their next allocation.
+            if (arena.frame.load(std::memory_order_acquire) == current_frame)
+            {
+                used_size += arena.used_size.load(std::memory_order_relaxed);
+            }
+        });
+    return used_size;
+}
+
+std::size_t frame_arena::get_block_allocation_count()
+{
+    std::size_t count = 0;
+    frame_arena_registry::instance().each(
+        [&count](thread_frame_arena& arena)
+        {
+            count += arena.block_allocation_count.load(std::memory_order_relaxed);
+        });
+    return count;
+}
+} // namespace violet
\ No newline at end of file
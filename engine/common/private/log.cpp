@@ -1,24 +1,388 @@
 #include "common/log.hpp"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace violet
 {
-log::log()
+namespace
 {
-    m_logger = spdlog::stdout_color_mt("console");
-    m_logger->set_level(spdlog::level::trace);
-    m_logger->set_pattern("%T.%e %^%-5l%$ | %v");
+struct alignas(16) record_header
+{
+    std::uint32_t size;
+    log_level level;
+    std::uint32_t payload_size;
+    void (*format)(const void* payload, std::size_t size, fmt::memory_buffer& buffer);
+    spdlog::log_clock::time_point time;
+};
+
+// Records are multiples of the header size, so the tail of the ring always has room for at least
+// a padding header.
+constexpr std::size_t align_record(std::size_t size) noexcept
+{
+    return (size + sizeof(record_header) - 1) / sizeof(record_header) * sizeof(record_header);
+}
+
+/**
+ * @brief Single producer, single consumer ring of variable sized records. The owning thread
+ * writes, the flush thread reads.
+ */
+class log_ring
+{
+public:
+    static constexpr std::size_t CAPACITY = 64 * 1024;
+    static_assert(CAPACITY % sizeof(record_header) == 0);
+
+    log_ring()
+        : m_data(std::make_unique<std::uint8_t[]>(CAPACITY))
+    {
+    }
+
+    void* begin_record(std::size_t size) noexcept
+    {
+        std::size_t record_size = align_record(sizeof(record_header) + size);
+        std::size_t offset = m_write % CAPACITY;
+
+        // Records never wrap, the tail of the ring is skipped with a padding record instead.
+        std::size_t padding = CAPACITY - offset < record_size ? CAPACITY - offset : 0;
+        if (m_write + padding + record_size - m_read.load(std::memory_order_acquire) > CAPACITY)
+        {
+            return nullptr;
+        }
+
+        if (padding != 0)
+        {
+            auto* header = new (m_data.get() + offset) record_header();
+            header->size = static_cast<std::uint32_t>(padding);
+            header->format = nullptr;
+
+            m_write += padding;
+            offset = 0;
+        }
+
+        m_pending = new (m_data.get() + offset) record_header();
+        m_pending->size = static_cast<std::uint32_t>(record_size);
+        m_pending->payload_size = static_cast<std::uint32_t>(size);
+        m_pending->time = spdlog::log_clock::now();
+
+        return m_pending + 1;
+    }
+
+    record_header* get_pending_header() const noexcept
+    {
+        return m_pending;
+    }
+
+    void end_record() noexcept
+    {
+        // Publishes the padding record, if any, together with this one.
+        m_write += m_pending->size;
+        m_published.store(m_write, std::memory_order_release);
+    }
+
+    template <typename Functor>
+    void consume(Functor&& functor)
+    {
+        std::uint64_t read = m_read.load(std::memory_order_relaxed);
+        std::uint64_t write = m_published.load(std::memory_order_acquire);
+
+        while (read < write)
+        {
+            const auto* header =
+                reinterpret_cast<const record_header*>(m_data.get() + (read % CAPACITY));
+            if (header->format != nullptr)
+            {
+                functor(*header, header + 1);
+            }
+            read += header->size;
+        }
+
+        m_read.store(read, std::memory_order_release);
+    }
+
+    bool is_empty() const noexcept
+    {
+        return m_read.load(std::memory_order_acquire) ==
+               m_published.load(std::memory_order_acquire);
+    }
+
+    void retire() noexcept
+    {
+        m_retired.store(true, std::memory_order_release);
+    }
+
+    bool is_retired() const noexcept
+    {
+        return m_retired.load(std::memory_order_acquire);
+    }
+
+private:
+    std::unique_ptr<std::uint8_t[]> m_data;
+
+    // Producer side.
+    alignas(64) std::atomic<std::uint64_t> m_published{0};
+    std::uint64_t m_write{0};
+    record_header* m_pending{nullptr};
+
+    // Consumer side.
+    alignas(64) std::atomic<std::uint64_t> m_read{0};
+
+    std::atomic<bool> m_retired{false};
+};
+
+class log_backend
+{
+public:
+    static log_backend& instance()
+    {
+        static log_backend instance;
+        return instance;
+    }
+
+    log_backend()
+    {
+        m_logger = spdlog::stdout_color_mt("console");
+        m_logger->set_level(spdlog::level::trace);
+        m_logger->set_pattern("%T.%e %^%-5l%$ | %v");
+
+        m_thread = std::thread(
+            [this]()
+            {
+                std::unique_lock lock(m_wake_mutex);
+                while (!m_stop)
+                {
+                    m_wake.wait_for(lock, std::chrono::milliseconds(5));
+
+                    lock.unlock();
+                    flush();
+                    lock.lock();
+                }
+            });
+    }
+
+    ~log_backend()
+    {
+        {
+            std::lock_guard lock(m_wake_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+
+        flush();
+        spdlog::drop_all();
+    }
+
+    std::shared_ptr<log_ring> add_ring()
+    {
+        auto ring = std::make_shared<log_ring>();
+
+        std::lock_guard lock(m_flush_mutex);
+        m_rings.push_back(ring);
+        return ring;
+    }
+
+    void flush()
+    {
+        std::lock_guard lock(m_flush_mutex);
+
+        for (const auto& ring : m_rings)
+        {
+            ring->consume(
+                [this](const record_header& header, const void* payload)
+                {
+                    m_buffer.clear();
+                    header.format(payload, header.payload_size, m_buffer);
+
+                    m_messages.push_back({
+                        .time = header.time,
+                        .level = header.level,
+                        .offset = m_text.size(),
+                        .size = m_buffer.size(),
+                    });
+                    m_text.append(m_buffer.data(), m_buffer.data() + m_buffer.size());
+                });
+        }
+
+        // Rings are drained one after another, restore the order in which records were made.
+        std::stable_sort(
+            m_messages.begin(),
+            m_messages.end(),
+            [](const message& a, const message& b)
+            {
+                return a.time < b.time;
+            });
+
+        for (const message& message : m_messages)
+        {
+            m_logger->log(
+                message.time,
+                spdlog::source_loc{},
+                get_spdlog_level(message.level),
+                spdlog::string_view_t(m_text.data() + message.offset, message.size));
+        }
+
+        std::uint64_t dropped_count = m_dropped_count.load(std::memory_order_relaxed);
+        if (dropped_count != m_reported_dropped_count)
+        {
+            m_logger->warn(
+                "[log] {} messages dropped, thread buffers are full.",
+                dropped_count - m_reported_dropped_count);
+            m_reported_dropped_count = dropped_count;
+        }
+
+        if (!m_messages.empty())
+        {
+            m_logger->flush();
+        }
+
+        m_messages.clear();
+        m_text.clear();
+
+        std::erase_if(
+            m_rings,
+            [](const auto& ring)
+            {
+                return ring->is_retired() && ring->is_empty();
+            });
+    }
+
+    void wake() noexcept
+    {
+        m_wake.notify_one();
+    }
+
+    void add_dropped() noexcept
+    {
+        m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t get_dropped_count() const noexcept
+    {
+        return m_dropped_count.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<log_overflow_policy> overflow_policy{LOG_OVERFLOW_POLICY_BLOCK};
+
+private:
+    struct message
+    {
+        spdlog::log_clock::time_point time;
+        log_level level;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    static spdlog::level::level_enum get_spdlog_level(log_level level) noexcept
+    {
+        switch (level)
+        {
+        case LOG_LEVEL_DEBUG:
+            return spdlog::level::debug;
+        case LOG_LEVEL_INFO:
+            return spdlog::level::info;
+        case LOG_LEVEL_WARN:
+            return spdlog::level::warn;
+        default:
+            return spdlog::level::err;
+        }
+    }
+
+    std::shared_ptr<spdlog::logger> m_logger;
+
+    std::mutex m_flush_mutex;
+    std::vector<std::shared_ptr<log_ring>> m_rings;
+    std::vector<message> m_messages;
+    std::string m_text;
+    fmt::memory_buffer m_buffer;
+
+    std::atomic<std::uint64_t> m_dropped_count{0};
+    std::uint64_t m_reported_dropped_count{0};
+
+    std::thread m_thread;
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    bool m_stop{false};
+};
+
+struct thread_log_ring
+{
+    thread_log_ring()
+        : ring(log_backend::instance().add_ring())
+    {
+    }
+
+    ~thread_log_ring()
+    {
+        ring->retire();
+    }
+
+    std::shared_ptr<log_ring> ring;
+};
+
+log_ring& get_thread_ring()
+{
+    thread_local thread_log_ring thread_ring;
+    return *thread_ring.ring;
+}
+} // namespace
+
+void log::flush()
+{
+    log_backend::instance().flush();
 }
 
-log::~log()
+void log::set_overflow_policy(log_overflow_policy policy) noexcept
 {
-    spdlog::drop_all();
+    log_backend::instance().overflow_policy.store(policy, std::memory_order_relaxed);
+}
+
+std::uint64_t log::get_dropped_count() noexcept
+{
+    return log_backend::instance().get_dropped_count();
+}
+
+void log::format_text(const void* payload, std::size_t size, fmt::memory_buffer& buffer)
+{
+    const auto* text = static_cast<const char*>(payload);
+    buffer.append(text, text + size);
+}
+
+void* log::begin_record(log_level level, format_function format, std::size_t size)
+{
+    log_ring& ring = get_thread_ring();
+    log_backend& backend = log_backend::instance();
+
+    void* data = ring.begin_record(size);
+    while (data == nullptr)
+    {
+        if (backend.overflow_policy.load(std::memory_order_relaxed) == LOG_OVERFLOW_POLICY_DROP)
+        {
+            backend.add_dropped();
+            return nullptr;
+        }
+
+        backend.wake();
+        std::this_thread::yield();
+
+        data = ring.begin_record(size);
+    }
+
+    record_header* header = ring.get_pending_header();
+    header->level = level;
+    header->format = format;
+
+    return data;
 }
 
-log& log::instance()
+void log::end_record() noexcept
 {
-    static log instance;
-    return instance;
+    get_thread_ring().end_record();
 }
 } // namespace violet
\ No newline at end of file
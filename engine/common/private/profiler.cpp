@@ -0,0 +1,441 @@
+#include "common/profiler.hpp"
+#include "common/flat_map.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace violet
+{
+namespace
+{
+class zone_buffer
+{
+public:
+    zone_buffer(std::size_t capacity)
+        : m_zones(std::bit_ceil(capacity)),
+          m_mask(m_zones.size() - 1)
+    {
+    }
+
+    void push(const profiler::zone& zone) noexcept
+    {
+        std::uint64_t index = m_write.load(std::memory_order_relaxed);
+        m_zones[index & m_mask] = zone;
+        m_write.store(index + 1, std::memory_order_release);
+    }
+
+    std::vector<profiler::zone> get_zones(std::uint32_t first_frame, std::uint32_t last_frame)
+        const
+    {
+        std::uint64_t end = m_write.load(std::memory_order_acquire);
+        std::uint64_t begin = end > m_zones.size() ? end - m_zones.size() : 0;
+
+        std::vector<profiler::zone> zones;
+        zones.reserve(end - begin);
+        for (std::uint64_t i = begin; i < end; ++i)
+        {
+            zones.push_back(m_zones[i & m_mask]);
+        }
+
+        // Zones that were overwritten while copying are dropped.
+        std::uint64_t write = m_write.load(std::memory_order_acquire);
+        std::uint64_t valid_begin = write > m_zones.size() ? write - m_zones.size() : 0;
+        zones.erase(zones.begin(), zones.begin() + (std::max(begin, valid_begin) - begin));
+
+        std::erase_if(
+            zones,
+            [=](const profiler::zone& zone)
+            {
+                return zone.frame < first_frame || zone.frame > last_frame;
+            });
+
+        // Zones are pushed when they end, parents after their children.
+        std::stable_sort(
+            zones.begin(),
+            zones.end(),
+            [](const profiler::zone& a, const profiler::zone& b)
+            {
+                return a.begin_time < b.begin_time;
+            });
+
+        return zones;
+    }
+
+    std::string name;
+
+private:
+    std::vector<profiler::zone> m_zones;
+    std::uint64_t m_mask;
+
+    std::atomic<std::uint64_t> m_write{0};
+};
+
+class profiler_registry
+{
+public:
+    static constexpr std::size_t FRAME_CAPACITY = 1024;
+
+    static profiler_registry& instance()
+    {
+        static profiler_registry instance;
+        return instance;
+    }
+
+    std::shared_ptr<zone_buffer> add_buffer(std::string_view name)
+    {
+        std::lock_guard lock(mutex);
+
+        auto buffer = std::make_shared<zone_buffer>(zone_capacity);
+        buffer->name = name.empty() ? "Thread " + std::to_string(buffers.size()) : name;
+        buffers.push_back(buffer);
+        return buffer;
+    }
+
+    void begin_frame(std::int64_t time) noexcept
+    {
+        std::uint32_t frame = this->frame.load(std::memory_order_relaxed) + 1;
+        frame_times[frame % FRAME_CAPACITY].store(time, std::memory_order_relaxed);
+        this->frame.store(frame, std::memory_order_release);
+    }
+
+    /**
+     * @brief Start times of the frames in [first_frame, last_frame] that are still recorded.
+     */
+    std::vector<std::pair<std::uint32_t, std::int64_t>> get_frames(
+        std::uint32_t first_frame,
+        std::uint32_t last_frame) const
+    {
+        std::uint32_t current = frame.load(std::memory_order_acquire);
+        std::uint32_t oldest = current >= FRAME_CAPACITY ? current - FRAME_CAPACITY + 1 : 0;
+
+        std::vector<std::pair<std::uint32_t, std::int64_t>> result;
+        for (std::uint32_t i = std::max(first_frame, oldest); i <= std::min(last_frame, current);
+             ++i)
+        {
+            result.emplace_back(i, frame_times[i % FRAME_CAPACITY].load(std::memory_order_relaxed));
+        }
+        return result;
+    }
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<zone_buffer>> buffers;
+    std::size_t zone_capacity{65536};
+
+    std::atomic<std::uint32_t> frame{0};
+    std::array<std::atomic<std::int64_t>, FRAME_CAPACITY> frame_times{};
+
+    std::int64_t start_time{profiler::now()};
+};
+
+struct thread_profiler
+{
+    static constexpr std::size_t MAX_DEPTH = 64;
+
+    zone_buffer& get_buffer()
+    {
+        if (buffer == nullptr)
+        {
+            buffer = profiler_registry::instance().add_buffer(name);
+        }
+        return *buffer;
+    }
+
+    std::shared_ptr<zone_buffer> buffer;
+    std::string name;
+
+    std::array<profiler::zone, MAX_DEPTH> stack;
+    std::uint32_t depth{0};
+};
+
+thread_local thread_profiler current_thread;
+
+void write_escaped(std::ostream& out, std::string_view str)
+{
+    for (char c : str)
+    {
+        switch (c)
+        {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) >= 0x20)
+            {
+                out << c;
+            }
+            break;
+        }
+    }
+}
+
+template <typename T>
+void write_value(std::ostream& out, T value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void write_string(std::ostream& out, std::string_view str)
+{
+    write_value(out, static_cast<std::uint32_t>(str.size()));
+    out.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+} // namespace
+
+void profiler::set_enabled(bool enabled, std::size_t zone_capacity)
+{
+    profiler_registry& registry = profiler_registry::instance();
+    {
+        std::lock_guard lock(registry.mutex);
+        registry.zone_capacity = zone_capacity;
+    }
+
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void profiler::set_thread_name(std::string_view name)
+{
+    current_thread.name = name;
+
+    if (current_thread.buffer != nullptr)
+    {
+        std::lock_guard lock(profiler_registry::instance().mutex);
+        current_thread.buffer->name = name;
+    }
+}
+
+void profiler::begin_frame(std::int64_t time) noexcept
+{
+    profiler_registry::instance().begin_frame(time);
+}
+
+std::uint32_t profiler::get_frame() noexcept
+{
+    return profiler_registry::instance().frame.load(std::memory_order_relaxed);
+}
+
+void profiler::begin_zone(const char* name, std::int64_t time, std::int64_t enqueue_time) noexcept
+{
+    thread_profiler& thread = current_thread;
+
+    if (thread.depth < thread_profiler::MAX_DEPTH)
+    {
+        thread.stack[thread.depth] = {
+            .name = name,
+            .enqueue_time = enqueue_time == 0 ? time : enqueue_time,
+            .begin_time = time,
+            .end_time = 0,
+            .frame = get_frame(),
+            .depth = thread.depth,
+        };
+    }
+    ++thread.depth;
+}
+
+void profiler::end_zone(std::int64_t time) noexcept
+{
+    thread_profiler& thread = current_thread;
+
+    // An end without a matching begin is ignored.
+    if (thread.depth == 0)
+    {
+        return;
+    }
+
+    --thread.depth;
+    if (thread.depth < thread_profiler::MAX_DEPTH)
+    {
+        profiler::zone& zone = thread.stack[thread.depth];
+        zone.end_time = time;
+        thread.get_buffer().push(zone);
+    }
+}
+
+void profiler::mark(const char* name, std::int64_t time) noexcept
+{
+    thread_profiler& thread = current_thread;
+
+    thread.get_buffer().push({
+        .name = name,
+        .enqueue_time = time,
+        .begin_time = time,
+        .end_time = time,
+        .frame = get_frame(),
+        .depth = thread.depth,
+    });
+}
+
+std::vector<profiler::zone> profiler::get_zones(
+    std::uint32_t first_frame,
+    std::uint32_t last_frame,
+    bool calling_thread_only)
+{
+    if (calling_thread_only)
+    {
+        return current_thread.buffer == nullptr ?
+                   std::vector<zone>() :
+                   current_thread.buffer->get_zones(first_frame, last_frame);
+    }
+
+    profiler_registry& registry = profiler_registry::instance();
+    std::lock_guard lock(registry.mutex);
+
+    std::vector<zone> result;
+    for (const auto& buffer : registry.buffers)
+    {
+        auto zones = buffer->get_zones(first_frame, last_frame);
+        result.insert(result.end(), zones.begin(), zones.end());
+    }
+    return result;
+}
+
+void profiler::write_chrome_trace(
+    std::ostream& out,
+    std::uint32_t first_frame,
+    std::uint32_t last_frame)
+{
+    profiler_registry& registry = profiler_registry::instance();
+    std::lock_guard lock(registry.mutex);
+
+    auto to_us = [&registry](std::int64_t time)
+    {
+        return static_cast<double>(time - registry.start_time) / 1000.0;
+    };
+
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    auto begin_event = [&]()
+    {
+        if (!first)
+        {
+            out << ',';
+        }
+        first = false;
+        out << "\n{";
+    };
+
+    for (const auto& [frame, time] : registry.get_frames(first_frame, last_frame))
+    {
+        begin_event();
+        out << "\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":" << to_us(time)
+            << ",\"name\":\"Frame " << frame << "\"}";
+    }
+
+    for (std::size_t thread_index = 0; thread_index < registry.buffers.size(); ++thread_index)
+    {
+        const zone_buffer& buffer = *registry.buffers[thread_index];
+
+        begin_event();
+        out << "\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << thread_index
+            << ",\"args\":{\"name\":\"";
+        write_escaped(out, buffer.name);
+        out << "\"}}";
+
+        for (const zone& zone : buffer.get_zones(first_frame, last_frame))
+        {
+            begin_event();
+
+            if (zone.begin_time == zone.end_time)
+            {
+                out << "\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":" << thread_index
+                    << ",\"ts\":" << to_us(zone.begin_time) << ",\"name\":\"";
+                write_escaped(out, zone.name);
+                out << "\",\"args\":{\"frame\":" << zone.frame << "}}";
+                continue;
+            }
+
+            out << "\"ph\":\"X\",\"pid\":0,\"tid\":" << thread_index
+                << ",\"ts\":" << to_us(zone.begin_time)
+                << ",\"dur\":" << to_us(zone.end_time) - to_us(zone.begin_time)
+                << ",\"name\":\"";
+            write_escaped(out, zone.name);
+            out << "\",\"args\":{\"frame\":" << zone.frame;
+            if (zone.enqueue_time != zone.begin_time)
+            {
+                out << ",\"queue_latency_us\":"
+                    << static_cast<double>(zone.begin_time - zone.enqueue_time) / 1000.0;
+            }
+            out << "}}";
+        }
+    }
+
+    out << "\n]}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void profiler::write_binary(std::ostream& out, std::uint32_t first_frame, std::uint32_t last_frame)
+{
+    profiler_registry& registry = profiler_registry::instance();
+    std::lock_guard lock(registry.mutex);
+
+    std::vector<std::vector<zone>> thread_zones;
+    std::vector<const char*> names;
+    flat_map<const char*, std::uint32_t> name_indexes;
+
+    for (const auto& buffer : registry.buffers)
+    {
+        thread_zones.push_back(buffer->get_zones(first_frame, last_frame));
+        for (const zone& zone : thread_zones.back())
+        {
+            auto [iter, inserted] =
+                name_indexes.try_emplace(zone.name, static_cast<std::uint32_t>(names.size()));
+            if (inserted)
+            {
+                names.push_back(zone.name);
+            }
+        }
+    }
+
+    out.write("VPRF", 4);
+    write_value<std::uint32_t>(out, 1);
+    write_value<std::int64_t>(out, registry.start_time);
+
+    write_value(out, static_cast<std::uint32_t>(names.size()));
+    for (const char* name : names)
+    {
+        write_string(out, name);
+    }
+
+    auto frames = registry.get_frames(first_frame, last_frame);
+    write_value(out, static_cast<std::uint32_t>(frames.size()));
+    for (const auto& [frame, time] : frames)
+    {
+        write_value(out, frame);
+        write_value(out, time);
+    }
+
+    write_value(out, static_cast<std::uint32_t>(thread_zones.size()));
+    for (std::size_t thread_index = 0; thread_index < thread_zones.size(); ++thread_index)
+    {
+        write_string(out, registry.buffers[thread_index]->name);
+
+        write_value(out, static_cast<std::uint32_t>(thread_zones[thread_index].size()));
+        for (const zone& zone : thread_zones[thread_index])
+        {
+            write_value(out, name_indexes[zone.name]);
+            write_value(out, zone.frame);
+            write_value(out, zone.depth);
+            write_value(out, zone.enqueue_time);
+            write_value(out, zone.begin_time);
+            write_value(out, zone.end_time);
+        }
+    }
+}
+} // namespace violet
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "common/string_id.hpp"
+#include "common/flat_map.hpp"
+#include <array>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace violet
+{
+namespace
+{
+class string_table
+{
+public:
+    static string_table& instance()
+    {
+        static string_table instance;
+        return instance;
+    }
+
+    void intern(std::uint64_t hash, std::string_view str)
+    {
+        shard& shard = get_shard(hash);
+
+        {
+            std::shared_lock lock(shard.mutex);
+            if (auto iter = shard.strings.find(hash); iter != shard.strings.end())
+            {
+                assert(iter->second == str && "String id collision.");
+                return;
+            }
+        }
+
+        std::unique_lock lock(shard.mutex);
+        if (shard.strings.contains(hash))
+        {
+            return;
+        }
+
+        // Strings live in a deque so views stay valid when the map rehashes.
+        const std::string& storage = shard.storage.emplace_back(str);
+        shard.strings[hash] = storage;
+    }
+
+    std::string_view find(std::uint64_t hash)
+    {
+        shard& shard = get_shard(hash);
+
+        std::shared_lock lock(shard.mutex);
+        auto iter = shard.strings.find(hash);
+        return iter == shard.strings.end() ? std::string_view() : iter->second;
+    }
+
+private:
+    struct shard
+    {
+        std::shared_mutex mutex;
+        flat_map<std::uint64_t, std::string_view> strings;
+        std::deque<std::string> storage;
+    };
+
+    static constexpr std::size_t SHARD_COUNT = 16;
+
+    shard& get_shard(std::uint64_t hash) noexcept
+    {
+        return m_shards[hash >> 60];
+    }
+
+    std::array<shard, SHARD_COUNT> m_shards;
+};
+} // namespace
+
+string_id::string_id(std::string_view str)
+    : m_value(hash_string(str))
+{
+    string_table::instance().intern(m_value, str);
+}
+
+std::string_view string_id::get_string() const
+{
+    return string_table::instance().find(m_value);
+}
+} // namespace violet
\ No newline at end of file
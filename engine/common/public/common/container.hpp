@@ -1,7 +1,7 @@
 #pragma once
 
+#include "common/flat_map.hpp"
 #include <string>
-#include <unordered_map>
 
 namespace violet
 {
@@ -33,5 +33,5 @@ struct string_equal
 } // namespace detail
 
 template <typename T>
-using string_map = std::unordered_map<std::string, T, detail::string_hash, detail::string_equal>;
+using string_map = flat_map<std::string, T, detail::string_hash, detail::string_equal>;
 } // namespace violet
\ No newline at end of file
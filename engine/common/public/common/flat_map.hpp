@@ -0,0 +1,1102 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define VIOLET_FLAT_MAP_SSE2
+#endif
+
+namespace violet
+{
+namespace detail
+{
+constexpr std::int8_t FLAT_CONTROL_EMPTY = -128;
+constexpr std::int8_t FLAT_CONTROL_DELETED = -2;
+constexpr std::int8_t FLAT_CONTROL_SENTINEL = -1;
+
+/**
+ * @brief 16 control bytes probed at once. A full slot stores the low 7 bits of its hash.
+ */
+class flat_group
+{
+public:
+    static constexpr std::size_t WIDTH = 16;
+
+    explicit flat_group(const std::int8_t* control) noexcept
+    {
+#ifdef VIOLET_FLAT_MAP_SSE2
+        m_control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+#else
+        std::memcpy(m_control, control, WIDTH);
+#endif
+    }
+
+    std::uint32_t match(std::int8_t h2) const noexcept
+    {
+#ifdef VIOLET_FLAT_MAP_SSE2
+        return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_control));
+#else
+        return match_if(
+            [h2](std::int8_t control)
+            {
+                return control == h2;
+            });
+#endif
+    }
+
+    std::uint32_t match_empty() const noexcept
+    {
+#ifdef VIOLET_FLAT_MAP_SSE2
+        return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(FLAT_CONTROL_EMPTY), m_control));
+#else
+        return match_if(
+            [](std::int8_t control)
+            {
+                return control == FLAT_CONTROL_EMPTY;
+            });
+#endif
+    }
+
+    std::uint32_t match_empty_or_deleted() const noexcept
+    {
+#ifdef VIOLET_FLAT_MAP_SSE2
+        return to_mask(_mm_cmpgt_epi8(_mm_set1_epi8(FLAT_CONTROL_SENTINEL), m_control));
+#else
+        return match_if(
+            [](std::int8_t control)
+            {
+                return control < FLAT_CONTROL_SENTINEL;
+            });
+#endif
+    }
+
+private:
+#ifdef VIOLET_FLAT_MAP_SSE2
+    static std::uint32_t to_mask(__m128i v) noexcept
+    {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(v));
+    }
+
+    __m128i m_control;
+#else
+    template <typename Predicate>
+    std::uint32_t match_if(Predicate&& predicate) const noexcept
+    {
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < WIDTH; ++i)
+        {
+            mask |= predicate(m_control[i]) ? 1u << i : 0u;
+        }
+        return mask;
+    }
+
+    std::int8_t m_control[WIDTH];
+#endif
+};
+
+template <typename T>
+concept flat_transparent = requires { typename T::is_transparent; };
+
+/**
+ * @brief Open addressing hash table in the style of Swiss tables. Slots live in one flat array
+ * next to a control byte array, a lookup compares 16 control bytes at once and only touches the
+ * slots whose 7-bit hash matches. Inserting or erasing invalidates iterators and references.
+ */
+template <typename Policy, typename Hash, typename Equal, bool Multi>
+class flat_table
+{
+public:
+    using key_type = typename Policy::key_type;
+    using value_type = typename Policy::value_type;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+
+    template <bool Const>
+    class basic_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename Policy::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+        basic_iterator() = default;
+
+        basic_iterator(const std::int8_t* control, pointer slot) noexcept
+            : m_control(control),
+              m_slot(slot)
+        {
+        }
+
+        template <bool OtherConst>
+            requires(Const && !OtherConst)
+        basic_iterator(const basic_iterator<OtherConst>& other) noexcept
+            : m_control(other.m_control),
+              m_slot(other.m_slot)
+        {
+        }
+
+        reference operator*() const noexcept
+        {
+            return *m_slot;
+        }
+
+        pointer operator->() const noexcept
+        {
+            return m_slot;
+        }
+
+        basic_iterator& operator++() noexcept
+        {
+            ++m_control;
+            ++m_slot;
+            skip_empty();
+            return *this;
+        }
+
+        basic_iterator operator++(int) noexcept
+        {
+            basic_iterator result = *this;
+            ++(*this);
+            return result;
+        }
+
+        bool operator==(const basic_iterator& other) const noexcept
+        {
+            return m_control == other.m_control;
+        }
+
+    private:
+        template <bool>
+        friend class basic_iterator;
+        friend class flat_table;
+
+        void skip_empty() noexcept
+        {
+            // The sentinel after the last slot stops the scan.
+            while (*m_control < FLAT_CONTROL_SENTINEL)
+            {
+                ++m_control;
+                ++m_slot;
+            }
+        }
+
+        const std::int8_t* m_control{nullptr};
+        pointer m_slot{nullptr};
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    /**
+     * @brief Visits the slots holding one key, used by the multimap.
+     */
+    template <bool Const>
+    class basic_key_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename Policy::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+        using table_pointer = std::conditional_t<Const, const flat_table*, flat_table*>;
+
+        basic_key_iterator() = default;
+
+        basic_key_iterator(table_pointer table, const key_type& key, std::size_t hash)
+            : m_table(table),
+              m_key(key),
+              m_offset(get_h1(hash) & table->m_capacity),
+              m_h2(get_h2(hash))
+        {
+            load_group();
+            next();
+        }
+
+        reference operator*() const noexcept
+        {
+            return m_table->m_slots[m_index];
+        }
+
+        pointer operator->() const noexcept
+        {
+            return &m_table->m_slots[m_index];
+        }
+
+        basic_key_iterator& operator++() noexcept
+        {
+            next();
+            return *this;
+        }
+
+        basic_key_iterator operator++(int) noexcept
+        {
+            basic_key_iterator result = *this;
+            next();
+            return result;
+        }
+
+        bool operator==(const basic_key_iterator& other) const noexcept
+        {
+            return m_index == other.m_index;
+        }
+
+        operator basic_iterator<Const>() const noexcept
+        {
+            return {m_table->m_control + m_index, m_table->m_slots + m_index};
+        }
+
+    private:
+        static constexpr std::size_t END = ~std::size_t(0);
+
+        void load_group() noexcept
+        {
+            flat_group group(m_table->m_control + m_offset);
+            m_match = group.match(m_h2);
+            m_last_group = group.match_empty() != 0;
+        }
+
+        void next() noexcept
+        {
+            while (true)
+            {
+                while (m_match != 0)
+                {
+                    std::size_t index = (m_offset + std::countr_zero(m_match)) &
+                                        m_table->m_capacity;
+                    m_match &= m_match - 1;
+
+                    if (m_table->m_equal(Policy::get_key(m_table->m_slots[index]), m_key))
+                    {
+                        m_index = index;
+                        return;
+                    }
+                }
+
+                if (m_last_group || ++m_probe_count > m_table->m_capacity / flat_group::WIDTH)
+                {
+                    m_index = END;
+                    return;
+                }
+
+                m_probe_index += flat_group::WIDTH;
+                m_offset = (m_offset + m_probe_index) & m_table->m_capacity;
+                load_group();
+            }
+        }
+
+        table_pointer m_table{nullptr};
+        key_type m_key{};
+
+        std::size_t m_offset{0};
+        std::size_t m_probe_index{0};
+        std::size_t m_probe_count{0};
+        std::uint32_t m_match{0};
+        bool m_last_group{true};
+        std::int8_t m_h2{0};
+
+        std::size_t m_index{END};
+    };
+
+    using key_iterator = basic_key_iterator<false>;
+    using const_key_iterator = basic_key_iterator<true>;
+
+    template <typename Iterator>
+    struct key_range
+    {
+        Iterator first;
+        Iterator second;
+
+        Iterator begin() const noexcept
+        {
+            return first;
+        }
+
+        Iterator end() const noexcept
+        {
+            return second;
+        }
+
+        bool empty() const noexcept
+        {
+            return first == second;
+        }
+    };
+
+    flat_table() = default;
+
+    flat_table(std::initializer_list<value_type> values)
+    {
+        reserve(values.size());
+        for (const value_type& value : values)
+        {
+            insert(value);
+        }
+    }
+
+    flat_table(const flat_table& other)
+        : m_hash(other.m_hash),
+          m_equal(other.m_equal)
+    {
+        reserve(other.m_size);
+        for (const value_type& value : other)
+        {
+            emplace_unchecked(get_hash(Policy::get_key(value)), value);
+        }
+    }
+
+    flat_table(flat_table&& other) noexcept
+        : m_control(std::exchange(other.m_control, nullptr)),
+          m_slots(std::exchange(other.m_slots, nullptr)),
+          m_capacity(std::exchange(other.m_capacity, 0)),
+          m_size(std::exchange(other.m_size, 0)),
+          m_growth_left(std::exchange(other.m_growth_left, 0)),
+          m_hash(std::move(other.m_hash)),
+          m_equal(std::move(other.m_equal))
+    {
+    }
+
+    ~flat_table()
+    {
+        destroy();
+    }
+
+    flat_table& operator=(const flat_table& other)
+    {
+        if (this != &other)
+        {
+            flat_table copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    flat_table& operator=(flat_table&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+
+            m_control = std::exchange(other.m_control, nullptr);
+            m_slots = std::exchange(other.m_slots, nullptr);
+            m_capacity = std::exchange(other.m_capacity, 0);
+            m_size = std::exchange(other.m_size, 0);
+            m_growth_left = std::exchange(other.m_growth_left, 0);
+            m_hash = std::move(other.m_hash);
+            m_equal = std::move(other.m_equal);
+        }
+        return *this;
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type value(std::forward<Args>(args)...);
+        return insert(std::move(value));
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return insert_key(Policy::get_key(value), value);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return insert_key(Policy::get_key(value), std::move(value));
+    }
+
+    template <typename Iterator>
+    void insert(Iterator first, Iterator last)
+    {
+        for (; first != last; ++first)
+        {
+            insert(*first);
+        }
+    }
+
+    iterator find(const key_type& key)
+    {
+        return find_key(key);
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+        return const_cast<flat_table*>(this)->find_key(key);
+    }
+
+    template <typename K>
+        requires(flat_transparent<Hash> && flat_transparent<Equal>)
+    iterator find(const K& key)
+    {
+        return find_key(key);
+    }
+
+    template <typename K>
+        requires(flat_transparent<Hash> && flat_transparent<Equal>)
+    const_iterator find(const K& key) const
+    {
+        return const_cast<flat_table*>(this)->find_key(key);
+    }
+
+    bool contains(const key_type& key) const
+    {
+        return find(key) != end();
+    }
+
+    template <typename K>
+        requires(flat_transparent<Hash> && flat_transparent<Equal>)
+    bool contains(const K& key) const
+    {
+        return find(key) != end();
+    }
+
+    size_type count(const key_type& key) const
+    {
+        if constexpr (Multi)
+        {
+            auto range = equal_range(key);
+            return static_cast<size_type>(std::distance(range.first, range.second));
+        }
+        else
+        {
+            return contains(key) ? 1 : 0;
+        }
+    }
+
+    key_range<key_iterator> equal_range(const key_type& key)
+        requires Multi
+    {
+        if (m_size == 0)
+        {
+            return {};
+        }
+        return {key_iterator(this, key, get_hash(key)), key_iterator()};
+    }
+
+    key_range<const_key_iterator> equal_range(const key_type& key) const
+        requires Multi
+    {
+        if (m_size == 0)
+        {
+            return {};
+        }
+        return {const_key_iterator(this, key, get_hash(key)), const_key_iterator()};
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        std::size_t index = pos.m_control - m_control;
+        erase_index(index);
+
+        iterator result(m_control + index, m_slots + index);
+        result.skip_empty();
+        return result;
+    }
+
+    iterator erase(iterator pos)
+    {
+        return erase(const_iterator(pos));
+    }
+
+    size_type erase(const key_type& key)
+    {
+        if constexpr (Multi)
+        {
+            size_type count = 0;
+            for (auto range = equal_range(key); !range.empty(); range = equal_range(key))
+            {
+                erase_index(get_index(range.first));
+                ++count;
+            }
+            return count;
+        }
+        else
+        {
+            auto iter = find(key);
+            if (iter == end())
+            {
+                return 0;
+            }
+
+            erase(iter);
+            return 1;
+        }
+    }
+
+    template <typename K>
+        requires(!Multi && flat_transparent<Hash> && flat_transparent<Equal>)
+    size_type erase(const K& key)
+    {
+        auto iter = find(key);
+        if (iter == end())
+        {
+            return 0;
+        }
+
+        erase(iter);
+        return 1;
+    }
+
+    void clear() noexcept
+    {
+        if (m_size == 0)
+        {
+            return;
+        }
+
+        for (std::size_t i = 0; i < m_capacity; ++i)
+        {
+            if (m_control[i] >= 0)
+            {
+                std::destroy_at(m_slots + i);
+            }
+        }
+
+        reset_control();
+        m_size = 0;
+    }
+
+    void reserve(size_type count)
+    {
+        std::size_t capacity = MIN_CAPACITY;
+        while (get_growth(capacity) < count)
+        {
+            capacity = capacity * 2 + 1;
+        }
+
+        if (capacity > m_capacity)
+        {
+            resize(capacity);
+        }
+    }
+
+    void swap(flat_table& other) noexcept
+    {
+        std::swap(m_control, other.m_control);
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_size, other.m_size);
+        std::swap(m_growth_left, other.m_growth_left);
+        std::swap(m_hash, other.m_hash);
+        std::swap(m_equal, other.m_equal);
+    }
+
+    iterator begin() noexcept
+    {
+        if (m_size == 0)
+        {
+            return end();
+        }
+
+        iterator result(m_control, m_slots);
+        result.skip_empty();
+        return result;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_cast<flat_table*>(this)->begin();
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    iterator end() noexcept
+    {
+        return {m_control + m_capacity, m_slots + m_capacity};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_cast<flat_table*>(this)->end();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    [[nodiscard]] size_type size() const noexcept
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    [[nodiscard]] size_type capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+protected:
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace_key(const K& key, Args&&... args)
+    {
+        std::size_t hash_value = get_hash(key);
+
+        if constexpr (!Multi)
+        {
+            std::size_t index = find_index(key, hash_value);
+            if (index != NOT_FOUND)
+            {
+                return {iterator(m_control + index, m_slots + index), false};
+            }
+        }
+
+        return {emplace_unchecked(hash_value, std::forward<Args>(args)...), true};
+    }
+
+    template <typename K>
+    std::size_t find_index(const K& key) const
+    {
+        return m_size == 0 ? NOT_FOUND : find_index(key, get_hash(key));
+    }
+
+    static constexpr std::size_t NOT_FOUND = ~std::size_t(0);
+
+private:
+    // Capacity is always 2^n - 1 and at least one group, so masking with it wraps around and the
+    // bytes cloned after the sentinel let a group be loaded at any slot.
+    static constexpr std::size_t MIN_CAPACITY = flat_group::WIDTH - 1;
+    static constexpr std::size_t CLONED_COUNT = flat_group::WIDTH - 1;
+
+    static std::size_t get_h1(std::size_t hash) noexcept
+    {
+        return hash >> 7;
+    }
+
+    static std::int8_t get_h2(std::size_t hash) noexcept
+    {
+        return static_cast<std::int8_t>(hash & 0x7F);
+    }
+
+    // Keeps the table at most 7/8 full.
+    static std::size_t get_growth(std::size_t capacity) noexcept
+    {
+        return capacity - capacity / 8;
+    }
+
+    template <typename K>
+    std::size_t get_hash(const K& key) const
+    {
+        // Engine hashers are often identity or 32-bit, spread them over all bits before splitting
+        // into h1 and h2.
+        auto value = static_cast<std::uint64_t>(m_hash(key));
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        return static_cast<std::size_t>(value);
+    }
+
+    template <typename K>
+    iterator find_key(const K& key)
+    {
+        std::size_t index = find_index(key);
+        return index == NOT_FOUND ? end() : iterator(m_control + index, m_slots + index);
+    }
+
+    template <typename K>
+    std::size_t find_index(const K& key, std::size_t hash_value) const
+    {
+        if (m_capacity == 0)
+        {
+            return NOT_FOUND;
+        }
+
+        std::size_t offset = get_h1(hash_value) & m_capacity;
+        std::int8_t h2 = get_h2(hash_value);
+
+        for (std::size_t probe = 0; probe <= m_capacity; probe += flat_group::WIDTH)
+        {
+            offset = (offset + probe) & m_capacity;
+
+            flat_group group(m_control + offset);
+            for (std::uint32_t match = group.match(h2); match != 0; match &= match - 1)
+            {
+                std::size_t index = (offset + std::countr_zero(match)) & m_capacity;
+                if (m_equal(Policy::get_key(m_slots[index]), key))
+                {
+                    return index;
+                }
+            }
+
+            if (group.match_empty() != 0)
+            {
+                break;
+            }
+        }
+
+        return NOT_FOUND;
+    }
+
+    std::size_t find_insert_index(std::size_t hash_value) const noexcept
+    {
+        std::size_t offset = get_h1(hash_value) & m_capacity;
+        for (std::size_t probe = 0;; probe += flat_group::WIDTH)
+        {
+            offset = (offset + probe) & m_capacity;
+
+            flat_group group(m_control + offset);
+            std::uint32_t match = group.match_empty_or_deleted();
+            if (match != 0)
+            {
+                return (offset + std::countr_zero(match)) & m_capacity;
+            }
+        }
+    }
+
+    template <typename K, typename V>
+    std::pair<iterator, bool> insert_key(const K& key, V&& value)
+    {
+        return try_emplace_key(key, std::forward<V>(value));
+    }
+
+    template <typename... Args>
+    iterator emplace_unchecked(std::size_t hash_value, Args&&... args)
+    {
+        if (m_capacity == 0)
+        {
+            grow();
+        }
+
+        std::size_t index = find_insert_index(hash_value);
+        if (m_control[index] == FLAT_CONTROL_EMPTY && m_growth_left == 0)
+        {
+            // Only tombstones can be reused without growing.
+            grow();
+            index = find_insert_index(hash_value);
+        }
+
+        std::construct_at(m_slots + index, std::forward<Args>(args)...);
+
+        if (m_control[index] == FLAT_CONTROL_EMPTY)
+        {
+            --m_growth_left;
+        }
+        set_control(index, get_h2(hash_value));
+        ++m_size;
+
+        return {m_control + index, m_slots + index};
+    }
+
+    void erase_index(std::size_t index) noexcept
+    {
+        std::destroy_at(m_slots + index);
+        --m_size;
+
+        // A slot can become empty again if no probe sequence ever passed a full group around it,
+        // otherwise it is left as a tombstone.
+        std::size_t index_before = (index - flat_group::WIDTH) & m_capacity;
+        std::uint32_t empty_before = flat_group(m_control + index_before).match_empty();
+        std::uint32_t empty_after = flat_group(m_control + index).match_empty();
+
+        bool was_never_full = empty_before != 0 && empty_after != 0 &&
+                              static_cast<std::size_t>(
+                                  std::countr_zero(empty_after) +
+                                  std::countl_zero(empty_before << 16)) < flat_group::WIDTH;
+
+        if (was_never_full)
+        {
+            set_control(index, FLAT_CONTROL_EMPTY);
+            ++m_growth_left;
+        }
+        else
+        {
+            set_control(index, FLAT_CONTROL_DELETED);
+        }
+    }
+
+    template <typename Iterator>
+    std::size_t get_index(const Iterator& iter) const noexcept
+    {
+        return iterator(iter).m_control - m_control;
+    }
+
+    void set_control(std::size_t index, std::int8_t control) noexcept
+    {
+        m_control[index] = control;
+        m_control[((index - CLONED_COUNT) & m_capacity) + CLONED_COUNT] = control;
+    }
+
+    void reset_control() noexcept
+    {
+        std::memset(m_control, FLAT_CONTROL_EMPTY, m_capacity + flat_group::WIDTH);
+        m_control[m_capacity] = FLAT_CONTROL_SENTINEL;
+        m_growth_left = get_growth(m_capacity);
+    }
+
+    void grow()
+    {
+        if (m_capacity == 0)
+        {
+            resize(MIN_CAPACITY);
+        }
+        else if (m_size * 2 <= get_growth(m_capacity))
+        {
+            // Mostly tombstones, rehashing in place of growing is enough.
+            resize(m_capacity);
+        }
+        else
+        {
+            resize(m_capacity * 2 + 1);
+        }
+    }
+
+    void resize(std::size_t capacity)
+    {
+        std::int8_t* old_control = m_control;
+        value_type* old_slots = m_slots;
+        std::size_t old_capacity = m_capacity;
+
+        std::size_t slot_offset = get_slot_offset(capacity);
+        auto* memory = static_cast<std::uint8_t*>(::operator new(
+            slot_offset + (capacity * sizeof(value_type)),
+            std::align_val_t(ALIGNMENT)));
+
+        m_control = reinterpret_cast<std::int8_t*>(memory);
+        m_slots = reinterpret_cast<value_type*>(memory + slot_offset);
+        m_capacity = capacity;
+        reset_control();
+
+        for (std::size_t i = 0; i < old_capacity; ++i)
+        {
+            if (old_control[i] >= 0)
+            {
+                std::size_t hash_value = get_hash(Policy::get_key(old_slots[i]));
+                std::size_t index = find_insert_index(hash_value);
+
+                Policy::transfer(m_slots + index, old_slots + i);
+                set_control(index, get_h2(hash_value));
+            }
+        }
+        m_growth_left -= m_size;
+
+        if (old_control != nullptr)
+        {
+            ::operator delete(old_control, std::align_val_t(ALIGNMENT));
+        }
+    }
+
+    void destroy() noexcept
+    {
+        if (m_control == nullptr)
+        {
+            return;
+        }
+
+        clear();
+        ::operator delete(m_control, std::align_val_t(ALIGNMENT));
+
+        m_control = nullptr;
+        m_slots = nullptr;
+        m_capacity = 0;
+        m_growth_left = 0;
+    }
+
+    static constexpr std::size_t ALIGNMENT = std::max(alignof(value_type), flat_group::WIDTH);
+
+    static std::size_t get_slot_offset(std::size_t capacity) noexcept
+    {
+        return (capacity + flat_group::WIDTH + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    std::int8_t* m_control{nullptr};
+    value_type* m_slots{nullptr};
+    std::size_t m_capacity{0};
+    std::size_t m_size{0};
+    std::size_t m_growth_left{0};
+
+    [[no_unique_address]] Hash m_hash;
+    [[no_unique_address]] Equal m_equal;
+};
+
+template <typename Key>
+struct flat_set_policy
+{
+    using key_type = Key;
+    using value_type = Key;
+
+    static const Key& get_key(const value_type& value) noexcept
+    {
+        return value;
+    }
+
+    static void transfer(value_type* dst, value_type* src)
+    {
+        std::construct_at(dst, std::move(*src));
+        std::destroy_at(src);
+    }
+};
+
+template <typename Key, typename Value>
+struct flat_map_policy
+{
+    using key_type = Key;
+    using value_type = std::pair<const Key, Value>;
+
+    static const Key& get_key(const value_type& value) noexcept
+    {
+        return value.first;
+    }
+
+    static void transfer(value_type* dst, value_type* src)
+    {
+        // The key is const only to users, it can be moved out of a slot that is destroyed next.
+        std::construct_at(
+            dst,
+            std::move(const_cast<Key&>(src->first)),
+            std::move(src->second));
+        std::destroy_at(src);
+    }
+};
+
+template <typename Key, typename Value, typename Hash, typename Equal, bool Multi>
+class flat_map_base : public flat_table<flat_map_policy<Key, Value>, Hash, Equal, Multi>
+{
+public:
+    using base_type = flat_table<flat_map_policy<Key, Value>, Hash, Equal, Multi>;
+    using mapped_type = Value;
+
+    using base_type::base_type;
+    using base_type::insert;
+
+    template <typename M>
+    std::pair<typename base_type::iterator, bool> insert(std::pair<Key, M>&& value)
+    {
+        return base_type::try_emplace_key(value.first, std::move(value));
+    }
+
+    template <typename... Args>
+    std::pair<typename base_type::iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        return base_type::try_emplace_key(
+            key,
+            std::piecewise_construct,
+            std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    std::pair<typename base_type::iterator, bool> try_emplace(Key&& key, Args&&... args)
+    {
+        return base_type::try_emplace_key(
+            key,
+            std::piecewise_construct,
+            std::forward_as_tuple(std::move(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+};
+} // namespace detail
+
+/**
+ * @brief Hash map with flat storage, see detail::flat_table. Supports heterogeneous lookup when
+ * both Hash and Equal define is_transparent.
+ */
+template <
+    typename Key,
+    typename Value,
+    typename Hash = std::hash<Key>,
+    typename Equal = std::equal_to<Key>>
+class flat_map : public detail::flat_map_base<Key, Value, Hash, Equal, false>
+{
+public:
+    using base_type = detail::flat_map_base<Key, Value, Hash, Equal, false>;
+    using base_type::base_type;
+
+    template <typename M>
+    std::pair<typename base_type::iterator, bool> insert_or_assign(const Key& key, M&& value)
+    {
+        auto result = base_type::try_emplace(key, std::forward<M>(value));
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    template <typename M>
+    std::pair<typename base_type::iterator, bool> insert_or_assign(Key&& key, M&& value)
+    {
+        auto result = base_type::try_emplace(std::move(key), std::forward<M>(value));
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    Value& operator[](const Key& key)
+    {
+        return base_type::try_emplace(key).first->second;
+    }
+
+    Value& operator[](Key&& key)
+    {
+        return base_type::try_emplace(std::move(key)).first->second;
+    }
+
+    Value& at(const Key& key)
+    {
+        auto iter = base_type::find(key);
+        if (iter == base_type::end())
+        {
+            throw std::out_of_range("flat_map::at: key not found.");
+        }
+        return iter->second;
+    }
+
+    const Value& at(const Key& key) const
+    {
+        auto iter = base_type::find(key);
+        if (iter == base_type::end())
+        {
+            throw std::out_of_range("flat_map::at: key not found.");
+        }
+        return iter->second;
+    }
+};
+
+/**
+ * @brief flat_map allowing duplicate keys, equal_range visits every value of a key.
+ */
+template <
+    typename Key,
+    typename Value,
+    typename Hash = std::hash<Key>,
+    typename Equal = std::equal_to<Key>>
+class flat_multimap : public detail::flat_map_base<Key, Value, Hash, Equal, true>
+{
+public:
+    using base_type = detail::flat_map_base<Key, Value, Hash, Equal, true>;
+    using base_type::base_type;
+};
+
+template <typename Key, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class flat_set : public detail::flat_table<detail::flat_set_policy<Key>, Hash, Equal, false>
+{
+public:
+    using base_type = detail::flat_table<detail::flat_set_policy<Key>, Hash, Equal, false>;
+    using base_type::base_type;
+};
+} // namespace violet
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace violet
+{
+/**
+ * @brief Bump allocator over a list of blocks. reset keeps the memory, blocks used in one round
+ * are merged into a single block so the next round usually allocates nothing.
+ */
+class linear_arena
+{
+public:
+    static constexpr std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    linear_arena(std::size_t block_size = DEFAULT_BLOCK_SIZE);
+    linear_arena(const linear_arena&) = delete;
+    ~linear_arena();
+
+    [[nodiscard]] void* allocate(std::size_t size, std::size_t alignment);
+
+    void reset();
+
+    [[nodiscard]] std::size_t get_used_size() const noexcept
+    {
+        return m_used_size;
+    }
+
+    [[nodiscard]] std::size_t get_capacity() const noexcept;
+
+    /**
+     * @brief Number of blocks taken from the heap since the arena was created.
+     */
+    [[nodiscard]] std::size_t get_block_allocation_count() const noexcept
+    {
+        return m_block_allocation_count;
+    }
+
+    linear_arena& operator=(const linear_arena&) = delete;
+
+private:
+    struct block
+    {
+        std::uint8_t* data;
+        std::size_t size;
+    };
+
+    void add_block(std::size_t size);
+
+    std::vector<block> m_blocks;
+    std::size_t m_block_index{0};
+    std::size_t m_offset{0};
+
+    std::size_t m_block_size;
+    std::size_t m_used_size{0};
+    std::size_t m_block_allocation_count{0};
+};
+
+/**
+ * @brief Thread local arenas for memory that lives at most until the end of the current frame.
+ * Every thread allocates from its own arena without locking. reset only starts a new frame, each
+ * arena is reset by its owning thread on its first allocation in the new frame, so threads still
+ * running jobs while the frame ends are never touched by another thread.
+ */
+class frame_arena
+{
+public:
+    [[nodiscard]] static void* allocate(std::size_t size, std::size_t alignment);
+
+    /**
+     * @brief Ends the current frame, called by the engine once all tasks of the frame are done. No
+     * frame memory may be alive afterwards, e.g. held across a co_await by a coroutine.
+     */
+    static void reset();
+
+    /**
+     * @brief Bytes allocated in the current frame by all threads.
+     */
+    [[nodiscard]] static std::size_t get_used_size();
+    [[nodiscard]] static std::size_t get_block_allocation_count();
+};
+
+/**
+ * @brief Standard allocator on frame_arena, deallocate does nothing. A container may grow on any
+ * thread, each allocation comes from the arena of the calling thread.
+ */
+template <typename T>
+class frame_allocator
+{
+public:
+    using value_type = T;
+
+    frame_allocator() noexcept = default;
+
+    template <typename U>
+    frame_allocator(const frame_allocator<U>& /* other */) noexcept
+    {
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(frame_arena::allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* /* p */, std::size_t /* n */) noexcept {}
+
+    template <typename U>
+    bool operator==(const frame_allocator<U>& /* other */) const noexcept
+    {
+        return true;
+    }
+};
+
+template <typename T>
+using frame_vector = std::vector<T, frame_allocator<T>>;
+
+template <
+    typename Key,
+    typename T,
+    typename Hash = std::hash<Key>,
+    typename Equal = std::equal_to<Key>>
+using frame_unordered_map =
+    std::unordered_map<Key, T, Hash, Equal, frame_allocator<std::pair<const Key, T>>>;
+
+/**
+ * @brief Counts heap allocations through the global operator new. Only counts when the engine is
+ * built with VIOLET_ALLOCATION_COUNTER, otherwise get_count is always 0.
+ */
+class allocation_counter
+{
+public:
+    [[nodiscard]] static bool is_enabled() noexcept;
+
+    /**
+     * @brief Allocations made by the calling thread.
+     */
+    [[nodiscard]] static std::uint64_t get_thread_count() noexcept;
+
+    /**
+     * @brief Allocations made by all threads.
+     */
+    [[nodiscard]] static std::uint64_t get_count() noexcept;
+};
+} // namespace violet
\ No newline at end of file
@@ -1,43 +1,166 @@
 #pragma once
 
-#include "spdlog/logger.h"
-#include <memory>
+#include "spdlog/common.h"
+#include "spdlog/fmt/fmt.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#ifndef VIOLET_LOG_LEVEL
+#define VIOLET_LOG_LEVEL 0
+#endif
 
 namespace violet
 {
+enum log_level : std::uint8_t
+{
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+};
+
+enum log_overflow_policy
+{
+    // Messages that do not fit into the thread buffer are dropped and counted.
+    LOG_OVERFLOW_POLICY_DROP,
+    // The logging thread waits until the flush thread makes room.
+    LOG_OVERFLOW_POLICY_BLOCK,
+};
+
+/**
+ * @brief Asynchronous logger. Every thread writes records into its own lock-free ring buffer, a
+ * background thread formats them and passes them to spdlog. Levels below VIOLET_LOG_LEVEL are
+ * compiled out.
+ */
 class log
 {
 public:
     template <typename... Args>
     static void error(spdlog::format_string_t<Args...> fmt, Args&&... args)
     {
-        instance().m_logger->error(fmt, std::forward<Args>(args)...);
+        write<LOG_LEVEL_ERROR>(fmt, std::forward<Args>(args)...);
     }
 
     template <typename... Args>
     static void warn(spdlog::format_string_t<Args...> fmt, Args&&... args)
     {
-        instance().m_logger->warn(fmt, std::forward<Args>(args)...);
+        write<LOG_LEVEL_WARN>(fmt, std::forward<Args>(args)...);
     }
 
     template <typename... Args>
     static void info(spdlog::format_string_t<Args...> fmt, Args&&... args)
     {
-        instance().m_logger->info(fmt, std::forward<Args>(args)...);
+        write<LOG_LEVEL_INFO>(fmt, std::forward<Args>(args)...);
     }
 
     template <typename... Args>
     static void debug(spdlog::format_string_t<Args...> fmt, Args&&... args)
     {
-        instance().m_logger->debug(fmt, std::forward<Args>(args)...);
+        write<LOG_LEVEL_DEBUG>(fmt, std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Writes every record logged so far, on the calling thread.
+     */
+    static void flush();
+
+    static void set_overflow_policy(log_overflow_policy policy) noexcept;
+
+    static std::uint64_t get_dropped_count() noexcept;
+
 private:
-    log();
-    ~log();
+    // Longer messages are truncated.
+    static constexpr std::size_t MAX_MESSAGE_SIZE = 4096;
+
+    using format_function =
+        void (*)(const void* payload, std::size_t size, fmt::memory_buffer& buffer);
+
+    template <typename T>
+    static constexpr bool is_deferrable = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+    // The format string follows the arguments in the record.
+    template <typename... Args>
+    struct deferred_payload
+    {
+        std::tuple<Args...> args;
+    };
+
+    template <log_level Level, typename... Args>
+    static void write(spdlog::format_string_t<Args...> fmt, Args&&... args)
+    {
+        if constexpr (Level >= VIOLET_LOG_LEVEL)
+        {
+            fmt::string_view format = fmt;
+
+            if constexpr ((is_deferrable<std::remove_cvref_t<Args>> && ...))
+            {
+                // The arguments are plain values, so formatting can wait for the flush thread. The
+                // format is copied as well, it may be a fmt::runtime string that dies with the call.
+                using payload_type = deferred_payload<std::remove_cvref_t<Args>...>;
+                static_assert(alignof(payload_type) <= 16);
+
+                if (format.size() <= MAX_MESSAGE_SIZE)
+                {
+                    void* data = begin_record(
+                        Level,
+                        &format_deferred<payload_type>,
+                        sizeof(payload_type) + format.size());
+                    if (data != nullptr)
+                    {
+                        new (data) payload_type{
+                            .args = {args...},
+                        };
+                        std::memcpy(
+                            static_cast<char*>(data) + sizeof(payload_type),
+                            format.data(),
+                            format.size());
+                        end_record();
+                    }
+                    return;
+                }
+            }
+
+            // Strings and user types may not outlive the call, format them now.
+            fmt::memory_buffer buffer;
+            fmt::format_to(std::back_inserter(buffer), fmt, std::forward<Args>(args)...);
+
+            std::size_t size = std::min(buffer.size(), MAX_MESSAGE_SIZE);
+
+            void* data = begin_record(Level, &format_text, size);
+            if (data != nullptr)
+            {
+                std::memcpy(data, buffer.data(), size);
+                end_record();
+            }
+        }
+    }
+
+    template <typename Payload>
+    static void format_deferred(const void* payload, std::size_t size, fmt::memory_buffer& buffer)
+    {
+        const auto* data = static_cast<const Payload*>(payload);
+        fmt::string_view format(reinterpret_cast<const char*>(data + 1), size - sizeof(Payload));
+
+        std::apply(
+            [&](const auto&... args)
+            {
+                fmt::vformat_to(std::back_inserter(buffer), format, fmt::make_format_args(args...));
+            },
+            data->args);
+    }
 
-    static log& instance();
+    static void format_text(const void* payload, std::size_t size, fmt::memory_buffer& buffer);
 
-    std::shared_ptr<spdlog::logger> m_logger;
+    /**
+     * @brief Reserves a record in the ring of the calling thread, returns nullptr if the record
+     * was dropped.
+     */
+    static void* begin_record(log_level level, format_function format, std::size_t size);
+    static void end_record() noexcept;
 };
 } // namespace violet
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#define VIOLET_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VIOLET_PROFILE_CONCAT(a, b) VIOLET_PROFILE_CONCAT_IMPL(a, b)
+
+#define VIOLET_PROFILE_ZONE(name)                                                                  \
+    ::violet::profile_zone VIOLET_PROFILE_CONCAT(violet_profile_zone_, __LINE__)(name)
+
+namespace violet
+{
+/**
+ * @brief Engine wide CPU profiler. Every thread records its zones into its own ring buffer without
+ * locking, old zones are overwritten when a buffer is full. Recording is off until set_enabled is
+ * called, a zone on a disabled profiler costs one atomic load.
+ */
+class profiler
+{
+public:
+    struct zone
+    {
+        // Must stay valid until the capture is written, e.g. a literal or a task name.
+        const char* name;
+
+        // Nanoseconds, see profiler::now. The enqueue time is when the work of the zone was queued,
+        // e.g. a task or a coroutine on the executor, and equals the begin time otherwise.
+        std::int64_t enqueue_time;
+        std::int64_t begin_time;
+        std::int64_t end_time;
+
+        std::uint32_t frame;
+        std::uint32_t depth;
+    };
+
+    static void set_enabled(bool enabled, std::size_t zone_capacity = 65536);
+
+    static bool is_enabled() noexcept
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Names the calling thread in exported traces.
+     */
+    static void set_thread_name(std::string_view name);
+
+    /**
+     * @brief Marks the start of a frame, called by timer::tick so markers match the frame time.
+     */
+    static void begin_frame(std::int64_t time) noexcept;
+
+    static std::uint32_t get_frame() noexcept;
+
+    static void begin_zone(
+        const char* name,
+        std::int64_t time = now(),
+        std::int64_t enqueue_time = 0) noexcept;
+    static void end_zone(std::int64_t time = now()) noexcept;
+
+    /**
+     * @brief Records an instant event, e.g. a task stolen by another thread. Instants are zones
+     * that end when they begin, Chrome traces show them as markers on the thread.
+     */
+    static void mark(const char* name, std::int64_t time = now()) noexcept;
+
+    /**
+     * @brief Copies the zones of frames in [first_frame, last_frame], of every thread or only of
+     * the calling thread, ordered by begin time per thread.
+     */
+    static std::vector<zone> get_zones(
+        std::uint32_t first_frame,
+        std::uint32_t last_frame,
+        bool calling_thread_only = false);
+
+    /**
+     * @brief Writes zones and frame markers of frames in [first_frame, last_frame] in the Chrome
+     * trace event format, which can be opened in chrome://tracing or Perfetto.
+     */
+    static void write_chrome_trace(
+        std::ostream& out,
+        std::uint32_t first_frame,
+        std::uint32_t last_frame);
+
+    /**
+     * @brief Compact little-endian capture of the same data: a "VPRF" header and version, a string
+     * table, frame markers, then the zones of every thread with name indexes into the table.
+     */
+    static void write_binary(
+        std::ostream& out,
+        std::uint32_t first_frame,
+        std::uint32_t last_frame);
+
+    static std::int64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    static inline std::atomic<bool> m_enabled{false};
+};
+
+class profile_zone
+{
+public:
+    profile_zone(const char* name) noexcept
+        : m_active(profiler::is_enabled())
+    {
+        if (m_active)
+        {
+            profiler::begin_zone(name);
+        }
+    }
+
+    profile_zone(const profile_zone&) = delete;
+
+    ~profile_zone()
+    {
+        if (m_active)
+        {
+            profiler::end_zone();
+        }
+    }
+
+    profile_zone& operator=(const profile_zone&) = delete;
+
+private:
+    bool m_active;
+};
+} // namespace violet
\ No newline at end of file
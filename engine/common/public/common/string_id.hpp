@@ -0,0 +1,73 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace violet
+{
+constexpr std::uint64_t hash_string(std::string_view str) noexcept
+{
+    // 64-bit FNV-1a.
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for (char c : str)
+    {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Integer identifier of a name. Literals are hashed at compile time, runtime strings are
+ * interned into a global table so get_string can map an id back to its name.
+ */
+class string_id
+{
+public:
+    constexpr string_id() noexcept = default;
+
+    template <std::size_t N>
+    consteval string_id(const char (&str)[N]) noexcept
+        : m_value(hash_string(std::string_view(str, N - 1)))
+    {
+    }
+
+    explicit string_id(std::string_view str);
+
+    /**
+     * @brief Returns the interned string, or an empty string if the id was only created from a
+     * literal and never interned.
+     */
+    [[nodiscard]] std::string_view get_string() const;
+
+    [[nodiscard]] constexpr std::uint64_t get_value() const noexcept
+    {
+        return m_value;
+    }
+
+    [[nodiscard]] constexpr bool is_empty() const noexcept
+    {
+        return m_value == EMPTY_VALUE;
+    }
+
+    constexpr bool operator==(const string_id& other) const noexcept = default;
+    constexpr std::strong_ordering operator<=>(const string_id& other) const noexcept = default;
+
+private:
+    static constexpr std::uint64_t EMPTY_VALUE = hash_string("");
+
+    std::uint64_t m_value{EMPTY_VALUE};
+};
+} // namespace violet
+
+template <>
+struct std::hash<violet::string_id>
+{
+    std::size_t operator()(const violet::string_id& id) const noexcept
+    {
+        return static_cast<std::size_t>(id.get_value());
+    }
+};
\ No newline at end of file
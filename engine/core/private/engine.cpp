@@ -1,8 +1,11 @@
 #include "core/engine.hpp"
+#include "common/frame_allocator.hpp"
 #include "common/log.hpp"
+#include "common/profiler.hpp"
 #include "engine_context.hpp"
 #include "task/task_graph_printer.hpp"
 #include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <ranges>
 
@@ -32,6 +35,18 @@ private:
     sleep_time_point m_time_point;
 };
 
+namespace
+{
+// A missing section reads as an empty object, so lookups in it fall back to their defaults.
+const dictionary& get_config_section(const dictionary& config, const char* name)
+{
+    static const dictionary empty = dictionary::object();
+
+    auto iter = config.find(name);
+    return iter != config.end() && iter->is_object() ? *iter : empty;
+}
+} // namespace
+
 system::system(std::string_view name) noexcept
     : m_name(name),
       m_context(nullptr)
@@ -87,6 +102,15 @@ application::application(std::string_view config_path)
         fin.close();
     }
 
+    // Enabled before any system is installed, so initialization shows up in captures.
+    profiler::set_thread_name("Main Thread");
+
+    const auto& profiler_config = get_config_section(m_config["engine"], "profiler");
+    if (profiler_config.value("enable", false))
+    {
+        profiler::set_enabled(true, profiler_config.value("zone_capacity", std::size_t{65536}));
+    }
+
     m_context = std::make_unique<engine_context>();
 }
 
@@ -100,30 +124,66 @@ void application::run()
     }
 
     m_exit = false;
+    m_run_begin = profiler::now();
+
+    const dictionary& engine_config = m_config["engine"];
+    const auto& headless_config = get_config_section(engine_config, "headless");
+    bool headless = headless_config.value("enable", false);
 
     frame_rater<60> frame_rater;
     timer& time = m_context->get_timer();
+    if (headless)
+    {
+        time.set_fixed_frame_delta(headless_config.value("delta_time", 1.0f / 60.0f));
+    }
     time.tick(timer::point::FRAME_START);
     time.tick(timer::point::FRAME_END);
 
     auto& executor = m_context->get_task_executor();
     auto& world = m_context->get_world();
 
-    m_context->get_task_graph().reset();
-    task_graph_printer::print(m_context->get_task_graph());
+    // Started before the systems are initialized, their loads run on the worker threads.
+    executor.run(engine_config.value("task_thread_count", std::size_t{0}));
 
-    executor.run(m_config["engine"]["task_thread_count"]);
+    initialize_systems();
 
-    while (!m_exit)
+    for (const auto& [name, rate] : get_config_section(engine_config, "tick_rates").items())
     {
-        time.tick(timer::point::FRAME_START);
+        // Groups of systems that are not installed, e.g. skipped in headless mode, are ignored.
+        task_group* group = m_context->get_task_graph().find_group(string_id(name));
+        if (group == nullptr)
+        {
+            log::warn("[engine] tick rate of unknown group {} is ignored.", name);
+            continue;
+        }
 
-        executor.execute_sync(m_context->get_task_graph());
-        world.add_version();
+        group->set_tick_rate(rate);
+    }
 
-        time.tick(timer::point::FRAME_END);
+    m_context->get_task_graph().reset();
+    if (!headless)
+    {
+        task_graph_printer::print(m_context->get_task_graph());
+    }
 
-        // frame_rater.sleep();
+    if (headless)
+    {
+        run_benchmark(headless_config);
+    }
+    else
+    {
+        if (!m_exit)
+        {
+            tick();
+            log::info("[engine] first frame after {:.2f}ms.", get_run_time());
+        }
+
+        while (!m_exit)
+        {
+            tick();
+
+            // frame_rater.sleep();
+        }
     }
 
     executor.stop();
@@ -145,18 +205,45 @@ void application::exit()
     m_exit = true;
 }
 
+bool application::is_headless() const
+{
+    auto iter = m_config.find("engine");
+    if (iter == m_config.end() || !iter->second.contains("headless"))
+    {
+        return false;
+    }
+
+    return iter->second["headless"].value("enable", false);
+}
+
 void application::install(std::size_t index, std::unique_ptr<system>&& system)
 {
-    system->m_context = m_context.get();
-    system->install(*this);
-    if (!system->initialize(m_config[system->get_name().data()]))
+    if (is_headless())
     {
-        throw std::runtime_error(system->get_name() + " initialize failed.");
+        dictionary skip_systems =
+            get_config_section(m_config["engine"], "headless").value("skip_systems", dictionary());
+        if (std::find(skip_systems.begin(), skip_systems.end(), system->get_name()) !=
+            skip_systems.end())
+        {
+            // Remembered so that installing it again, e.g. as a dependency, is a no-op.
+            m_skipped_systems.push_back(index);
+            log::info("[engine] {} skipped in headless mode.", system->get_name());
+            return;
+        }
     }
 
+    system->m_context = m_context.get();
+    system->install(*this);
+
     m_context->set_system(index, system.get());
     log::info("[engine] {} installed successfully.", system->get_name());
     m_systems.push_back(std::move(system));
+
+    // Systems installed before run are initialized together when the application starts.
+    if (!m_exit)
+    {
+        initialize_systems();
+    }
 }
 
 void application::uninstall(std::size_t index)
@@ -184,8 +271,382 @@ void application::uninstall(std::size_t index)
     }
 }
 
+void application::initialize_systems()
+{
+    struct startup_record
+    {
+        system* instance;
+        const dictionary* config;
+
+        // Nanoseconds, see profiler::now.
+        std::int64_t load_begin{0};
+        std::int64_t load_end{0};
+        std::int64_t initialize_begin{0};
+        std::int64_t initialize_end{0};
+
+        bool load_result{false};
+        std::exception_ptr load_exception;
+        std::atomic<bool> loaded{false};
+    };
+
+    std::vector<system*> systems;
+    for (const auto& system : m_systems)
+    {
+        if (!system->m_initialized)
+        {
+            systems.push_back(system.get());
+        }
+    }
+
+    if (systems.empty())
+    {
+        return;
+    }
+
+    std::int64_t startup_begin = profiler::now();
+
+    std::vector<startup_record> records(systems.size());
+    for (std::size_t i = 0; i < systems.size(); ++i)
+    {
+        records[i].instance = systems[i];
+        // Looked up on the main thread, the map must not be modified by the loads.
+        records[i].config = &m_config[systems[i]->get_name()];
+    }
+
+    // Dependencies on systems that are not installed or already initialized are satisfied.
+    std::vector<std::vector<std::size_t>> dependencies(systems.size());
+    for (std::size_t i = 0; i < systems.size(); ++i)
+    {
+        for (std::size_t index : systems[i]->m_dependencies)
+        {
+            if (!m_context->has_system(index))
+            {
+                continue;
+            }
+
+            auto iter = std::ranges::find(systems, m_context->get_system(index));
+            if (iter != systems.end() && *iter != systems[i])
+            {
+                dependencies[i].push_back(iter - systems.begin());
+            }
+        }
+    }
+
+    // Install order, except that a system is initialized after the systems it depends on.
+    std::vector<std::size_t> initialize_order;
+    std::vector<bool> ordered(systems.size(), false);
+    auto is_ready = [&](std::size_t i)
+    {
+        return !ordered[i] && std::ranges::all_of(
+                                  dependencies[i],
+                                  [&](std::size_t dependency)
+                                  {
+                                      return ordered[dependency];
+                                  });
+    };
+
+    while (initialize_order.size() < systems.size())
+    {
+        std::size_t next = 0;
+        while (next < systems.size() && !is_ready(next))
+        {
+            ++next;
+        }
+
+        if (next == systems.size())
+        {
+            throw std::runtime_error("Circular system dependency.");
+        }
+
+        initialize_order.push_back(next);
+        ordered[next] = true;
+    }
+
+    task_graph load_graph;
+    std::vector<task*> load_tasks(systems.size());
+    for (std::size_t i = 0; i < systems.size(); ++i)
+    {
+        startup_record& record = records[i];
+
+        task& load_task = load_graph.add_task();
+        load_task.set_name(systems[i]->get_name() + " Load")
+            .set_execute(
+                [&record]()
+                {
+                    profile_zone zone(record.instance->get_name().c_str());
+
+                    record.load_begin = profiler::now();
+                    try
+                    {
+                        record.load_result = record.instance->load(*record.config);
+                    }
+                    catch (...)
+                    {
+                        record.load_exception = std::current_exception();
+                    }
+                    record.load_end = profiler::now();
+
+                    record.loaded.store(true, std::memory_order_release);
+                    record.loaded.notify_one();
+                });
+        load_tasks[i] = &load_task;
+    }
+
+    for (std::size_t i = 0; i < systems.size(); ++i)
+    {
+        for (std::size_t dependency : dependencies[i])
+        {
+            load_tasks[i]->add_dependency(*load_tasks[dependency]);
+        }
+    }
+
+    std::future<void> load_future = m_context->get_task_executor().execute(load_graph);
+
+    // Initialization touches the world and the task graph, so it stays on the main thread and
+    // only waits for the load of the system it is about to initialize.
+    task_graph& task_graph = m_context->get_task_graph();
+    for (std::size_t i : initialize_order)
+    {
+        startup_record& record = records[i];
+
+        record.loaded.wait(false, std::memory_order_acquire);
+
+        if (record.load_exception != nullptr || !record.load_result)
+        {
+            load_future.get();
+
+            if (record.load_exception != nullptr)
+            {
+                std::rethrow_exception(record.load_exception);
+            }
+            throw std::runtime_error(record.instance->get_name() + " load failed.");
+        }
+
+        system& system = *record.instance;
+        system.m_task_begin = task_graph.get_task_count();
+
+        record.initialize_begin = profiler::now();
+        {
+            profile_zone zone(system.get_name().c_str());
+
+            if (!system.initialize(*record.config))
+            {
+                load_future.get();
+                throw std::runtime_error(system.get_name() + " initialize failed.");
+            }
+        }
+        record.initialize_end = profiler::now();
+
+        system.m_task_end = task_graph.get_task_count();
+        system.m_initialized = true;
+    }
+
+    load_future.get();
+
+    auto to_ms = [startup_begin](std::int64_t time)
+    {
+        return static_cast<double>(time - startup_begin) / 1000000.0;
+    };
+
+    log::info(
+        "[engine] {} systems initialized in {:.2f}ms.",
+        records.size(),
+        to_ms(profiler::now()));
+    for (const startup_record& record : records)
+    {
+        log::info(
+            "[engine]     {}: load {:.2f}ms - {:.2f}ms, initialize {:.2f}ms - {:.2f}ms.",
+            record.instance->get_name(),
+            to_ms(record.load_begin),
+            to_ms(record.load_end),
+            to_ms(record.initialize_begin),
+            to_ms(record.initialize_end));
+    }
+}
+
+void application::tick()
+{
+    timer& time = m_context->get_timer();
+    auto& executor = m_context->get_task_executor();
+    auto& world = m_context->get_world();
+
+    time.tick(timer::point::FRAME_START);
+
+    // No task of the frame graph is running, coroutines may touch frame state here.
+    executor.execute_main_thread_coroutines();
+
+    task_graph& task_graph = m_context->get_task_graph();
+    task_graph.advance(time.get_frame_delta());
+
+    executor.execute_sync(task_graph);
+    world.add_version();
+
+    // All tasks of the frame are done, nothing allocated from the frame arenas is alive.
+    frame_arena::reset();
+
+    time.tick(timer::point::FRAME_END);
+
+    if (profiler::is_enabled())
+    {
+        const auto& profiler_config = get_config_section(m_config["engine"], "profiler");
+        auto first_frame = profiler_config.value("first_frame", 100u);
+        auto frame_count = profiler_config.value("frame_count", 10u);
+
+        if (profiler::get_frame() == first_frame + frame_count - 1)
+        {
+            auto output = profiler_config.value("output", std::string("trace.json"));
+
+            if (profiler_config.value("format", std::string("json")) == "binary")
+            {
+                std::ofstream fout(output, std::ios::binary);
+                profiler::write_binary(fout, first_frame, profiler::get_frame());
+            }
+            else
+            {
+                std::ofstream fout(output);
+                profiler::write_chrome_trace(fout, first_frame, profiler::get_frame());
+            }
+            log::info("[engine] profiler capture saved: {}.", output);
+        }
+    }
+}
+
+void application::run_benchmark(const dictionary& config)
+{
+    auto frame_count = config.value("frame_count", 1000u);
+
+    // Tasks created while a system was initialized are timed as part of that system.
+    const auto& tasks = m_context->get_task_graph().get_tasks();
+
+    std::vector<std::vector<const task_wrapper*>> system_tasks(m_systems.size());
+    for (std::size_t i = 0; i < m_systems.size(); ++i)
+    {
+        const system& system = *m_systems[i];
+        for (std::uint32_t j = system.m_task_begin; j < system.m_task_end; ++j)
+        {
+            if (!tasks[j]->is_empty())
+            {
+                system_tasks[i].push_back(tasks[j].get());
+            }
+        }
+    }
+
+    std::vector<std::uint64_t> frame_times;
+    std::vector<std::vector<std::uint64_t>> system_times(m_systems.size());
+
+    frame_times.reserve(frame_count);
+    for (auto& times : system_times)
+    {
+        times.reserve(frame_count);
+    }
+
+    log::info("[engine] headless benchmark: {} frames.", frame_count);
+
+    double first_frame_time = 0.0;
+
+    for (std::uint32_t frame = 0; frame < frame_count && !m_exit; ++frame)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        tick();
+        auto end = std::chrono::steady_clock::now();
+
+        frame_times.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+
+        if (frame == 0)
+        {
+            first_frame_time = get_run_time();
+        }
+
+        for (std::size_t i = 0; i < system_tasks.size(); ++i)
+        {
+            std::uint64_t time = 0;
+            for (const task_wrapper* task : system_tasks[i])
+            {
+                time += task->last_duration;
+            }
+            system_times[i].push_back(time);
+        }
+    }
+
+    auto get_statistics = [](std::vector<std::uint64_t> samples)
+    {
+        dictionary result;
+        if (samples.empty())
+        {
+            return result;
+        }
+
+        std::ranges::sort(samples);
+
+        auto to_ms = [](std::uint64_t time)
+        {
+            return static_cast<double>(time) / 1000000.0;
+        };
+
+        // Nearest rank percentile.
+        auto percentile = [&](double p)
+        {
+            double rank = std::ceil(p * static_cast<double>(samples.size()));
+            return to_ms(samples[std::max<std::size_t>(static_cast<std::size_t>(rank), 1) - 1]);
+        };
+
+        std::uint64_t total = 0;
+        for (std::uint64_t sample : samples)
+        {
+            total += sample;
+        }
+
+        result["mean_ms"] = to_ms(total) / static_cast<double>(samples.size());
+        result["p50_ms"] = percentile(0.5);
+        result["p99_ms"] = percentile(0.99);
+        result["min_ms"] = to_ms(samples.front());
+        result["max_ms"] = to_ms(samples.back());
+        return result;
+    };
+
+    dictionary report;
+    report["frame_count"] = frame_times.size();
+    report["delta_time"] = config.value("delta_time", 1.0f / 60.0f);
+    report["thread_count"] = m_context->get_task_executor().get_thread_count();
+    // Startup included, from run to the end of the first frame.
+    report["first_frame_ms"] = first_frame_time;
+    report["frame"] = get_statistics(frame_times);
+
+    // System times are CPU time summed over their tasks, which may overlap on worker threads.
+    dictionary& systems = report["systems"];
+    systems = dictionary::object();
+    for (std::size_t i = 0; i < m_systems.size(); ++i)
+    {
+        if (!system_tasks[i].empty())
+        {
+            systems[m_systems[i]->get_name()] = get_statistics(system_times[i]);
+        }
+    }
+
+    auto output = config.value("output", std::string("benchmark.json"));
+    std::ofstream fout(output);
+    fout << report.dump(4);
+
+    log::info(
+        "[engine] headless benchmark saved: {}, frame p50 {:.3f}ms, p99 {:.3f}ms.",
+        output,
+        report["frame"].value("p50_ms", 0.0),
+        report["frame"].value("p99_ms", 0.0));
+}
+
+double application::get_run_time() const noexcept
+{
+    return static_cast<double>(profiler::now() - m_run_begin) / 1000000.0;
+}
+
 bool application::has_system(std::size_t index) const noexcept
 {
     return m_context->has_system(index);
 }
+
+bool application::is_skipped(std::size_t index) const noexcept
+{
+    return std::ranges::find(m_skipped_systems, index) != m_skipped_systems.end();
+}
 } // namespace violet
\ No newline at end of file
@@ -21,6 +21,17 @@ public:
     virtual ~system() = default;
 
     virtual void install(application& app) {}
+
+    /**
+     * @brief Expensive startup work that only touches the system itself, e.g. loading plugins or
+     * creating devices. Loads run on the worker threads concurrently with the loads of other
+     * systems, before initialize is called on the main thread.
+     */
+    virtual bool load(const dictionary& config)
+    {
+        return true;
+    }
+
     virtual bool initialize(const dictionary& config)
     {
         return true;
@@ -45,6 +56,17 @@ protected:
     task_graph& get_task_graph() noexcept;
     task_executor& get_task_executor() noexcept;
 
+    /**
+     * @brief The load of this system starts after the loads of T have finished, and its initialize
+     * runs after theirs, e.g. because it uses their tasks or devices. Systems that are not
+     * installed are ignored.
+     */
+    template <typename... T>
+    void add_dependency()
+    {
+        (m_dependencies.push_back(system_index::value<T>()), ...);
+    }
+
 private:
     friend class application;
 
@@ -52,6 +74,13 @@ private:
 
     std::string m_name;
     engine_context* m_context;
+
+    std::vector<std::size_t> m_dependencies;
+    bool m_initialized{false};
+
+    // Range of the tasks added while the system was initialized.
+    std::uint32_t m_task_begin{0};
+    std::uint32_t m_task_end{0};
 };
 
 template <typename T>
@@ -63,11 +92,16 @@ public:
     application(std::string_view config_path = "");
     ~application();
 
+    /**
+     * @brief Systems installed before run are only constructed and installed here, they are loaded
+     * and initialized together when run starts. Systems installed while the application is running
+     * are initialized before install returns.
+     */
     template <derived_from_system T, typename... Args>
     void install(Args&&... args)
     {
         std::size_t index = system_index::value<T>();
-        if (!has_system(index))
+        if (!has_system(index) && !is_skipped(index))
         {
             install(index, std::make_unique<T>(std::forward<Args>(args)...));
         }
@@ -76,16 +110,47 @@ public:
     void run();
     void exit();
 
+    /**
+     * @brief Headless runs skip window and RHI systems and step the world a fixed number of frames
+     * with a fixed delta time, see engine.headless in the config.
+     */
+    bool is_headless() const;
+
 private:
     void install(std::size_t index, std::unique_ptr<system>&& system);
     void uninstall(std::size_t index);
 
     bool has_system(std::size_t index) const noexcept;
+    bool is_skipped(std::size_t index) const noexcept;
+
+    /**
+     * @brief Loads every system that is not initialized yet on the task executor, then initializes
+     * them on the main thread in install order, dependencies first, and logs the startup timeline.
+     */
+    void initialize_systems();
+
+    void tick();
+
+    /**
+     * @brief Runs the configured number of frames as fast as possible and writes frame and per
+     * system timing statistics as JSON.
+     */
+    void run_benchmark(const dictionary& config);
+
+    /**
+     * @brief Milliseconds since run was called, logged as the time to the first frame.
+     */
+    double get_run_time() const noexcept;
 
     std::map<std::string, dictionary> m_config;
     std::vector<std::unique_ptr<system>> m_systems;
+    // Systems not installed because the application runs headless.
+    std::vector<std::size_t> m_skipped_systems;
 
     std::unique_ptr<engine_context> m_context;
     std::atomic<bool> m_exit{true};
+
+    // Nanoseconds, see profiler::now.
+    std::int64_t m_run_begin{0};
 };
 } // namespace violet
\ No newline at end of file
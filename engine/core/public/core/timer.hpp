@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/profiler.hpp"
 #include <array>
 #include <chrono>
 
@@ -34,6 +35,13 @@ public:
         }
 
         m_time_point[point] = now<std::chrono::steady_clock>();
+
+        if (point == FRAME_START)
+        {
+            profiler::begin_frame(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      m_time_point[point].time_since_epoch())
+                                      .count());
+        }
     }
 
     steady_time_point time_point(point point) const noexcept
@@ -49,10 +57,24 @@ public:
 
     float get_frame_delta() const noexcept
     {
+        if (m_fixed_frame_delta > 0.0f)
+        {
+            return m_fixed_frame_delta;
+        }
+
         return static_cast<float>(get_delta(PRE_FRAME_START, FRAME_START).count()) * 0.000000001f;
     }
 
+    /**
+     * @brief Makes get_frame_delta return a constant simulated step, 0 restores the measured one.
+     */
+    void set_fixed_frame_delta(float delta) noexcept
+    {
+        m_fixed_frame_delta = delta;
+    }
+
 private:
     std::array<steady_time_point, NUM_TIME_POINT> m_time_point;
+    float m_fixed_frame_delta{0.0f};
 };
 } // namespace violet
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "ecs/world.hpp"
 #include "archetype_chunk.hpp"
+#include "common/frame_allocator.hpp"
 
 namespace violet
 {
@@ -64,11 +65,11 @@ void world::execute(std::span<world_command*> commands)
     {
         bool destroyed{false};
         component_mask mask;
-        std::vector<component_id> components;
-        std::vector<void*> component_data;
+        frame_vector<component_id> components;
+        frame_vector<void*> component_data;
     };
-    std::unordered_map<entity_id, entity_state> normal_entity_states;
-    std::vector<entity_state> temp_entity_states;
+    frame_unordered_map<entity_id, entity_state> normal_entity_states;
+    frame_vector<entity_state> temp_entity_states;
 
     auto get_state = [&, this](entity e) -> entity_state&
     {
@@ -85,7 +86,13 @@ void world::execute(std::span<world_command*> commands)
             entity_state state = {};
             state.destroyed = false;
             state.mask = archetype->get_mask();
-            state.components = archetype->get_component_ids();
+            for (component_id id = 0; id < state.mask.size(); ++id)
+            {
+                if (state.mask.test(id))
+                {
+                    state.components.push_back(id);
+                }
+            }
             state.component_data.resize(state.components.size());
 
             normal_entity_states[e.id] = state;
@@ -103,7 +110,7 @@ void world::execute(std::span<world_command*> commands)
         auto iter = m_archetypes.find(state.mask);
         if (iter == m_archetypes.cend())
         {
-            std::vector<component_id> components;
+            frame_vector<component_id> components;
             for (component_id component_id : state.components)
             {
                 if (state.mask.test(component_id))
@@ -1,12 +1,12 @@
 #pragma once
 
+#include "common/flat_map.hpp"
 #include "ecs/entity.hpp"
 #include "ecs/view.hpp"
 #include "ecs/world_command.hpp"
 #include <queue>
 #include <span>
 #include <thread>
-#include <unordered_map>
 
 namespace violet
 {
@@ -318,7 +318,7 @@ private:
     std::uint32_t m_world_version{1};
 
     std::unique_ptr<archetype_chunk_allocator> m_archetype_chunk_allocator;
-    std::unordered_map<component_mask, std::unique_ptr<archetype>> m_archetypes;
+    flat_map<component_mask, std::unique_ptr<archetype>> m_archetypes;
 
     std::array<component_info, MAX_COMPONENT_TYPE> m_components;
     std::vector<entity_info> m_entities;
@@ -1,4 +1,7 @@
 #include "graphics/dds.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <fstream>
 
 namespace violet
@@ -322,6 +325,60 @@ bool is_compressed_format(rhi_format format)
         return false;
     }
 }
+
+// Fills everything but the pixels, returns the offset of the pixels or 0 if the headers are
+// invalid.
+std::size_t read_headers(std::span<const char> file, texture_data& data)
+{
+    std::size_t offset = 0;
+
+    auto read = [&](void* dst, std::size_t size)
+    {
+        if (offset + size > file.size())
+        {
+            return false;
+        }
+
+        std::memcpy(dst, file.data() + offset, size);
+        offset += size;
+        return true;
+    };
+
+    std::uint32_t magic_number;
+    if (!read(&magic_number, sizeof(std::uint32_t)) || magic_number != MAGIC_NUMBER)
+    {
+        return 0;
+    }
+
+    dds_header header;
+    if (!read(&header, sizeof(dds_header)))
+    {
+        return 0;
+    }
+
+    data.extent.width = header.dwWidth;
+    data.extent.height = header.dwHeight;
+    data.extent.depth = header.dwDepth > 0 ? header.dwDepth : 1;
+    data.level_count = header.dwMipMapCount > 0 ? header.dwMipMapCount : 1;
+
+    if (header.ddspf.dwFlags == DDPF_FOURCC && header.ddspf.dwFourCC == FOURCC_DX10)
+    {
+        dds_header_dxt10 header_dxt10;
+        if (!read(&header_dxt10, sizeof(dds_header_dxt10)))
+        {
+            return 0;
+        }
+
+        data.format = get_rhi_format(header_dxt10.dxgiFormat);
+        data.layer_count = header_dxt10.arraySize;
+    }
+    else
+    {
+        data.layer_count = 1;
+    }
+
+    return offset;
+}
 } // namespace
 
 bool dds::save(std::string_view path, const texture_data& data)
@@ -391,52 +448,43 @@ bool dds::save(std::string_view path, const texture_data& data)
 
 bool dds::load(std::string_view path, texture_data& data)
 {
-    std::ifstream fin(std::string(path), std::ios::binary);
+    std::ifstream fin(std::string(path), std::ios::binary | std::ios::ate);
     if (!fin.is_open())
     {
         return false;
     }
 
-    std::uint32_t magic_number;
-    fin.read(reinterpret_cast<char*>(&magic_number), sizeof(std::uint32_t));
+    auto file_size = static_cast<std::size_t>(fin.tellg());
+    fin.seekg(0);
+
+    // Only the headers go through a separate buffer, the pixels are read in place.
+    std::array<char, sizeof(std::uint32_t) + sizeof(dds_header) + sizeof(dds_header_dxt10)>
+        headers = {};
+    std::size_t headers_size = std::min(headers.size(), file_size);
+    fin.read(headers.data(), static_cast<std::streamsize>(headers_size));
 
-    if (magic_number != MAGIC_NUMBER)
+    std::size_t offset = read_headers(std::span<const char>(headers.data(), headers_size), data);
+    if (fin.fail() || offset == 0)
     {
         return false;
     }
 
-    dds_header header;
-    fin.read(reinterpret_cast<char*>(&header), sizeof(dds_header));
+    data.pixels.resize(file_size - offset);
+    fin.seekg(static_cast<std::streamoff>(offset));
+    fin.read(data.pixels.data(), static_cast<std::streamsize>(data.pixels.size()));
 
-    data.extent.width = header.dwWidth;
-    data.extent.height = header.dwHeight;
-    data.extent.depth = header.dwDepth > 0 ? header.dwDepth : 1;
-    data.level_count = header.dwMipMapCount > 0 ? header.dwMipMapCount : 1;
-
-    if (header.ddspf.dwFlags == DDPF_FOURCC && header.ddspf.dwFourCC == FOURCC_DX10)
-    {
-        dds_header_dxt10 header_dxt10;
-        fin.read(reinterpret_cast<char*>(&header_dxt10), sizeof(dds_header_dxt10));
+    return !fin.fail();
+}
 
-        data.format = get_rhi_format(header_dxt10.dxgiFormat);
-        data.layer_count = header_dxt10.arraySize;
-    }
-    else
+bool dds::load(std::span<const char> file, texture_data& data)
+{
+    std::size_t offset = read_headers(file, data);
+    if (offset == 0)
     {
-        data.layer_count = 1;
+        return false;
     }
 
-    std::streampos current = fin.tellg();
-
-    fin.seekg(0, std::ios::end);
-    std::streampos end = fin.tellg();
-
-    std::streampos remaining = end - current;
-
-    fin.seekg(current);
-
-    data.pixels.resize(static_cast<std::size_t>(remaining));
-    fin.read(data.pixels.data(), remaining);
+    data.pixels.assign(file.begin() + static_cast<std::ptrdiff_t>(offset), file.end());
 
     return true;
 }
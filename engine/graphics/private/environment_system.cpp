@@ -3,6 +3,7 @@
 #include "components/light_component_meta.hpp"
 #include "components/scene_component.hpp"
 #include "components/skybox_component_meta.hpp"
+#include "graphics/graphics_system.hpp"
 #include "graphics/render_graph/render_graph.hpp"
 #include "graphics/renderers/passes/ibl_pass.hpp"
 
@@ -272,6 +273,8 @@ private:
 environment_system::environment_system()
     : system("environment")
 {
+    // The render device is created by graphics, shaders are prepared in initialize.
+    add_dependency<graphics_system>();
 }
 
 bool environment_system::initialize(const dictionary& config)
@@ -282,6 +285,14 @@ bool environment_system::initialize(const dictionary& config)
     world.register_component<atmosphere_component>();
     world.register_component<atmosphere_component_meta>();
 
+    // Only needed once a skybox or an atmosphere is added, so they are prepared in the background.
+    // A pass that gets there first compiles its shader synchronously.
+    auto& executor = get_task_executor();
+    auto& device = render_device::instance();
+    executor.execute(device.get_shader_async<hdri_convert_cs>(executor));
+    executor.execute(device.get_shader_async<transmittance_lut_cs>(executor));
+    executor.execute(device.get_shader_async<multi_scattering_lut_cs>(executor));
+
     return true;
 }
 
@@ -184,17 +184,17 @@ void geometry::add_morph_target(std::string_view name, const std::vector<morph_e
 }
 
 void geometry::set_additional_buffer(
-    std::string_view name,
+    string_id name,
     const void* data,
     std::size_t size,
     rhi_buffer_flags flags)
 {
     m_additional_buffers.insert_or_assign(
-        std::string(name),
+        name,
         std::make_unique<raw_buffer>(data, size, flags));
 }
 
-raw_buffer* geometry::get_additional_buffer(std::string_view name) const
+raw_buffer* geometry::get_additional_buffer(string_id name) const
 {
     auto iter = m_additional_buffers.find(name);
     return iter == m_additional_buffers.end() ? nullptr : iter->second.get();
@@ -1,7 +1,7 @@
 #pragma once
 
+#include "common/flat_map.hpp"
 #include "graphics/render_device.hpp"
-#include <unordered_map>
 
 namespace violet
 {
@@ -75,7 +75,6 @@ private:
     };
     std::vector<upload_command> m_upload_commands;
 
-    std::unordered_map<rhi_buffer*, std::pair<rhi_pipeline_stage_flags, rhi_access_flags>>
-        m_dst_buffers;
+    flat_map<rhi_buffer*, std::pair<rhi_pipeline_stage_flags, rhi_access_flags>> m_dst_buffers;
 };
 } // namespace violet
\ No newline at end of file
@@ -9,24 +9,51 @@
 #include "graphics/graphics_config.hpp"
 #include "graphics/material_manager.hpp"
 #include "graphics/renderer.hpp"
+#include "graphics/resources/spatiotemporal_blue_noise.hpp"
+#include "graphics/texture_loader.hpp"
 #include "light_system.hpp"
 #include "mesh_system.hpp"
 #include "render_scene_manager.hpp"
 #include "rhi_plugin.hpp"
+#include "scene/hierarchy_system.hpp"
 #include "scene/scene_system.hpp"
 #include "skinning_system.hpp"
 #include "virtual_shadow_map/vsm_manager.hpp"
+#include "window/window_system.hpp"
 #include <algorithm>
 
 namespace violet
 {
+namespace
+{
+// Completes on the main thread, see texture_loader::load_async.
+template <typename T>
+async_task<void> stream_global_texture(task_executor& executor)
+{
+    rhi_ptr<rhi_texture> texture =
+        co_await texture_loader::load_async(executor, std::string(T::path));
+    if (texture != nullptr)
+    {
+        render_device::instance().set_texture(std::make_unique<T>(std::move(texture)));
+    }
+}
+} // namespace
+
 graphics_system::graphics_system()
     : system("graphics")
 {
+    // Frames begin after the window update and rendering waits for the transform group.
+    add_dependency<window_system, hierarchy_system>();
 }
 
 graphics_system::~graphics_system()
 {
+    // Nothing was created if the system was skipped in headless mode before it was loaded.
+    if (m_plugin == nullptr)
+    {
+        return;
+    }
+
 #ifndef NDEBUG
     m_debug_drawer = nullptr;
 #endif
@@ -51,24 +78,24 @@ void graphics_system::install(application& app)
     app.install<environment_system>();
 }
 
+bool graphics_system::load(const dictionary& config)
+{
+    m_plugin = std::make_unique<rhi_plugin>();
+    m_plugin->load(config["rhi"]);
+
+    return m_plugin->get_rhi()->initialize({
+        .features = RHI_FEATURE_INDIRECT_DRAW | RHI_FEATURE_BINDLESS,
+        .frame_resource_count = config["frame_resource_count"],
+    });
+}
+
 bool graphics_system::initialize(const dictionary& config)
 {
     graphics_config::instance().initialize(
         config["max_draw_commands"],
         config["max_candidate_clusters"]);
 
-    m_plugin = std::make_unique<rhi_plugin>();
-    m_plugin->load(config["rhi"]);
-
-    if (!m_plugin->get_rhi()->initialize({
-            .features = RHI_FEATURE_INDIRECT_DRAW | RHI_FEATURE_BINDLESS,
-            .frame_resource_count = config["frame_resource_count"],
-        }))
-    {
-        return false;
-    }
-
-    render_device::instance().initialize(m_plugin->get_rhi());
+    render_device::instance().initialize(m_plugin->get_rhi(), get_task_executor());
 
     auto& task_graph = get_task_graph();
     auto& pre_update_group = task_graph.get_group("PreUpdate");
@@ -154,6 +181,12 @@ bool graphics_system::initialize(const dictionary& config)
     };
     device.create_parameter(parameter_desc);
 
+    // Streamed in while the first frames render, passes that need them earlier load them
+    // synchronously and the streamed copy is dropped.
+    auto& executor = get_task_executor();
+    executor.execute(stream_global_texture<spatiotemporal_blue_noise>(executor));
+    executor.execute(stream_global_texture<spatiotemporal_blue_noise_cosine>(executor));
+
     return true;
 }
 
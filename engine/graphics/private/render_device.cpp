@@ -5,7 +5,6 @@
 #include "graphics/resources/texture.hpp"
 #include "shader_compiler.hpp"
 #include "transient_allocator.hpp"
-#include <fstream>
 
 namespace violet
 {
@@ -84,9 +83,10 @@ render_device& render_device::instance()
     return instance;
 }
 
-void render_device::initialize(rhi* rhi)
+void render_device::initialize(rhi* rhi, task_executor& executor)
 {
     m_rhi = rhi;
+    m_executor = &executor;
     m_rhi_deleter = rhi_deleter(rhi);
 
     m_shader_compiler = std::make_unique<shader_compiler>();
@@ -365,25 +365,26 @@ void render_device::create_global_resources()
     assert(m_global_samplers[5]->get_bindless() == 5);
 }
 
-std::vector<std::uint8_t> render_device::compile_shader(
-    std::string_view path,
-    std::string_view entry_point,
-    rhi_shader_stage_flag stage,
-    std::span<const std::wstring> defines)
+std::vector<char> render_device::read_shader(std::string_view path)
 {
-    std::ifstream fin(std::string(path), std::ios::binary);
-    if (!fin.is_open())
+    // Passes that compile shaders run on the workers, the wait helps with other jobs so the read
+    // can resume even if every worker is waiting.
+    std::vector<char> source;
+    if (!m_executor->wait(
+            m_executor->execute(async_file::read(*m_executor, std::string(path), source))))
     {
         throw std::runtime_error("Failed to open file!");
     }
 
-    fin.seekg(0, std::ios::end);
-
-    std::vector<char> source(fin.tellg());
-    fin.seekg(0);
-    fin.read(source.data(), static_cast<std::streamsize>(source.size()));
-    fin.close();
+    return source;
+}
 
+std::vector<std::uint8_t> render_device::compile_shader(
+    std::span<char> source,
+    std::string_view entry_point,
+    rhi_shader_stage_flag stage,
+    std::span<const std::wstring> defines)
+{
     std::vector<const wchar_t*> arguments = {
         L"-I",
         L"assets/shaders",
@@ -10,7 +10,7 @@ namespace
 struct render_pass
 {
     rdg_pass* pass;
-    std::vector<rdg_reference*> attachments;
+    frame_vector<rdg_reference*> attachments;
 
     bool is_mergeable(const render_pass& other) const noexcept
     {
@@ -702,7 +702,7 @@ void render_graph::allocate_resources()
 
 void render_graph::merge_passes()
 {
-    std::vector<render_pass> pending_merge_passes;
+    frame_vector<render_pass> pending_merge_passes;
 
     auto flush_merge_passes = [&]()
     {
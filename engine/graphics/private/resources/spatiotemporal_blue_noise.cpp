@@ -5,25 +5,33 @@ namespace violet
 {
 spatiotemporal_blue_noise::spatiotemporal_blue_noise()
 {
-    auto texture = texture_loader::load("assets/textures/stbn_vec3_2Dx1D_128x128x64.dds");
+    auto texture = texture_loader::load(path);
     if (texture == nullptr)
     {
-        throw std::runtime_error("Failed to load assets/textures/stbn_vec3_2Dx1D_128x128x64.dds.");
+        throw std::runtime_error("Failed to load " + std::string(path) + ".");
     }
 
     set_texture(std::move(texture));
 }
 
+spatiotemporal_blue_noise::spatiotemporal_blue_noise(rhi_ptr<rhi_texture>&& texture)
+{
+    set_texture(std::move(texture));
+}
+
 spatiotemporal_blue_noise_cosine::spatiotemporal_blue_noise_cosine()
 {
-    auto texture =
-        texture_loader::load("assets/textures/stbn_unitvec3_cosine_2Dx1D_128x128x64.dds");
+    auto texture = texture_loader::load(path);
     if (texture == nullptr)
     {
-        throw std::runtime_error(
-            "Failed to load assets/textures/stbn_unitvec3_cosine_2Dx1D_128x128x64.dds.");
+        throw std::runtime_error("Failed to load " + std::string(path) + ".");
     }
 
     set_texture(std::move(texture));
 }
+
+spatiotemporal_blue_noise_cosine::spatiotemporal_blue_noise_cosine(rhi_ptr<rhi_texture>&& texture)
+{
+    set_texture(std::move(texture));
+}
 } // namespace violet
\ No newline at end of file
@@ -1,10 +1,87 @@
 #include "graphics/texture_loader.hpp"
 #include "graphics/dds.hpp"
+#include "task/async_file.hpp"
 #include <cstddef>
 
 namespace violet
 {
 rhi_ptr<rhi_texture> texture_loader::load(const texture_data& data, load_options options)
+{
+    rhi_command* command = render_device::instance().allocate_command();
+    rhi_ptr<rhi_texture> texture = create(data, options, command);
+    render_device::instance().execute_sync(command);
+
+    return texture;
+}
+
+rhi_ptr<rhi_texture> texture_loader::load(std::string_view path)
+{
+    assert(path.ends_with(".dds"));
+
+    texture_data data;
+    if (!dds::load(path, data))
+    {
+        return nullptr;
+    }
+
+    return load(data);
+}
+
+async_task<rhi_ptr<rhi_texture>> texture_loader::load_async(
+    task_executor& executor,
+    std::string path,
+    load_options options)
+{
+    assert(path.ends_with(".dds"));
+
+    std::vector<char> file;
+    if (!co_await async_file::read(executor, path, file))
+    {
+        co_return nullptr;
+    }
+
+    texture_data data;
+    if (!dds::load(std::span<const char>(file), data))
+    {
+        co_return nullptr;
+    }
+
+    // The render device is not thread safe, commands are recorded between frames.
+    co_await executor.switch_to_main_thread();
+
+    rhi_command* command = render_device::instance().allocate_command();
+    rhi_ptr<rhi_texture> texture = create(data, options, command);
+
+    rhi_ptr<rhi_fence> fence = render_device::instance().create_fence();
+
+    execute_batch batch = {
+        .commands = {command},
+        .signal_fences = {{
+            .fence = fence.get(),
+            .stages = RHI_PIPELINE_STAGE_TRANSFER,
+            .value = 1,
+        }},
+    };
+    render_device::instance().execute(std::span<execute_batch>(&batch, 1));
+
+    rhi_fence* upload_fence = fence.get();
+    co_await executor.poll(
+        [upload_fence]()
+        {
+            return upload_fence->get_value() >= 1;
+        });
+
+    // The fence goes back to the device on the main thread as well.
+    co_await executor.switch_to_main_thread();
+    fence = nullptr;
+
+    co_return texture;
+}
+
+rhi_ptr<rhi_texture> texture_loader::create(
+    const texture_data& data,
+    load_options options,
+    rhi_command* command)
 {
     rhi_extent extent = data.extent;
 
@@ -24,8 +101,6 @@ rhi_ptr<rhi_texture> texture_loader::load(const texture_data& data, load_options
 
     rhi_ptr<rhi_texture> texture = render_device::instance().create_texture(texture_desc);
 
-    rhi_command* command = render_device::instance().allocate_command();
-
     upload(command, data, texture.get());
 
     rhi_texture_barrier texture_barrier = {
@@ -45,24 +120,9 @@ rhi_ptr<rhi_texture> texture_loader::load(const texture_data& data, load_options
 
     command->set_pipeline_barrier(nullptr, 0, &texture_barrier, 1);
 
-    render_device::instance().execute_sync(command);
-
     return texture;
 }
 
-rhi_ptr<rhi_texture> texture_loader::load(std::string_view path)
-{
-    assert(path.ends_with(".dds"));
-
-    texture_data data;
-    if (!dds::load(path, data))
-    {
-        return nullptr;
-    }
-
-    return load(data);
-}
-
 void texture_loader::upload(rhi_command* command, const texture_data& data, rhi_texture* texture)
 {
     rhi_ptr<rhi_buffer> staging_buffer = render_device::instance().create_buffer({
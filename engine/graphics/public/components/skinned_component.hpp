@@ -1,14 +1,14 @@
 #pragma once
 
+#include "common/string_id.hpp"
 #include "graphics/render_interface.hpp"
-#include <string>
 #include <vector>
 
 namespace violet
 {
 struct skinned_component
 {
-    std::vector<std::string> inputs;
+    std::vector<string_id> inputs;
     rhi_shader* shader;
 };
 } // namespace violet
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "graphics/resources/texture.hpp"
+#include <span>
 
 namespace violet
 {
@@ -9,5 +10,6 @@ class dds
 public:
     static bool save(std::string_view path, const texture_data& data);
     static bool load(std::string_view path, texture_data& data);
+    static bool load(std::span<const char> file, texture_data& data);
 };
 } // namespace violet
\ No newline at end of file
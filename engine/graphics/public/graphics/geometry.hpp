@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common/container.hpp"
+#include "common/string_id.hpp"
 #include "graphics/cluster.hpp"
 #include "graphics/morph_target.hpp"
 #include "graphics/render_device.hpp"
@@ -138,12 +139,12 @@ public:
     }
 
     void set_additional_buffer(
-        std::string_view name,
+        string_id name,
         const void* data,
         std::size_t size,
         rhi_buffer_flags flags);
 
-    raw_buffer* get_additional_buffer(std::string_view name) const;
+    raw_buffer* get_additional_buffer(string_id name) const;
 
     render_id get_id() const noexcept
     {
@@ -203,7 +204,7 @@ private:
     std::uint32_t m_vertex_count{0};
     std::uint32_t m_index_count{0};
 
-    string_map<std::unique_ptr<raw_buffer>> m_additional_buffers;
+    flat_map<string_id, std::unique_ptr<raw_buffer>> m_additional_buffers;
 
     std::vector<submesh> m_submeshes;
     std::vector<render_id> m_submesh_ids;
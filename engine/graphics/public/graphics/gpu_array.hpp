@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common/allocator.hpp"
+#include "common/frame_allocator.hpp"
 #include "graphics/resources/buffer.hpp"
 
 namespace violet
@@ -105,7 +106,8 @@ public:
 
         if (update_all || need_resize)
         {
-            std::vector<gpu_type> gpu_datas;
+            frame_vector<gpu_type> gpu_datas;
+            gpu_datas.reserve(m_index_to_id.size());
 
             for (render_id id : m_index_to_id)
             {
@@ -344,7 +346,8 @@ public:
 
         if (update_all || need_resize)
         {
-            std::vector<gpu_type> gpu_datas;
+            frame_vector<gpu_type> gpu_datas;
+            gpu_datas.reserve(m_objects.size());
 
             for (auto& wrapper : m_objects)
             {
@@ -555,7 +558,8 @@ public:
 
         if (update_all || need_resize)
         {
-            std::vector<gpu_type> gpu_datas;
+            frame_vector<gpu_type> gpu_datas;
+            gpu_datas.reserve(m_objects.size());
 
             for (auto& wrapper : m_objects)
             {
@@ -23,6 +23,7 @@ public:
     virtual ~graphics_system();
 
     void install(application& app) override;
+    bool load(const dictionary& config) override;
     bool initialize(const dictionary& config) override;
 
 #ifndef NDEBUG
@@ -4,6 +4,7 @@
 #include "common/type_index.hpp"
 #include "graphics/pipeline_state.hpp"
 #include "graphics/shader.hpp"
+#include "task/async_file.hpp"
 #include <memory>
 #include <span>
 #include <string>
@@ -63,7 +64,10 @@ public:
 
     static render_device& instance();
 
-    void initialize(rhi* rhi);
+    /**
+     * @brief Shader sources are read through the io service of the executor.
+     */
+    void initialize(rhi* rhi, task_executor& executor);
     void reset();
 
     rhi_command* allocate_command();
@@ -95,39 +99,44 @@ public:
             return iter->second.get();
         }
 
-        auto code = compile_shader(T::path, T::entry_point, T::stage, defines);
-
-        rhi_shader_desc desc = {
-            .code = code.data(),
-            .code_size = static_cast<std::uint32_t>(code.size()),
-            .stage = T::stage,
-            .entry_point = T::entry_point.data(),
-        };
+        std::vector<char> source = read_shader(T::path);
+        return create_shader<T>(std::move(key), source);
+    }
 
-        if constexpr (has_inputs<T>)
+    /**
+     * @brief Reads the shader source through the executor's io service, so shaders that are needed
+     * later can be prepared while frames render. The shader is compiled on the main thread, where
+     * the shader cache is used, and the task completes there.
+     *
+     * @return Returns nullptr if the source could not be read.
+     */
+    template <typename T>
+    async_task<rhi_shader*> get_shader_async(
+        task_executor& executor,
+        std::vector<std::wstring> defines = {})
+    {
+        std::vector<char> source;
+        if (!co_await async_file::read(executor, std::string(T::path), source))
         {
-            desc.vertex.attributes = T::inputs.attributes;
-            desc.vertex.attribute_count = T::inputs.attribute_count;
+            co_return nullptr;
         }
 
-        if constexpr (has_parameters<T>)
-        {
-            desc.parameters = T::parameters.parameters;
-            desc.parameter_count = T::parameters.parameter_count;
-        }
+        co_await executor.switch_to_main_thread();
 
-        if constexpr (has_constant<T>)
+        shader_key key = {
+            .path = std::string(T::path),
+            .entry_point = std::string(T::entry_point),
+            .stage = T::stage,
+            .defines = std::move(defines),
+        };
+
+        auto iter = m_shaders.find(key);
+        if (iter != m_shaders.end())
         {
-            desc.push_constant_size = sizeof(T::constant_data);
+            co_return iter->second.get();
         }
 
-        auto shader = rhi_ptr<rhi_shader>(m_rhi->create_shader(desc), m_rhi_deleter);
-        shader->set_name(T::path.data());
-
-        rhi_shader* result = shader.get();
-        m_shaders[key] = std::move(shader);
-
-        return result;
+        co_return create_shader<T>(std::move(key), source);
     }
 
     material_manager* get_material_manager() const noexcept
@@ -251,6 +260,25 @@ public:
         return static_cast<T*>(m_global_textures[index].get());
     }
 
+    /**
+     * @brief Installs a global texture loaded elsewhere, e.g. streamed in with
+     * texture_loader::load_async. Does nothing if get_texture already created it.
+     */
+    template <typename T>
+    void set_texture(std::unique_ptr<T>&& texture)
+    {
+        std::size_t index = global_texture_index::value<T>();
+        if (m_global_textures.size() <= index)
+        {
+            m_global_textures.resize(index + 1);
+        }
+
+        if (m_global_textures[index] == nullptr)
+        {
+            m_global_textures[index] = std::move(texture);
+        }
+    }
+
 private:
     struct shader_key
     {
@@ -290,13 +318,54 @@ private:
 
     void create_global_resources();
 
+    template <typename T>
+    rhi_shader* create_shader(shader_key&& key, std::span<char> source)
+    {
+        auto code = compile_shader(source, T::entry_point, T::stage, key.defines);
+
+        rhi_shader_desc desc = {
+            .code = code.data(),
+            .code_size = static_cast<std::uint32_t>(code.size()),
+            .stage = T::stage,
+            .entry_point = T::entry_point.data(),
+        };
+
+        if constexpr (has_inputs<T>)
+        {
+            desc.vertex.attributes = T::inputs.attributes;
+            desc.vertex.attribute_count = T::inputs.attribute_count;
+        }
+
+        if constexpr (has_parameters<T>)
+        {
+            desc.parameters = T::parameters.parameters;
+            desc.parameter_count = T::parameters.parameter_count;
+        }
+
+        if constexpr (has_constant<T>)
+        {
+            desc.push_constant_size = sizeof(typename T::constant_data);
+        }
+
+        auto shader = rhi_ptr<rhi_shader>(m_rhi->create_shader(desc), m_rhi_deleter);
+        shader->set_name(T::path.data());
+
+        rhi_shader* result = shader.get();
+        m_shaders[std::move(key)] = std::move(shader);
+
+        return result;
+    }
+
+    std::vector<char> read_shader(std::string_view path);
+
     std::vector<std::uint8_t> compile_shader(
-        std::string_view path,
+        std::span<char> source,
         std::string_view entry_point,
         rhi_shader_stage_flag stage,
         std::span<const std::wstring> defines);
 
     rhi* m_rhi{nullptr};
+    task_executor* m_executor{nullptr};
     rhi_deleter m_rhi_deleter;
 
     std::unordered_map<shader_key, rhi_ptr<rhi_shader>, shader_hash> m_shaders;
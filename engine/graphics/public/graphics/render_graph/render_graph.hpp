@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/frame_allocator.hpp"
 #include "graphics/render_graph/rdg_allocator.hpp"
 #include "graphics/render_graph/rdg_pass.hpp"
 #include "graphics/render_graph/rdg_resource.hpp"
@@ -127,16 +128,16 @@ private:
 
     struct batch
     {
-        std::vector<rhi_texture_barrier> texture_barriers;
-        std::vector<rhi_buffer_barrier> buffer_barriers;
+        frame_vector<rhi_texture_barrier> texture_barriers;
+        frame_vector<rhi_buffer_barrier> buffer_barriers;
 
         rhi_render_pass* render_pass;
-        std::vector<rhi_attachment> attachments;
+        frame_vector<rhi_attachment> attachments;
 
         rdg_pass* begin_pass;
         rdg_pass* end_pass;
     };
-    std::vector<batch> m_batches;
+    frame_vector<batch> m_batches;
 
     rdg_pass* m_final_pass;
 
@@ -919,6 +919,7 @@ public:
     virtual ~rhi_fence() = default;
 
     virtual void wait(std::uint64_t value) = 0;
+    virtual std::uint64_t get_value() const = 0;
 };
 
 enum rhi_query_type
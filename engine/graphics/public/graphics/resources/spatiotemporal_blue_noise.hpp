@@ -7,12 +7,19 @@ namespace violet
 class spatiotemporal_blue_noise : public texture_2d
 {
 public:
+    static constexpr std::string_view path = "assets/textures/stbn_vec3_2Dx1D_128x128x64.dds";
+
     spatiotemporal_blue_noise();
+    spatiotemporal_blue_noise(rhi_ptr<rhi_texture>&& texture);
 };
 
 class spatiotemporal_blue_noise_cosine : public texture_2d
 {
 public:
+    static constexpr std::string_view path =
+        "assets/textures/stbn_unitvec3_cosine_2Dx1D_128x128x64.dds";
+
     spatiotemporal_blue_noise_cosine();
+    spatiotemporal_blue_noise_cosine(rhi_ptr<rhi_texture>&& texture);
 };
 } // namespace violet
\ No newline at end of file
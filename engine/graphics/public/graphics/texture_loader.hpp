@@ -2,6 +2,7 @@
 
 #include "graphics/render_device.hpp"
 #include "graphics/resources/texture.hpp"
+#include "task/task_executor.hpp"
 
 namespace violet
 {
@@ -21,7 +22,22 @@ public:
 
     static rhi_ptr<rhi_texture> load(std::string_view path);
 
+    /**
+     * @brief Loads a dds texture without blocking a worker thread. The file is read
+     * asynchronously, the upload is recorded on the main thread between frames and the coroutine
+     * is suspended until the upload fence signals. The coroutine completes on the main thread.
+     */
+    static async_task<rhi_ptr<rhi_texture>> load_async(
+        task_executor& executor,
+        std::string path,
+        load_options options = LOAD_OPTION_NONE);
+
 private:
+    static rhi_ptr<rhi_texture> create(
+        const texture_data& data,
+        load_options options,
+        rhi_command* command);
+
     static void upload(rhi_command* command, const texture_data& data, rhi_texture* texture);
 };
 } // namespace violet
\ No newline at end of file
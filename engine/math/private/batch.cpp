@@ -0,0 +1,299 @@
+#include "math/batch.hpp"
+#include "batch_kernel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace violet
+{
+namespace
+{
+void cpuid(std::uint32_t leaf, std::uint32_t (&registers)[4]) noexcept
+{
+#ifdef _MSC_VER
+    int result[4];
+    __cpuidex(result, static_cast<int>(leaf), 0);
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        registers[i] = static_cast<std::uint32_t>(result[i]);
+    }
+#else
+    __cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+std::uint64_t xgetbv() noexcept
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    std::uint32_t eax = 0;
+    std::uint32_t edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+simd_level detect_simd_level() noexcept
+{
+    std::uint32_t registers[4];
+
+    cpuid(0, registers);
+    if (registers[0] < 7)
+    {
+        return SIMD_LEVEL_SSE;
+    }
+
+    // The OS has to save the wider registers too, which XCR0 reports.
+    cpuid(1, registers);
+    bool fma = registers[2] & (1u << 12);
+    bool osxsave = registers[2] & (1u << 27);
+    bool avx = registers[2] & (1u << 28);
+    if (!fma || !osxsave || !avx)
+    {
+        return SIMD_LEVEL_SSE;
+    }
+
+    std::uint64_t xcr0 = xgetbv();
+    if ((xcr0 & 0x6) != 0x6)
+    {
+        return SIMD_LEVEL_SSE;
+    }
+
+    cpuid(7, registers);
+    bool avx2 = registers[1] & (1u << 5);
+    bool avx512f = registers[1] & (1u << 16);
+    if (!avx2)
+    {
+        return SIMD_LEVEL_SSE;
+    }
+
+    if (avx512f && (xcr0 & 0xE6) == 0xE6)
+    {
+        return SIMD_LEVEL_AVX512;
+    }
+
+    return SIMD_LEVEL_AVX2;
+}
+
+class batch_dispatcher
+{
+public:
+    static batch_dispatcher& instance()
+    {
+        static batch_dispatcher instance;
+        return instance;
+    }
+
+    const batch_kernels& get_kernels() const noexcept
+    {
+        return m_kernels[m_level.load(std::memory_order_relaxed)];
+    }
+
+    simd_level get_level() const noexcept
+    {
+        return m_level.load(std::memory_order_relaxed);
+    }
+
+    void set_level(simd_level level) noexcept
+    {
+        m_level.store(std::min(level, m_supported_level), std::memory_order_relaxed);
+    }
+
+private:
+    batch_dispatcher()
+        : m_kernels{get_batch_kernels_sse(), get_batch_kernels_avx2(), get_batch_kernels_avx512()},
+          m_supported_level(detect_simd_level()),
+          m_level(m_supported_level)
+    {
+    }
+
+    batch_kernels m_kernels[3];
+
+    simd_level m_supported_level;
+    std::atomic<simd_level> m_level;
+};
+
+const batch_kernels& get_kernels() noexcept
+{
+    return batch_dispatcher::instance().get_kernels();
+}
+
+// Kernels over arrays of structures read them as plain floats.
+static_assert(sizeof(vec3f) == sizeof(float) * 3);
+static_assert(sizeof(sphere3f) == sizeof(float) * 4);
+static_assert(sizeof(box3f) == sizeof(float) * 6);
+} // namespace
+
+simd_level batch::get_simd_level() noexcept
+{
+    return batch_dispatcher::instance().get_level();
+}
+
+void batch::set_simd_level(simd_level level) noexcept
+{
+    batch_dispatcher::instance().set_level(level);
+}
+
+void batch::mul(
+    std::span<const mat4f_x8> a,
+    std::span<const mat4f_x8> b,
+    std::span<mat4f_x8> result)
+{
+    assert(a.size() == result.size() && b.size() == result.size());
+    get_kernels().mul(a.data(), b.data(), result.data(), result.size());
+}
+
+void batch::inverse(std::span<const mat4f_x8> m, std::span<mat4f_x8> result)
+{
+    assert(m.size() == result.size());
+    get_kernels().inverse(m.data(), result.data(), result.size());
+}
+
+void batch::inverse_transform(std::span<const mat4f_x8> m, std::span<mat4f_x8> result)
+{
+    assert(m.size() == result.size());
+    get_kernels().inverse_transform(m.data(), result.data(), result.size());
+}
+
+void batch::affine_transform(
+    std::span<const vec3f_x8> scale,
+    std::span<const vec4f_x8> rotation,
+    std::span<const vec3f_x8> translation,
+    std::span<mat4f_x8> result)
+{
+    assert(scale.size() == result.size() && rotation.size() == result.size());
+    assert(translation.size() == result.size());
+    get_kernels().affine_transform(
+        scale.data(),
+        rotation.data(),
+        translation.data(),
+        result.data(),
+        result.size());
+}
+
+void batch::transform_point(
+    std::span<const vec3f_x8> points,
+    std::span<const mat4f_x8> m,
+    std::span<vec3f_x8> result)
+{
+    assert(points.size() == result.size() && m.size() == result.size());
+    get_kernels().transform_point(points.data(), m.data(), result.data(), result.size());
+}
+
+void batch::transform_point(
+    std::span<const vec3f_x8> points,
+    const mat4f& m,
+    std::span<vec3f_x8> result)
+{
+    assert(points.size() == result.size());
+    get_kernels().transform_point_uniform(points.data(), &m[0][0], result.data(), result.size());
+}
+
+void batch::quaternion_mul(
+    std::span<const vec4f_x8> a,
+    std::span<const vec4f_x8> b,
+    std::span<vec4f_x8> result)
+{
+    assert(a.size() == result.size() && b.size() == result.size());
+    get_kernels().quaternion_mul(a.data(), b.data(), result.data(), result.size());
+}
+
+void batch::quaternion_mul_vec(
+    std::span<const vec4f_x8> q,
+    std::span<const vec3f_x8> v,
+    std::span<vec3f_x8> result)
+{
+    assert(q.size() == result.size() && v.size() == result.size());
+    get_kernels().quaternion_mul_vec(q.data(), v.data(), result.data(), result.size());
+}
+
+void batch::quaternion_normalize(std::span<const vec4f_x8> q, std::span<vec4f_x8> result)
+{
+    assert(q.size() == result.size());
+    get_kernels().quaternion_normalize(q.data(), result.data(), result.size());
+}
+
+void batch::quaternion_slerp(
+    std::span<const vec4f_x8> a,
+    std::span<const vec4f_x8> b,
+    float t,
+    std::span<vec4f_x8> result)
+{
+    assert(a.size() == result.size() && b.size() == result.size());
+    get_kernels().quaternion_slerp(a.data(), b.data(), t, result.data(), result.size());
+}
+void batch::transform_points(
+    std::span<const vec3f> points,
+    const mat4f& m,
+    std::span<vec3f> result)
+{
+    assert(points.size() == result.size());
+    get_kernels().transform_points(
+        reinterpret_cast<const float*>(points.data()),
+        &m[0][0],
+        reinterpret_cast<float*>(result.data()),
+        result.size());
+}
+
+void batch::transform_normals(
+    std::span<const vec3f> normals,
+    const mat4f& m,
+    std::span<vec3f> result)
+{
+    assert(normals.size() == result.size());
+    get_kernels().transform_normals(
+        reinterpret_cast<const float*>(normals.data()),
+        &m[0][0],
+        reinterpret_cast<float*>(result.data()),
+        result.size());
+}
+
+void batch::transform_spheres(
+    std::span<const sphere3f> spheres,
+    const mat4f& m,
+    std::span<sphere3f> result)
+{
+    assert(spheres.size() == result.size());
+
+    float scale = std::max({
+        vector::length(vec3f(m[0])),
+        vector::length(vec3f(m[1])),
+        vector::length(vec3f(m[2])),
+    });
+
+    get_kernels().transform_spheres(
+        reinterpret_cast<const float*>(spheres.data()),
+        &m[0][0],
+        scale,
+        reinterpret_cast<float*>(result.data()),
+        result.size());
+}
+
+void batch::transform_boxes(std::span<const box3f> boxes, const mat4f& m, std::span<box3f> result)
+{
+    assert(boxes.size() == result.size());
+    get_kernels().transform_boxes(
+        reinterpret_cast<const float*>(boxes.data()),
+        &m[0][0],
+        reinterpret_cast<float*>(result.data()),
+        result.size());
+}
+
+box3f batch::get_bounds(std::span<const vec3f> points)
+{
+    box3f result;
+    get_kernels().get_bounds(
+        reinterpret_cast<const float*>(points.data()),
+        points.size(),
+        &result.min.x);
+    return result;
+}
+} // namespace violet
\ No newline at end of file
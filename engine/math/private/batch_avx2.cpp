@@ -0,0 +1,14 @@
+#include "batch_kernel.hpp"
+#include "batch_lane.hpp"
+
+#ifndef __AVX2__
+#error "batch_avx2.cpp must be compiled with AVX2 enabled"
+#endif
+
+namespace violet
+{
+batch_kernels get_batch_kernels_avx2() noexcept
+{
+    return batch_kernel::make_kernels<batch_kernel::avx2_lane>();
+}
+} // namespace violet
\ No newline at end of file
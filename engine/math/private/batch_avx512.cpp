@@ -0,0 +1,14 @@
+#include "batch_kernel.hpp"
+#include "batch_lane.hpp"
+
+#ifndef __AVX512F__
+#error "batch_avx512.cpp must be compiled with AVX-512 enabled"
+#endif
+
+namespace violet
+{
+batch_kernels get_batch_kernels_avx512() noexcept
+{
+    return batch_kernel::make_kernels<batch_kernel::avx512_lane>();
+}
+} // namespace violet
\ No newline at end of file
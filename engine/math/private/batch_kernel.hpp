@@ -0,0 +1,1006 @@
+#pragma once
+
+#include "math/batch_types.hpp"
+#include <limits>
+
+namespace violet
+{
+struct batch_kernels
+{
+    void (*mul)(const mat4f_x8* a, const mat4f_x8* b, mat4f_x8* result, std::size_t count);
+    void (*inverse)(const mat4f_x8* m, mat4f_x8* result, std::size_t count);
+    void (*inverse_transform)(const mat4f_x8* m, mat4f_x8* result, std::size_t count);
+    void (*affine_transform)(
+        const vec3f_x8* scale,
+        const vec4f_x8* rotation,
+        const vec3f_x8* translation,
+        mat4f_x8* result,
+        std::size_t count);
+    void (*transform_point)(
+        const vec3f_x8* points,
+        const mat4f_x8* m,
+        vec3f_x8* result,
+        std::size_t count);
+    void (*transform_point_uniform)(
+        const vec3f_x8* points,
+        const float* m,
+        vec3f_x8* result,
+        std::size_t count);
+    void (*quaternion_mul)(
+        const vec4f_x8* a,
+        const vec4f_x8* b,
+        vec4f_x8* result,
+        std::size_t count);
+    void (*quaternion_mul_vec)(
+        const vec4f_x8* q,
+        const vec3f_x8* v,
+        vec3f_x8* result,
+        std::size_t count);
+    void (*quaternion_normalize)(const vec4f_x8* q, vec4f_x8* result, std::size_t count);
+    void (*quaternion_slerp)(
+        const vec4f_x8* a,
+        const vec4f_x8* b,
+        float t,
+        vec4f_x8* result,
+        std::size_t count);
+
+    // Arrays of structures, see the strides in batch.cpp.
+    void (*transform_points)(const float* points, const float* m, float* result, std::size_t count);
+    void (*transform_normals)(
+        const float* normals,
+        const float* m,
+        float* result,
+        std::size_t count);
+    void (*transform_spheres)(
+        const float* spheres,
+        const float* m,
+        float scale,
+        float* result,
+        std::size_t count);
+    void (*transform_boxes)(const float* boxes, const float* m, float* result, std::size_t count);
+    void (*get_bounds)(const float* points, std::size_t count, float* result);
+};
+
+batch_kernels get_batch_kernels_sse() noexcept;
+batch_kernels get_batch_kernels_avx2() noexcept;
+batch_kernels get_batch_kernels_avx512() noexcept;
+
+/**
+ * Kernels are written once against a lane type and instantiated by every simd level in its own
+ * translation unit, compiled with the matching instruction set. Everything here has internal
+ * linkage, otherwise the linker keeps one copy of an inline function or template emitted by
+ * several of these translation units and may pick the one compiled for a wider instruction set.
+ * For the same reason kernels do not call standard algorithms, whose instantiations such as
+ * std::copy<float*> are shared with the rest of the program.
+ *
+ * A lane type provides:
+ * - type, mask: register and comparison result.
+ * - lane_count: floats per register, pack_count: packs covered by one register (2 when lanes are
+ *   wider than a pack).
+ * - tail: lane type for packs left over when pack_count > 1.
+ * - load/store(float*, stride), where stride is the distance between consecutive packs in floats.
+ * - transpose_load(float*, stride, v[4]): reads 4 floats of lane_count elements that are stride
+ *   floats apart, v[i] holds float i of every element. transpose_store writes them back in
+ *   element order, so with stride < 4 the 4th float of an element is overwritten by the next one.
+ *   Used by the kernels over arrays of structures.
+ * - set1, add, sub, mul, div, fmadd(a, b, c) = a * b + c, sqrt, min, max, less, greater, select.
+ */
+namespace batch_kernel
+{
+namespace
+{
+template <typename P>
+constexpr std::size_t stride_v = sizeof(P) / sizeof(float);
+
+template <typename L, typename Functor>
+std::size_t for_each_lane(std::size_t count, Functor&& functor)
+{
+    std::size_t i = 0;
+    for (; i + L::pack_count <= count; i += L::pack_count)
+    {
+        for (std::size_t lane = 0; lane < BATCH_WIDTH; lane += L::lane_count)
+        {
+            functor(i, lane);
+        }
+    }
+    return i;
+}
+
+template <typename L>
+struct mat4
+{
+    using type = typename L::type;
+
+    type m[4][4];
+
+    void load(const mat4f_x8* pack, std::size_t lane)
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            for (std::size_t j = 0; j < 4; ++j)
+            {
+                m[i][j] = L::load(pack->m[i][j] + lane, stride_v<mat4f_x8>);
+            }
+        }
+    }
+
+    void store(mat4f_x8* pack, std::size_t lane) const
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            for (std::size_t j = 0; j < 4; ++j)
+            {
+                L::store(pack->m[i][j] + lane, stride_v<mat4f_x8>, m[i][j]);
+            }
+        }
+    }
+};
+
+template <typename L>
+struct vec3
+{
+    using type = typename L::type;
+
+    type x;
+    type y;
+    type z;
+
+    void load(const vec3f_x8* pack, std::size_t lane)
+    {
+        x = L::load(pack->x + lane, stride_v<vec3f_x8>);
+        y = L::load(pack->y + lane, stride_v<vec3f_x8>);
+        z = L::load(pack->z + lane, stride_v<vec3f_x8>);
+    }
+
+    void store(vec3f_x8* pack, std::size_t lane) const
+    {
+        L::store(pack->x + lane, stride_v<vec3f_x8>, x);
+        L::store(pack->y + lane, stride_v<vec3f_x8>, y);
+        L::store(pack->z + lane, stride_v<vec3f_x8>, z);
+    }
+};
+
+template <typename L>
+struct vec4
+{
+    using type = typename L::type;
+
+    type x;
+    type y;
+    type z;
+    type w;
+
+    void load(const vec4f_x8* pack, std::size_t lane)
+    {
+        x = L::load(pack->x + lane, stride_v<vec4f_x8>);
+        y = L::load(pack->y + lane, stride_v<vec4f_x8>);
+        z = L::load(pack->z + lane, stride_v<vec4f_x8>);
+        w = L::load(pack->w + lane, stride_v<vec4f_x8>);
+    }
+
+    void store(vec4f_x8* pack, std::size_t lane) const
+    {
+        L::store(pack->x + lane, stride_v<vec4f_x8>, x);
+        L::store(pack->y + lane, stride_v<vec4f_x8>, y);
+        L::store(pack->z + lane, stride_v<vec4f_x8>, z);
+        L::store(pack->w + lane, stride_v<vec4f_x8>, w);
+    }
+};
+
+// sin(x) for x in [0, pi / 2], Taylor series up to x^11.
+template <typename L>
+typename L::type sin_half_pi(typename L::type x)
+{
+    auto x2 = L::mul(x, x);
+    auto p = L::fmadd(x2, L::set1(-2.5052108e-8f), L::set1(2.7557319e-6f));
+    p = L::fmadd(x2, p, L::set1(-1.9841270e-4f));
+    p = L::fmadd(x2, p, L::set1(8.3333333e-3f));
+    p = L::fmadd(x2, p, L::set1(-1.6666667e-1f));
+    return L::fmadd(L::mul(x, x2), p, x);
+}
+
+// atan2(y, x) for x, y >= 0, with the range reduction of Cephes atanf.
+template <typename L>
+typename L::type atan2_positive(typename L::type y, typename L::type x)
+{
+    auto ratio = L::div(y, x);
+
+    auto big = L::greater(ratio, L::set1(2.414213562f));
+    auto middle = L::greater(ratio, L::set1(0.414213562f));
+
+    auto one = L::set1(1.0f);
+    auto z = L::select(
+        big,
+        L::div(L::set1(-1.0f), ratio),
+        L::select(middle, L::div(L::sub(ratio, one), L::add(ratio, one)), ratio));
+    auto base = L::select(
+        big,
+        L::set1(1.5707963268f),
+        L::select(middle, L::set1(0.7853981634f), L::set1(0.0f)));
+
+    auto z2 = L::mul(z, z);
+    auto p = L::fmadd(z2, L::set1(8.05374449538e-2f), L::set1(-1.38776856032e-1f));
+    p = L::fmadd(z2, p, L::set1(1.99777106478e-1f));
+    p = L::fmadd(z2, p, L::set1(-3.33329491539e-1f));
+
+    return L::add(base, L::fmadd(L::mul(z, z2), p, z));
+}
+
+// Only a row of a is kept in registers and b is read from memory, which leaves room for the
+// accumulators. Storing a row right away is safe if the result aliases a, a result aliasing b is
+// only stored once every row is done.
+template <typename L, bool AliasB>
+void mul(const mat4f_x8& a, const mat4f_x8& b, mat4f_x8& result, std::size_t lane)
+{
+    constexpr std::size_t stride = stride_v<mat4f_x8>;
+
+    typename L::type value[4][4];
+    for (std::size_t row = 0; row < 4; ++row)
+    {
+        auto x = L::load(a.m[row][0] + lane, stride);
+        auto y = L::load(a.m[row][1] + lane, stride);
+        auto z = L::load(a.m[row][2] + lane, stride);
+        auto w = L::load(a.m[row][3] + lane, stride);
+
+        for (std::size_t column = 0; column < 4; ++column)
+        {
+            auto v = L::mul(x, L::load(b.m[0][column] + lane, stride));
+            v = L::fmadd(y, L::load(b.m[1][column] + lane, stride), v);
+            v = L::fmadd(z, L::load(b.m[2][column] + lane, stride), v);
+            v = L::fmadd(w, L::load(b.m[3][column] + lane, stride), v);
+
+            if constexpr (AliasB)
+            {
+                value[row][column] = v;
+            }
+            else
+            {
+                L::store(result.m[row][column] + lane, stride, v);
+            }
+        }
+    }
+
+    if constexpr (AliasB)
+    {
+        for (std::size_t row = 0; row < 4; ++row)
+        {
+            for (std::size_t column = 0; column < 4; ++column)
+            {
+                L::store(result.m[row][column] + lane, stride, value[row][column]);
+            }
+        }
+    }
+}
+
+template <typename L>
+void mul(const mat4f_x8* a, const mat4f_x8* b, mat4f_x8* result, std::size_t count)
+{
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            if (result == b)
+            {
+                mul<L, true>(a[i], b[i], result[i], lane);
+            }
+            else
+            {
+                mul<L, false>(a[i], b[i], result[i], lane);
+            }
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        mul<typename L::tail>(a + done, b + done, result + done, count - done);
+    }
+}
+
+template <typename L>
+void inverse(const mat4f_x8* m, mat4f_x8* result, std::size_t count)
+{
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            mat4<L> a;
+            a.load(m + i, lane);
+
+            auto det2 = [](auto a, auto b, auto c, auto d)
+            {
+                return L::sub(L::mul(a, b), L::mul(c, d));
+            };
+
+            auto s0 = det2(a.m[0][0], a.m[1][1], a.m[1][0], a.m[0][1]);
+            auto s1 = det2(a.m[0][0], a.m[1][2], a.m[1][0], a.m[0][2]);
+            auto s2 = det2(a.m[0][0], a.m[1][3], a.m[1][0], a.m[0][3]);
+            auto s3 = det2(a.m[0][1], a.m[1][2], a.m[1][1], a.m[0][2]);
+            auto s4 = det2(a.m[0][1], a.m[1][3], a.m[1][1], a.m[0][3]);
+            auto s5 = det2(a.m[0][2], a.m[1][3], a.m[1][2], a.m[0][3]);
+
+            auto c5 = det2(a.m[2][2], a.m[3][3], a.m[3][2], a.m[2][3]);
+            auto c4 = det2(a.m[2][1], a.m[3][3], a.m[3][1], a.m[2][3]);
+            auto c3 = det2(a.m[2][1], a.m[3][2], a.m[3][1], a.m[2][2]);
+            auto c2 = det2(a.m[2][0], a.m[3][3], a.m[3][0], a.m[2][3]);
+            auto c1 = det2(a.m[2][0], a.m[3][2], a.m[3][0], a.m[2][2]);
+            auto c0 = det2(a.m[2][0], a.m[3][1], a.m[3][0], a.m[2][1]);
+
+            auto det = L::sub(L::mul(s0, c5), L::mul(s1, c4));
+            det = L::fmadd(s2, c3, det);
+            det = L::fmadd(s3, c2, det);
+            det = L::sub(det, L::mul(s4, c1));
+            det = L::fmadd(s5, c0, det);
+            auto inverse_det = L::div(L::set1(1.0f), det);
+
+            // a * x - b * y + c * z
+            auto cofactor = [&](auto a, auto x, auto b, auto y, auto c, auto z)
+            {
+                return L::mul(L::fmadd(c, z, L::sub(L::mul(a, x), L::mul(b, y))), inverse_det);
+            };
+            auto negative = [](auto v)
+            {
+                return L::sub(L::set1(0.0f), v);
+            };
+
+            mat4<L> r;
+            r.m[0][0] = cofactor(a.m[1][1], c5, a.m[1][2], c4, a.m[1][3], c3);
+            r.m[0][1] = negative(cofactor(a.m[0][1], c5, a.m[0][2], c4, a.m[0][3], c3));
+            r.m[0][2] = cofactor(a.m[3][1], s5, a.m[3][2], s4, a.m[3][3], s3);
+            r.m[0][3] = negative(cofactor(a.m[2][1], s5, a.m[2][2], s4, a.m[2][3], s3));
+
+            r.m[1][0] = negative(cofactor(a.m[1][0], c5, a.m[1][2], c2, a.m[1][3], c1));
+            r.m[1][1] = cofactor(a.m[0][0], c5, a.m[0][2], c2, a.m[0][3], c1);
+            r.m[1][2] = negative(cofactor(a.m[3][0], s5, a.m[3][2], s2, a.m[3][3], s1));
+            r.m[1][3] = cofactor(a.m[2][0], s5, a.m[2][2], s2, a.m[2][3], s1);
+
+            r.m[2][0] = cofactor(a.m[1][0], c4, a.m[1][1], c2, a.m[1][3], c0);
+            r.m[2][1] = negative(cofactor(a.m[0][0], c4, a.m[0][1], c2, a.m[0][3], c0));
+            r.m[2][2] = cofactor(a.m[3][0], s4, a.m[3][1], s2, a.m[3][3], s0);
+            r.m[2][3] = negative(cofactor(a.m[2][0], s4, a.m[2][1], s2, a.m[2][3], s0));
+
+            r.m[3][0] = negative(cofactor(a.m[1][0], c3, a.m[1][1], c1, a.m[1][2], c0));
+            r.m[3][1] = cofactor(a.m[0][0], c3, a.m[0][1], c1, a.m[0][2], c0);
+            r.m[3][2] = negative(cofactor(a.m[3][0], s3, a.m[3][1], s1, a.m[3][2], s0));
+            r.m[3][3] = cofactor(a.m[2][0], s3, a.m[2][1], s1, a.m[2][2], s0);
+
+            r.store(result + i, lane);
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        inverse<typename L::tail>(m + done, result + done, count - done);
+    }
+}
+
+template <typename L>
+void inverse_transform(const mat4f_x8* m, mat4f_x8* result, std::size_t count)
+{
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            mat4<L> a;
+            a.load(m + i, lane);
+
+            typename L::type scale[3];
+            for (std::size_t row = 0; row < 3; ++row)
+            {
+                auto length_sq = L::mul(a.m[row][0], a.m[row][0]);
+                length_sq = L::fmadd(a.m[row][1], a.m[row][1], length_sq);
+                length_sq = L::fmadd(a.m[row][2], a.m[row][2], length_sq);
+                scale[row] = L::div(L::set1(1.0f), length_sq);
+            }
+
+            mat4<L> r;
+            for (std::size_t row = 0; row < 3; ++row)
+            {
+                for (std::size_t column = 0; column < 3; ++column)
+                {
+                    r.m[row][column] = L::mul(a.m[column][row], scale[column]);
+                }
+                r.m[row][3] = L::set1(0.0f);
+            }
+
+            for (std::size_t column = 0; column < 3; ++column)
+            {
+                auto value = L::mul(a.m[3][0], a.m[column][0]);
+                value = L::fmadd(a.m[3][1], a.m[column][1], value);
+                value = L::fmadd(a.m[3][2], a.m[column][2], value);
+                r.m[3][column] = L::mul(L::sub(L::set1(0.0f), value), scale[column]);
+            }
+            r.m[3][3] = L::set1(1.0f);
+
+            r.store(result + i, lane);
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        inverse_transform<typename L::tail>(m + done, result + done, count - done);
+    }
+}
+
+template <typename L>
+void affine_transform(
+    const vec3f_x8* scale,
+    const vec4f_x8* rotation,
+    const vec3f_x8* translation,
+    mat4f_x8* result,
+    std::size_t count)
+{
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            vec3<L> s;
+            s.load(scale + i, lane);
+            vec4<L> q;
+            q.load(rotation + i, lane);
+            vec3<L> t;
+            t.load(translation + i, lane);
+
+            auto x2 = L::add(q.x, q.x);
+            auto y2 = L::add(q.y, q.y);
+            auto z2 = L::add(q.z, q.z);
+
+            auto xx = L::mul(q.x, x2);
+            auto xy = L::mul(q.x, y2);
+            auto xz = L::mul(q.x, z2);
+            auto xw = L::mul(q.w, x2);
+            auto yy = L::mul(q.y, y2);
+            auto yz = L::mul(q.y, z2);
+            auto yw = L::mul(q.w, y2);
+            auto zz = L::mul(q.z, z2);
+            auto zw = L::mul(q.w, z2);
+
+            auto one = L::set1(1.0f);
+            auto zero = L::set1(0.0f);
+
+            mat4<L> r;
+            r.m[0][0] = L::mul(s.x, L::sub(L::sub(one, yy), zz));
+            r.m[0][1] = L::mul(s.x, L::add(xy, zw));
+            r.m[0][2] = L::mul(s.x, L::sub(xz, yw));
+            r.m[0][3] = zero;
+
+            r.m[1][0] = L::mul(s.y, L::sub(xy, zw));
+            r.m[1][1] = L::mul(s.y, L::sub(L::sub(one, xx), zz));
+            r.m[1][2] = L::mul(s.y, L::add(yz, xw));
+            r.m[1][3] = zero;
+
+            r.m[2][0] = L::mul(s.z, L::add(xz, yw));
+            r.m[2][1] = L::mul(s.z, L::sub(yz, xw));
+            r.m[2][2] = L::mul(s.z, L::sub(L::sub(one, xx), yy));
+            r.m[2][3] = zero;
+
+            r.m[3][0] = t.x;
+            r.m[3][1] = t.y;
+            r.m[3][2] = t.z;
+            r.m[3][3] = one;
+
+            r.store(result + i, lane);
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        affine_transform<typename L::tail>(
+            scale + done,
+            rotation + done,
+            translation + done,
+            result + done,
+            count - done);
+    }
+}
+
+template <typename L>
+void transform_point(
+    const vec3f_x8* points,
+    const mat4f_x8* m,
+    vec3f_x8* result,
+    std::size_t count)
+{
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            vec3<L> p;
+            p.load(points + i, lane);
+
+            typename L::type r[3];
+            for (std::size_t column = 0; column < 3; ++column)
+            {
+                auto value = L::load(m[i].m[3][column] + lane, stride_v<mat4f_x8>);
+                value = L::fmadd(p.x, L::load(m[i].m[0][column] + lane, stride_v<mat4f_x8>), value);
+                value = L::fmadd(p.y, L::load(m[i].m[1][column] + lane, stride_v<mat4f_x8>), value);
+                value = L::fmadd(p.z, L::load(m[i].m[2][column] + lane, stride_v<mat4f_x8>), value);
+                r[column] = value;
+            }
+
+            vec3<L>{r[0], r[1], r[2]}.store(result + i, lane);
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        transform_point<typename L::tail>(points + done, m + done, result + done, count - done);
+    }
+}
+
+template <typename L>
+void transform_point_uniform(
+    const vec3f_x8* points,
+    const float* m,
+    vec3f_x8* result,
+    std::size_t count)
+{
+    typename L::type matrix[4][3];
+    for (std::size_t row = 0; row < 4; ++row)
+    {
+        for (std::size_t column = 0; column < 3; ++column)
+        {
+            matrix[row][column] = L::set1(m[row * 4 + column]);
+        }
+    }
+
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            vec3<L> p;
+            p.load(points + i, lane);
+
+            typename L::type r[3];
+            for (std::size_t column = 0; column < 3; ++column)
+            {
+                auto value = L::fmadd(p.x, matrix[0][column], matrix[3][column]);
+                value = L::fmadd(p.y, matrix[1][column], value);
+                r[column] = L::fmadd(p.z, matrix[2][column], value);
+            }
+
+            vec3<L>{r[0], r[1], r[2]}.store(result + i, lane);
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        transform_point_uniform<typename L::tail>(
+            points + done,
+            m,
+            result + done,
+            count - done);
+    }
+}
+
+template <typename L>
+void quaternion_mul(const vec4f_x8* a, const vec4f_x8* b, vec4f_x8* result, std::size_t count)
+{
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            vec4<L> p;
+            p.load(a + i, lane);
+            vec4<L> q;
+            q.load(b + i, lane);
+
+            vec4<L> r;
+            r.x = L::fmadd(p.w, q.x, L::mul(p.x, q.w));
+            r.x = L::fmadd(p.y, q.z, r.x);
+            r.x = L::sub(r.x, L::mul(p.z, q.y));
+
+            r.y = L::fmadd(p.w, q.y, L::mul(p.y, q.w));
+            r.y = L::fmadd(p.z, q.x, r.y);
+            r.y = L::sub(r.y, L::mul(p.x, q.z));
+
+            r.z = L::fmadd(p.w, q.z, L::mul(p.z, q.w));
+            r.z = L::fmadd(p.x, q.y, r.z);
+            r.z = L::sub(r.z, L::mul(p.y, q.x));
+
+            r.w = L::sub(L::mul(p.w, q.w), L::mul(p.x, q.x));
+            r.w = L::sub(r.w, L::mul(p.y, q.y));
+            r.w = L::sub(r.w, L::mul(p.z, q.z));
+
+            r.store(result + i, lane);
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        quaternion_mul<typename L::tail>(a + done, b + done, result + done, count - done);
+    }
+}
+
+template <typename L>
+void quaternion_mul_vec(
+    const vec4f_x8* q,
+    const vec3f_x8* v,
+    vec3f_x8* result,
+    std::size_t count)
+{
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            vec4<L> r;
+            r.load(q + i, lane);
+            vec3<L> p;
+            p.load(v + i, lane);
+
+            // v + 2 * cross(q.xyz, cross(q.xyz, v) + q.w * v)
+            auto tx = L::fmadd(r.w, p.x, L::sub(L::mul(r.y, p.z), L::mul(r.z, p.y)));
+            auto ty = L::fmadd(r.w, p.y, L::sub(L::mul(r.z, p.x), L::mul(r.x, p.z)));
+            auto tz = L::fmadd(r.w, p.z, L::sub(L::mul(r.x, p.y), L::mul(r.y, p.x)));
+
+            auto two = L::set1(2.0f);
+
+            vec3<L> o;
+            o.x = L::fmadd(two, L::sub(L::mul(r.y, tz), L::mul(r.z, ty)), p.x);
+            o.y = L::fmadd(two, L::sub(L::mul(r.z, tx), L::mul(r.x, tz)), p.y);
+            o.z = L::fmadd(two, L::sub(L::mul(r.x, ty), L::mul(r.y, tx)), p.z);
+            o.store(result + i, lane);
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        quaternion_mul_vec<typename L::tail>(q + done, v + done, result + done, count - done);
+    }
+}
+
+template <typename L>
+void quaternion_normalize(const vec4f_x8* q, vec4f_x8* result, std::size_t count)
+{
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            vec4<L> r;
+            r.load(q + i, lane);
+
+            auto length_sq = L::mul(r.x, r.x);
+            length_sq = L::fmadd(r.y, r.y, length_sq);
+            length_sq = L::fmadd(r.z, r.z, length_sq);
+            length_sq = L::fmadd(r.w, r.w, length_sq);
+
+            auto scale = L::div(L::set1(1.0f), L::sqrt(length_sq));
+            r.x = L::mul(r.x, scale);
+            r.y = L::mul(r.y, scale);
+            r.z = L::mul(r.z, scale);
+            r.w = L::mul(r.w, scale);
+
+            r.store(result + i, lane);
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        quaternion_normalize<typename L::tail>(q + done, result + done, count - done);
+    }
+}
+
+template <typename L>
+void quaternion_slerp(
+    const vec4f_x8* a,
+    const vec4f_x8* b,
+    float t,
+    vec4f_x8* result,
+    std::size_t count)
+{
+    std::size_t done = for_each_lane<L>(
+        count,
+        [&](std::size_t i, std::size_t lane)
+        {
+            vec4<L> p;
+            p.load(a + i, lane);
+            vec4<L> q;
+            q.load(b + i, lane);
+
+            auto cos_omega = L::mul(p.x, q.x);
+            cos_omega = L::fmadd(p.y, q.y, cos_omega);
+            cos_omega = L::fmadd(p.z, q.z, cos_omega);
+            cos_omega = L::fmadd(p.w, q.w, cos_omega);
+
+            // Take the shorter path.
+            auto zero = L::set1(0.0f);
+            auto one = L::set1(1.0f);
+            auto sign = L::select(L::less(cos_omega, zero), L::set1(-1.0f), one);
+            cos_omega = L::mul(cos_omega, sign);
+
+            auto sin_omega = L::sqrt(L::max(L::sub(one, L::mul(cos_omega, cos_omega)), zero));
+            auto omega = atan2_positive<L>(sin_omega, cos_omega);
+            auto inverse_sin = L::div(one, sin_omega);
+
+            auto t0 = L::set1(1.0f - t);
+            auto t1 = L::set1(t);
+
+            // Nearly parallel quaternions fall back to a linear blend, as quaternion::slerp does.
+            auto linear = L::greater(cos_omega, L::set1(0.9999f));
+            auto k0 = L::select(linear, t0, L::mul(sin_half_pi<L>(L::mul(t0, omega)), inverse_sin));
+            auto k1 = L::select(linear, t1, L::mul(sin_half_pi<L>(L::mul(t1, omega)), inverse_sin));
+            k1 = L::mul(k1, sign);
+
+            vec4<L> r;
+            r.x = L::fmadd(q.x, k1, L::mul(p.x, k0));
+            r.y = L::fmadd(q.y, k1, L::mul(p.y, k0));
+            r.z = L::fmadd(q.z, k1, L::mul(p.z, k0));
+            r.w = L::fmadd(q.w, k1, L::mul(p.w, k0));
+            r.store(result + i, lane);
+        });
+
+    if constexpr (L::pack_count > 1)
+    {
+        quaternion_slerp<typename L::tail>(a + done, b + done, t, result + done, count - done);
+    }
+}
+
+/**
+ * Runs functor(input, output) on groups of L::lane_count elements of Stride floats. Loads and
+ * stores touch 4 floats per element and may run past the last element of a group, so the last
+ * group always goes through padded buffers. Its unused elements repeat the last element.
+ */
+template <typename L, std::size_t InputStride, std::size_t OutputStride, typename Functor>
+void for_each_element(const float* input, float* output, std::size_t count, Functor&& functor)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::size_t i = 0;
+    for (; i + L::lane_count < count; i += L::lane_count)
+    {
+        functor(input + i * InputStride, output + i * OutputStride);
+    }
+
+    float input_tail[L::lane_count * InputStride + 4];
+    float output_tail[L::lane_count * OutputStride + 4];
+
+    std::size_t rest = count - i;
+    for (std::size_t j = 0; j < L::lane_count; ++j)
+    {
+        const float* element = input + (i + (j < rest ? j : rest - 1)) * InputStride;
+        for (std::size_t k = 0; k < InputStride; ++k)
+        {
+            input_tail[j * InputStride + k] = element[k];
+        }
+    }
+    for (std::size_t k = 0; k < 4; ++k)
+    {
+        input_tail[L::lane_count * InputStride + k] = 0.0f;
+    }
+
+    functor(input_tail, output_tail);
+
+    for (std::size_t k = 0; k < rest * OutputStride; ++k)
+    {
+        output[i * OutputStride + k] = output_tail[k];
+    }
+}
+
+template <typename L>
+struct uniform_matrix
+{
+    using type = typename L::type;
+
+    explicit uniform_matrix(const float* m)
+    {
+        for (std::size_t row = 0; row < 4; ++row)
+        {
+            for (std::size_t column = 0; column < 3; ++column)
+            {
+                value[row][column] = L::set1(m[row * 4 + column]);
+            }
+        }
+    }
+
+    // Writes the first 3 entries of result.
+    void transform_point(const type (&v)[4], type (&result)[4]) const
+    {
+        for (std::size_t column = 0; column < 3; ++column)
+        {
+            auto r = L::fmadd(v[0], value[0][column], value[3][column]);
+            r = L::fmadd(v[1], value[1][column], r);
+            result[column] = L::fmadd(v[2], value[2][column], r);
+        }
+    }
+
+    // Writes the first 3 entries of result.
+    void transform_vector(const type (&v)[4], type (&result)[4]) const
+    {
+        for (std::size_t column = 0; column < 3; ++column)
+        {
+            auto r = L::mul(v[0], value[0][column]);
+            r = L::fmadd(v[1], value[1][column], r);
+            result[column] = L::fmadd(v[2], value[2][column], r);
+        }
+    }
+
+    type value[4][3];
+};
+
+template <typename L>
+void transform_points(const float* points, const float* m, float* result, std::size_t count)
+{
+    uniform_matrix<L> matrix(m);
+
+    for_each_element<L, 3, 3>(
+        points,
+        result,
+        count,
+        [&](const float* input, float* output)
+        {
+            typename L::type p[4];
+            L::transpose_load(input, 3, p);
+
+            typename L::type r[4];
+            matrix.transform_point(p, r);
+            r[3] = r[2]; // Overwritten by the next element.
+
+            L::transpose_store(output, 3, r);
+        });
+}
+
+template <typename L>
+void transform_normals(const float* normals, const float* m, float* result, std::size_t count)
+{
+    uniform_matrix<L> matrix(m);
+
+    for_each_element<L, 3, 3>(
+        normals,
+        result,
+        count,
+        [&](const float* input, float* output)
+        {
+            typename L::type n[4];
+            L::transpose_load(input, 3, n);
+
+            typename L::type r[4];
+            matrix.transform_vector(n, r);
+
+            // Same tolerance as vector::normalize.
+            auto length = L::sqrt(L::fmadd(r[0], r[0], L::fmadd(r[1], r[1], L::mul(r[2], r[2]))));
+            auto degenerate = L::less(length, L::set1(1e-8f));
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                r[i] = L::select(degenerate, r[i], L::div(r[i], length));
+            }
+            r[3] = r[2]; // Overwritten by the next element.
+
+            L::transpose_store(output, 3, r);
+        });
+}
+
+template <typename L>
+void transform_spheres(
+    const float* spheres,
+    const float* m,
+    float scale,
+    float* result,
+    std::size_t count)
+{
+    uniform_matrix<L> matrix(m);
+    auto radius_scale = L::set1(scale);
+
+    for_each_element<L, 4, 4>(
+        spheres,
+        result,
+        count,
+        [&](const float* input, float* output)
+        {
+            typename L::type s[4];
+            L::transpose_load(input, 4, s);
+
+            typename L::type r[4];
+            matrix.transform_point(s, r);
+            r[3] = L::mul(s[3], radius_scale);
+
+            L::transpose_store(output, 4, r);
+        });
+}
+
+// Arvo's method, equal to the bounds of the 8 transformed corners.
+template <typename L>
+void transform_boxes(const float* boxes, const float* m, float* result, std::size_t count)
+{
+    uniform_matrix<L> matrix(m);
+
+    for_each_element<L, 6, 6>(
+        boxes,
+        result,
+        count,
+        [&](const float* input, float* output)
+        {
+            typename L::type min[4];
+            typename L::type max[4];
+            L::transpose_load(input, 6, min);
+            L::transpose_load(input + 3, 6, max);
+
+            typename L::type result_min[4];
+            typename L::type result_max[4];
+            for (std::size_t column = 0; column < 3; ++column)
+            {
+                result_min[column] = matrix.value[3][column];
+                result_max[column] = matrix.value[3][column];
+                for (std::size_t row = 0; row < 3; ++row)
+                {
+                    auto a = L::mul(min[row], matrix.value[row][column]);
+                    auto b = L::mul(max[row], matrix.value[row][column]);
+                    result_min[column] = L::add(result_min[column], L::min(a, b));
+                    result_max[column] = L::add(result_max[column], L::max(a, b));
+                }
+            }
+            result_min[3] = result_max[0];
+            result_max[3] = result_max[2];
+
+            // Max first, the min pass then restores the min.x the max pass ran over.
+            L::transpose_store(output + 3, 6, result_max);
+            L::transpose_store(output, 6, result_min);
+        });
+}
+
+template <typename L>
+void get_bounds(const float* points, std::size_t count, float* result)
+{
+    typename L::type min[3];
+    typename L::type max[3];
+    // Constants, so no numeric_limits member is emitted into this translation unit.
+    constexpr float max_value = std::numeric_limits<float>::max();
+    constexpr float lowest_value = std::numeric_limits<float>::lowest();
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        min[i] = L::set1(max_value);
+        max[i] = L::set1(lowest_value);
+    }
+
+    for_each_element<L, 3, 0>(
+        points,
+        nullptr,
+        count,
+        [&](const float* input, float* /* output */)
+        {
+            typename L::type p[4];
+            L::transpose_load(input, 3, p);
+
+            // min and max return the second operand for NaN, so NaN points are skipped like in
+            // box::expand.
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                min[i] = L::min(p[i], min[i]);
+                max[i] = L::max(p[i], max[i]);
+            }
+        });
+
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        // A stride of one pack stores lanes contiguously at every level.
+        alignas(64) float min_values[L::lane_count];
+        alignas(64) float max_values[L::lane_count];
+        L::store(min_values, BATCH_WIDTH, min[i]);
+        L::store(max_values, BATCH_WIDTH, max[i]);
+
+        result[i] = min_values[0];
+        result[3 + i] = max_values[0];
+        for (std::size_t j = 1; j < L::lane_count; ++j)
+        {
+            result[i] = min_values[j] < result[i] ? min_values[j] : result[i];
+            result[3 + i] = result[3 + i] < max_values[j] ? max_values[j] : result[3 + i];
+        }
+    }
+}
+
+template <typename L>
+batch_kernels make_kernels() noexcept
+{
+    return {
+        .mul = &mul<L>,
+        .inverse = &inverse<L>,
+        .inverse_transform = &inverse_transform<L>,
+        .affine_transform = &affine_transform<L>,
+        .transform_point = &transform_point<L>,
+        .transform_point_uniform = &transform_point_uniform<L>,
+        .quaternion_mul = &quaternion_mul<L>,
+        .quaternion_mul_vec = &quaternion_mul_vec<L>,
+        .quaternion_normalize = &quaternion_normalize<L>,
+        .quaternion_slerp = &quaternion_slerp<L>,
+        .transform_points = &transform_points<L>,
+        .transform_normals = &transform_normals<L>,
+        .transform_spheres = &transform_spheres<L>,
+        .transform_boxes = &transform_boxes<L>,
+        .get_bounds = &get_bounds<L>,
+    };
+}
+} // namespace
+} // namespace batch_kernel
+} // namespace violet
\ No newline at end of file
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <cstddef>
+#include <immintrin.h>
+
+namespace violet::batch_kernel
+{
+namespace
+{
+struct sse_lane
+{
+    using type = __m128;
+    using mask = __m128;
+
+    static constexpr std::size_t lane_count = 4;
+    static constexpr std::size_t pack_count = 1;
+
+    static type load(const float* p, std::size_t /* stride */) noexcept
+    {
+        return _mm_load_ps(p);
+    }
+
+    static void store(float* p, std::size_t /* stride */, type v) noexcept
+    {
+        _mm_store_ps(p, v);
+    }
+
+    static void transpose_load(const float* p, std::size_t stride, type (&v)[4]) noexcept
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            v[i] = _mm_loadu_ps(p + i * stride);
+        }
+        _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+    }
+
+    static void transpose_store(float* p, std::size_t stride, type (&v)[4]) noexcept
+    {
+        _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            _mm_storeu_ps(p + i * stride, v[i]);
+        }
+    }
+
+
+    static type set1(float v) noexcept
+    {
+        return _mm_set1_ps(v);
+    }
+
+    static type add(type a, type b) noexcept
+    {
+        return _mm_add_ps(a, b);
+    }
+
+    static type sub(type a, type b) noexcept
+    {
+        return _mm_sub_ps(a, b);
+    }
+
+    static type mul(type a, type b) noexcept
+    {
+        return _mm_mul_ps(a, b);
+    }
+
+    static type div(type a, type b) noexcept
+    {
+        return _mm_div_ps(a, b);
+    }
+
+    static type fmadd(type a, type b, type c) noexcept
+    {
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+    }
+
+    static type sqrt(type v) noexcept
+    {
+        return _mm_sqrt_ps(v);
+    }
+
+    static type min(type a, type b) noexcept
+    {
+        return _mm_min_ps(a, b);
+    }
+
+    static type max(type a, type b) noexcept
+    {
+        return _mm_max_ps(a, b);
+    }
+
+    static mask less(type a, type b) noexcept
+    {
+        return _mm_cmplt_ps(a, b);
+    }
+
+    static mask greater(type a, type b) noexcept
+    {
+        return _mm_cmpgt_ps(a, b);
+    }
+
+    static type select(mask m, type a, type b) noexcept
+    {
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+};
+
+#ifdef __AVX2__
+struct avx2_lane
+{
+    using type = __m256;
+    using mask = __m256;
+
+    static constexpr std::size_t lane_count = 8;
+    static constexpr std::size_t pack_count = 1;
+
+    static type load(const float* p, std::size_t /* stride */) noexcept
+    {
+        return _mm256_load_ps(p);
+    }
+
+    static void store(float* p, std::size_t /* stride */, type v) noexcept
+    {
+        _mm256_store_ps(p, v);
+    }
+
+    static void transpose_load(const float* p, std::size_t stride, type (&v)[4]) noexcept
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            __m256 low = _mm256_castps128_ps256(_mm_loadu_ps(p + i * stride));
+            v[i] = _mm256_insertf128_ps(low, _mm_loadu_ps(p + (i + 4) * stride), 1);
+        }
+        transpose(v);
+    }
+
+    static void transpose_store(float* p, std::size_t stride, type (&v)[4]) noexcept
+    {
+        transpose(v);
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            _mm_storeu_ps(p + i * stride, _mm256_castps256_ps128(v[i]));
+        }
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            _mm_storeu_ps(p + (i + 4) * stride, _mm256_extractf128_ps(v[i], 1));
+        }
+    }
+
+
+    static type set1(float v) noexcept
+    {
+        return _mm256_set1_ps(v);
+    }
+
+    static type add(type a, type b) noexcept
+    {
+        return _mm256_add_ps(a, b);
+    }
+
+    static type sub(type a, type b) noexcept
+    {
+        return _mm256_sub_ps(a, b);
+    }
+
+    static type mul(type a, type b) noexcept
+    {
+        return _mm256_mul_ps(a, b);
+    }
+
+    static type div(type a, type b) noexcept
+    {
+        return _mm256_div_ps(a, b);
+    }
+
+    static type fmadd(type a, type b, type c) noexcept
+    {
+        return _mm256_fmadd_ps(a, b, c);
+    }
+
+    static type sqrt(type v) noexcept
+    {
+        return _mm256_sqrt_ps(v);
+    }
+
+    static type min(type a, type b) noexcept
+    {
+        return _mm256_min_ps(a, b);
+    }
+
+    static type max(type a, type b) noexcept
+    {
+        return _mm256_max_ps(a, b);
+    }
+
+    static mask less(type a, type b) noexcept
+    {
+        return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+    }
+
+    static mask greater(type a, type b) noexcept
+    {
+        return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+    }
+
+    static type select(mask m, type a, type b) noexcept
+    {
+        return _mm256_blendv_ps(b, a, m);
+    }
+
+private:
+    // 4x4 transpose inside each 128-bit half.
+    static void transpose(type (&v)[4]) noexcept
+    {
+        type t0 = _mm256_unpacklo_ps(v[0], v[1]);
+        type t1 = _mm256_unpacklo_ps(v[2], v[3]);
+        type t2 = _mm256_unpackhi_ps(v[0], v[1]);
+        type t3 = _mm256_unpackhi_ps(v[2], v[3]);
+        v[0] = _mm256_shuffle_ps(t0, t1, 0x44);
+        v[1] = _mm256_shuffle_ps(t0, t1, 0xEE);
+        v[2] = _mm256_shuffle_ps(t2, t3, 0x44);
+        v[3] = _mm256_shuffle_ps(t2, t3, 0xEE);
+    }
+};
+#endif
+
+#ifdef __AVX512F__
+/**
+ * Covers two packs per register, the lower half is the first pack.
+ */
+struct avx512_lane
+{
+    using type = __m512;
+    using mask = __mmask16;
+    using tail = avx2_lane;
+
+    static constexpr std::size_t lane_count = 16;
+    static constexpr std::size_t pack_count = 2;
+
+    static type load(const float* p, std::size_t stride) noexcept
+    {
+        __m512d low = _mm512_castpd256_pd512(_mm256_castps_pd(_mm256_load_ps(p)));
+        __m256d high = _mm256_castps_pd(_mm256_load_ps(p + stride));
+        return _mm512_castpd_ps(_mm512_insertf64x4(low, high, 1));
+    }
+
+    static void store(float* p, std::size_t stride, type v) noexcept
+    {
+        _mm256_store_ps(p, _mm512_castps512_ps256(v));
+        __m256d high = _mm512_extractf64x4_pd(_mm512_castps_pd(v), 1);
+        _mm256_store_ps(p + stride, _mm256_castpd_ps(high));
+    }
+
+    static void transpose_load(const float* p, std::size_t stride, type (&v)[4]) noexcept
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            v[i] = _mm512_castps128_ps512(_mm_loadu_ps(p + i * stride));
+            v[i] = _mm512_insertf32x4(v[i], _mm_loadu_ps(p + (i + 4) * stride), 1);
+            v[i] = _mm512_insertf32x4(v[i], _mm_loadu_ps(p + (i + 8) * stride), 2);
+            v[i] = _mm512_insertf32x4(v[i], _mm_loadu_ps(p + (i + 12) * stride), 3);
+        }
+        transpose(v);
+    }
+
+    static void transpose_store(float* p, std::size_t stride, type (&v)[4]) noexcept
+    {
+        transpose(v);
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            _mm_storeu_ps(p + i * stride, _mm512_castps512_ps128(v[i]));
+        }
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            _mm_storeu_ps(p + (i + 4) * stride, _mm512_extractf32x4_ps(v[i], 1));
+        }
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            _mm_storeu_ps(p + (i + 8) * stride, _mm512_extractf32x4_ps(v[i], 2));
+        }
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            _mm_storeu_ps(p + (i + 12) * stride, _mm512_extractf32x4_ps(v[i], 3));
+        }
+    }
+
+    static type set1(float v) noexcept
+    {
+        return _mm512_set1_ps(v);
+    }
+
+    static type add(type a, type b) noexcept
+    {
+        return _mm512_add_ps(a, b);
+    }
+
+    static type sub(type a, type b) noexcept
+    {
+        return _mm512_sub_ps(a, b);
+    }
+
+    static type mul(type a, type b) noexcept
+    {
+        return _mm512_mul_ps(a, b);
+    }
+
+    static type div(type a, type b) noexcept
+    {
+        return _mm512_div_ps(a, b);
+    }
+
+    static type fmadd(type a, type b, type c) noexcept
+    {
+        return _mm512_fmadd_ps(a, b, c);
+    }
+
+    static type sqrt(type v) noexcept
+    {
+        return _mm512_sqrt_ps(v);
+    }
+
+    static type min(type a, type b) noexcept
+    {
+        return _mm512_min_ps(a, b);
+    }
+
+    static type max(type a, type b) noexcept
+    {
+        return _mm512_max_ps(a, b);
+    }
+
+    static mask less(type a, type b) noexcept
+    {
+        return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+    }
+
+    static mask greater(type a, type b) noexcept
+    {
+        return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+    }
+
+    static type select(mask m, type a, type b) noexcept
+    {
+        return _mm512_mask_blend_ps(m, b, a);
+    }
+
+private:
+    // 4x4 transpose inside each 128-bit quarter.
+    static void transpose(type (&v)[4]) noexcept
+    {
+        type t0 = _mm512_unpacklo_ps(v[0], v[1]);
+        type t1 = _mm512_unpacklo_ps(v[2], v[3]);
+        type t2 = _mm512_unpackhi_ps(v[0], v[1]);
+        type t3 = _mm512_unpackhi_ps(v[2], v[3]);
+        v[0] = _mm512_shuffle_ps(t0, t1, 0x44);
+        v[1] = _mm512_shuffle_ps(t0, t1, 0xEE);
+        v[2] = _mm512_shuffle_ps(t2, t3, 0x44);
+        v[3] = _mm512_shuffle_ps(t2, t3, 0xEE);
+    }
+
+};
+#endif
+} // namespace
+} // namespace violet::batch_kernel
\ No newline at end of file
@@ -0,0 +1,10 @@
+#include "batch_kernel.hpp"
+#include "batch_lane.hpp"
+
+namespace violet
+{
+batch_kernels get_batch_kernels_sse() noexcept
+{
+    return batch_kernel::make_kernels<batch_kernel::sse_lane>();
+}
+} // namespace violet
\ No newline at end of file
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "math/batch_types.hpp"
+#include "math/box.hpp"
+#include "math/sphere.hpp"
+#include <span>
+
+namespace violet
+{
+/**
+ * @brief Math over structure of arrays packs of BATCH_WIDTH elements. Every function applies the
+ * scalar operation of the same name in matrix or quaternion to each lane.
+ *
+ * Kernels are compiled for SSE, AVX2 and AVX-512, the widest one the CPU supports is selected at
+ * startup. Inputs and results are spans of the same length, results must not alias inputs unless
+ * noted otherwise.
+ */
+struct batch
+{
+    static simd_level get_simd_level() noexcept;
+
+    /**
+     * @brief Forces the kernels of a level, levels above what the CPU supports are clamped. Used to
+     * compare levels against each other.
+     */
+    static void set_simd_level(simd_level level) noexcept;
+
+    // Matrix, the result may alias a or b.
+    static void mul(
+        std::span<const mat4f_x8> a,
+        std::span<const mat4f_x8> b,
+        std::span<mat4f_x8> result);
+
+    // General inverse, the result may alias m.
+    static void inverse(std::span<const mat4f_x8> m, std::span<mat4f_x8> result);
+
+    // Inverse of matrices without shear, see matrix::inverse_transform. The result may alias m.
+    static void inverse_transform(std::span<const mat4f_x8> m, std::span<mat4f_x8> result);
+
+    static void affine_transform(
+        std::span<const vec3f_x8> scale,
+        std::span<const vec4f_x8> rotation,
+        std::span<const vec3f_x8> translation,
+        std::span<mat4f_x8> result);
+
+    // Points with w = 1, every lane uses its own matrix.
+    static void transform_point(
+        std::span<const vec3f_x8> points,
+        std::span<const mat4f_x8> m,
+        std::span<vec3f_x8> result);
+
+    // Points with w = 1, every lane uses the same matrix.
+    static void transform_point(
+        std::span<const vec3f_x8> points,
+        const mat4f& m,
+        std::span<vec3f_x8> result);
+
+    // Quaternion, the result may alias a or b.
+    static void quaternion_mul(
+        std::span<const vec4f_x8> a,
+        std::span<const vec4f_x8> b,
+        std::span<vec4f_x8> result);
+
+    static void quaternion_mul_vec(
+        std::span<const vec4f_x8> q,
+        std::span<const vec3f_x8> v,
+        std::span<vec3f_x8> result);
+
+    static void quaternion_normalize(std::span<const vec4f_x8> q, std::span<vec4f_x8> result);
+
+    static void quaternion_slerp(
+        std::span<const vec4f_x8> a,
+        std::span<const vec4f_x8> b,
+        float t,
+        std::span<vec4f_x8> result);
+
+    // Geometry stored as arrays of structures, every element is transformed by the same matrix.
+    // Spans can be split into ranges and processed concurrently, e.g. with
+    // task_executor::parallel_for, bounds of the ranges are then merged with box::expand.
+
+    static void transform_points(
+        std::span<const vec3f> points,
+        const mat4f& m,
+        std::span<vec3f> result);
+
+    /**
+     * @brief Transforms directions by the upper 3x3 of m and normalizes them. Pass the inverse
+     * transpose for matrices with non-uniform scale.
+     */
+    static void transform_normals(
+        std::span<const vec3f> normals,
+        const mat4f& m,
+        std::span<vec3f> result);
+
+    // Radii are scaled by the largest axis scale of m.
+    static void transform_spheres(
+        std::span<const sphere3f> spheres,
+        const mat4f& m,
+        std::span<sphere3f> result);
+
+    // Bounds of the transformed corners, same as box::transform.
+    static void transform_boxes(
+        std::span<const box3f> boxes,
+        const mat4f& m,
+        std::span<box3f> result);
+
+    // Same as box::expand over every point, an empty span returns an empty box.
+    [[nodiscard]] static box3f get_bounds(std::span<const vec3f> points);
+
+    static void set(vec3f_x8& pack, std::size_t lane, const vec3f& value) noexcept
+    {
+        pack.x[lane] = value.x;
+        pack.y[lane] = value.y;
+        pack.z[lane] = value.z;
+    }
+
+    static void set(vec4f_x8& pack, std::size_t lane, const vec4f& value) noexcept
+    {
+        pack.x[lane] = value.x;
+        pack.y[lane] = value.y;
+        pack.z[lane] = value.z;
+        pack.w[lane] = value.w;
+    }
+
+    static void set(mat4f_x8& pack, std::size_t lane, const mat4f& value) noexcept
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            for (std::size_t j = 0; j < 4; ++j)
+            {
+                pack.m[i][j][lane] = value[i][j];
+            }
+        }
+    }
+
+    [[nodiscard]] static vec3f get(const vec3f_x8& pack, std::size_t lane) noexcept
+    {
+        return {pack.x[lane], pack.y[lane], pack.z[lane]};
+    }
+
+    [[nodiscard]] static vec4f get(const vec4f_x8& pack, std::size_t lane) noexcept
+    {
+        return {pack.x[lane], pack.y[lane], pack.z[lane], pack.w[lane]};
+    }
+
+    [[nodiscard]] static mat4f get(const mat4f_x8& pack, std::size_t lane) noexcept
+    {
+        mat4f result;
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            for (std::size_t j = 0; j < 4; ++j)
+            {
+                result[i][j] = pack.m[i][j][lane];
+            }
+        }
+        return result;
+    }
+};
+} // namespace violet
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+namespace violet
+{
+/**
+ * @brief Elements in a structure of arrays pack. Batch kernels process 4, 8 or 16 lanes per
+ * instruction depending on the simd level, see batch::get_simd_level.
+ */
+static constexpr std::size_t BATCH_WIDTH = 8;
+
+struct alignas(32) vec3f_x8
+{
+    float x[BATCH_WIDTH];
+    float y[BATCH_WIDTH];
+    float z[BATCH_WIDTH];
+};
+
+struct alignas(32) vec4f_x8
+{
+    float x[BATCH_WIDTH];
+    float y[BATCH_WIDTH];
+    float z[BATCH_WIDTH];
+    float w[BATCH_WIDTH];
+};
+
+struct alignas(32) mat4f_x8
+{
+    // [row][column][lane]
+    float m[4][4][BATCH_WIDTH];
+};
+
+enum simd_level
+{
+    SIMD_LEVEL_SSE,
+    SIMD_LEVEL_AVX2,
+    SIMD_LEVEL_AVX512,
+};
+} // namespace violet
\ No newline at end of file
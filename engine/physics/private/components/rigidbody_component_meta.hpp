@@ -22,6 +22,9 @@ public:
 
     bool dirty{false};
     mat4f transform;
+
+    // Transform before the last step, frames between steps blend from it to transform.
+    mat4f previous_transform;
 };
 
 class rigidbody_motion_state_kinematic : public rigidbody_motion_state
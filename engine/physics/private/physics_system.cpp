@@ -1,4 +1,5 @@
 #include "physics/physics_system.hpp"
+#include "common/frame_allocator.hpp"
 #include "components/collider_component.hpp"
 #include "components/hierarchy_component.hpp"
 #include "components/joint_component.hpp"
@@ -17,9 +18,40 @@
 
 namespace violet
 {
+class graphics_system;
+
+namespace
+{
+mat4f_simd interpolate_transform(const mat4f& previous, const mat4f& current, float t)
+{
+    if (previous == current)
+    {
+        return math::load(current);
+    }
+
+    vec4f_simd previous_scale;
+    vec4f_simd previous_rotation;
+    vec4f_simd previous_position;
+    matrix::decompose(math::load(previous), previous_scale, previous_rotation, previous_position);
+
+    vec4f_simd current_scale;
+    vec4f_simd current_rotation;
+    vec4f_simd current_position;
+    matrix::decompose(math::load(current), current_scale, current_rotation, current_position);
+
+    return matrix::affine_transform(
+        vector::lerp(previous_scale, current_scale, t),
+        quaternion::slerp(previous_rotation, current_rotation, t),
+        vector::lerp(previous_position, current_position, t));
+}
+} // namespace
+
 physics_system::physics_system()
     : system("physics")
 {
+    // Graphics is optional, if installed the rendering group must exist before physics orders
+    // itself before it.
+    add_dependency<transform_system, graphics_system>();
 }
 
 physics_system::~physics_system()
@@ -31,19 +63,26 @@ physics_system::~physics_system()
     m_plugin = nullptr;
 }
 
-bool physics_system::initialize(const dictionary& config)
+bool physics_system::load(const dictionary& config)
 {
     m_plugin = std::make_unique<physics_plugin>();
     m_plugin->load(config["plugin"]);
     m_context = std::make_unique<physics_context>(m_plugin->get_plugin());
 
+    return true;
+}
+
+bool physics_system::initialize(const dictionary& config)
+{
     auto& task_graph = get_task_graph();
     auto& post_update_group = task_graph.get_group("PostUpdate");
     auto& transform_group = task_graph.get_group("Transform");
     auto& physics_group = task_graph.add_group()
                               .set_name("Physics")
                               .set_group(post_update_group)
-                              .add_dependency(transform_group);
+                              .add_dependency(transform_group)
+                              .set_tick_rate(60.0f, 3);
+    m_physics_group = &physics_group;
 
     task_graph.add_task()
         .set_name("Physics Simulation")
@@ -57,12 +96,27 @@ bool physics_system::initialize(const dictionary& config)
                 update_joint();
                 simulation();
 
-                get_system<transform_system>().update_transform();
-
                 m_system_version = get_world().get_version();
             });
 
-    task_graph.get_group("Rendering").add_dependency(physics_group);
+    // Runs every frame, so bodies move smoothly between the fixed steps of the physics group.
+    auto& interpolation_task = task_graph.add_task()
+                                   .set_name("Physics Interpolation")
+                                   .set_group(post_update_group)
+                                   .add_dependency(physics_group)
+                                   .set_execute(
+                                       [this]()
+                                       {
+                                           interpolation();
+
+                                           get_system<transform_system>().update_transform();
+                                       });
+
+    // The rendering group only exists if graphics is installed, headless runs skip it.
+    if (task_group* rendering_group = task_graph.find_group("Rendering"))
+    {
+        rendering_group->add_dependency(interpolation_task);
+    }
 
     auto& world = get_world();
     world.register_component<rigidbody_component>();
@@ -79,13 +133,30 @@ bool physics_system::initialize(const dictionary& config)
 
 void physics_system::simulation()
 {
-    constexpr float time_step = 1.0f / 60.0f;
+    // The physics group runs at a fixed rate, the graph decides how many steps are due.
+    float time_step = m_physics_group->get_step_delta();
 
-    m_time += get_timer().get_frame_delta();
-    m_time = std::min(m_time, 3.0f * time_step);
+    auto& world = get_world();
 
-    while (m_time > time_step)
+    for (std::uint32_t i = 0; i < m_physics_group->get_step_count(); ++i)
     {
+        world.get_view().read<rigidbody_component_meta>().each(
+            [](const rigidbody_component_meta& rigidbody_meta)
+            {
+                auto* motion_state = rigidbody_meta.motion_state.get();
+                if (motion_state == nullptr)
+                {
+                    return;
+                }
+
+                // A body that moved in the last step is written once more, even if it sleeps now.
+                if (motion_state->previous_transform != motion_state->transform)
+                {
+                    motion_state->dirty = true;
+                }
+                motion_state->previous_transform = motion_state->transform;
+            });
+
         for (auto& scene : m_scenes)
         {
             if (scene != nullptr)
@@ -97,11 +168,23 @@ void physics_system::simulation()
                 scene->simulation(time_step);
             }
         }
+    }
 
-        m_time -= time_step;
+#ifdef VIOLET_PHYSICS_DEBUG_DRAW
+    auto& debug_drawer = get_system<graphics_system>().get_debug_drawer();
+
+    for (const auto& line : m_debug->get_lines())
+    {
+        debug_drawer.draw_line(line.start, line.end, line.color);
     }
+#endif
+}
 
-    std::vector<entity> root_entities;
+void physics_system::interpolation()
+{
+    float interpolation = m_physics_group->get_interpolation();
+
+    frame_vector<entity> root_entities;
 
     auto& world = get_world();
     world.get_view()
@@ -116,17 +199,8 @@ void physics_system::simulation()
 
     for (entity root : root_entities)
     {
-        update_transform(root, {}, false);
-    }
-
-#ifdef VIOLET_PHYSICS_DEBUG_DRAW
-    auto& debug_drawer = get_system<graphics_system>().get_debug_drawer();
-
-    for (const auto& line : m_debug->get_lines())
-    {
-        debug_drawer.draw_line(line.start, line.end, line.color);
+        update_transform(root, {}, false, interpolation);
     }
-#endif
 }
 
 void physics_system::update_rigidbody()
@@ -163,6 +237,8 @@ void physics_system::update_rigidbody()
                     mat4f_simd initial_transform =
                         matrix::mul(math::load(rigidbody.offset), math::load(transform.matrix));
                     math::store(initial_transform, rigidbody_meta.motion_state->transform);
+                    rigidbody_meta.motion_state->previous_transform =
+                        rigidbody_meta.motion_state->transform;
 
                     phy_rigidbody_desc desc = {
                         .type = rigidbody.type,
@@ -329,7 +405,11 @@ void physics_system::update_joint()
             });
 }
 
-void physics_system::update_transform(entity e, const mat4f& parent_world, bool parent_dirty)
+void physics_system::update_transform(
+    entity e,
+    const mat4f& parent_world,
+    bool parent_dirty,
+    float interpolation)
 {
     auto& world = get_world();
 
@@ -340,9 +420,16 @@ void physics_system::update_transform(entity e, const mat4f& parent_world, bool
     {
         const auto& rigidbody = world.get_component<const rigidbody_component>(e);
         const auto& rigidbody_meta = world.get_component<const rigidbody_component_meta>(e);
-        if (rigidbody_meta.motion_state->dirty || parent_dirty)
+        const auto& motion_state = *rigidbody_meta.motion_state;
+
+        // Bodies still moving are written every frame, at the blend of the last two steps.
+        bool moving = motion_state.previous_transform != motion_state.transform;
+        if (motion_state.dirty || moving || parent_dirty)
         {
-            mat4f_simd rigidbody_matrix = math::load(rigidbody_meta.motion_state->transform);
+            mat4f_simd rigidbody_matrix = interpolate_transform(
+                motion_state.previous_transform,
+                motion_state.transform,
+                interpolation);
             mat4f_simd offset_matrix = math::load(rigidbody.offset);
             mat4f_simd offset_matrix_inv = matrix::inverse(offset_matrix);
             mat4f_simd world_matrix = matrix::mul(offset_matrix_inv, rigidbody_matrix);
@@ -404,7 +491,7 @@ void physics_system::update_transform(entity e, const mat4f& parent_world, bool
     {
         for (const auto& child : world.get_component<const child_component>(e).children)
         {
-            update_transform(child, current_world_matrix, dirty);
+            update_transform(child, current_world_matrix, dirty, interpolation);
         }
     }
 }
@@ -19,6 +19,7 @@ public:
     physics_system();
     virtual ~physics_system();
 
+    bool load(const dictionary& config) override;
     bool initialize(const dictionary& config) override;
 
     physics_context* get_context() const noexcept
@@ -82,10 +83,15 @@ private:
     };
 
     void simulation();
+    void interpolation();
 
     void update_rigidbody();
     void update_joint();
-    void update_transform(entity e, const mat4f& parent_world, bool parent_dirty);
+    void update_transform(
+        entity e,
+        const mat4f& parent_world,
+        bool parent_dirty,
+        float interpolation);
 
     physics_scene* get_scene(std::uint32_t layer);
 
@@ -103,7 +109,7 @@ private:
 
     std::uint32_t m_system_version{0};
 
-    float m_time{0.0f};
+    task_group* m_physics_group{nullptr};
 
 #ifdef VIOLET_PHYSICS_DEBUG_DRAW
     std::unique_ptr<physics_debug> m_debug;
@@ -14,6 +14,7 @@ public:
     virtual ~vk_fence();
 
     void wait(std::uint64_t value) override;
+    std::uint64_t get_value() const override;
 
     VkSemaphore get_semaphore() const noexcept
     {
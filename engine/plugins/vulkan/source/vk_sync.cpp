@@ -39,4 +39,11 @@ void vk_fence::wait(std::uint64_t value)
 
     vkWaitSemaphores(m_context->get_device(), &wait_info, UINT64_MAX);
 }
+
+std::uint64_t vk_fence::get_value() const
+{
+    std::uint64_t value = 0;
+    vk_check(vkGetSemaphoreCounterValue(m_context->get_device(), m_semaphore, &value));
+    return value;
+}
 } // namespace violet::vk
\ No newline at end of file
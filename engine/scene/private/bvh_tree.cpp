@@ -0,0 +1,1003 @@
+#include "scene/bvh_tree.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace violet
+{
+namespace
+{
+float get_area(const box3f& box) noexcept
+{
+    vec3f extent = box::get_extent(box);
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+box3f get_union(const box3f& a, const box3f& b) noexcept
+{
+    box3f result = a;
+    box::expand(result, b);
+    return result;
+}
+
+bool contains(const box3f& outer, const box3f& inner) noexcept
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+           outer.min.z <= inner.min.z && outer.max.x >= inner.max.x &&
+           outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+template <typename Node, typename Functor>
+void traverse_box(
+    const std::vector<Node>& nodes,
+    std::uint32_t root,
+    std::uint32_t leaf_bit,
+    const box3f& box,
+    std::vector<std::uint32_t>& stack,
+    Functor&& functor)
+{
+    __m128 box_min_x = _mm_set1_ps(box.min.x);
+    __m128 box_min_y = _mm_set1_ps(box.min.y);
+    __m128 box_min_z = _mm_set1_ps(box.min.z);
+    __m128 box_max_x = _mm_set1_ps(box.max.x);
+    __m128 box_max_y = _mm_set1_ps(box.max.y);
+    __m128 box_max_z = _mm_set1_ps(box.max.z);
+
+    stack.clear();
+    stack.push_back(root);
+
+    while (!stack.empty())
+    {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        __m128 x = _mm_and_ps(
+            _mm_cmple_ps(_mm_load_ps(node.min_x), box_max_x),
+            _mm_cmpge_ps(_mm_load_ps(node.max_x), box_min_x));
+        __m128 y = _mm_and_ps(
+            _mm_cmple_ps(_mm_load_ps(node.min_y), box_max_y),
+            _mm_cmpge_ps(_mm_load_ps(node.max_y), box_min_y));
+        __m128 z = _mm_and_ps(
+            _mm_cmple_ps(_mm_load_ps(node.min_z), box_max_z),
+            _mm_cmpge_ps(_mm_load_ps(node.max_z), box_min_z));
+
+        auto mask = static_cast<std::uint32_t>(_mm_movemask_ps(_mm_and_ps(_mm_and_ps(x, y), z)));
+        mask &= (1u << node.count) - 1;
+
+        while (mask != 0)
+        {
+            std::uint32_t child = node.children[std::countr_zero(mask)];
+            mask &= mask - 1;
+
+            if (child & leaf_bit)
+            {
+                functor(child & ~leaf_bit);
+            }
+            else
+            {
+                stack.push_back(child);
+            }
+        }
+    }
+}
+} // namespace
+
+bvh_tree::bvh_tree(float margin)
+    : m_margin(margin)
+{
+}
+
+bvh_tree::~bvh_tree() {}
+
+bvh_tree::proxy_id bvh_tree::add(const box3f& bounds, std::uint32_t user_data)
+{
+    proxy_id id;
+    if (m_free_proxies.empty())
+    {
+        id = static_cast<proxy_id>(m_proxies.size());
+        m_proxies.emplace_back();
+    }
+    else
+    {
+        id = m_free_proxies.back();
+        m_free_proxies.pop_back();
+    }
+
+    vec3f margin = {m_margin, m_margin, m_margin};
+
+    proxy& proxy = m_proxies[id];
+    proxy.bounds = bounds;
+    proxy.fat_bounds.min = bounds.min - margin;
+    proxy.fat_bounds.max = bounds.max + margin;
+    proxy.user_data = user_data;
+
+    insert_leaf(id);
+
+    return id;
+}
+
+void bvh_tree::remove(proxy_id proxy)
+{
+    remove_leaf(proxy);
+    m_free_proxies.push_back(proxy);
+}
+
+bool bvh_tree::update(proxy_id proxy, const box3f& bounds)
+{
+    auto& data = m_proxies[proxy];
+
+    if (contains(data.fat_bounds, bounds))
+    {
+        data.bounds = bounds;
+        set_slot_bounds(data.node, data.slot, bounds);
+        return false;
+    }
+
+    remove_leaf(proxy);
+
+    // Extend the fat box in the direction of movement, so a proxy that keeps moving the same way
+    // is reinserted less often.
+    vec3f displacement = (box::get_center(bounds) - box::get_center(data.bounds)) * 2.0f;
+    vec3f margin = {m_margin, m_margin, m_margin};
+
+    data.bounds = bounds;
+    data.fat_bounds.min = bounds.min - margin;
+    data.fat_bounds.max = bounds.max + margin;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        if (displacement[i] < 0.0f)
+        {
+            data.fat_bounds.min[i] += displacement[i];
+        }
+        else
+        {
+            data.fat_bounds.max[i] += displacement[i];
+        }
+    }
+
+    insert_leaf(proxy);
+
+    return true;
+}
+
+void bvh_tree::clear()
+{
+    m_root = INVALID_NODE;
+    m_nodes.clear();
+    m_free_nodes.clear();
+    m_proxies.clear();
+    m_free_proxies.clear();
+    m_optimize_cursor = 0;
+}
+
+void bvh_tree::optimize(std::size_t node_count)
+{
+    node_count = std::min(node_count, m_nodes.size());
+
+    for (std::size_t i = 0; i < node_count; ++i)
+    {
+        if (m_optimize_cursor >= m_nodes.size())
+        {
+            m_optimize_cursor = 0;
+        }
+
+        std::uint32_t node_index = m_optimize_cursor++;
+        if (m_nodes[node_index].count != 0)
+        {
+            rotate(node_index);
+        }
+    }
+}
+
+std::size_t bvh_tree::get_height() const
+{
+    if (m_root == INVALID_NODE)
+    {
+        return 0;
+    }
+
+    std::size_t height = 0;
+
+    std::vector<std::pair<std::uint32_t, std::size_t>> stack;
+    stack.emplace_back(m_root, 1);
+    while (!stack.empty())
+    {
+        auto [node_index, depth] = stack.back();
+        stack.pop_back();
+
+        height = std::max(height, depth);
+
+        const node& node = m_nodes[node_index];
+        for (std::uint32_t i = 0; i < node.count; ++i)
+        {
+            if ((node.children[i] & LEAF_BIT) == 0)
+            {
+                stack.emplace_back(node.children[i], depth + 1);
+            }
+        }
+    }
+
+    return height;
+}
+
+float bvh_tree::get_cost() const
+{
+    float cost = 0.0f;
+    for (std::uint32_t i = 0; i < m_nodes.size(); ++i)
+    {
+        if (m_nodes[i].count != 0)
+        {
+            cost += get_area(get_node_bounds(i));
+        }
+    }
+    return cost;
+}
+
+std::array<vec4f, 6> bvh_tree::get_frustum_planes(const mat4f& view_projection) noexcept
+{
+    auto column = [&](std::size_t index) -> vec4f
+    {
+        return {
+            view_projection[0][index],
+            view_projection[1][index],
+            view_projection[2][index],
+            view_projection[3][index],
+        };
+    };
+
+    vec4f x = column(0);
+    vec4f y = column(1);
+    vec4f z = column(2);
+    vec4f w = column(3);
+
+    std::array<vec4f, 6> planes = {
+        vec4f{w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w},
+        vec4f{w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w},
+        vec4f{w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w},
+        vec4f{w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w},
+        z,
+        vec4f{w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w},
+    };
+
+    for (vec4f& plane : planes)
+    {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f)
+        {
+            plane = {plane.x / length, plane.y / length, plane.z / length, plane.w / length};
+        }
+    }
+
+    return planes;
+}
+
+void bvh_tree::frustum_culling(
+    std::span<const vec4f, 6> planes,
+    std::vector<proxy_id>& visible) const
+{
+    if (m_root == INVALID_NODE)
+    {
+        return;
+    }
+
+    struct plane_info
+    {
+        __m128 x;
+        __m128 y;
+        __m128 z;
+        __m128 w;
+
+        // Offsets of the corner furthest along the plane normal.
+        std::size_t positive_x;
+        std::size_t positive_y;
+        std::size_t positive_z;
+    };
+
+    std::array<plane_info, 6> frustum;
+    for (std::size_t i = 0; i < planes.size(); ++i)
+    {
+        frustum[i].x = _mm_set1_ps(planes[i].x);
+        frustum[i].y = _mm_set1_ps(planes[i].y);
+        frustum[i].z = _mm_set1_ps(planes[i].z);
+        frustum[i].w = _mm_set1_ps(planes[i].w);
+        frustum[i].positive_x = planes[i].x >= 0.0f ? offsetof(node, max_x) : offsetof(node, min_x);
+        frustum[i].positive_y = planes[i].y >= 0.0f ? offsetof(node, max_y) : offsetof(node, min_y);
+        frustum[i].positive_z = planes[i].z >= 0.0f ? offsetof(node, max_z) : offsetof(node, min_z);
+    }
+
+    // Offset of the opposite corner.
+    auto negative = [](std::size_t offset)
+    {
+        return offset >= offsetof(node, max_x) ? offset - offsetof(node, max_x)
+                                               : offset + offsetof(node, max_x);
+    };
+
+    std::vector<std::uint32_t> stack;
+    std::vector<std::uint32_t> inside_stack;
+
+    stack.push_back(m_root);
+    while (!stack.empty())
+    {
+        const node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        const auto* base = reinterpret_cast<const char*>(&node);
+
+        __m128 outside = _mm_setzero_ps();
+        __m128 intersect = _mm_setzero_ps();
+
+        for (const auto& plane : frustum)
+        {
+            __m128 px = _mm_load_ps(reinterpret_cast<const float*>(base + plane.positive_x));
+            __m128 py = _mm_load_ps(reinterpret_cast<const float*>(base + plane.positive_y));
+            __m128 pz = _mm_load_ps(reinterpret_cast<const float*>(base + plane.positive_z));
+
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(plane.x, px), _mm_mul_ps(plane.y, py)),
+                _mm_add_ps(_mm_mul_ps(plane.z, pz), plane.w));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+
+            __m128 nx =
+                _mm_load_ps(reinterpret_cast<const float*>(base + negative(plane.positive_x)));
+            __m128 ny =
+                _mm_load_ps(reinterpret_cast<const float*>(base + negative(plane.positive_y)));
+            __m128 nz =
+                _mm_load_ps(reinterpret_cast<const float*>(base + negative(plane.positive_z)));
+
+            distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(plane.x, nx), _mm_mul_ps(plane.y, ny)),
+                _mm_add_ps(_mm_mul_ps(plane.z, nz), plane.w));
+            intersect = _mm_or_ps(intersect, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+
+        auto valid = (1u << node.count) - 1;
+        auto mask = ~static_cast<std::uint32_t>(_mm_movemask_ps(outside)) & valid;
+        auto partial = static_cast<std::uint32_t>(_mm_movemask_ps(intersect));
+
+        while (mask != 0)
+        {
+            auto slot = static_cast<std::uint32_t>(std::countr_zero(mask));
+            mask &= mask - 1;
+
+            std::uint32_t child = node.children[slot];
+            if (child & LEAF_BIT)
+            {
+                visible.push_back(child & ~LEAF_BIT);
+            }
+            else if (partial & (1u << slot))
+            {
+                stack.push_back(child);
+            }
+            else
+            {
+                // Fully inside, everything below is visible.
+                collect_leaves(child, inside_stack, visible);
+            }
+        }
+    }
+}
+
+void bvh_tree::query_sphere(const sphere3f& sphere, std::vector<proxy_id>& result) const
+{
+    if (m_root == INVALID_NODE)
+    {
+        return;
+    }
+
+    __m128 center_x = _mm_set1_ps(sphere.center.x);
+    __m128 center_y = _mm_set1_ps(sphere.center.y);
+    __m128 center_z = _mm_set1_ps(sphere.center.z);
+    __m128 radius_sq = _mm_set1_ps(sphere.radius * sphere.radius);
+
+    auto distance = [](__m128 center, const float* min, const float* max)
+    {
+        __m128 d = _mm_max_ps(
+            _mm_sub_ps(_mm_load_ps(min), center),
+            _mm_sub_ps(center, _mm_load_ps(max)));
+        return _mm_max_ps(d, _mm_setzero_ps());
+    };
+
+    std::vector<std::uint32_t> stack;
+    stack.push_back(m_root);
+
+    while (!stack.empty())
+    {
+        const node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        __m128 dx = distance(center_x, node.min_x, node.max_x);
+        __m128 dy = distance(center_y, node.min_y, node.max_y);
+        __m128 dz = distance(center_z, node.min_z, node.max_z);
+        __m128 distance_sq =
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+        auto mask =
+            static_cast<std::uint32_t>(_mm_movemask_ps(_mm_cmple_ps(distance_sq, radius_sq)));
+        mask &= (1u << node.count) - 1;
+
+        while (mask != 0)
+        {
+            std::uint32_t child = node.children[std::countr_zero(mask)];
+            mask &= mask - 1;
+
+            if (child & LEAF_BIT)
+            {
+                result.push_back(child & ~LEAF_BIT);
+            }
+            else
+            {
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+void bvh_tree::query_box(const box3f& box, std::vector<proxy_id>& result) const
+{
+    if (m_root == INVALID_NODE)
+    {
+        return;
+    }
+
+    std::vector<std::uint32_t> stack;
+    traverse_box(
+        m_nodes,
+        m_root,
+        LEAF_BIT,
+        box,
+        stack,
+        [&](proxy_id proxy)
+        {
+            result.push_back(proxy);
+        });
+}
+
+void bvh_tree::raycast(std::span<const ray> rays, std::span<ray_hit> hits) const
+{
+    std::vector<std::pair<std::uint32_t, float>> stack;
+
+    for (std::size_t i = 0; i < rays.size(); ++i)
+    {
+        hits[i] = {};
+
+        if (m_root == INVALID_NODE)
+        {
+            continue;
+        }
+
+        const ray& ray = rays[i];
+
+        // Avoid 0 * inf for axis aligned rays.
+        auto inverse = [](float direction)
+        {
+            return 1.0f / std::copysign(std::max(std::abs(direction), 1e-20f), direction);
+        };
+
+        __m128 origin_x = _mm_set1_ps(ray.origin.x);
+        __m128 origin_y = _mm_set1_ps(ray.origin.y);
+        __m128 origin_z = _mm_set1_ps(ray.origin.z);
+        __m128 inverse_x = _mm_set1_ps(inverse(ray.direction.x));
+        __m128 inverse_y = _mm_set1_ps(inverse(ray.direction.y));
+        __m128 inverse_z = _mm_set1_ps(inverse(ray.direction.z));
+
+        float closest = ray.max_distance;
+        proxy_id closest_proxy = INVALID_PROXY;
+
+        stack.clear();
+        stack.emplace_back(m_root, 0.0f);
+
+        while (!stack.empty())
+        {
+            auto [node_index, distance] = stack.back();
+            stack.pop_back();
+
+            if (distance > closest)
+            {
+                continue;
+            }
+
+            const node& node = m_nodes[node_index];
+
+            __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.min_x), origin_x), inverse_x);
+            __m128 x2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.max_x), origin_x), inverse_x);
+            __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.min_y), origin_y), inverse_y);
+            __m128 y2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.max_y), origin_y), inverse_y);
+            __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.min_z), origin_z), inverse_z);
+            __m128 z2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.max_z), origin_z), inverse_z);
+
+            __m128 t_near = _mm_max_ps(
+                _mm_max_ps(_mm_min_ps(x1, x2), _mm_min_ps(y1, y2)),
+                _mm_max_ps(_mm_min_ps(z1, z2), _mm_setzero_ps()));
+            __m128 t_far = _mm_min_ps(
+                _mm_min_ps(_mm_max_ps(x1, x2), _mm_max_ps(y1, y2)),
+                _mm_min_ps(_mm_max_ps(z1, z2), _mm_set1_ps(closest)));
+
+            auto mask = static_cast<std::uint32_t>(_mm_movemask_ps(_mm_cmple_ps(t_near, t_far)));
+            mask &= (1u << node.count) - 1;
+
+            alignas(16) float distances[NODE_WIDTH];
+            _mm_store_ps(distances, t_near);
+
+            std::pair<std::uint32_t, float> inner[NODE_WIDTH];
+            std::uint32_t inner_count = 0;
+
+            while (mask != 0)
+            {
+                auto slot = static_cast<std::uint32_t>(std::countr_zero(mask));
+                mask &= mask - 1;
+
+                std::uint32_t child = node.children[slot];
+                if (child & LEAF_BIT)
+                {
+                    if (distances[slot] < closest)
+                    {
+                        closest = distances[slot];
+                        closest_proxy = child & ~LEAF_BIT;
+                    }
+                }
+                else
+                {
+                    inner[inner_count++] = {child, distances[slot]};
+                }
+            }
+
+            // Push the nearest child last, so it is visited first.
+            for (std::uint32_t j = 1; j < inner_count; ++j)
+            {
+                for (std::uint32_t k = j; k > 0 && inner[k - 1].second < inner[k].second; --k)
+                {
+                    std::swap(inner[k - 1], inner[k]);
+                }
+            }
+            stack.insert(stack.end(), inner, inner + inner_count);
+        }
+
+        if (closest_proxy != INVALID_PROXY)
+        {
+            hits[i] = {.proxy = closest_proxy, .distance = closest};
+        }
+    }
+}
+
+void bvh_tree::query_boxes(std::span<const box3f> boxes, std::vector<overlap>& overlaps) const
+{
+    if (m_root == INVALID_NODE)
+    {
+        return;
+    }
+
+    std::vector<std::uint32_t> stack;
+    for (std::size_t i = 0; i < boxes.size(); ++i)
+    {
+        traverse_box(
+            m_nodes,
+            m_root,
+            LEAF_BIT,
+            boxes[i],
+            stack,
+            [&](proxy_id proxy)
+            {
+                overlaps.push_back({
+                    .query = static_cast<std::uint32_t>(i),
+                    .proxy = proxy,
+                });
+            });
+    }
+}
+
+void bvh_tree::insert_leaf(proxy_id proxy)
+{
+    const box3f fat_bounds = m_proxies[proxy].fat_bounds;
+
+    if (m_root == INVALID_NODE)
+    {
+        m_root = allocate_node();
+    }
+
+    __m128 fat_min_x = _mm_set1_ps(fat_bounds.min.x);
+    __m128 fat_min_y = _mm_set1_ps(fat_bounds.min.y);
+    __m128 fat_min_z = _mm_set1_ps(fat_bounds.min.z);
+    __m128 fat_max_x = _mm_set1_ps(fat_bounds.max.x);
+    __m128 fat_max_y = _mm_set1_ps(fat_bounds.max.y);
+    __m128 fat_max_z = _mm_set1_ps(fat_bounds.max.z);
+
+    auto area = [](__m128 x, __m128 y, __m128 z)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, y), _mm_mul_ps(y, z)), _mm_mul_ps(z, x));
+    };
+
+    // Deepest node on the path whose child bounds did not grow, nothing above it changed.
+    std::uint32_t stable_node = INVALID_NODE;
+
+    std::uint32_t node_index = m_root;
+    while (true)
+    {
+        node& node = m_nodes[node_index];
+
+        if (node.count < NODE_WIDTH)
+        {
+            set_child(node_index, node.count, proxy | LEAF_BIT, m_proxies[proxy].bounds);
+            ++node.count;
+            break;
+        }
+
+        // Descend into the child whose surface area grows the least.
+        __m128 min_x = _mm_load_ps(node.min_x);
+        __m128 min_y = _mm_load_ps(node.min_y);
+        __m128 min_z = _mm_load_ps(node.min_z);
+        __m128 max_x = _mm_load_ps(node.max_x);
+        __m128 max_y = _mm_load_ps(node.max_y);
+        __m128 max_z = _mm_load_ps(node.max_z);
+
+        __m128 old_area =
+            area(_mm_sub_ps(max_x, min_x), _mm_sub_ps(max_y, min_y), _mm_sub_ps(max_z, min_z));
+        __m128 new_area = area(
+            _mm_sub_ps(_mm_max_ps(max_x, fat_max_x), _mm_min_ps(min_x, fat_min_x)),
+            _mm_sub_ps(_mm_max_ps(max_y, fat_max_y), _mm_min_ps(min_y, fat_min_y)),
+            _mm_sub_ps(_mm_max_ps(max_z, fat_max_z), _mm_min_ps(min_z, fat_min_z)));
+
+        alignas(16) float cost[NODE_WIDTH];
+        _mm_store_ps(cost, _mm_sub_ps(new_area, old_area));
+
+        std::uint32_t best_slot = 0;
+        for (std::uint32_t i = 1; i < NODE_WIDTH; ++i)
+        {
+            if (cost[i] < cost[best_slot])
+            {
+                best_slot = i;
+            }
+        }
+
+        std::uint32_t child = node.children[best_slot];
+        if (child & LEAF_BIT)
+        {
+            // Pair the leaf with the new proxy in a new node.
+            box3f slot_bounds = get_union(get_child_bounds(node_index, best_slot), fat_bounds);
+
+            std::uint32_t new_node_index = allocate_node();
+
+            proxy_id other = child & ~LEAF_BIT;
+            set_child(new_node_index, 0, child, m_proxies[other].bounds);
+            set_child(new_node_index, 1, proxy | LEAF_BIT, m_proxies[proxy].bounds);
+            m_nodes[new_node_index].count = 2;
+
+            set_child(node_index, best_slot, new_node_index, slot_bounds);
+
+            node_index = new_node_index;
+            break;
+        }
+
+        box3f slot_bounds = get_slot_bounds(node_index, best_slot);
+        if (contains(slot_bounds, fat_bounds))
+        {
+            stable_node = node_index;
+        }
+        else
+        {
+            set_slot_bounds(node_index, best_slot, get_union(slot_bounds, fat_bounds));
+        }
+        node_index = child;
+    }
+
+    for (std::size_t depth = 0; node_index != INVALID_NODE; ++depth)
+    {
+        if (node_index == stable_node && depth > 1)
+        {
+            break;
+        }
+
+        rotate(node_index);
+        node_index = m_nodes[node_index].parent;
+    }
+}
+
+void bvh_tree::remove_leaf(proxy_id proxy)
+{
+    std::uint32_t node_index = m_proxies[proxy].node;
+    std::uint32_t slot = m_proxies[proxy].slot;
+
+    m_proxies[proxy].node = INVALID_NODE;
+
+    node& node = m_nodes[node_index];
+
+    std::uint32_t last = node.count - 1;
+    if (slot != last)
+    {
+        set_child(node_index, slot, node.children[last], get_slot_bounds(node_index, last));
+    }
+    set_slot_bounds(node_index, last, box3f());
+    node.children[last] = INVALID_NODE;
+    --node.count;
+
+    if (node_index == m_root)
+    {
+        if (node.count == 0)
+        {
+            free_node(node_index);
+            m_root = INVALID_NODE;
+        }
+        else if (node.count == 1 && (node.children[0] & LEAF_BIT) == 0)
+        {
+            m_root = node.children[0];
+            m_nodes[m_root].parent = INVALID_NODE;
+            m_nodes[m_root].parent_slot = 0;
+            free_node(node_index);
+        }
+        return;
+    }
+
+    if (node.count == 1)
+    {
+        // Replace the node with its only child.
+        std::uint32_t parent = node.parent;
+        set_child(parent, node.parent_slot, node.children[0], get_slot_bounds(node_index, 0));
+        free_node(node_index);
+
+        node_index = parent;
+    }
+
+    refit(node_index);
+}
+
+void bvh_tree::refit(std::uint32_t node_index)
+{
+    while (node_index != m_root)
+    {
+        const node& node = m_nodes[node_index];
+
+        box3f bounds = get_node_bounds(node_index);
+        if (bounds == get_slot_bounds(node.parent, node.parent_slot))
+        {
+            break;
+        }
+
+        set_slot_bounds(node.parent, node.parent_slot, bounds);
+        node_index = node.parent;
+    }
+}
+
+void bvh_tree::rotate(std::uint32_t node_index)
+{
+    // Try swapping a child of the node with a grandchild, this keeps the bounds of the node but
+    // can shrink the bounds of the child that receives the swapped subtree.
+    const node& node = m_nodes[node_index];
+
+    float best_benefit = 0.0f;
+    std::uint32_t best_a = 0;
+    std::uint32_t best_b = 0;
+    std::uint32_t best_c = 0;
+
+    for (std::uint32_t a = 0; a < node.count; ++a)
+    {
+        std::uint32_t child = node.children[a];
+        if (child & LEAF_BIT)
+        {
+            continue;
+        }
+
+        const auto& child_node = m_nodes[child];
+
+        // Fat bounds of the grandchildren, the union of all lanes except one is the bounds of the
+        // child if that grandchild is swapped out.
+        alignas(16) float bounds[6][NODE_WIDTH];
+        for (std::uint32_t c = 0; c < NODE_WIDTH; ++c)
+        {
+            box3f grandchild_bounds = c < child_node.count ? get_child_bounds(child, c) : box3f();
+            bounds[0][c] = grandchild_bounds.min.x;
+            bounds[1][c] = grandchild_bounds.min.y;
+            bounds[2][c] = grandchild_bounds.min.z;
+            bounds[3][c] = grandchild_bounds.max.x;
+            bounds[4][c] = grandchild_bounds.max.y;
+            bounds[5][c] = grandchild_bounds.max.z;
+        }
+
+        auto others_min = [](const float* values)
+        {
+            __m128 v = _mm_load_ps(values);
+            return _mm_min_ps(
+                simd::shuffle<1, 2, 3, 0>(v),
+                _mm_min_ps(simd::shuffle<2, 3, 0, 1>(v), simd::shuffle<3, 0, 1, 2>(v)));
+        };
+        auto others_max = [](const float* values)
+        {
+            __m128 v = _mm_load_ps(values);
+            return _mm_max_ps(
+                simd::shuffle<1, 2, 3, 0>(v),
+                _mm_max_ps(simd::shuffle<2, 3, 0, 1>(v), simd::shuffle<3, 0, 1, 2>(v)));
+        };
+
+        __m128 min_x = others_min(bounds[0]);
+        __m128 min_y = others_min(bounds[1]);
+        __m128 min_z = others_min(bounds[2]);
+        __m128 max_x = others_max(bounds[3]);
+        __m128 max_y = others_max(bounds[4]);
+        __m128 max_z = others_max(bounds[5]);
+
+        float area = get_area(get_slot_bounds(node_index, a));
+
+        for (std::uint32_t b = 0; b < node.count; ++b)
+        {
+            if (b == a)
+            {
+                continue;
+            }
+
+            box3f sibling_bounds = get_child_bounds(node_index, b);
+
+            __m128 x = _mm_sub_ps(
+                _mm_max_ps(max_x, _mm_set1_ps(sibling_bounds.max.x)),
+                _mm_min_ps(min_x, _mm_set1_ps(sibling_bounds.min.x)));
+            __m128 y = _mm_sub_ps(
+                _mm_max_ps(max_y, _mm_set1_ps(sibling_bounds.max.y)),
+                _mm_min_ps(min_y, _mm_set1_ps(sibling_bounds.min.y)));
+            __m128 z = _mm_sub_ps(
+                _mm_max_ps(max_z, _mm_set1_ps(sibling_bounds.max.z)),
+                _mm_min_ps(min_z, _mm_set1_ps(sibling_bounds.min.z)));
+
+            alignas(16) float new_area[NODE_WIDTH];
+            _mm_store_ps(
+                new_area,
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, y), _mm_mul_ps(y, z)), _mm_mul_ps(z, x)));
+
+            for (std::uint32_t c = 0; c < child_node.count; ++c)
+            {
+                // Ignore tiny improvements, they only reshuffle the tree.
+                float benefit = area - new_area[c];
+                if (benefit > best_benefit && benefit > area * 1e-3f)
+                {
+                    best_benefit = benefit;
+                    best_a = a;
+                    best_b = b;
+                    best_c = c;
+                }
+            }
+        }
+    }
+
+    if (best_benefit == 0.0f)
+    {
+        return;
+    }
+
+    std::uint32_t child = node.children[best_a];
+    std::uint32_t sibling = node.children[best_b];
+    std::uint32_t grandchild = m_nodes[child].children[best_c];
+
+    box3f sibling_bounds = get_slot_bounds(node_index, best_b);
+    box3f grandchild_bounds = get_slot_bounds(child, best_c);
+
+    set_child(child, best_c, sibling, sibling_bounds);
+    set_child(node_index, best_b, grandchild, grandchild_bounds);
+    set_slot_bounds(node_index, best_a, get_node_bounds(child));
+}
+
+void bvh_tree::set_child(
+    std::uint32_t node_index,
+    std::uint32_t slot,
+    std::uint32_t child,
+    const box3f& bounds) noexcept
+{
+    m_nodes[node_index].children[slot] = child;
+    set_slot_bounds(node_index, slot, bounds);
+
+    if (child & LEAF_BIT)
+    {
+        proxy& proxy = m_proxies[child & ~LEAF_BIT];
+        proxy.node = node_index;
+        proxy.slot = slot;
+    }
+    else
+    {
+        node& node = m_nodes[child];
+        node.parent = node_index;
+        node.parent_slot = static_cast<std::uint16_t>(slot);
+    }
+}
+
+void bvh_tree::set_slot_bounds(
+    std::uint32_t node_index,
+    std::uint32_t slot,
+    const box3f& bounds) noexcept
+{
+    node& node = m_nodes[node_index];
+    node.min_x[slot] = bounds.min.x;
+    node.min_y[slot] = bounds.min.y;
+    node.min_z[slot] = bounds.min.z;
+    node.max_x[slot] = bounds.max.x;
+    node.max_y[slot] = bounds.max.y;
+    node.max_z[slot] = bounds.max.z;
+}
+
+box3f bvh_tree::get_slot_bounds(std::uint32_t node_index, std::uint32_t slot) const noexcept
+{
+    const node& node = m_nodes[node_index];
+
+    box3f bounds;
+    bounds.min = {node.min_x[slot], node.min_y[slot], node.min_z[slot]};
+    bounds.max = {node.max_x[slot], node.max_y[slot], node.max_z[slot]};
+    return bounds;
+}
+
+box3f bvh_tree::get_child_bounds(std::uint32_t node_index, std::uint32_t slot) const noexcept
+{
+    std::uint32_t child = m_nodes[node_index].children[slot];
+    if (child & LEAF_BIT)
+    {
+        return m_proxies[child & ~LEAF_BIT].fat_bounds;
+    }
+    return get_slot_bounds(node_index, slot);
+}
+
+box3f bvh_tree::get_node_bounds(std::uint32_t node_index) const noexcept
+{
+    box3f bounds;
+    for (std::uint32_t i = 0; i < m_nodes[node_index].count; ++i)
+    {
+        box::expand(bounds, get_child_bounds(node_index, i));
+    }
+    return bounds;
+}
+
+void bvh_tree::collect_leaves(
+    std::uint32_t node_index,
+    std::vector<std::uint32_t>& stack,
+    std::vector<proxy_id>& result) const
+{
+    stack.clear();
+    stack.push_back(node_index);
+
+    while (!stack.empty())
+    {
+        const node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        for (std::uint32_t i = 0; i < node.count; ++i)
+        {
+            if (node.children[i] & LEAF_BIT)
+            {
+                result.push_back(node.children[i] & ~LEAF_BIT);
+            }
+            else
+            {
+                stack.push_back(node.children[i]);
+            }
+        }
+    }
+}
+
+std::uint32_t bvh_tree::allocate_node()
+{
+    std::uint32_t node_index;
+    if (m_free_nodes.empty())
+    {
+        node_index = static_cast<std::uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+    else
+    {
+        node_index = m_free_nodes.back();
+        m_free_nodes.pop_back();
+    }
+
+    node& node = m_nodes[node_index];
+    for (std::uint32_t i = 0; i < NODE_WIDTH; ++i)
+    {
+        set_slot_bounds(node_index, i, box3f());
+        node.children[i] = INVALID_NODE;
+    }
+    node.parent = INVALID_NODE;
+    node.parent_slot = 0;
+    node.count = 0;
+
+    return node_index;
+}
+
+void bvh_tree::free_node(std::uint32_t node_index)
+{
+    node& node = m_nodes[node_index];
+    node.parent = INVALID_NODE;
+    node.count = 0;
+
+    m_free_nodes.push_back(node_index);
+}
+} // namespace violet
\ No newline at end of file
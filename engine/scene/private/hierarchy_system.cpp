@@ -1,5 +1,6 @@
 #include "scene/hierarchy_system.hpp"
 #include "components/hierarchy_component.hpp"
+#include "components/transform_component.hpp"
 
 namespace violet
 {
@@ -29,6 +30,12 @@ bool hierarchy_system::initialize(const dictionary& config)
                 process_add_parent();
                 process_set_parent();
                 process_remove_parent();
+
+                if (m_depth_order_dirty)
+                {
+                    update_depth_order();
+                }
+
                 m_system_version = get_world().get_version();
             });
 
@@ -39,6 +46,8 @@ void hierarchy_system::destroy(entity e)
 {
     auto& world = get_world();
 
+    m_depth_order_dirty = true;
+
     std::queue<entity> queue;
     queue.push(e);
 
@@ -98,6 +107,11 @@ void hierarchy_system::process_add_parent()
                 }
             });
 
+    if (!add_parent_entities.empty())
+    {
+        m_depth_order_dirty = true;
+    }
+
     for (auto& [e, parent] : add_parent_entities)
     {
         world.add_component<previous_parent_component>(e);
@@ -120,7 +134,7 @@ void hierarchy_system::process_set_parent()
     std::vector<std::pair<entity, entity>> add_child_entities;
 
     world.get_view().read<entity>().read<parent_component>().read<previous_parent_component>().each(
-        [&world, &remove_child_entities, &remove_parent_entities, &add_child_entities](
+        [this, &world, &remove_child_entities, &remove_parent_entities, &add_child_entities](
             const entity& e,
             const parent_component& parent,
             const previous_parent_component& previous_parent)
@@ -130,6 +144,8 @@ void hierarchy_system::process_set_parent()
                 return;
             }
 
+            m_depth_order_dirty = true;
+
             auto& previous_parent_children =
                 world.get_component<child_component>(previous_parent.parent);
 
@@ -217,6 +233,11 @@ void hierarchy_system::process_remove_parent()
                 remove_previous_parent_entities.push_back(e);
             });
 
+    if (!remove_previous_parent_entities.empty())
+    {
+        m_depth_order_dirty = true;
+    }
+
     for (auto& e : remove_child_entities)
     {
         world.remove_component<child_component>(e);
@@ -227,4 +248,60 @@ void hierarchy_system::process_remove_parent()
         world.remove_component<previous_parent_component>(e);
     }
 }
+
+void hierarchy_system::update_depth_order()
+{
+    auto& world = get_world();
+
+    m_nodes.clear();
+    m_level_offsets.clear();
+    m_level_offsets.push_back(0);
+
+    world.get_view()
+        .read<entity>()
+        .read<child_component>()
+        .with<transform_component>()
+        .without<parent_component>()
+        .each(
+            [this](const entity& e, const child_component& child)
+            {
+                for (entity c : child.children)
+                {
+                    m_nodes.push_back({
+                        .e = c,
+                        .parent = e,
+                        .parent_index = hierarchy_node::ROOT_PARENT,
+                    });
+                }
+            });
+
+    std::size_t level_begin = 0;
+    while (level_begin != m_nodes.size())
+    {
+        std::size_t level_end = m_nodes.size();
+        m_level_offsets.push_back(static_cast<std::uint32_t>(level_end));
+
+        for (std::size_t i = level_begin; i < level_end; ++i)
+        {
+            entity e = m_nodes[i].e;
+            if (!world.has_component<child_component>(e))
+            {
+                continue;
+            }
+
+            for (entity c : world.get_component<const child_component>(e).children)
+            {
+                m_nodes.push_back({
+                    .e = c,
+                    .parent = e,
+                    .parent_index = static_cast<std::uint32_t>(i),
+                });
+            }
+        }
+
+        level_begin = level_end;
+    }
+
+    m_depth_order_dirty = false;
+}
 } // namespace violet
\ No newline at end of file
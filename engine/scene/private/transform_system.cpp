@@ -1,5 +1,6 @@
 #include "scene/transform_system.hpp"
 #include "components/hierarchy_component.hpp"
+#include "math/batch.hpp"
 #include "math/matrix.hpp"
 #include "scene/hierarchy_system.hpp"
 
@@ -165,72 +166,95 @@ void transform_system::update_world(bool force)
                        view.template is_updated<transform_local_component>(m_system_version);
             });
 
-    std::vector<entity> root_entities;
+    // Children are updated level by level in the depth order kept by hierarchy_system. Resolving
+    // components and propagating dirty flags is sequential, the matrix multiplications of a level
+    // are independent and run in parallel, BATCH_WIDTH at a time with batch::mul.
+    static constexpr std::size_t grain_size = 256;
 
-    world.get_view().read<entity>().with<transform_component>().without<parent_component>().each(
-        [&root_entities](const entity& e)
-        {
-            root_entities.push_back(e);
-        });
+    auto& hierarchy = get_system<hierarchy_system>();
 
-    for (auto& root : root_entities)
+    m_node_updated.assign(hierarchy.get_node_count(), 0);
+
+    for (std::size_t level = 0; level < hierarchy.get_level_count(); ++level)
     {
-        if (world.has_component<child_component>(root))
+        std::span<const hierarchy_node> nodes = hierarchy.get_level(level);
+        std::size_t node_offset = hierarchy.get_level_offset(level);
+
+        m_world_updates.clear();
+
+        for (std::size_t i = 0; i < nodes.size(); ++i)
         {
-            bool root_dirty =
-                force || world.is_updated<transform_local_component>(root, m_system_version);
+            const hierarchy_node& node = nodes[i];
 
-            const auto& root_transform = world.get_component<const transform_world_component>(root);
-            for (const auto& child : world.get_component<const child_component>(root).children)
+            bool parent_dirty = false;
+            if (node.parent_index == hierarchy_node::ROOT_PARENT)
             {
-                update_world_recursive(child, root_transform, root_dirty);
+                parent_dirty = force || world.is_updated<transform_local_component>(
+                                            node.parent,
+                                            m_system_version);
+            }
+            else
+            {
+                parent_dirty = m_node_updated[node.parent_index] != 0;
             }
-        }
-    }
-}
-
-void transform_system::update_world_recursive(
-    entity e,
-    const transform_world_component& parent_world_transform,
-    bool parent_dirty)
-{
-    auto& world = get_world();
-
-    const auto& transform = world.get_component<const transform_component>(e);
-
-    bool need_update = parent_dirty || transform.is_world_dirty() ||
-                       world.is_updated<parent_component>(e, m_system_version);
-
-    if (need_update)
-    {
-        auto& world_transform = world.get_component<transform_world_component>(e);
-        world_transform.scale = vector::mul(parent_world_transform.scale, transform.get_scale());
-
-        mat4f_simd local_matrix =
-            math::load(world.get_component<const transform_local_component>(e).matrix);
-        mat4f_simd parent_matrix = math::load(parent_world_transform.matrix);
-        math::store(matrix::mul(local_matrix, parent_matrix), world_transform.matrix);
 
-        transform.clear_world_dirty();
+            const auto& transform = world.get_component<const transform_component>(node.e);
 
-        if (world.has_component<child_component>(e))
-        {
-            for (const auto& child : world.get_component<const child_component>(e).children)
+            bool need_update = parent_dirty || transform.is_world_dirty() ||
+                               world.is_updated<parent_component>(node.e, m_system_version);
+            if (!need_update)
             {
-                update_world_recursive(child, world_transform, true);
+                continue;
             }
+
+            m_node_updated[node_offset + i] = 1;
+
+            m_world_updates.push_back({
+                .transform = &transform,
+                .local = &world.get_component<const transform_local_component>(node.e),
+                .parent = &world.get_component<const transform_world_component>(node.parent),
+                .world = &world.get_component<transform_world_component>(node.e),
+            });
         }
-    }
-    else
-    {
-        if (world.has_component<child_component>(e))
-        {
-            const auto& world_transform = world.get_component<const transform_world_component>(e);
-            for (const auto& child : world.get_component<const child_component>(e).children)
+
+        get_task_executor().parallel_for(
+            m_world_updates.size(),
+            grain_size,
+            [this](std::size_t begin, std::size_t end)
             {
-                update_world_recursive(child, world_transform, false);
-            }
-        }
+                mat4f_x8 local_matrices;
+                mat4f_x8 parent_matrices;
+
+                for (std::size_t pack_begin = begin; pack_begin < end; pack_begin += BATCH_WIDTH)
+                {
+                    std::size_t pack_end = std::min(pack_begin + BATCH_WIDTH, end);
+
+                    // Lanes past the end of the range repeat the last update and are not stored.
+                    for (std::size_t lane = 0; lane < BATCH_WIDTH; ++lane)
+                    {
+                        const world_update& update =
+                            m_world_updates[std::min(pack_begin + lane, pack_end - 1)];
+                        batch::set(local_matrices, lane, update.local->matrix);
+                        batch::set(parent_matrices, lane, update.parent->matrix);
+                    }
+
+                    batch::mul(
+                        std::span(&local_matrices, 1),
+                        std::span(&parent_matrices, 1),
+                        std::span(&local_matrices, 1));
+
+                    for (std::size_t i = pack_begin; i < pack_end; ++i)
+                    {
+                        const world_update& update = m_world_updates[i];
+
+                        update.world->scale =
+                            vector::mul(update.parent->scale, update.transform->get_scale());
+                        update.world->matrix = batch::get(local_matrices, i - pack_begin);
+
+                        update.transform->clear_world_dirty();
+                    }
+                }
+            });
     }
 }
 } // namespace violet
\ No newline at end of file
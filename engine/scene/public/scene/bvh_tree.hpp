@@ -1,79 +1,197 @@
 #pragma once
 
-#include "scene/bounding_box.hpp"
+#include "math/box.hpp"
+#include "math/sphere.hpp"
 #include <array>
-#include <queue>
-#include <stack>
+#include <limits>
+#include <span>
+#include <vector>
 
 namespace violet
 {
+/**
+ * @brief Dynamic AABB tree with four children per node.
+ *
+ * The bounds of the children of a node are stored as structure of arrays, so every node is tested
+ * against a frustum, sphere, box or ray with a single pass of 4-wide SSE instructions. Proxies are
+ * inserted with a fat box, moving a proxy inside its fat box only rewrites its own bounds.
+ *
+ * Queries are const and can run concurrently, e.g. by splitting a batch across
+ * task_executor::parallel_for.
+ */
 class bvh_tree
 {
 public:
-    bvh_tree();
+    using proxy_id = std::uint32_t;
+    static constexpr proxy_id INVALID_PROXY = std::numeric_limits<proxy_id>::max();
 
-    std::size_t add(const bounding_volume_aabb& aabb);
-    void remove(std::size_t proxy_id);
+    struct ray
+    {
+        vec3f origin;
+        vec3f direction;
+        float max_distance{std::numeric_limits<float>::max()};
+    };
+
+    struct ray_hit
+    {
+        proxy_id proxy{INVALID_PROXY};
+        float distance{std::numeric_limits<float>::max()};
+    };
+
+    struct overlap
+    {
+        std::uint32_t query;
+        proxy_id proxy;
+    };
+
+    bvh_tree(float margin = 0.1f);
+    bvh_tree(const bvh_tree&) = delete;
+    ~bvh_tree();
+
+    proxy_id add(const box3f& bounds, std::uint32_t user_data = 0);
+    void remove(proxy_id proxy);
+
+    /**
+     * @brief Updates the bounds of a proxy. Returns true if the proxy left its fat box and was
+     * reinserted.
+     */
+    bool update(proxy_id proxy, const box3f& bounds);
 
     void clear();
 
-    std::size_t update(std::size_t proxy_id, const bounding_volume_aabb& aabb);
+    /**
+     * @brief Runs tree rotations on up to node_count nodes, continuing where the previous call
+     * stopped. Rotations are also applied along the insertion path, this spreads the rest over
+     * frames.
+     */
+    void optimize(std::size_t node_count);
 
-    bool visible(std::size_t proxy_id) const noexcept { return m_nodes[proxy_id].visible; }
-    void frustum_culling(const std::array<float4, 6>& frustum);
+    const box3f& get_bounds(proxy_id proxy) const noexcept
+    {
+        return m_proxies[proxy].bounds;
+    }
 
-    template <typename T>
-    void print(T&& functor)
+    const box3f& get_fat_bounds(proxy_id proxy) const noexcept
     {
-        if (m_root_index == INVALID_NODE_INDEX)
-            return;
+        return m_proxies[proxy].fat_bounds;
+    }
 
-        std::stack<std::size_t> dfs;
-        dfs.push(m_root_index);
+    std::uint32_t get_user_data(proxy_id proxy) const noexcept
+    {
+        return m_proxies[proxy].user_data;
+    }
 
-        while (!dfs.empty())
-        {
-            auto index = dfs.top();
-            dfs.pop();
+    std::size_t get_proxy_count() const noexcept
+    {
+        return m_proxies.size() - m_free_proxies.size();
+    }
 
-            functor(m_nodes[index].aabb, m_nodes[index].visible);
+    std::size_t get_height() const;
 
-            if (m_nodes[index].depth > 0)
-            {
-                dfs.push(m_nodes[index].left_child);
-                dfs.push(m_nodes[index].right_child);
-            }
-        }
-    }
+    /**
+     * @brief Sum of the surface areas of all nodes, the lower the cheaper queries are.
+     */
+    float get_cost() const;
 
-private:
-    static constexpr std::size_t INVALID_NODE_INDEX = -1;
+    /**
+     * @brief Extracts the planes of a row-vector view projection matrix, pointing inwards.
+     */
+    static std::array<vec4f, 6> get_frustum_planes(const mat4f& view_projection) noexcept;
+
+    /**
+     * @brief Appends proxies whose bounds are not outside any of the planes. A point p is inside a
+     * plane if dot(plane.xyz, p) + plane.w >= 0.
+     */
+    void frustum_culling(std::span<const vec4f, 6> planes, std::vector<proxy_id>& visible) const;
 
-    struct bvh_node
+    void query_sphere(const sphere3f& sphere, std::vector<proxy_id>& result) const;
+    void query_box(const box3f& box, std::vector<proxy_id>& result) const;
+
+    /**
+     * @brief Finds the closest proxy bounds hit by each ray.
+     */
+    void raycast(std::span<const ray> rays, std::span<ray_hit> hits) const;
+
+    /**
+     * @brief Appends a pair for every proxy that overlaps one of the boxes.
+     */
+    void query_boxes(std::span<const box3f> boxes, std::vector<overlap>& overlaps) const;
+
+private:
+    static constexpr std::uint32_t INVALID_NODE = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint32_t LEAF_BIT = 1u << 31;
+    static constexpr std::uint32_t NODE_WIDTH = 4;
+
+    /**
+     * @brief Leaf children store the exact bounds of their proxy, inner children the union of the
+     * fat boxes below them.
+     */
+    struct alignas(64) node
     {
-        bounding_volume_aabb aabb;
+        float min_x[NODE_WIDTH];
+        float min_y[NODE_WIDTH];
+        float min_z[NODE_WIDTH];
+        float max_x[NODE_WIDTH];
+        float max_y[NODE_WIDTH];
+        float max_z[NODE_WIDTH];
+
+        std::uint32_t children[NODE_WIDTH];
+
+        std::uint32_t parent;
+        std::uint16_t parent_slot;
+        std::uint16_t count;
+    };
 
-        std::size_t parent;
-        std::size_t left_child;
-        std::size_t right_child;
+    struct proxy
+    {
+        box3f bounds;
+        box3f fat_bounds;
 
-        int depth;
+        std::uint32_t user_data;
 
-        bool visible;
+        std::uint32_t node;
+        std::uint32_t slot;
     };
 
-    void balance(std::size_t index);
-    std::size_t rotate(std::size_t index);
+    void insert_leaf(proxy_id proxy);
+    void remove_leaf(proxy_id proxy);
+
+    void refit(std::uint32_t node_index);
+    void rotate(std::uint32_t node_index);
+
+    void set_child(
+        std::uint32_t node_index,
+        std::uint32_t slot,
+        std::uint32_t child,
+        const box3f& bounds) noexcept;
+    void set_slot_bounds(
+        std::uint32_t node_index,
+        std::uint32_t slot,
+        const box3f& bounds) noexcept;
+    box3f get_slot_bounds(std::uint32_t node_index, std::uint32_t slot) const noexcept;
+
+    // Bounds a child occupies in its parent, the fat box for leaves.
+    box3f get_child_bounds(std::uint32_t node_index, std::uint32_t slot) const noexcept;
+    box3f get_node_bounds(std::uint32_t node_index) const noexcept;
+
+    void collect_leaves(
+        std::uint32_t node_index,
+        std::vector<std::uint32_t>& stack,
+        std::vector<proxy_id>& result) const;
+
+    std::uint32_t allocate_node();
+    void free_node(std::uint32_t node_index);
+
+    float m_margin;
 
-    float calculate_cost(const bounding_volume_aabb& aabb);
-    bounding_volume_aabb union_box(const bounding_volume_aabb& a, const bounding_volume_aabb& b);
+    std::uint32_t m_root{INVALID_NODE};
 
-    std::size_t allocate_node();
-    void free_node(std::size_t index);
+    std::vector<node> m_nodes;
+    std::vector<std::uint32_t> m_free_nodes;
 
-    std::size_t m_root_index;
+    std::vector<proxy> m_proxies;
+    std::vector<proxy_id> m_free_proxies;
 
-    std::deque<bvh_node> m_nodes;
-    std::queue<std::size_t> m_free_nodes;
+    std::uint32_t m_optimize_cursor{0};
 };
 } // namespace violet
\ No newline at end of file
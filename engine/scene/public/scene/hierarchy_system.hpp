@@ -1,9 +1,22 @@
 #pragma once
 
 #include "core/engine.hpp"
+#include <limits>
+#include <span>
 
 namespace violet
 {
+struct hierarchy_node
+{
+    static constexpr std::uint32_t ROOT_PARENT = std::numeric_limits<std::uint32_t>::max();
+
+    entity e;
+    entity parent;
+
+    // Index of the parent in the depth order, ROOT_PARENT if the parent has no parent.
+    std::uint32_t parent_index;
+};
+
 class hierarchy_system : public system
 {
 public:
@@ -13,11 +26,43 @@ public:
 
     void destroy(entity e);
 
+    /**
+     * @brief Returns the entities that have a parent, grouped by depth. Level 0 holds the children
+     * of root entities, and every parent appears in an earlier level than its children.
+     */
+    std::span<const hierarchy_node> get_level(std::size_t level) const noexcept
+    {
+        return std::span<const hierarchy_node>(m_nodes).subspan(
+            m_level_offsets[level],
+            m_level_offsets[level + 1] - m_level_offsets[level]);
+    }
+
+    std::size_t get_level_offset(std::size_t level) const noexcept
+    {
+        return m_level_offsets[level];
+    }
+
+    std::size_t get_level_count() const noexcept
+    {
+        return m_level_offsets.size() - 1;
+    }
+
+    std::size_t get_node_count() const noexcept
+    {
+        return m_nodes.size();
+    }
+
 private:
     void process_add_parent();
     void process_set_parent();
     void process_remove_parent();
 
+    void update_depth_order();
+
+    std::vector<hierarchy_node> m_nodes;
+    std::vector<std::uint32_t> m_level_offsets{0};
+    bool m_depth_order_dirty{true};
+
     std::uint32_t m_system_version{0};
 };
 } // namespace violet
\ No newline at end of file
@@ -23,10 +23,17 @@ private:
     void update_local(bool force = false);
     void update_world(bool force = false);
 
-    void update_world_recursive(
-        entity e,
-        const transform_world_component& parent_world_transform,
-        bool parent_dirty);
+    struct world_update
+    {
+        const transform_component* transform;
+        const transform_local_component* local;
+        const transform_world_component* parent;
+        transform_world_component* world;
+    };
+
+    // Whether the world matrix of each hierarchy node was updated this frame, in depth order.
+    std::vector<std::uint8_t> m_node_updated;
+    std::vector<world_update> m_world_updates;
 
     std::uint32_t m_system_version{0};
 };
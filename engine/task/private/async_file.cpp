@@ -0,0 +1,135 @@
+#include "task/async_file.hpp"
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace violet
+{
+async_file::async_file(async_file&& other) noexcept
+    : m_file(std::exchange(other.m_file, invalid_file)),
+      m_size(std::exchange(other.m_size, 0))
+{
+}
+
+async_file::~async_file()
+{
+    close();
+}
+
+bool async_file::open(std::string_view path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(
+        std::string(path).c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = reinterpret_cast<std::intptr_t>(file);
+    m_size = static_cast<std::uint64_t>(size.QuadPart);
+#else
+    int file = ::open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat info = {};
+    if (fstat(file, &info) != 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    m_file = file;
+    m_size = static_cast<std::uint64_t>(info.st_size);
+#endif
+
+    return true;
+}
+
+void async_file::close()
+{
+    if (!is_open())
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    CloseHandle(reinterpret_cast<HANDLE>(m_file));
+#else
+    ::close(static_cast<int>(m_file));
+#endif
+
+    m_file = invalid_file;
+    m_size = 0;
+}
+
+async_task<bool> async_file::read(
+    task_executor& executor,
+    std::string path,
+    std::vector<char>& data)
+{
+    static constexpr std::size_t chunk_size = 1024 * 1024;
+
+    async_file file;
+    if (!file.open(path))
+    {
+        co_return false;
+    }
+
+    data.resize(file.get_size());
+
+    std::vector<io_request> requests;
+    for (std::size_t offset = 0; offset < data.size(); offset += chunk_size)
+    {
+        std::size_t size = std::min(chunk_size, data.size() - offset);
+        requests.push_back(file.make_request(offset, std::span<char>(data.data() + offset, size)));
+    }
+
+    co_await executor.read(requests);
+
+    co_return std::ranges::all_of(
+        requests,
+        [](const io_request& request)
+        {
+            return request.result == static_cast<std::int64_t>(request.buffer.size());
+        });
+}
+
+async_file& async_file::operator=(async_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        m_file = std::exchange(other.m_file, invalid_file);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+} // namespace violet
\ No newline at end of file
@@ -0,0 +1,454 @@
+#include "io_service.hpp"
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define VIOLET_IO_URING
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace violet
+{
+namespace
+{
+// Largest single read, larger requests are split by the retry path.
+constexpr std::size_t max_read_size = 1 << 30;
+} // namespace
+
+#ifdef VIOLET_IO_URING
+class task_executor::io_service::uring
+{
+public:
+    static std::unique_ptr<uring> create()
+    {
+        io_uring_params params = {};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = queue_depth * 4;
+
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        // IORING_OP_READ and IORING_FEAT_RW_CUR_POS were both added in 5.6.
+        constexpr std::uint32_t required_features =
+            IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS;
+        if ((params.features & required_features) != required_features)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        auto result = std::unique_ptr<uring>(new uring(fd, params));
+        if (!result->is_valid())
+        {
+            return nullptr;
+        }
+
+        result->m_thread = std::thread(
+            [ring = result.get()]()
+            {
+                ring->tick();
+            });
+
+        return result;
+    }
+
+    ~uring()
+    {
+        if (m_thread.joinable())
+        {
+            // A nop without user data stops the completion thread.
+            std::scoped_lock lock(m_submit_mutex);
+
+            io_uring_sqe* sqe = get_sqe();
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = 0;
+            flush();
+        }
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+
+        if (m_sqes != MAP_FAILED)
+        {
+            munmap(m_sqes, m_sqes_size);
+        }
+
+        if (m_ring != MAP_FAILED)
+        {
+            munmap(m_ring, m_ring_size);
+        }
+
+        close(m_fd);
+    }
+
+    void submit(std::span<io_request> requests)
+    {
+        std::scoped_lock lock(m_submit_mutex);
+
+        for (io_request& request : requests)
+        {
+            prepare_read(request);
+        }
+        flush();
+    }
+
+private:
+    static constexpr std::uint32_t queue_depth = 256;
+
+    uring(int fd, const io_uring_params& params)
+        : m_fd(fd)
+    {
+        m_ring_size = std::max(
+            params.sq_off.array + params.sq_entries * sizeof(std::uint32_t),
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        m_ring = mmap(
+            nullptr,
+            m_ring_size,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            fd,
+            IORING_OFF_SQ_RING);
+
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = mmap(
+            nullptr,
+            m_sqes_size,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            fd,
+            IORING_OFF_SQES);
+
+        if (!is_valid())
+        {
+            return;
+        }
+
+        auto* ring = static_cast<char*>(m_ring);
+
+        m_sq_head = reinterpret_cast<std::uint32_t*>(ring + params.sq_off.head);
+        m_sq_tail = reinterpret_cast<std::uint32_t*>(ring + params.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<std::uint32_t*>(ring + params.sq_off.ring_mask);
+        m_sq_entries = params.sq_entries;
+        m_sq_array = reinterpret_cast<std::uint32_t*>(ring + params.sq_off.array);
+
+        m_cq_head = reinterpret_cast<std::uint32_t*>(ring + params.cq_off.head);
+        m_cq_tail = reinterpret_cast<std::uint32_t*>(ring + params.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<std::uint32_t*>(ring + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+    }
+
+    bool is_valid() const noexcept
+    {
+        return m_ring != MAP_FAILED && m_sqes != MAP_FAILED;
+    }
+
+    io_uring_sqe* get_sqe()
+    {
+        std::uint32_t tail = *m_sq_tail;
+        if (tail - std::atomic_ref(*m_sq_head).load(std::memory_order_acquire) == m_sq_entries)
+        {
+            flush();
+        }
+
+        std::uint32_t index = tail & m_sq_mask;
+
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(m_sqes) + index;
+        std::memset(sqe, 0, sizeof(io_uring_sqe));
+
+        m_sq_array[index] = index;
+        std::atomic_ref(*m_sq_tail).store(tail + 1, std::memory_order_release);
+        ++m_unsubmitted;
+
+        return sqe;
+    }
+
+    void prepare_read(io_request& request)
+    {
+        auto done = static_cast<std::size_t>(request.result);
+
+        io_uring_sqe* sqe = get_sqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = static_cast<int>(request.file);
+        sqe->off = request.offset + done;
+        sqe->addr = reinterpret_cast<std::uint64_t>(request.buffer.data() + done);
+        sqe->len =
+            static_cast<std::uint32_t>(std::min(request.buffer.size() - done, max_read_size));
+        sqe->user_data = reinterpret_cast<std::uint64_t>(&request);
+    }
+
+    std::uint32_t get_free_sqe_count() const noexcept
+    {
+        return m_sq_entries -
+               (*m_sq_tail - std::atomic_ref(*m_sq_head).load(std::memory_order_acquire));
+    }
+
+    // Submits the queued entries once. Returns false if the kernel could not take them yet.
+    bool try_flush()
+    {
+        auto count = static_cast<int>(
+            syscall(__NR_io_uring_enter, m_fd, m_unsubmitted, 0, 0, nullptr, 0));
+
+        if (count >= 0)
+        {
+            m_unsubmitted -= static_cast<std::uint32_t>(count);
+            return m_unsubmitted == 0;
+        }
+
+        if (errno != EAGAIN && errno != EBUSY && errno != EINTR)
+        {
+            assert(false);
+            m_unsubmitted = 0;
+            return true;
+        }
+
+        return false;
+    }
+
+    void flush()
+    {
+        while (m_unsubmitted != 0)
+        {
+            if (!try_flush())
+            {
+                // The completion queue is backed up, give the completion thread time to drain it.
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Called on the completion thread, which must never wait for itself: retries that do not fit
+    // in the submission queue stay queued and are tried again after the next completions are
+    // reaped.
+    void submit_retries(std::vector<io_request*>& retries)
+    {
+        std::unique_lock lock(m_submit_mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            return;
+        }
+
+        std::size_t count = std::min<std::size_t>(retries.size(), get_free_sqe_count());
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            prepare_read(*retries[i]);
+        }
+        retries.erase(retries.begin(), retries.begin() + static_cast<std::ptrdiff_t>(count));
+
+        if (m_unsubmitted != 0)
+        {
+            try_flush();
+        }
+    }
+
+    void tick()
+    {
+        std::vector<io_request*> retries;
+
+        bool stop = false;
+        while (!stop)
+        {
+            std::uint32_t head = *m_cq_head;
+            std::uint32_t tail = std::atomic_ref(*m_cq_tail).load(std::memory_order_acquire);
+
+            if (head == tail)
+            {
+                if (retries.empty())
+                {
+                    syscall(__NR_io_uring_enter, m_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                }
+                else
+                {
+                    submit_retries(retries);
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe& cqe = m_cqes[head & m_cq_mask];
+                if (cqe.user_data == 0)
+                {
+                    stop = true;
+                    continue;
+                }
+
+                auto* request = reinterpret_cast<io_request*>(cqe.user_data);
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+                {
+                    retries.push_back(request);
+                }
+                else if (cqe.res < 0)
+                {
+                    request->result = -1;
+                    request->owner->complete();
+                }
+                else
+                {
+                    request->result += cqe.res;
+
+                    // Short reads are continued, a read of 0 bytes means end of file.
+                    if (cqe.res != 0 &&
+                        static_cast<std::size_t>(request->result) < request->buffer.size())
+                    {
+                        retries.push_back(request);
+                    }
+                    else
+                    {
+                        request->owner->complete();
+                    }
+                }
+            }
+
+            std::atomic_ref(*m_cq_head).store(head, std::memory_order_release);
+
+            if (!retries.empty() && !stop)
+            {
+                submit_retries(retries);
+            }
+        }
+
+        // Reads still waiting for a retry will never be submitted, fail them so no one waits
+        // forever.
+        for (io_request* request : retries)
+        {
+            request->result = -1;
+            request->owner->complete();
+        }
+    }
+
+    int m_fd;
+
+    void* m_ring{MAP_FAILED};
+    std::size_t m_ring_size{0};
+    void* m_sqes{MAP_FAILED};
+    std::size_t m_sqes_size{0};
+
+    std::uint32_t* m_sq_head{nullptr};
+    std::uint32_t* m_sq_tail{nullptr};
+    std::uint32_t m_sq_mask{0};
+    std::uint32_t m_sq_entries{0};
+    std::uint32_t* m_sq_array{nullptr};
+
+    std::uint32_t* m_cq_head{nullptr};
+    std::uint32_t* m_cq_tail{nullptr};
+    std::uint32_t m_cq_mask{0};
+    io_uring_cqe* m_cqes{nullptr};
+
+    std::uint32_t m_unsubmitted{0};
+    std::mutex m_submit_mutex;
+
+    std::thread m_thread;
+};
+#else
+class task_executor::io_service::uring
+{
+public:
+    void submit(std::span<io_request> /* requests */) {}
+};
+#endif
+
+task_executor::io_service::io_service(task_executor* executor)
+    : m_executor(executor)
+{
+#ifdef VIOLET_IO_URING
+    m_uring = uring::create();
+#endif
+}
+
+task_executor::io_service::~io_service() {}
+
+void task_executor::io_service::read(std::span<io_request> requests)
+{
+    if (m_uring != nullptr)
+    {
+        m_uring->submit(requests);
+        return;
+    }
+
+    for (io_request& request : requests)
+    {
+        m_executor->add_blocking(
+            [request = &request]()
+            {
+                request->result = read_sync(*request);
+                request->owner->complete();
+            });
+    }
+}
+
+std::int64_t task_executor::io_service::read_sync(const io_request& request) noexcept
+{
+    std::size_t done = 0;
+
+    while (done < request.buffer.size())
+    {
+        std::size_t size = std::min(request.buffer.size() - done, max_read_size);
+        std::uint64_t offset = request.offset + done;
+
+#ifdef _WIN32
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD count = 0;
+        if (!ReadFile(
+                reinterpret_cast<HANDLE>(request.file),
+                request.buffer.data() + done,
+                static_cast<DWORD>(size),
+                &count,
+                &overlapped))
+        {
+            if (GetLastError() == ERROR_HANDLE_EOF)
+            {
+                break;
+            }
+            return -1;
+        }
+#else
+        ssize_t count = pread(
+            static_cast<int>(request.file),
+            request.buffer.data() + done,
+            size,
+            static_cast<off_t>(offset));
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+#endif
+
+        if (count == 0)
+        {
+            break;
+        }
+
+        done += static_cast<std::size_t>(count);
+    }
+
+    return static_cast<std::int64_t>(done);
+}
+} // namespace violet
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "task/task_executor.hpp"
+
+namespace violet
+{
+/**
+ * @brief Reads files for coroutines. On Linux reads are batched through io_uring and completed on
+ * a dedicated thread, elsewhere (or if io_uring is not available) they run on the executor's
+ * blocking threads.
+ */
+class task_executor::io_service
+{
+public:
+    io_service(task_executor* executor);
+    ~io_service();
+
+    void read(std::span<io_request> requests);
+
+private:
+    class uring;
+
+    static std::int64_t read_sync(const io_request& request) noexcept;
+
+    task_executor* m_executor;
+    std::unique_ptr<uring> m_uring;
+};
+} // namespace violet
\ No newline at end of file
@@ -1,7 +1,27 @@
 #include "task/task_executor.hpp"
+#include "common/profiler.hpp"
+#include "io_service.hpp"
+#include <algorithm>
+#include <cassert>
+#include <list>
 
 namespace violet
 {
+namespace
+{
+thread_local std::uint32_t current_thread = task_executor::NO_THREAD;
+
+// The wait of a thread for its next job, only recorded if the profiler was on when it began.
+void record_idle(std::int64_t idle_time) noexcept
+{
+    if (idle_time != 0 && profiler::is_enabled())
+    {
+        profiler::begin_zone("Idle", idle_time);
+        profiler::end_zone();
+    }
+}
+} // namespace
+
 class task_executor::thread_pool
 {
 public:
@@ -18,9 +38,9 @@ public:
     template <typename Functor>
     void run(Functor functor)
     {
-        for (auto& thread : m_threads)
+        for (std::size_t i = 0; i < m_threads.size(); ++i)
         {
-            thread = std::thread(functor);
+            m_threads[i] = std::thread(functor, i);
         }
     }
 
@@ -39,6 +59,234 @@ private:
     std::vector<std::thread> m_threads;
 };
 
+class task_executor::timer_service
+{
+public:
+    timer_service(task_executor* executor)
+        : m_executor(executor)
+    {
+        m_thread = std::thread(
+            [this]()
+            {
+                tick();
+            });
+    }
+
+    ~timer_service()
+    {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_one();
+
+        m_thread.join();
+    }
+
+    void add(std::chrono::steady_clock::time_point time, std::coroutine_handle<> coroutine)
+    {
+        {
+            std::scoped_lock lock(m_mutex);
+            if (m_cancel)
+            {
+                m_executor->schedule(coroutine);
+                return;
+            }
+            m_timers.push({time, coroutine});
+        }
+        m_cv.notify_one();
+    }
+
+    void add(std::function<bool()> condition, std::coroutine_handle<> coroutine)
+    {
+        {
+            std::scoped_lock lock(m_mutex);
+            if (m_cancel)
+            {
+                m_executor->schedule(coroutine);
+                return;
+            }
+            m_polls.push_back({std::move(condition), coroutine});
+        }
+        m_cv.notify_one();
+    }
+
+    /**
+     * @brief Resumes every waiting coroutine now, and coroutines added later at once.
+     */
+    void cancel()
+    {
+        std::scoped_lock lock(m_mutex);
+        m_cancel = true;
+
+        while (!m_timers.empty())
+        {
+            m_executor->schedule(m_timers.top().coroutine);
+            m_timers.pop();
+        }
+
+        for (poll& poll : m_polls)
+        {
+            m_executor->schedule(poll.coroutine);
+        }
+        m_polls.clear();
+    }
+
+private:
+    static constexpr auto poll_interval = std::chrono::microseconds(250);
+
+    struct timer
+    {
+        std::chrono::steady_clock::time_point time;
+        std::coroutine_handle<> coroutine;
+
+        bool operator>(const timer& other) const noexcept
+        {
+            return time > other.time;
+        }
+    };
+
+    struct poll
+    {
+        std::function<bool()> condition;
+        std::coroutine_handle<> coroutine;
+    };
+
+    void tick()
+    {
+        std::unique_lock lock(m_mutex);
+
+        while (!m_stop)
+        {
+            auto now = std::chrono::steady_clock::now();
+
+            while (!m_timers.empty() && m_timers.top().time <= now)
+            {
+                m_executor->schedule(m_timers.top().coroutine);
+                m_timers.pop();
+            }
+
+            for (auto iter = m_polls.begin(); iter != m_polls.end();)
+            {
+                if (iter->condition())
+                {
+                    m_executor->schedule(iter->coroutine);
+                    iter = m_polls.erase(iter);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+
+            auto wake_time = std::chrono::steady_clock::time_point::max();
+            if (!m_timers.empty())
+            {
+                wake_time = m_timers.top().time;
+            }
+            if (!m_polls.empty())
+            {
+                wake_time = std::min(wake_time, now + poll_interval);
+            }
+
+            if (wake_time == std::chrono::steady_clock::time_point::max())
+            {
+                m_cv.wait(lock);
+            }
+            else
+            {
+                m_cv.wait_until(lock, wake_time);
+            }
+        }
+    }
+
+    task_executor* m_executor;
+
+    std::priority_queue<timer, std::vector<timer>, std::greater<timer>> m_timers;
+    std::list<poll> m_polls;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop{false};
+    bool m_cancel{false};
+};
+
+class task_executor::blocking_service
+{
+public:
+    blocking_service(std::size_t thread_count)
+        : m_thread_pool(thread_count)
+    {
+        m_thread_pool.run(
+            [this](std::size_t /* thread_index */)
+            {
+                std::function<void()> functor;
+                while (m_queue.pop(functor))
+                {
+                    functor();
+                }
+            });
+    }
+
+    ~blocking_service()
+    {
+        m_queue.close();
+        m_thread_pool.join();
+    }
+
+    void add(std::function<void()> functor)
+    {
+        m_queue.push(functor);
+    }
+
+private:
+    task_queue_thread_safe<std::function<void()>> m_queue;
+    thread_pool m_thread_pool;
+};
+
+namespace
+{
+struct parallel_context
+{
+    void run()
+    {
+        while (true)
+        {
+            std::size_t chunk = next_chunk.fetch_add(1);
+            if (chunk >= chunk_count)
+            {
+                break;
+            }
+
+            std::size_t begin = chunk * grain_size;
+            function(begin, std::min(begin + grain_size, count));
+
+            completed_chunk_count.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    std::size_t count;
+    std::size_t grain_size;
+    std::size_t chunk_count;
+
+    std::function<void(std::size_t, std::size_t)> function;
+
+    std::atomic<std::size_t> next_chunk{0};
+    std::atomic<std::size_t> completed_chunk_count{0};
+};
+
+// Helpers may start after every chunk has been taken, so they share ownership of the context
+// instead of the caller waiting for them.
+detail::async_task_detached parallel_helper(
+    task_executor& executor,
+    std::shared_ptr<parallel_context> context)
+{
+    co_await executor.schedule();
+    context->run();
+}
+} // namespace
+
 task_executor::task_executor()
     : m_stop(true)
 {
@@ -57,30 +305,47 @@ void task_executor::run(std::size_t thread_count)
     }
 
     m_stop = false;
+    m_cancel = false;
 
     if (thread_count == 0)
     {
         thread_count = std::thread::hardware_concurrency();
     }
 
+    m_thread_count = thread_count;
+
+    current_thread = 0;
+    m_steal_names.clear();
+    m_steal_names.push_back("Steal from Main Thread");
+    for (std::size_t i = 1; i <= thread_count; ++i)
+    {
+        m_steal_names.push_back("Steal from Worker " + std::to_string(i));
+    }
+
     m_thread_pool = std::make_unique<thread_pool>(thread_count);
     m_thread_pool->run(
-        [this]()
+        [this](std::size_t thread_index)
         {
-            while (true)
-            {
-                task_wrapper* current = m_worker_thread_queue.pop();
-                if (!current)
-                {
-                    break;
-                }
+            // Thread 0 is the main thread.
+            ++thread_index;
+            current_thread = static_cast<std::uint32_t>(thread_index);
+
+            profiler::set_thread_name("Worker " + std::to_string(thread_index));
 
-                current->execute();
-                current->get_graph()->notify_task_complete();
+            job current;
+            std::int64_t idle_time = profiler::is_enabled() ? profiler::now() : 0;
+            while (m_worker_thread_queue.pop(current))
+            {
+                record_idle(idle_time);
+                execute_job(current);
 
-                on_task_completed(current);
+                idle_time = profiler::is_enabled() ? profiler::now() : 0;
             }
         });
+
+    m_timer_service = std::make_unique<timer_service>(this);
+    m_blocking_service = std::make_unique<blocking_service>(2);
+    m_io_service = std::make_unique<io_service>(this);
 }
 
 void task_executor::stop()
@@ -92,6 +357,27 @@ void task_executor::stop()
 
     m_stop = true;
 
+    m_cancel = true;
+    m_timer_service->cancel();
+    {
+        std::scoped_lock lock(m_main_thread_coroutine_mutex);
+        for (std::coroutine_handle<> coroutine : m_main_thread_coroutines)
+        {
+            schedule(coroutine);
+        }
+        m_main_thread_coroutines.clear();
+    }
+
+    // The services may only go away once nothing completes through them anymore.
+    while (m_uninterruptible_count != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    m_io_service = nullptr;
+    m_blocking_service = nullptr;
+    m_timer_service = nullptr;
+
     m_main_thread_queue.close();
     m_worker_thread_queue.close();
 
@@ -99,6 +385,45 @@ void task_executor::stop()
     m_thread_pool = nullptr;
 }
 
+void task_executor::parallel_for_impl(
+    std::size_t count,
+    std::size_t grain_size,
+    std::function<void(std::size_t, std::size_t)> function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grain_size = std::max<std::size_t>(grain_size, 1);
+    std::size_t chunk_count = (count + grain_size - 1) / grain_size;
+
+    if (chunk_count == 1 || m_stop)
+    {
+        function(0, count);
+        return;
+    }
+
+    auto context = std::make_shared<parallel_context>();
+    context->count = count;
+    context->grain_size = grain_size;
+    context->chunk_count = chunk_count;
+    context->function = std::move(function);
+
+    std::size_t helper_count = std::min(chunk_count - 1, m_thread_count);
+    for (std::size_t i = 0; i < helper_count; ++i)
+    {
+        parallel_helper(*this, context);
+    }
+
+    context->run();
+
+    while (context->completed_chunk_count.load(std::memory_order_acquire) != chunk_count)
+    {
+        std::this_thread::yield();
+    }
+}
+
 void task_executor::execute_task(task_wrapper* task)
 {
     if (task->is_empty())
@@ -107,13 +432,21 @@ void task_executor::execute_task(task_wrapper* task)
         return;
     }
 
+    bool profile = profiler::is_enabled();
+    job current = {
+        .task = task,
+        .priority = task->priority,
+        .enqueue_time = profile ? profiler::now() : 0,
+        .enqueue_thread = profile ? get_current_thread() : NO_THREAD,
+    };
+
     if (task->get_options() & TASK_OPTION_MAIN_THREAD)
     {
-        m_main_thread_queue.push(task);
+        m_main_thread_queue.push(current);
     }
     else
     {
-        m_worker_thread_queue.push(task);
+        m_worker_thread_queue.push(current);
     }
 }
 
@@ -121,20 +454,120 @@ void task_executor::execute_main_thread_task(std::size_t task_count)
 {
     while (task_count > 0)
     {
-        task_wrapper* current = m_main_thread_queue.pop();
-        if (!current)
+        std::int64_t idle_time = profiler::is_enabled() ? profiler::now() : 0;
+
+        job current;
+        if (!m_main_thread_queue.pop(current))
         {
             break;
         }
 
-        current->execute();
-        current->get_graph()->notify_task_complete();
-        on_task_completed(current);
+        record_idle(idle_time);
+        execute_job(current);
 
         --task_count;
     }
 }
 
+void task_executor::execute_main_thread_coroutines()
+{
+    std::vector<std::coroutine_handle<>> coroutines;
+    {
+        std::scoped_lock lock(m_main_thread_coroutine_mutex);
+        coroutines.swap(m_main_thread_coroutines);
+    }
+
+    // Coroutines that switch to the main thread again are resumed by the next call.
+    for (std::coroutine_handle<> coroutine : coroutines)
+    {
+        coroutine.resume();
+    }
+}
+
+void task_executor::execute_job(const job& current)
+{
+    if (current.coroutine)
+    {
+        bool zone = profiler::is_enabled();
+        if (zone)
+        {
+            record_steal(current);
+            profiler::begin_zone("Coroutine", profiler::now(), current.enqueue_time);
+        }
+
+        current.coroutine.resume();
+
+        if (zone)
+        {
+            profiler::end_zone();
+        }
+        return;
+    }
+
+    if (current.task->skip)
+    {
+        // The fixed rate group of the task has no step due, only release the successors.
+        current.task->last_duration = 0;
+        current.task->get_graph()->notify_task_complete();
+        on_task_completed(current.task);
+        return;
+    }
+
+    bool zone = profiler::is_enabled();
+
+    std::int64_t begin = profiler::now();
+    if (zone)
+    {
+        record_steal(current);
+
+        const std::string& name = current.task->get_name();
+        profiler::begin_zone(name.empty() ? "Task" : name.c_str(), begin, current.enqueue_time);
+    }
+
+    current.task->execute();
+
+    std::int64_t end = profiler::now();
+    if (zone)
+    {
+        profiler::end_zone(end);
+    }
+
+    current.task->update_duration(static_cast<std::uint64_t>(end - begin));
+
+    current.task->get_graph()->notify_task_complete();
+
+    on_task_completed(current.task);
+}
+
+bool task_executor::execute_worker_job()
+{
+    job current;
+    if (!m_worker_thread_queue.try_pop(current))
+    {
+        return false;
+    }
+
+    execute_job(current);
+    return true;
+}
+
+std::uint32_t task_executor::get_current_thread() noexcept
+{
+    return current_thread;
+}
+
+void task_executor::record_steal(const job& current) const noexcept
+{
+    // Wake ups from the timer, blocking and io threads are not steals.
+    if (current.enqueue_thread == NO_THREAD || current.enqueue_thread == current_thread ||
+        current.enqueue_thread >= m_steal_names.size())
+    {
+        return;
+    }
+
+    profiler::mark(m_steal_names[current.enqueue_thread].c_str());
+}
+
 void task_executor::on_task_completed(task_wrapper* task)
 {
     for (task_wrapper* successor : task->successors)
@@ -150,4 +583,68 @@ void task_executor::on_task_completed(task_wrapper* task)
         }
     }
 }
+
+void task_executor::add_timer(
+    std::chrono::steady_clock::time_point time,
+    std::coroutine_handle<> coroutine)
+{
+    if (m_cancel)
+    {
+        schedule(coroutine);
+        return;
+    }
+
+    assert(m_timer_service != nullptr);
+    m_timer_service->add(time, coroutine);
+}
+
+void task_executor::add_poll(std::function<bool()> condition, std::coroutine_handle<> coroutine)
+{
+    if (m_cancel)
+    {
+        schedule(coroutine);
+        return;
+    }
+
+    assert(m_timer_service != nullptr);
+    m_timer_service->add(std::move(condition), coroutine);
+}
+
+void task_executor::add_blocking(std::function<void()> functor)
+{
+    assert(m_blocking_service != nullptr);
+
+    ++m_uninterruptible_count;
+    m_blocking_service->add(
+        [this, functor = std::move(functor)]()
+        {
+            functor();
+            --m_uninterruptible_count;
+        });
+}
+
+void task_executor::add_main_thread(std::coroutine_handle<> coroutine)
+{
+    std::scoped_lock lock(m_main_thread_coroutine_mutex);
+    if (m_cancel)
+    {
+        schedule(coroutine);
+        return;
+    }
+    m_main_thread_coroutines.push_back(coroutine);
+}
+
+void task_executor::add_read(std::span<io_request> requests)
+{
+    assert(m_io_service != nullptr);
+
+    ++m_uninterruptible_count;
+    m_io_service->read(requests);
+}
+
+void task_executor::complete_read(std::coroutine_handle<> coroutine)
+{
+    schedule(coroutine);
+    --m_uninterruptible_count;
+}
 } // namespace violet
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "task/task_graph.hpp"
+#include "common/flat_map.hpp"
+#include <algorithm>
 #include <stack>
 
 namespace violet
@@ -17,12 +19,27 @@ std::future<void> task_graph::reset() noexcept
         m_dirty = false;
     }
 
+    update_priority();
+
     m_incomplete_count = m_main_thread_task_count + m_worker_thread_task_count;
     m_promise = std::promise<void>();
 
     return m_promise.get_future();
 }
 
+void task_graph::advance(float delta) noexcept
+{
+    for (auto& group : m_groups)
+    {
+        group->advance(delta);
+    }
+
+    for (auto& task : m_tasks)
+    {
+        task->skip = task->get_group() != nullptr && !task->get_group()->is_active();
+    }
+}
+
 void task_graph::notify_task_complete()
 {
     m_incomplete_count.fetch_sub(1);
@@ -76,7 +93,8 @@ void task_graph::compile()
 void task_graph::transitive_reduction()
 {
     // Topological sort.
-    std::unordered_map<task*, std::size_t> in_edge;
+    flat_map<task*, std::size_t> in_edge;
+    in_edge.reserve(m_tasks.size());
     for (auto& task : m_tasks)
     {
         in_edge[task.get()] = task->get_dependencies().size();
@@ -88,7 +106,8 @@ void task_graph::transitive_reduction()
         stack.push(root);
     }
 
-    std::vector<task_wrapper*> sorted_tasks;
+    std::vector<task_wrapper*>& sorted_tasks = m_sorted_tasks;
+    sorted_tasks.clear();
     while (!stack.empty())
     {
         task* node = stack.top();
@@ -106,7 +125,8 @@ void task_graph::transitive_reduction()
     }
 
     // Transitive reduction.
-    std::unordered_map<task*, std::uint8_t> task_flags;
+    flat_map<task*, std::uint8_t> task_flags;
+    task_flags.reserve(sorted_tasks.size());
     for (int i = 1; i < sorted_tasks.size(); ++i)
     {
         for (int j = 0; j < i; ++j)
@@ -142,4 +162,33 @@ void task_graph::transitive_reduction()
         }
     }
 }
+
+void task_graph::update_priority()
+{
+    // Tasks that have not been measured yet count as this long, so that the first frame is
+    // ordered by the number of tasks on the longest path.
+    static constexpr std::uint64_t default_duration = 1000;
+    static constexpr std::uint64_t max_critical_path = (1ull << 62) - 1;
+
+    for (auto iter = m_sorted_tasks.rbegin(); iter != m_sorted_tasks.rend(); ++iter)
+    {
+        task_wrapper* task = *iter;
+
+        std::uint64_t successor_path = 0;
+        for (task_wrapper* successor : task->successors)
+        {
+            successor_path = std::max(successor_path, successor->critical_path);
+        }
+
+        std::uint64_t duration = 0;
+        if (!task->is_empty())
+        {
+            duration = task->duration == 0 ? default_duration : task->duration;
+        }
+
+        task->critical_path = std::min(successor_path + duration, max_critical_path);
+        task->priority =
+            (static_cast<std::uint64_t>(task->get_priority()) << 62) | task->critical_path;
+    }
+}
 } // namespace violet
\ No newline at end of file
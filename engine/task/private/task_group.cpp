@@ -1,5 +1,6 @@
 #include "task/task_group.hpp"
 #include "task/task_graph.hpp"
+#include <algorithm>
 #include <cassert>
 
 namespace violet
@@ -25,6 +26,55 @@ task_group& task_group::set_group(task_group& group)
     return *this;
 }
 
+task_group& task_group::set_tick_rate(float rate, std::uint32_t max_step_count)
+{
+    assert(rate >= 0.0f && max_step_count > 0);
+
+    m_tick_rate = rate;
+    m_max_step_count = max_step_count;
+    m_accumulated_time = 0.0f;
+
+    return *this;
+}
+
+bool task_group::is_active() const noexcept
+{
+    for (const task_group* group = this; group != nullptr; group = group->m_group)
+    {
+        if (group->m_step_count == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void task_group::advance(float delta) noexcept
+{
+    if (m_tick_rate == 0.0f)
+    {
+        m_step_count = 1;
+        m_step_delta = delta;
+        return;
+    }
+
+    m_step_delta = 1.0f / m_tick_rate;
+    m_accumulated_time += delta;
+
+    auto step_count = static_cast<std::uint32_t>(m_accumulated_time * m_tick_rate);
+    m_accumulated_time -= static_cast<float>(step_count) * m_step_delta;
+
+    if (step_count > m_max_step_count)
+    {
+        // Falling further behind every frame is worse than slowing the simulation down.
+        step_count = m_max_step_count;
+        m_accumulated_time = 0.0f;
+    }
+
+    m_step_count = step_count;
+    m_accumulated_time = std::max(m_accumulated_time, 0.0f);
+}
+
 void task_group::add_dependency_impl(task& dependency)
 {
     m_begin->add_dependency(dependency);
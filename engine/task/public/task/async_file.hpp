@@ -0,0 +1,67 @@
+#pragma once
+
+#include "task/task_executor.hpp"
+#include <string>
+#include <vector>
+
+namespace violet
+{
+/**
+ * @brief A read-only file whose reads are served by the executor's io service.
+ */
+class async_file
+{
+public:
+    using io_request = task_executor::io_request;
+
+    async_file() = default;
+    async_file(const async_file&) = delete;
+    async_file(async_file&& other) noexcept;
+    ~async_file();
+
+    bool open(std::string_view path);
+    void close();
+
+    bool is_open() const noexcept
+    {
+        return m_file != invalid_file;
+    }
+
+    std::uint64_t get_size() const noexcept
+    {
+        return m_size;
+    }
+
+    io_request make_request(std::uint64_t offset, std::span<char> buffer) const noexcept
+    {
+        return {.file = m_file, .offset = offset, .buffer = buffer};
+    }
+
+    /**
+     * @brief Reads into the caller's buffer without an intermediate copy. The buffer must stay
+     * alive until the awaitable completes. Use task_executor::read to submit several requests as
+     * one batch.
+     */
+    [[nodiscard]] auto read(task_executor& executor, io_request& request) const noexcept
+    {
+        return executor.read(std::span<io_request>(&request, 1));
+    }
+
+    /**
+     * @brief Reads the whole file into data. Large files are split into chunks that are all
+     * submitted at once, so the disk queue stays full.
+     *
+     * @return Returns false if the file could not be opened or read.
+     */
+    static async_task<bool> read(task_executor& executor, std::string path, std::vector<char>& data);
+
+    async_file& operator=(const async_file&) = delete;
+    async_file& operator=(async_file&& other) noexcept;
+
+private:
+    static constexpr std::intptr_t invalid_file = -1;
+
+    std::intptr_t m_file{invalid_file};
+    std::uint64_t m_size{0};
+};
+} // namespace violet
\ No newline at end of file
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace violet
+{
+template <typename T>
+class async_task;
+
+namespace detail
+{
+class async_task_promise_base
+{
+public:
+    struct final_awaitable
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coroutine) noexcept
+        {
+            std::coroutine_handle<> continuation = coroutine.promise().m_continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    final_awaitable final_suspend() noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        m_exception = std::current_exception();
+    }
+
+    void set_continuation(std::coroutine_handle<> continuation) noexcept
+    {
+        m_continuation = continuation;
+    }
+
+protected:
+    void rethrow_if_exception() const
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+private:
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr m_exception;
+};
+
+template <typename T>
+class async_task_promise : public async_task_promise_base
+{
+public:
+    async_task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value)
+    {
+        m_value.emplace(std::forward<U>(value));
+    }
+
+    T result()
+    {
+        rethrow_if_exception();
+
+        assert(m_value.has_value());
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<T> m_value;
+};
+
+template <>
+class async_task_promise<void> : public async_task_promise_base
+{
+public:
+    async_task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() const
+    {
+        rethrow_if_exception();
+    }
+};
+
+/**
+ * @brief A coroutine that starts eagerly and destroys itself on completion. Used to bridge
+ * async_task into non-coroutine code, see task_executor::execute.
+ */
+struct async_task_detached
+{
+    struct promise_type
+    {
+        async_task_detached get_return_object() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+} // namespace detail
+
+/**
+ * @brief A lazily started coroutine producing a value of type T.
+ *
+ * The coroutine body does not run until the task is awaited. When the body finishes, execution
+ * transfers directly to the awaiting coroutine, so a chain of awaited tasks runs on whichever
+ * thread resumed the innermost suspension point. Use task_executor::schedule to move onto a
+ * worker thread and task_executor::execute to run a task from non-coroutine code.
+ *
+ * @tparam T Result type.
+ */
+template <typename T = void>
+class [[nodiscard]] async_task
+{
+public:
+    using promise_type = detail::async_task_promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    async_task() noexcept = default;
+
+    explicit async_task(handle_type coroutine) noexcept
+        : m_coroutine(coroutine)
+    {
+    }
+
+    async_task(const async_task&) = delete;
+
+    async_task(async_task&& other) noexcept
+        : m_coroutine(std::exchange(other.m_coroutine, nullptr))
+    {
+    }
+
+    ~async_task()
+    {
+        if (m_coroutine)
+        {
+            m_coroutine.destroy();
+        }
+    }
+
+    bool is_ready() const noexcept
+    {
+        return !m_coroutine || m_coroutine.done();
+    }
+
+    auto operator co_await() noexcept
+    {
+        struct awaitable
+        {
+            bool await_ready() const noexcept
+            {
+                return !coroutine || coroutine.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                coroutine.promise().set_continuation(awaiting);
+                return coroutine;
+            }
+
+            T await_resume()
+            {
+                return coroutine.promise().result();
+            }
+
+            handle_type coroutine;
+        };
+
+        assert(m_coroutine);
+        return awaitable{m_coroutine};
+    }
+
+    async_task& operator=(const async_task&) = delete;
+
+    async_task& operator=(async_task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_coroutine)
+            {
+                m_coroutine.destroy();
+            }
+            m_coroutine = std::exchange(other.m_coroutine, nullptr);
+        }
+        return *this;
+    }
+
+private:
+    handle_type m_coroutine;
+};
+
+namespace detail
+{
+template <typename T>
+async_task<T> async_task_promise<T>::get_return_object() noexcept
+{
+    return async_task<T>(std::coroutine_handle<async_task_promise<T>>::from_promise(*this));
+}
+
+inline async_task<void> async_task_promise<void>::get_return_object() noexcept
+{
+    return async_task<void>(std::coroutine_handle<async_task_promise<void>>::from_promise(*this));
+}
+} // namespace detail
+} // namespace violet
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/string_id.hpp"
 #include <functional>
 #include <string>
 #include <vector>
@@ -13,6 +14,13 @@ enum task_option
 };
 using task_options = std::uint32_t;
 
+enum task_priority : std::uint8_t
+{
+    TASK_PRIORITY_LOW,
+    TASK_PRIORITY_NORMAL,
+    TASK_PRIORITY_HIGH,
+};
+
 class task;
 class task_group;
 
@@ -29,6 +37,7 @@ public:
     task& set_name(std::string_view name)
     {
         m_name = name;
+        m_name_id = string_id(name);
         return *this;
     }
 
@@ -37,6 +46,11 @@ public:
         return m_name;
     }
 
+    string_id get_name_id() const noexcept
+    {
+        return m_name_id;
+    }
+
     task& set_options(task_options options) noexcept
     {
         m_options = options;
@@ -48,8 +62,28 @@ public:
         return m_options;
     }
 
+    /**
+     * @brief Overrides the critical-path ordering. Ready tasks with a higher priority are always
+     * scheduled first; tasks with the same priority are ordered by their critical-path length.
+     */
+    task& set_priority(task_priority priority) noexcept
+    {
+        m_priority = priority;
+        return *this;
+    }
+
+    task_priority get_priority() const noexcept
+    {
+        return m_priority;
+    }
+
     task& set_group(task_group& group);
 
+    task_group* get_group() const noexcept
+    {
+        return m_group;
+    }
+
     template <typename Functor>
     task& set_execute(Functor functor)
     {
@@ -97,7 +131,9 @@ private:
     void add_dependency_impl(task_group& dependency);
 
     std::string m_name;
+    string_id m_name_id;
     task_options m_options{0};
+    task_priority m_priority{TASK_PRIORITY_NORMAL};
     task_graph* m_graph{nullptr};
     task_group* m_group{nullptr};
 
@@ -1,14 +1,304 @@
 #pragma once
 
+#include "common/profiler.hpp"
+#include "task/async_task.hpp"
 #include "task/task_graph.hpp"
 #include "task/task_queue.hpp"
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace violet
 {
+/**
+ * @brief Thrown into coroutines that wait on a timer, a poll or the main thread when the executor
+ * stops.
+ */
+class task_cancelled : public std::runtime_error
+{
+public:
+    task_cancelled()
+        : std::runtime_error("Task cancelled.")
+    {
+    }
+};
+
 class task_executor
 {
 public:
-    using task_queue = task_queue_thread_safe<task_wrapper>;
+    // Jobs queued by threads that do not belong to the executor, e.g. the timer thread.
+    static constexpr std::uint32_t NO_THREAD = std::numeric_limits<std::uint32_t>::max();
+
+    struct job
+    {
+        task_wrapper* task{nullptr};
+        std::coroutine_handle<> coroutine{nullptr};
+
+        // Resumed coroutines are already in flight and are finished before new tasks start.
+        std::uint64_t priority{std::numeric_limits<std::uint64_t>::max()};
+
+        // Only set when the profiler is enabled.
+        std::int64_t enqueue_time{0};
+        std::uint32_t enqueue_thread{NO_THREAD};
+
+        bool operator<(const job& other) const noexcept
+        {
+            return priority < other.priority;
+        }
+    };
+
+    using task_queue = task_priority_queue_thread_safe<job>;
+
+    class schedule_awaitable
+    {
+    public:
+        schedule_awaitable(task_executor* executor) noexcept
+            : m_executor(executor)
+        {
+        }
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine)
+        {
+            m_executor->schedule(coroutine);
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        task_executor* m_executor;
+    };
+
+    class main_thread_awaitable
+    {
+    public:
+        main_thread_awaitable(task_executor* executor) noexcept
+            : m_executor(executor)
+        {
+        }
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine)
+        {
+            m_executor->add_main_thread(coroutine);
+        }
+
+        void await_resume() const
+        {
+            m_executor->throw_if_cancelled();
+        }
+
+    private:
+        task_executor* m_executor;
+    };
+
+    class sleep_awaitable
+    {
+    public:
+        sleep_awaitable(
+            task_executor* executor,
+            std::chrono::steady_clock::time_point time) noexcept
+            : m_executor(executor),
+              m_time(time)
+        {
+        }
+
+        bool await_ready() const noexcept
+        {
+            return m_time <= std::chrono::steady_clock::now();
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine)
+        {
+            m_executor->add_timer(m_time, coroutine);
+        }
+
+        void await_resume() const
+        {
+            m_executor->throw_if_cancelled();
+        }
+
+    private:
+        task_executor* m_executor;
+        std::chrono::steady_clock::time_point m_time;
+    };
+
+    class poll_awaitable
+    {
+    public:
+        poll_awaitable(task_executor* executor, std::function<bool()> condition) noexcept
+            : m_executor(executor),
+              m_condition(std::move(condition))
+        {
+        }
+
+        bool await_ready() const
+        {
+            return m_condition();
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine)
+        {
+            m_executor->add_poll(std::move(m_condition), coroutine);
+        }
+
+        void await_resume() const
+        {
+            m_executor->throw_if_cancelled();
+        }
+
+    private:
+        task_executor* m_executor;
+        std::function<bool()> m_condition;
+    };
+
+    template <typename Functor>
+    class blocking_awaitable
+    {
+    public:
+        using result_type = std::invoke_result_t<Functor>;
+
+        blocking_awaitable(task_executor* executor, Functor functor)
+            : m_executor(executor),
+              m_functor(std::move(functor))
+        {
+        }
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine)
+        {
+            m_executor->add_blocking(
+                [this, coroutine]()
+                {
+                    try
+                    {
+                        if constexpr (std::is_void_v<result_type>)
+                        {
+                            m_functor();
+                        }
+                        else
+                        {
+                            m_result.emplace(m_functor());
+                        }
+                    }
+                    catch (...)
+                    {
+                        m_exception = std::current_exception();
+                    }
+
+                    m_executor->schedule(coroutine);
+                });
+        }
+
+        result_type await_resume()
+        {
+            if (m_exception)
+            {
+                std::rethrow_exception(m_exception);
+            }
+
+            if constexpr (!std::is_void_v<result_type>)
+            {
+                return std::move(*m_result);
+            }
+        }
+
+    private:
+        struct empty
+        {
+        };
+
+        task_executor* m_executor;
+        Functor m_functor;
+
+        std::conditional_t<std::is_void_v<result_type>, empty, std::optional<result_type>>
+            m_result;
+        std::exception_ptr m_exception;
+    };
+
+    class read_awaitable;
+
+    /**
+     * @brief A positioned read into a caller-owned buffer, see async_file.
+     */
+    struct io_request
+    {
+        std::intptr_t file;
+        std::uint64_t offset;
+        std::span<char> buffer;
+
+        // Number of bytes read, or -1 if the read failed.
+        std::int64_t result{0};
+
+        read_awaitable* owner{nullptr};
+    };
+
+    class read_awaitable
+    {
+    public:
+        read_awaitable(task_executor* executor, std::span<io_request> requests) noexcept
+            : m_executor(executor),
+              m_requests(requests)
+        {
+        }
+
+        bool await_ready() const noexcept
+        {
+            return m_requests.empty();
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine)
+        {
+            m_coroutine = coroutine;
+            m_pending = m_requests.size();
+
+            for (io_request& request : m_requests)
+            {
+                request.result = 0;
+                request.owner = this;
+            }
+
+            m_executor->add_read(m_requests);
+        }
+
+        void await_resume() const noexcept {}
+
+        /**
+         * @brief Called by the io service once per request. The last completion resumes the
+         * awaiting coroutine, after which neither the request nor the awaitable may be touched.
+         */
+        void complete() noexcept
+        {
+            if (m_pending.fetch_sub(1) == 1)
+            {
+                m_executor->complete_read(m_coroutine);
+            }
+        }
+
+    private:
+        task_executor* m_executor;
+        std::span<io_request> m_requests;
+
+        std::coroutine_handle<> m_coroutine;
+        std::atomic<std::size_t> m_pending{0};
+    };
 
     task_executor();
     ~task_executor();
@@ -46,22 +336,245 @@ public:
         }
     }
 
+    /**
+     * @brief Runs a coroutine on the worker threads. The coroutine may suspend any number of times
+     * without occupying a worker.
+     *
+     * @return A future that receives the result of the coroutine.
+     */
+    template <typename T>
+    std::future<T> execute(async_task<T> task)
+    {
+        std::promise<T> promise;
+        std::future<T> future = promise.get_future();
+        execute_detached(*this, std::move(task), std::move(promise));
+        return future;
+    }
+
+    /**
+     * @brief Waits for the result of execute, running queued worker jobs on the calling thread in
+     * the meantime. A worker that waits for a coroutine this way does not take the thread the
+     * coroutine needs to resume on.
+     */
+    template <typename T>
+    T wait(std::future<T> future)
+    {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            if (!execute_worker_job())
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        return future.get();
+    }
+
+    /**
+     * @brief Resumes the coroutine on a worker thread.
+     */
+    void schedule(std::coroutine_handle<> coroutine)
+    {
+        bool profile = profiler::is_enabled();
+        m_worker_thread_queue.push({
+            .coroutine = coroutine,
+            .enqueue_time = profile ? profiler::now() : 0,
+            .enqueue_thread = profile ? get_current_thread() : NO_THREAD,
+        });
+    }
+
+    /**
+     * @brief Awaiting the result moves the current coroutine onto a worker thread.
+     */
+    [[nodiscard]] schedule_awaitable schedule() noexcept
+    {
+        return {this};
+    }
+
+    /**
+     * @brief Awaiting the result moves the current coroutine onto the main thread. It is resumed by
+     * execute_main_thread_coroutines, while no task graph is executing, so it may use state that
+     * frame tasks use without locks, e.g. the render device.
+     */
+    [[nodiscard]] main_thread_awaitable switch_to_main_thread() noexcept
+    {
+        return {this};
+    }
+
+    /**
+     * @brief Resumes the coroutines that switched to the main thread. Must be called on the main
+     * thread between task graph executions.
+     */
+    void execute_main_thread_coroutines();
+
+    [[nodiscard]] sleep_awaitable sleep_until(std::chrono::steady_clock::time_point time) noexcept
+    {
+        return {this, time};
+    }
+
+    template <typename Rep, typename Period>
+    [[nodiscard]] sleep_awaitable sleep_for(std::chrono::duration<Rep, Period> duration) noexcept
+    {
+        return sleep_until(
+            std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration));
+    }
+
+    /**
+     * @brief Suspends until the condition returns true. The condition is evaluated periodically
+     * on the timer thread, so it must be cheap and thread-safe, e.g. polling a GPU fence value.
+     */
+    [[nodiscard]] poll_awaitable poll(std::function<bool()> condition)
+    {
+        return {this, std::move(condition)};
+    }
+
+    /**
+     * @brief Runs a blocking call on a dedicated blocking thread and resumes the current
+     * coroutine on a worker thread with its result.
+     */
+    template <typename Functor>
+    [[nodiscard]] blocking_awaitable<Functor> execute_blocking(Functor functor)
+    {
+        return {this, std::move(functor)};
+    }
+
+    /**
+     * @brief Splits [0, count) into chunks of grain_size and runs functor(begin, end) on them in
+     * parallel. The calling thread works on chunks as well, so it is safe to call from a task.
+     */
+    template <typename Functor>
+    void parallel_for(std::size_t count, std::size_t grain_size, Functor&& functor)
+    {
+        parallel_for_impl(
+            count,
+            grain_size,
+            [&functor](std::size_t begin, std::size_t end)
+            {
+                functor(begin, end);
+            });
+    }
+
+    /**
+     * @brief Submits all reads at once and resumes the current coroutine on a worker thread when
+     * every request has completed. On Linux the reads go through io_uring, elsewhere they run on
+     * the blocking threads.
+     */
+    [[nodiscard]] read_awaitable read(std::span<io_request> requests) noexcept
+    {
+        return {this, requests};
+    }
+
     void run(std::size_t thread_count = 0);
+
+    /**
+     * @brief Coroutines waiting on a timer, a poll or the main thread are resumed on the workers
+     * with task_cancelled. Blocking calls and reads cannot be interrupted, stop waits until they
+     * have finished and resumed their coroutines, then runs the remaining jobs and joins the
+     * workers.
+     */
     void stop();
 
+    std::size_t get_thread_count() const noexcept
+    {
+        return m_thread_count;
+    }
+
 private:
     class thread_pool;
+    class timer_service;
+    class blocking_service;
+    class io_service;
+
+    template <typename T>
+    static detail::async_task_detached execute_detached(
+        task_executor& executor,
+        async_task<T> task,
+        std::promise<T> promise)
+    {
+        co_await executor.schedule();
+
+        try
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                co_await task;
+                promise.set_value();
+            }
+            else
+            {
+                promise.set_value(co_await task);
+            }
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    void parallel_for_impl(
+        std::size_t count,
+        std::size_t grain_size,
+        std::function<void(std::size_t, std::size_t)> function);
 
     void execute_task(task_wrapper* task);
     void execute_main_thread_task(std::size_t task_count);
 
+    void execute_job(const job& current);
+
+    /**
+     * @brief Runs one queued worker job on the calling thread, returns false if there is none.
+     */
+    bool execute_worker_job();
+
+    /**
+     * @brief Index of the calling thread, 0 for the thread that called run and 1 to thread count
+     * for the workers, NO_THREAD for any other thread.
+     */
+    static std::uint32_t get_current_thread() noexcept;
+
+    /**
+     * @brief Records a job that runs on another executor thread than the one that queued it. A
+     * work stealing scheduler would have kept it on the queuing thread and stolen it from there.
+     */
+    void record_steal(const job& current) const noexcept;
+
     void on_task_completed(task_wrapper* task);
 
+    void add_timer(std::chrono::steady_clock::time_point time, std::coroutine_handle<> coroutine);
+    void add_poll(std::function<bool()> condition, std::coroutine_handle<> coroutine);
+    void add_blocking(std::function<void()> functor);
+    void add_main_thread(std::coroutine_handle<> coroutine);
+    void add_read(std::span<io_request> requests);
+    void complete_read(std::coroutine_handle<> coroutine);
+
+    void throw_if_cancelled() const
+    {
+        if (m_cancel)
+        {
+            throw task_cancelled();
+        }
+    }
+
     task_queue m_main_thread_queue;
     task_queue m_worker_thread_queue;
 
+    std::vector<std::coroutine_handle<>> m_main_thread_coroutines;
+    std::mutex m_main_thread_coroutine_mutex;
+
     std::unique_ptr<thread_pool> m_thread_pool;
+    std::size_t m_thread_count{0};
+    // Profiler names of steals, by the thread the job was stolen from.
+    std::vector<std::string> m_steal_names;
+    std::unique_ptr<timer_service> m_timer_service;
+    std::unique_ptr<blocking_service> m_blocking_service;
+    std::unique_ptr<io_service> m_io_service;
 
     std::atomic<bool> m_stop;
+
+    // Set while stopping, waits that can be cancelled resume at once.
+    std::atomic<bool> m_cancel{false};
+    // Blocking calls and reads that have not resumed their coroutine yet.
+    std::atomic<std::size_t> m_uninterruptible_count{0};
 };
 } // namespace violet
\ No newline at end of file
@@ -14,10 +14,33 @@ public:
     {
     }
 
+    void update_duration(std::uint64_t sample) noexcept
+    {
+        last_duration = sample;
+
+        // Exponential moving average, so a single slow frame does not reorder the whole graph.
+        duration = duration == 0 ? sample : (duration * 7 + sample) / 8;
+    }
+
     std::vector<task_wrapper*> dependencies;
     std::vector<task_wrapper*> successors;
 
     std::atomic<std::uint32_t> uncompleted_dependency_count{0};
+
+    // Measured execution time in nanoseconds, 0 if the task has not run yet.
+    std::uint64_t duration{0};
+
+    // Execution time of the latest run in nanoseconds.
+    std::uint64_t last_duration{0};
+
+    // Length of the longest path from this task to a leaf, in nanoseconds.
+    std::uint64_t critical_path{0};
+
+    // Scheduling key, higher values are executed first.
+    std::uint64_t priority{0};
+
+    // Set when a fixed rate group of the task has no step due this frame.
+    bool skip{false};
 };
 
 class task_graph
@@ -46,16 +69,22 @@ public:
 
     std::future<void> reset() noexcept;
 
+    /**
+     * @brief Advances the fixed rate groups by the frame delta in seconds and decides which tasks
+     * are skipped this frame. Called before the graph is executed.
+     */
+    void advance(float delta) noexcept;
+
     const std::vector<task_wrapper*>& get_root_tasks() const noexcept
     {
         return m_roots;
     }
 
-    task& get_task(std::string_view name) const
+    task& get_task(string_id name) const
     {
         for (const auto& t : m_tasks)
         {
-            if (t->get_name() == name)
+            if (t->get_name_id() == name)
             {
                 return *t;
             }
@@ -64,17 +93,32 @@ public:
         throw std::runtime_error("Task not found");
     }
 
-    task_group& get_group(std::string_view name) const
+    task_group& get_group(string_id name) const
+    {
+        task_group* group = find_group(name);
+        if (group == nullptr)
+        {
+            throw std::runtime_error("Task not found");
+        }
+
+        return *group;
+    }
+
+    /**
+     * @brief Same as get_group, but returns nullptr if there is no group with the name, e.g. one
+     * that is added by a system which is not installed.
+     */
+    task_group* find_group(string_id name) const noexcept
     {
         for (const auto& t : m_groups)
         {
-            if (t->get_name() == name)
+            if (t->get_name_id() == name)
             {
-                return *t;
+                return t.get();
             }
         }
 
-        throw std::runtime_error("Task not found");
+        return nullptr;
     }
 
     std::uint32_t get_task_count() const noexcept
@@ -105,11 +149,13 @@ public:
 private:
     void compile();
     void transitive_reduction();
+    void update_priority();
 
     std::vector<std::unique_ptr<task_group>> m_groups;
     std::vector<std::unique_ptr<task_wrapper>> m_tasks;
 
     std::vector<task_wrapper*> m_roots;
+    std::vector<task_wrapper*> m_sorted_tasks;
 
     bool m_dirty;
 
@@ -15,6 +15,7 @@ public:
     task_group& set_name(std::string_view name)
     {
         m_name = name;
+        m_name_id = string_id(name);
 
         m_begin->set_name(m_name + group_begin_suffix.data());
         m_end->set_name(m_name + group_end_suffix.data());
@@ -27,8 +28,66 @@ public:
         return m_name;
     }
 
+    string_id get_name_id() const noexcept
+    {
+        return m_name_id;
+    }
+
     task_group& set_group(task_group& group);
 
+    task_group* get_group() const noexcept
+    {
+        return m_group;
+    }
+
+    /**
+     * @brief Runs the tasks of the group at a fixed rate instead of once per frame. Tasks are
+     * skipped on frames where no step is due and should simulate get_step_count steps otherwise.
+     * At most max_step_count steps run in one frame, a larger backlog is dropped. A rate of 0 makes
+     * the group run every frame again.
+     */
+    task_group& set_tick_rate(float rate, std::uint32_t max_step_count = 4);
+
+    float get_tick_rate() const noexcept
+    {
+        return m_tick_rate;
+    }
+
+    /**
+     * @brief Number of fixed steps due this frame, always 1 for per-frame groups.
+     */
+    std::uint32_t get_step_count() const noexcept
+    {
+        return m_step_count;
+    }
+
+    /**
+     * @brief Length of one step in seconds, the frame delta for per-frame groups.
+     */
+    float get_step_delta() const noexcept
+    {
+        return m_step_delta;
+    }
+
+    /**
+     * @brief Fraction of a step accumulated but not simulated yet, in [0, 1). Consumers running at
+     * the frame rate use it to interpolate between the last two steps.
+     */
+    float get_interpolation() const noexcept
+    {
+        return m_tick_rate == 0.0f ? 0.0f : m_accumulated_time * m_tick_rate;
+    }
+
+    /**
+     * @brief False if this group or one of its parents has no step due this frame.
+     */
+    bool is_active() const noexcept;
+
+    /**
+     * @brief Advances the fixed step accumulator, called by the graph once per frame.
+     */
+    void advance(float delta) noexcept;
+
     task& get_begin_task()
     {
         return *m_begin;
@@ -51,10 +110,18 @@ private:
     void add_dependency_impl(task_group& dependency);
 
     std::string m_name;
+    string_id m_name_id;
     task_graph* m_graph{nullptr};
     task_group* m_group{nullptr};
 
     task* m_begin{nullptr};
     task* m_end{nullptr};
+
+    float m_tick_rate{0.0f};
+    std::uint32_t m_max_step_count{0};
+    float m_accumulated_time{0.0f};
+
+    std::uint32_t m_step_count{1};
+    float m_step_delta{0.0f};
 };
 } // namespace violet
\ No newline at end of file
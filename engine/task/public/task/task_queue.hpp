@@ -1,8 +1,11 @@
 #pragma once
 
 #include "task/lock_free_queue.hpp"
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <queue>
+#include <thread>
 
 namespace violet
 {
@@ -17,14 +20,20 @@ public:
     {
     }
 
-    void push(task_type* task)
+    void push(const task_type& task)
     {
         std::scoped_lock lock(m_mutex);
         m_queue.push(task);
         m_cv.notify_one();
     }
 
-    task_type* pop()
+    /**
+     * @brief Blocks until a task is available or the queue is closed.
+     *
+     * @param task Receives the popped task.
+     * @return Returns false if the queue has been closed and drained.
+     */
+    bool pop(task_type& task)
     {
         std::unique_lock lock(m_mutex);
         m_cv.wait(
@@ -36,12 +45,12 @@ public:
 
         if (!m_queue.empty())
         {
-            task_type* task = m_queue.front();
+            task = m_queue.front();
             m_queue.pop();
-            return task;
+            return true;
         }
 
-        return nullptr;
+        return false;
     }
 
     void close()
@@ -51,7 +60,79 @@ public:
     }
 
 private:
-    std::queue<task_type*> m_queue;
+    std::queue<task_type> m_queue;
+
+    std::condition_variable m_cv;
+    std::mutex m_mutex;
+
+    std::atomic<bool> m_close;
+};
+
+/**
+ * @brief Same as task_queue_thread_safe, but pops the greatest task first.
+ */
+template <typename T, typename Compare = std::less<T>>
+class task_priority_queue_thread_safe
+{
+public:
+    using task_type = T;
+
+    task_priority_queue_thread_safe()
+        : m_close(false)
+    {
+    }
+
+    void push(const task_type& task)
+    {
+        std::scoped_lock lock(m_mutex);
+        m_queue.push(task);
+        m_cv.notify_one();
+    }
+
+    bool pop(task_type& task)
+    {
+        std::unique_lock lock(m_mutex);
+        m_cv.wait(
+            lock,
+            [this]
+            {
+                return !m_queue.empty() || m_close;
+            });
+
+        if (!m_queue.empty())
+        {
+            task = m_queue.top();
+            m_queue.pop();
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Same as pop, but returns false instead of blocking if no task is available.
+     */
+    bool try_pop(task_type& task)
+    {
+        std::scoped_lock lock(m_mutex);
+        if (m_queue.empty())
+        {
+            return false;
+        }
+
+        task = m_queue.top();
+        m_queue.pop();
+        return true;
+    }
+
+    void close()
+    {
+        m_close = true;
+        m_cv.notify_all();
+    }
+
+private:
+    std::priority_queue<task_type, std::vector<task_type>, Compare> m_queue;
 
     std::condition_variable m_cv;
     std::mutex m_mutex;
@@ -70,25 +151,24 @@ public:
     {
     }
 
-    void push(task_type* task)
+    void push(const task_type& task)
     {
         m_queue.push(task);
     }
 
-    task_type* pop()
+    bool pop(task_type& task)
     {
-        task_type* task = nullptr;
         while (!m_queue.pop(task))
         {
             std::this_thread::yield();
 
             if (m_close)
             {
-                return nullptr;
+                return false;
             }
         }
 
-        return task;
+        return true;
     }
 
     void close()
@@ -97,7 +177,7 @@ public:
     }
 
 private:
-    lock_free_queue<task_type*> m_queue;
+    lock_free_queue<task_type> m_queue;
     std::atomic<bool> m_close;
 };
 } // namespace violet
\ No newline at end of file
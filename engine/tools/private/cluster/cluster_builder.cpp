@@ -1,12 +1,15 @@
 #include "cluster/cluster_builder.hpp"
 #include "algorithm/disjoint_set.hpp"
 #include "algorithm/hash.hpp"
+#include "common/flat_map.hpp"
 #include "cluster/graph_linker.hpp"
 #include "cluster/graph_partitioner.hpp"
+#include "math/batch.hpp"
 #include "mesh_simplifier/mesh_simplifier.hpp"
 #include <algorithm>
 #include <iterator>
 #include <map>
+#include <utility>
 #include <unordered_map>
 
 namespace violet
@@ -69,16 +72,12 @@ struct edge_key_hash
 };
 
 template <typename T>
-using edge_map = std::unordered_multimap<edge_key, T, edge_key_hash>;
+using edge_map = flat_multimap<edge_key, T, edge_key_hash>;
 } // namespace
 
 void cluster_builder::set_positions(std::span<const vec3f> positions)
 {
-    m_bounds = {};
-    for (const vec3f& position : positions)
-    {
-        box::expand(m_bounds, position);
-    }
+    m_bounds = batch::get_bounds(positions);
 
     m_positions.assign(positions.begin(), positions.end());
 
@@ -150,31 +149,54 @@ void cluster_builder::set_indexes(std::span<const std::uint32_t> indexes)
     m_indexes.assign(indexes.begin(), indexes.end());
 }
 
+void cluster_builder::set_clusters(std::span<const cluster> clusters, std::uint32_t lod)
+{
+    m_clusters.clear();
+    m_clusters.reserve(clusters.size());
+    for (const auto& cluster : clusters)
+    {
+        m_clusters.push_back({
+            .index_offset = cluster.index_offset,
+            .index_count = cluster.index_count,
+            .lod_bounds = cluster.lod_bounds,
+            .lod_error = cluster.lod_error,
+        });
+    }
+
+    m_base_lod = lod;
+}
+
 void cluster_builder::build()
 {
-    std::uint32_t group_offset = 0;
-    std::uint32_t group_lod = 0;
+    if (m_clusters.empty())
+    {
+        cluster_triangles(m_positions, m_indexes, m_clusters);
+    }
+    else
+    {
+        find_cluster_edges(m_clusters);
+    }
+
+    std::uint32_t cluster_offset = 0;
+    std::uint32_t previous_cluster_count = 0;
+    std::uint32_t group_lod = m_base_lod;
 
-    std::vector<std::uint32_t> bvh_indexes;
     while (true)
     {
-        auto cluster_offset = static_cast<std::uint32_t>(m_clusters.size());
+        auto cluster_count = static_cast<std::uint32_t>(m_clusters.size()) - cluster_offset;
 
-        if (m_clusters.empty())
-        {
-            cluster_triangles(m_positions, m_indexes);
-        }
-        else
+        // A level that removed less than a quarter of the clusters of its predecessor is mostly
+        // locked, simplifying it again would not make it much smaller.
+        if (m_stop_cluster_count != 0 &&
+            (cluster_count <= m_stop_cluster_count ||
+             (previous_cluster_count != 0 && cluster_count * 4 > previous_cluster_count * 3)))
         {
-            for (std::uint32_t i = group_offset; i < m_groups.size(); ++i)
-            {
-                simplify_group(i);
-            }
+            m_top_cluster_offset = cluster_offset;
+            m_top_lod = group_lod;
+            return;
         }
 
-        auto cluster_count = static_cast<std::uint32_t>(m_clusters.size()) - cluster_offset;
-
-        group_offset = static_cast<std::uint32_t>(m_groups.size());
+        auto group_offset = static_cast<std::uint32_t>(m_groups.size());
 
         group_clusters(cluster_offset, cluster_count);
 
@@ -183,36 +205,52 @@ void cluster_builder::build()
             m_groups[i].lod = group_lod;
         }
 
-        std::vector<std::uint32_t> group_indexes(m_groups.size() - group_offset);
-        std::iota(group_indexes.begin(), group_indexes.end(), group_offset);
-        bvh_indexes.push_back(build_bvh(group_indexes, false));
-
         ++group_lod;
 
         if (cluster_count == 1)
         {
             break;
         }
-    }
 
-    if (bvh_indexes.size() > 1)
-    {
-        build_bvh(bvh_indexes, true);
-    }
-    else
-    {
-        auto& root = m_cluster_nodes.emplace_back();
-        root.is_leaf = false;
-        root.children.push_back(bvh_indexes[0]);
+        cluster_offset = static_cast<std::uint32_t>(m_clusters.size());
+        previous_cluster_count = cluster_count;
+
+        // Groups of a level only read the previous levels, so they are simplified in parallel and
+        // merged in group order.
+        std::vector<simplified_group> results(m_groups.size() - group_offset);
+        parallel_for(
+            results.size(),
+            [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    simplify_group(group_offset + static_cast<std::uint32_t>(i), results[i]);
+                }
+            });
+
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            merge_group(group_offset + static_cast<std::uint32_t>(i), results[i]);
+            results[i] = {};
+        }
     }
 
-    calculate_bvh_error();
-    calculate_bvh_depth();
+    m_top_cluster_offset = static_cast<std::uint32_t>(m_clusters.size());
+    m_top_lod = group_lod;
+
+    build_cluster_nodes();
+}
+
+void cluster_builder::build_hierarchy(std::vector<cluster_group> groups)
+{
+    m_groups = std::move(groups);
+    build_cluster_nodes();
 }
 
 void cluster_builder::cluster_triangles(
     const std::vector<vec3f>& positions,
-    std::vector<std::uint32_t>& indexes)
+    std::vector<std::uint32_t>& indexes,
+    std::vector<cluster>& clusters) const
 {
     auto edge_count = static_cast<std::uint32_t>(indexes.size());
     std::uint32_t triangle_count = edge_count / 3;
@@ -221,6 +259,7 @@ void cluster_builder::cluster_triangles(
 
     // Build a half-edge hash table for subsequent rapid lookup of adjacent edges.
     edge_map<std::uint32_t> edge_map;
+    edge_map.reserve(edge_count);
     for (std::uint32_t edge_index = 0; edge_index < edge_count; ++edge_index)
     {
         edge_key edge_key = {
@@ -300,6 +339,7 @@ void cluster_builder::cluster_triangles(
 
     // Partition the mesh into clusters.
     graph_partitioner partitioner;
+    partitioner.set_executor(m_executor);
     partitioner.partition(
         triangle_adjacency,
         triangle_adjacency_cost,
@@ -329,7 +369,7 @@ void cluster_builder::cluster_triangles(
     }
 
     // Construct clusters based on the sorted triangles.
-    m_clusters.reserve(m_clusters.size() + parts.size());
+    clusters.reserve(clusters.size() + parts.size());
     for (auto [begin, end] : parts)
     {
         cluster cluster = {
@@ -379,7 +419,74 @@ void cluster_builder::cluster_triangles(
         }
         cluster.lod_bounds = cluster.bounding_sphere;
 
-        m_clusters.push_back(cluster);
+        clusters.push_back(cluster);
+    }
+}
+
+void cluster_builder::find_cluster_edges(std::span<cluster> clusters) const
+{
+    // Build a half-edge hash table for subsequent rapid lookup of adjacent clusters.
+    edge_map<std::uint32_t> edge_map;
+    for (std::uint32_t cluster_index = 0; cluster_index < clusters.size(); ++cluster_index)
+    {
+        const cluster& cluster = clusters[cluster_index];
+
+        for (std::uint32_t i = 0; i < cluster.index_count; ++i)
+        {
+            std::uint32_t edge_index = cluster.index_offset + i;
+
+            edge_key edge_key = {
+                .p0 = m_positions[m_indexes[edge_index]],
+                .p1 = m_positions[m_indexes[cycle_3(edge_index)]],
+            };
+            edge_map.insert({edge_key, cluster_index});
+        }
+    }
+
+    for (std::uint32_t cluster_index = 0; cluster_index < clusters.size(); ++cluster_index)
+    {
+        cluster& cluster = clusters[cluster_index];
+
+        cluster.external_edges.assign(cluster.index_count, 0);
+        for (std::uint32_t i = 0; i < cluster.index_count; ++i)
+        {
+            std::uint32_t edge_index = cluster.index_offset + i;
+
+            auto range = edge_map.equal_range({
+                .p0 = m_positions[m_indexes[cycle_3(edge_index)]],
+                .p1 = m_positions[m_indexes[edge_index]],
+            });
+
+            // If the edge is adjacent to an edge in another cluster, or to no edge at all, it must
+            // be an external edge.
+            if (range.first == range.second)
+            {
+                cluster.external_edges[i] |= cluster::EXTERNAL_EDGE_CLUSTER;
+            }
+
+            for (auto iter = range.first; iter != range.second; ++iter)
+            {
+                if (iter->second != cluster_index)
+                {
+                    cluster.external_edges[i] |= cluster::EXTERNAL_EDGE_CLUSTER;
+                }
+            }
+        }
+
+        cluster.bounding_box = {};
+        for (std::uint32_t i = 0; i < cluster.index_count; ++i)
+        {
+            box::expand(cluster.bounding_box, m_positions[m_indexes[cluster.index_offset + i]]);
+        }
+
+        cluster.bounding_sphere.center = box::get_center(cluster.bounding_box);
+        cluster.bounding_sphere.radius = 0.0f;
+        for (std::uint32_t i = 0; i < cluster.index_count; ++i)
+        {
+            sphere::expand(
+                cluster.bounding_sphere,
+                m_positions[m_indexes[cluster.index_offset + i]]);
+        }
     }
 }
 
@@ -416,30 +523,35 @@ void cluster_builder::group_clusters(std::uint32_t cluster_offset, std::uint32_t
         // Key: adjacency cluster index.
         // Value: adjacency edge count. Used to determine the cost of grouping two clusters.
         std::vector<std::map<std::uint32_t, std::uint32_t>> cluster_adjacency_map(clusters.size());
-        for (std::uint32_t cluster_index = 0; cluster_index < clusters.size(); ++cluster_index)
-        {
-            const auto& cluster = clusters[cluster_index];
-
-            for (std::uint32_t i = 0; i < cluster.index_count; ++i)
+        parallel_for(
+            clusters.size(),
+            [&](std::size_t begin, std::size_t end)
             {
-                // If the edge is not an external edge, it is not an adjacency edge.
-                if (cluster.external_edges[i] == 0)
+                for (std::size_t cluster_index = begin; cluster_index < end; ++cluster_index)
                 {
-                    continue;
-                }
+                    const auto& cluster = clusters[cluster_index];
 
-                std::uint32_t edge_index = cluster.index_offset + i;
-
-                auto range = edge_map.equal_range({
-                    .p0 = m_positions[m_indexes[cycle_3(edge_index)]],
-                    .p1 = m_positions[m_indexes[edge_index]],
-                });
-                for (auto iter = range.first; iter != range.second; ++iter)
-                {
-                    ++cluster_adjacency_map[cluster_index][iter->second];
+                    for (std::uint32_t i = 0; i < cluster.index_count; ++i)
+                    {
+                        // If the edge is not an external edge, it is not an adjacency edge.
+                        if (cluster.external_edges[i] == 0)
+                        {
+                            continue;
+                        }
+
+                        std::uint32_t edge_index = cluster.index_offset + i;
+
+                        auto range = std::as_const(edge_map).equal_range({
+                            .p0 = m_positions[m_indexes[cycle_3(edge_index)]],
+                            .p1 = m_positions[m_indexes[edge_index]],
+                        });
+                        for (auto iter = range.first; iter != range.second; ++iter)
+                        {
+                            ++cluster_adjacency_map[cluster_index][iter->second];
+                        }
+                    }
                 }
-            }
-        }
+            });
 
         // Build a disjoint set for linking independent clusters.
         disjoint_set<std::uint32_t> disjoint_set(static_cast<std::uint32_t>(clusters.size()));
@@ -485,6 +597,7 @@ void cluster_builder::group_clusters(std::uint32_t cluster_offset, std::uint32_t
         cluster_adjacency_offset.push_back(static_cast<std::uint32_t>(cluster_adjacency.size()));
 
         graph_partitioner partitioner;
+        partitioner.set_executor(m_executor);
         partitioner.partition(
             cluster_adjacency,
             cluster_adjacency_cost,
@@ -516,78 +629,87 @@ void cluster_builder::group_clusters(std::uint32_t cluster_offset, std::uint32_t
         std::iota(cluster_index_to_sorted.begin(), cluster_index_to_sorted.end(), 0);
     }
 
-    // Construct groups based on the sorted clusters.
-    m_groups.reserve(m_groups.size() + cluster_parts.size());
-    for (auto [begin, end] : cluster_parts)
-    {
-        cluster_group group = {
-            .min_lod_error = std::numeric_limits<float>::infinity(),
-            .max_parent_lod_error = std::numeric_limits<float>::infinity(),
-            .cluster_offset = begin + cluster_offset,
-            .cluster_count = end - begin,
-        };
-
-        std::vector<sphere3f> cluster_bounding_spheres;
-        std::vector<sphere3f> cluster_lod_bounds;
-
-        for (std::uint32_t cluster_index = begin; cluster_index < end; ++cluster_index)
+    // Construct groups based on the sorted clusters. Every part writes its own group and clusters.
+    std::size_t group_offset = m_groups.size();
+    m_groups.resize(group_offset + cluster_parts.size());
+    parallel_for(
+        cluster_parts.size(),
+        [&](std::size_t part_begin, std::size_t part_end)
         {
-            cluster& cluster = clusters[cluster_index];
-            cluster.group_index = static_cast<std::uint32_t>(m_groups.size());
-
-            group.min_lod_error = std::min(group.min_lod_error, cluster.lod_error);
+            for (std::size_t part = part_begin; part < part_end; ++part)
+            {
+                auto [begin, end] = cluster_parts[part];
+
+                cluster_group& group = m_groups[group_offset + part];
+                group = {
+                    .min_lod_error = std::numeric_limits<float>::infinity(),
+                    .max_parent_lod_error = std::numeric_limits<float>::infinity(),
+                    .cluster_offset = begin + cluster_offset,
+                    .cluster_count = end - begin,
+                };
 
-            box::expand(group.bounding_box, cluster.bounding_box);
-            cluster_bounding_spheres.push_back(cluster.bounding_sphere);
-            cluster_lod_bounds.push_back(cluster.lod_bounds);
+                std::vector<sphere3f> cluster_bounding_spheres;
+                std::vector<sphere3f> cluster_lod_bounds;
 
-            // Find the external edges of the group.
-            for (std::uint32_t i = 0; i < cluster.index_count; ++i)
-            {
-                if (cluster.external_edges[i] == 0)
+                for (std::uint32_t cluster_index = begin; cluster_index < end; ++cluster_index)
                 {
-                    continue;
-                }
+                    cluster& cluster = clusters[cluster_index];
+                    cluster.group_index = static_cast<std::uint32_t>(group_offset + part);
 
-                std::uint32_t edge_index = cluster.index_offset + i;
+                    group.min_lod_error = std::min(group.min_lod_error, cluster.lod_error);
 
-                auto range = edge_map.equal_range({
-                    .p0 = m_positions[m_indexes[cycle_3(edge_index)]],
-                    .p1 = m_positions[m_indexes[edge_index]],
-                });
+                    box::expand(group.bounding_box, cluster.bounding_box);
+                    cluster_bounding_spheres.push_back(cluster.bounding_sphere);
+                    cluster_lod_bounds.push_back(cluster.lod_bounds);
 
-                // If the edge is adjacent to an edge in another cluster not in the group, it must
-                // be an external edge.
-                for (auto iter = range.first; iter != range.second; ++iter)
-                {
-                    std::uint32_t adjacency_cluster_index = cluster_index_to_sorted[iter->second];
-                    if (adjacency_cluster_index < begin || adjacency_cluster_index >= end)
+                    // Find the external edges of the group.
+                    for (std::uint32_t i = 0; i < cluster.index_count; ++i)
                     {
-                        cluster.external_edges[i] |= cluster::EXTERNAL_EDGE_GROUP;
+                        if (cluster.external_edges[i] == 0)
+                        {
+                            continue;
+                        }
+
+                        std::uint32_t edge_index = cluster.index_offset + i;
+
+                        auto range = std::as_const(edge_map).equal_range({
+                            .p0 = m_positions[m_indexes[cycle_3(edge_index)]],
+                            .p1 = m_positions[m_indexes[edge_index]],
+                        });
+
+                        // If the edge is adjacent to an edge in another cluster not in the group,
+                        // it must be an external edge.
+                        for (auto iter = range.first; iter != range.second; ++iter)
+                        {
+                            std::uint32_t adjacency_cluster_index =
+                                cluster_index_to_sorted[iter->second];
+                            if (adjacency_cluster_index < begin || adjacency_cluster_index >= end)
+                            {
+                                cluster.external_edges[i] |= cluster::EXTERNAL_EDGE_GROUP;
+                            }
+                        }
+
+                        // If the edge is not adjacent to any other edges, it must be an external
+                        // edge.
+                        if (range.first == range.second)
+                        {
+                            cluster.external_edges[i] |= cluster::EXTERNAL_EDGE_GROUP;
+                        }
                     }
                 }
 
-                // If the edge is not adjacent to any other edges, it must be an external edge.
-                if (range.first == range.second)
-                {
-                    cluster.external_edges[i] |= cluster::EXTERNAL_EDGE_GROUP;
-                }
+                group.bounding_sphere = sphere::create(cluster_bounding_spheres);
+                group.lod_bounds = sphere::create(cluster_lod_bounds);
             }
-        }
-
-        group.bounding_sphere = sphere::create(cluster_bounding_spheres);
-        group.lod_bounds = sphere::create(cluster_lod_bounds);
-
-        m_groups.push_back(group);
-    }
+        });
 }
 
-void cluster_builder::simplify_group(std::uint32_t group_index)
+void cluster_builder::simplify_group(std::uint32_t group_index, simplified_group& result) const
 {
-    auto& group = m_groups[group_index];
+    const auto& group = m_groups[group_index];
 
     // Collect the indexes of the group for simplification.
-    std::vector<std::uint32_t> indexes;
+    std::vector<std::uint32_t>& indexes = result.indexes;
 
     std::unordered_map<std::uint32_t, std::uint32_t> group_index_remap;
     std::vector<std::uint32_t> group_vertex_remap;
@@ -613,8 +735,8 @@ void cluster_builder::simplify_group(std::uint32_t group_index)
         }
     }
 
-    std::vector<vec3f> positions;
-    std::vector<float> attributes;
+    std::vector<vec3f>& positions = result.positions;
+    std::vector<float>& attributes = result.attributes;
 
     positions.reserve(group_vertex_remap.size());
     attributes.reserve(group_vertex_remap.size() * get_attribute_count());
@@ -727,12 +849,19 @@ void cluster_builder::simplify_group(std::uint32_t group_index)
     positions.resize(simplifier.get_vertex_count());
     indexes.resize(simplifier.get_index_count());
 
-    lod_error = std::max(lod_error, error);
-
-    std::size_t cluster_offset = m_clusters.size();
+    result.lod_error = std::max(lod_error, error);
 
     // Cluster the new triangles.
-    cluster_triangles(positions, indexes);
+    cluster_triangles(positions, indexes, result.clusters);
+}
+
+void cluster_builder::merge_group(std::uint32_t group_index, simplified_group& result)
+{
+    auto& group = m_groups[group_index];
+
+    const auto& positions = result.positions;
+    const auto& indexes = result.indexes;
+    auto vertex_count = static_cast<std::uint32_t>(positions.size());
 
     auto vertex_offset = static_cast<std::uint32_t>(m_positions.size());
     m_positions.insert(m_positions.end(), positions.begin(), positions.end());
@@ -748,23 +877,23 @@ void cluster_builder::simplify_group(std::uint32_t group_index)
 
     if (!m_normals.empty())
     {
-        m_normals.resize(m_normals.size() + simplifier.get_vertex_count());
+        m_normals.resize(m_normals.size() + vertex_count);
     }
 
     if (!m_tangents.empty())
     {
-        m_tangents.resize(m_tangents.size() + simplifier.get_vertex_count());
+        m_tangents.resize(m_tangents.size() + vertex_count);
     }
 
     if (!m_texcoords.empty())
     {
-        m_texcoords.resize(m_texcoords.size() + simplifier.get_vertex_count());
+        m_texcoords.resize(m_texcoords.size() + vertex_count);
     }
 
-    if (!attributes.empty())
+    if (!result.attributes.empty())
     {
-        const float* attribute_data = attributes.data();
-        for (std::size_t i = 0; i < simplifier.get_vertex_count(); ++i)
+        const float* attribute_data = result.attributes.data();
+        for (std::size_t i = 0; i < vertex_count; ++i)
         {
             if (!m_normals.empty())
             {
@@ -786,15 +915,57 @@ void cluster_builder::simplify_group(std::uint32_t group_index)
         }
     }
 
-    for (std::size_t i = cluster_offset; i < m_clusters.size(); ++i)
+    for (cluster& cluster : result.clusters)
     {
-        m_clusters[i].index_offset += index_offset;
-        m_clusters[i].lod_bounds = group.lod_bounds;
-        m_clusters[i].lod_error = lod_error;
-        m_clusters[i].child_group_index = group_index;
+        cluster.index_offset += index_offset;
+        cluster.lod_bounds = group.lod_bounds;
+        cluster.lod_error = result.lod_error;
+        cluster.child_group_index = group_index;
+
+        m_clusters.push_back(std::move(cluster));
+    }
+
+    group.max_parent_lod_error = result.lod_error;
+}
+
+void cluster_builder::build_cluster_nodes()
+{
+    m_cluster_nodes.clear();
+
+    // Each lod gets a BVH of its own, the roots of which are joined under a single root.
+    std::vector<std::vector<std::uint32_t>> lod_groups;
+    for (std::uint32_t group_index = 0; group_index < m_groups.size(); ++group_index)
+    {
+        std::uint32_t lod = m_groups[group_index].lod;
+        if (lod >= lod_groups.size())
+        {
+            lod_groups.resize(lod + 1);
+        }
+        lod_groups[lod].push_back(group_index);
     }
 
-    group.max_parent_lod_error = lod_error;
+    std::vector<std::uint32_t> bvh_indexes;
+    for (auto& group_indexes : lod_groups)
+    {
+        if (!group_indexes.empty())
+        {
+            bvh_indexes.push_back(build_bvh(group_indexes, false));
+        }
+    }
+
+    if (bvh_indexes.size() > 1)
+    {
+        build_bvh(bvh_indexes, true);
+    }
+    else
+    {
+        auto& root = m_cluster_nodes.emplace_back();
+        root.is_leaf = false;
+        root.children.push_back(bvh_indexes[0]);
+    }
+
+    calculate_bvh_error();
+    calculate_bvh_depth();
 }
 
 std::uint32_t cluster_builder::build_bvh(std::span<std::uint32_t> indexes, bool root)
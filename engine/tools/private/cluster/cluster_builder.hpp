@@ -2,6 +2,7 @@
 
 #include "math/box.hpp"
 #include "math/sphere.hpp"
+#include "task/task_executor.hpp"
 #include <span>
 #include <vector>
 
@@ -69,8 +70,39 @@ public:
     void set_texcoords(std::span<const vec2f> texcoords);
     void set_indexes(std::span<const std::uint32_t> indexes);
 
+    /**
+     * @brief Uses the given clusters as the finest level instead of clustering the triangles, so a
+     * build can continue from the top level of other builders. Only the index range, lod bounds and
+     * lod error of each cluster are read. Groups of the first level get the given lod.
+     */
+    void set_clusters(std::span<const cluster> clusters, std::uint32_t lod);
+
+    /**
+     * @brief Stops before grouping a level that has at most the given number of clusters, or that
+     * failed to reduce the previous level because too much of it is locked. The clusters of that
+     * level are left without a group and no cluster nodes are built. 0 builds to a single cluster.
+     */
+    void set_stop_cluster_count(std::uint32_t cluster_count) noexcept
+    {
+        m_stop_cluster_count = cluster_count;
+    }
+
+    /**
+     * @brief Groups of a level are simplified and clustered on the executor. The result does not
+     * depend on the thread count, groups are merged back in order. Builds serially if not set.
+     */
+    void set_executor(task_executor* executor) noexcept
+    {
+        m_executor = executor;
+    }
+
     void build();
 
+    /**
+     * @brief Builds only the cluster nodes, over groups that were built by other builders.
+     */
+    void build_hierarchy(std::vector<cluster_group> groups);
+
     const std::vector<cluster>& get_clusters() const noexcept
     {
         return m_clusters;
@@ -86,6 +118,19 @@ public:
         return m_groups;
     }
 
+    /**
+     * @brief Clusters from this offset on were left without a group by a stopped build.
+     */
+    std::uint32_t get_top_cluster_offset() const noexcept
+    {
+        return m_top_cluster_offset;
+    }
+
+    std::uint32_t get_top_lod() const noexcept
+    {
+        return m_top_lod;
+    }
+
     const std::vector<vec3f>& get_positions() const noexcept
     {
         return m_positions;
@@ -112,12 +157,42 @@ public:
     }
 
 private:
+    struct simplified_group
+    {
+        std::vector<vec3f> positions;
+        std::vector<float> attributes;
+        std::vector<std::uint32_t> indexes;
+
+        // Index offsets are relative to the indexes of the group.
+        std::vector<cluster> clusters;
+
+        float lod_error;
+    };
+
     void cluster_triangles(
         const std::vector<vec3f>& positions,
-        std::vector<std::uint32_t>& indexes);
+        std::vector<std::uint32_t>& indexes,
+        std::vector<cluster>& clusters) const;
+    void find_cluster_edges(std::span<cluster> clusters) const;
     void group_clusters(std::uint32_t cluster_offset, std::uint32_t cluster_count);
-    void simplify_group(std::uint32_t group_index);
 
+    void simplify_group(std::uint32_t group_index, simplified_group& result) const;
+    void merge_group(std::uint32_t group_index, simplified_group& result);
+
+    template <typename Functor>
+    void parallel_for(std::size_t count, Functor&& functor)
+    {
+        if (m_executor != nullptr)
+        {
+            m_executor->parallel_for(count, 1, functor);
+        }
+        else
+        {
+            functor(0, count);
+        }
+    }
+
+    void build_cluster_nodes();
     std::uint32_t build_bvh(std::span<std::uint32_t> indexes, bool root);
     void sort_groups(std::span<std::uint32_t> group_indexes, std::uint32_t split);
     void calculate_bvh_error();
@@ -136,6 +211,13 @@ private:
 
     box3f m_bounds;
 
+    task_executor* m_executor{nullptr};
+
+    std::uint32_t m_stop_cluster_count{0};
+    std::uint32_t m_top_cluster_offset{0};
+    std::uint32_t m_base_lod{0};
+    std::uint32_t m_top_lod{0};
+
     std::vector<cluster> m_clusters;
     std::vector<cluster_node> m_cluster_nodes;
     std::vector<cluster_group> m_groups;
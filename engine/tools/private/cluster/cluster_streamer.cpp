@@ -0,0 +1,692 @@
+#include "cluster/cluster_streamer.hpp"
+#include "algorithm/hash.hpp"
+#include "common/flat_map.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace violet
+{
+namespace
+{
+// Rough peak memory of cluster_builder per input triangle, including the welded vertices, the edge
+// tables, the partitioner graphs and the simplified levels.
+constexpr std::size_t BYTES_PER_TRIANGLE = 1024;
+constexpr std::uint64_t MIN_BRICK_TRIANGLE_COUNT = 1024;
+constexpr std::uint32_t MAX_BRICK_DEPTH = 16;
+
+// The top levels of up to 8 sibling bricks are merged, so each is cut at an eighth of a brick.
+constexpr std::uint32_t MERGE_BRICK_COUNT = 8;
+constexpr std::uint32_t CLUSTER_TRIANGLE_COUNT = 128;
+
+constexpr std::size_t READ_TRIANGLE_COUNT = 16384;
+
+constexpr std::uint32_t INVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+using vertex = cluster_streamer::vertex;
+
+struct vertex_hash
+{
+    std::uint64_t operator()(const vertex& v) const noexcept
+    {
+        return hash::xx_hash(&v, sizeof(vertex));
+    }
+};
+
+struct vertex_equal
+{
+    bool operator()(const vertex& a, const vertex& b) const noexcept
+    {
+        return std::memcmp(&a, &b, sizeof(vertex)) == 0;
+    }
+};
+
+// Corners of bricks come in unindexed, sibling top levels share their border vertices.
+void weld_vertices(std::vector<vertex>& vertices, std::vector<std::uint32_t>& indexes)
+{
+    flat_map<vertex, std::uint32_t, vertex_hash, vertex_equal> vertex_map;
+    vertex_map.reserve(vertices.size());
+
+    std::vector<vertex> welded_vertices;
+    for (std::uint32_t& index : indexes)
+    {
+        auto [iter, inserted] = vertex_map.insert(
+            {vertices[index], static_cast<std::uint32_t>(welded_vertices.size())});
+        if (inserted)
+        {
+            welded_vertices.push_back(vertices[index]);
+        }
+        index = iter->second;
+    }
+
+    vertices = std::move(welded_vertices);
+}
+
+template <typename T>
+void write_array(std::ofstream& fout, const std::vector<T>& array)
+{
+    fout.write(
+        reinterpret_cast<const char*>(array.data()),
+        static_cast<std::streamsize>(array.size() * sizeof(T)));
+}
+
+template <typename T>
+void read_array(std::ifstream& fin, std::vector<T>& array, std::size_t count)
+{
+    std::size_t offset = array.size();
+    array.resize(offset + count);
+    fin.read(
+        reinterpret_cast<char*>(array.data() + offset),
+        static_cast<std::streamsize>(count * sizeof(T)));
+}
+} // namespace
+
+cluster_streamer::~cluster_streamer()
+{
+    for (auto& lod_file : m_lod_files)
+    {
+        lod_file.close();
+    }
+
+    if (!m_directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::remove_all(m_directory, error);
+    }
+}
+
+void cluster_streamer::set_memory_budget(std::size_t memory_budget) noexcept
+{
+    m_brick_triangle_count =
+        std::max<std::uint64_t>(memory_budget / BYTES_PER_TRIANGLE, MIN_BRICK_TRIANGLE_COUNT);
+    m_stop_cluster_count = std::max(
+        static_cast<std::uint32_t>(
+            m_brick_triangle_count / (MERGE_BRICK_COUNT * CLUSTER_TRIANGLE_COUNT)),
+        1u);
+}
+
+bool cluster_streamer::build(const std::function<std::size_t(std::span<vertex>)>& read)
+{
+    if (m_brick_triangle_count == 0)
+    {
+        set_memory_budget(std::size_t{1} << 30);
+    }
+
+    std::filesystem::path temp_directory = m_temp_directory;
+    if (temp_directory.empty())
+    {
+        temp_directory = std::filesystem::temp_directory_path();
+    }
+
+    std::random_device random;
+    m_directory = temp_directory / ("violet-clusters-" + std::to_string(random()));
+
+    std::error_code error;
+    if (!std::filesystem::create_directories(m_directory, error))
+    {
+        m_directory.clear();
+        return false;
+    }
+
+    brick root = {};
+    if (!spill_triangles(read, root))
+    {
+        return false;
+    }
+
+    if (root.triangle_count == 0)
+    {
+        return false;
+    }
+
+    split_brick(root, 0);
+
+    top_level top = {};
+    if (!build_brick(root, true, top))
+    {
+        return false;
+    }
+
+    bool result = true;
+    for (auto& lod_file : m_lod_files)
+    {
+        lod_file.close();
+        result = result && !lod_file.fail();
+    }
+
+    return result;
+}
+
+bool cluster_streamer::for_each_cluster(
+    std::uint32_t lod,
+    const std::function<
+        void(const cluster&, std::span<const vertex>, std::span<const std::uint32_t>)>& callback)
+    const
+{
+    if (lod >= m_lod_paths.size() || m_lod_paths[lod].empty())
+    {
+        return true;
+    }
+
+    std::ifstream fin(m_lod_paths[lod], std::ios::binary);
+    if (!fin.is_open())
+    {
+        return false;
+    }
+
+    cluster stored_cluster = {};
+    std::vector<vertex> vertices;
+    std::vector<std::uint32_t> indexes;
+
+    for (std::uint32_t i = 0; i < m_lod_cluster_counts[lod]; ++i)
+    {
+        fin.read(reinterpret_cast<char*>(&stored_cluster), sizeof(cluster));
+
+        std::uint32_t counts[2] = {};
+        fin.read(reinterpret_cast<char*>(counts), sizeof(counts));
+
+        vertices.clear();
+        indexes.clear();
+        read_array(fin, vertices, counts[0]);
+        read_array(fin, indexes, counts[1]);
+
+        if (fin.fail())
+        {
+            return false;
+        }
+
+        callback(stored_cluster, vertices, indexes);
+    }
+
+    return true;
+}
+
+bool cluster_streamer::spill_triangles(
+    const std::function<std::size_t(std::span<vertex>)>& read,
+    brick& root)
+{
+    root.path = create_temp_path("brick");
+    root.triangle_count = 0;
+
+    std::ofstream fout(root.path, std::ios::binary);
+    if (!fout.is_open())
+    {
+        return false;
+    }
+
+    std::vector<vertex> vertices(READ_TRIANGLE_COUNT * 3);
+    while (true)
+    {
+        std::size_t vertex_count = read(vertices);
+        if (vertex_count == 0)
+        {
+            break;
+        }
+
+        vertex_count -= vertex_count % 3;
+        for (std::size_t i = 0; i < vertex_count; ++i)
+        {
+            // Unused attributes must not keep equal vertices from being welded.
+            vertex& corner = vertices[i];
+            corner.normal = m_has_normal ? corner.normal : vec3f{};
+            corner.tangent = m_has_tangent ? corner.tangent : vec4f{};
+            corner.texcoord = m_has_texcoord ? corner.texcoord : vec2f{};
+        }
+
+        for (std::size_t i = 0; i < vertex_count; i += 3)
+        {
+            vec3f center = vertices[i + 0].position;
+            center += vertices[i + 1].position;
+            center += vertices[i + 2].position;
+            center /= 3.0f;
+
+            box::expand(root.bounds, center);
+        }
+
+        fout.write(
+            reinterpret_cast<const char*>(vertices.data()),
+            static_cast<std::streamsize>(vertex_count * sizeof(vertex)));
+        root.triangle_count += vertex_count / 3;
+    }
+
+    return !fout.fail();
+}
+
+void cluster_streamer::split_brick(brick& brick, std::uint32_t depth)
+{
+    if (brick.triangle_count <= m_brick_triangle_count || depth == MAX_BRICK_DEPTH)
+    {
+        return;
+    }
+
+    // Only axes at least half as long as the longest one are split, so the bricks of flat scans
+    // do not become slivers.
+    vec3f extent = box::get_extent(brick.bounds);
+    float max_extent = std::max({extent.x, extent.y, extent.z});
+    if (max_extent <= 0.0f)
+    {
+        return;
+    }
+
+    vec3f center = box::get_center(brick.bounds);
+
+    std::array<bool, 3> split_axes = {};
+    for (std::size_t axis = 0; axis < 3; ++axis)
+    {
+        split_axes[axis] = extent[axis] >= max_extent * 0.5f;
+    }
+
+    std::array<cluster_streamer::brick, 8> children = {};
+    std::array<std::ofstream, 8> child_files;
+
+    {
+        std::ifstream fin(brick.path, std::ios::binary);
+
+        std::vector<vertex> vertices(READ_TRIANGLE_COUNT * 3);
+        while (fin)
+        {
+            fin.read(
+                reinterpret_cast<char*>(vertices.data()),
+                static_cast<std::streamsize>(vertices.size() * sizeof(vertex)));
+            auto vertex_count = static_cast<std::size_t>(fin.gcount()) / sizeof(vertex);
+
+            for (std::size_t i = 0; i < vertex_count; i += 3)
+            {
+                vec3f triangle_center = vertices[i + 0].position;
+                triangle_center += vertices[i + 1].position;
+                triangle_center += vertices[i + 2].position;
+                triangle_center /= 3.0f;
+
+                std::uint32_t child_index = 0;
+                for (std::uint32_t axis = 0; axis < 3; ++axis)
+                {
+                    if (split_axes[axis] && triangle_center[axis] >= center[axis])
+                    {
+                        child_index |= 1 << axis;
+                    }
+                }
+
+                auto& child = children[child_index];
+                if (!child_files[child_index].is_open())
+                {
+                    child.path = create_temp_path("brick");
+                    child_files[child_index].open(child.path, std::ios::binary);
+                }
+
+                child_files[child_index].write(
+                    reinterpret_cast<const char*>(vertices.data() + i),
+                    static_cast<std::streamsize>(3 * sizeof(vertex)));
+                ++child.triangle_count;
+                box::expand(child.bounds, triangle_center);
+            }
+        }
+    }
+
+    std::filesystem::remove(brick.path);
+    brick.path.clear();
+
+    for (std::size_t i = 0; i < children.size(); ++i)
+    {
+        if (children[i].triangle_count != 0)
+        {
+            child_files[i].close();
+            brick.children.push_back(std::move(children[i]));
+        }
+    }
+
+    for (auto& child : brick.children)
+    {
+        split_brick(child, depth + 1);
+    }
+}
+
+bool cluster_streamer::build_brick(brick& brick, bool root, top_level& top)
+{
+    std::vector<vertex> vertices;
+    std::vector<std::uint32_t> indexes;
+    std::vector<cluster_builder::cluster> clusters;
+    std::uint32_t lod = 0;
+
+    if (brick.children.empty())
+    {
+        std::ifstream fin(brick.path, std::ios::binary);
+        read_array(fin, vertices, brick.triangle_count * 3);
+        bool succeeded = !fin.fail();
+        fin.close();
+
+        std::filesystem::remove(brick.path);
+
+        if (!succeeded)
+        {
+            return false;
+        }
+
+        indexes.resize(vertices.size());
+        std::iota(indexes.begin(), indexes.end(), 0);
+    }
+    else
+    {
+        // Children are built one after another, only their top levels are kept until the merge.
+        std::vector<top_level> child_tops(brick.children.size());
+        for (std::size_t i = 0; i < brick.children.size(); ++i)
+        {
+            if (!build_brick(brick.children[i], false, child_tops[i]))
+            {
+                return false;
+            }
+        }
+        brick.children.clear();
+
+        // Every top level is read even after a failure, so that all temporary files are removed.
+        bool succeeded = true;
+        for (const auto& child_top : child_tops)
+        {
+            succeeded = read_top_level(child_top, vertices, indexes, clusters) && succeeded;
+            lod = std::max(lod, child_top.lod);
+        }
+
+        if (!succeeded)
+        {
+            return false;
+        }
+    }
+
+    weld_vertices(vertices, indexes);
+
+    cluster_builder builder;
+    builder.set_executor(m_executor);
+
+    {
+        std::vector<vec3f> positions;
+        positions.reserve(vertices.size());
+        for (const auto& corner : vertices)
+        {
+            positions.push_back(corner.position);
+        }
+        builder.set_positions(positions);
+    }
+
+    if (m_has_normal)
+    {
+        std::vector<vec3f> normals;
+        normals.reserve(vertices.size());
+        for (const auto& corner : vertices)
+        {
+            normals.push_back(corner.normal);
+        }
+        builder.set_normals(normals);
+    }
+
+    if (m_has_tangent)
+    {
+        std::vector<vec4f> tangents;
+        tangents.reserve(vertices.size());
+        for (const auto& corner : vertices)
+        {
+            tangents.push_back(corner.tangent);
+        }
+        builder.set_tangents(tangents);
+    }
+
+    if (m_has_texcoord)
+    {
+        std::vector<vec2f> texcoords;
+        texcoords.reserve(vertices.size());
+        for (const auto& corner : vertices)
+        {
+            texcoords.push_back(corner.texcoord);
+        }
+        builder.set_texcoords(texcoords);
+    }
+
+    vertices = {};
+
+    builder.set_indexes(indexes);
+    indexes = {};
+
+    if (!clusters.empty())
+    {
+        builder.set_clusters(clusters, lod);
+        clusters = {};
+    }
+
+    if (!root)
+    {
+        builder.set_stop_cluster_count(m_stop_cluster_count);
+    }
+
+    builder.build();
+
+    if (!write_groups(builder))
+    {
+        return false;
+    }
+
+    if (!root)
+    {
+        write_top_level(builder, top);
+    }
+
+    return true;
+}
+
+bool cluster_streamer::write_groups(const cluster_builder& builder)
+{
+    const auto& builder_positions = builder.get_positions();
+    const auto& builder_normals = builder.get_normals();
+    const auto& builder_tangents = builder.get_tangents();
+    const auto& builder_texcoords = builder.get_texcoords();
+    const auto& builder_indexes = builder.get_indexes();
+    const auto& builder_clusters = builder.get_clusters();
+
+    // Every cluster is written with its own vertices, so a lod can be paged in on its own.
+    std::vector<std::uint32_t> vertex_remap(builder_positions.size(), INVALID_INDEX);
+    std::vector<std::uint32_t> cluster_vertices;
+
+    std::vector<vertex> vertices;
+    std::vector<std::uint32_t> indexes;
+
+    for (const auto& group : builder.get_groups())
+    {
+        if (group.lod >= m_lod_files.size())
+        {
+            m_lod_paths.resize(group.lod + 1);
+            m_lod_files.resize(group.lod + 1);
+            m_lod_cluster_counts.resize(group.lod + 1);
+        }
+
+        std::ofstream& fout = m_lod_files[group.lod];
+        if (!fout.is_open())
+        {
+            m_lod_paths[group.lod] = create_temp_path("lod");
+            fout.open(m_lod_paths[group.lod], std::ios::binary);
+            if (!fout.is_open())
+            {
+                return false;
+            }
+        }
+
+        auto& output_group = m_groups.emplace_back(group);
+        output_group.cluster_offset = m_lod_cluster_counts[group.lod];
+
+        for (std::uint32_t i = 0; i < group.cluster_count; ++i)
+        {
+            const auto& builder_cluster = builder_clusters[group.cluster_offset + i];
+
+            cluster output_cluster = {
+                .index_offset = 0,
+                .index_count = builder_cluster.index_count,
+                .bounding_sphere = builder_cluster.bounding_sphere,
+                .lod_bounds = builder_cluster.lod_bounds,
+                .lod_error = builder_cluster.lod_error,
+                .parent_lod_bounds = group.lod_bounds,
+                .parent_lod_error = group.max_parent_lod_error,
+                .lod = group.lod,
+            };
+
+            cluster_vertices.clear();
+            indexes.clear();
+
+            for (std::uint32_t j = 0; j < builder_cluster.index_count; ++j)
+            {
+                std::uint32_t index = builder_indexes[builder_cluster.index_offset + j];
+                if (vertex_remap[index] == INVALID_INDEX)
+                {
+                    vertex_remap[index] = static_cast<std::uint32_t>(cluster_vertices.size());
+                    cluster_vertices.push_back(index);
+                }
+
+                indexes.push_back(vertex_remap[index]);
+            }
+
+            vertices.clear();
+            for (std::uint32_t index : cluster_vertices)
+            {
+                vertices.push_back({
+                    .position = builder_positions[index],
+                    .normal = m_has_normal ? builder_normals[index] : vec3f{},
+                    .tangent = m_has_tangent ? builder_tangents[index] : vec4f{},
+                    .texcoord = m_has_texcoord ? builder_texcoords[index] : vec2f{},
+                });
+
+                vertex_remap[index] = INVALID_INDEX;
+            }
+
+            std::uint32_t counts[] = {
+                static_cast<std::uint32_t>(vertices.size()),
+                static_cast<std::uint32_t>(indexes.size()),
+            };
+
+            fout.write(reinterpret_cast<const char*>(&output_cluster), sizeof(cluster));
+            fout.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+            write_array(fout, vertices);
+            write_array(fout, indexes);
+
+            ++m_lod_cluster_counts[group.lod];
+        }
+
+        if (fout.fail())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void cluster_streamer::write_top_level(const cluster_builder& builder, top_level& top)
+{
+    const auto& builder_positions = builder.get_positions();
+    const auto& builder_normals = builder.get_normals();
+    const auto& builder_tangents = builder.get_tangents();
+    const auto& builder_texcoords = builder.get_texcoords();
+    const auto& builder_indexes = builder.get_indexes();
+    const auto& builder_clusters = builder.get_clusters();
+
+    std::vector<std::uint32_t> vertex_remap(builder_positions.size(), INVALID_INDEX);
+    std::vector<vertex> vertices;
+    std::vector<std::uint32_t> indexes;
+    std::vector<cluster_builder::cluster> clusters;
+
+    for (std::size_t i = builder.get_top_cluster_offset(); i < builder_clusters.size(); ++i)
+    {
+        const auto& builder_cluster = builder_clusters[i];
+
+        clusters.push_back({
+            .index_offset = static_cast<std::uint32_t>(indexes.size()),
+            .index_count = builder_cluster.index_count,
+            .lod_bounds = builder_cluster.lod_bounds,
+            .lod_error = builder_cluster.lod_error,
+        });
+
+        for (std::uint32_t j = 0; j < builder_cluster.index_count; ++j)
+        {
+            std::uint32_t index = builder_indexes[builder_cluster.index_offset + j];
+            if (vertex_remap[index] == INVALID_INDEX)
+            {
+                vertex_remap[index] = static_cast<std::uint32_t>(vertices.size());
+
+                vertices.push_back({
+                    .position = builder_positions[index],
+                    .normal = m_has_normal ? builder_normals[index] : vec3f{},
+                    .tangent = m_has_tangent ? builder_tangents[index] : vec4f{},
+                    .texcoord = m_has_texcoord ? builder_texcoords[index] : vec2f{},
+                });
+            }
+
+            indexes.push_back(vertex_remap[index]);
+        }
+    }
+
+    top.path = create_temp_path("top");
+    top.lod = builder.get_top_lod();
+
+    std::ofstream fout(top.path, std::ios::binary);
+
+    std::uint32_t counts[] = {
+        static_cast<std::uint32_t>(vertices.size()),
+        static_cast<std::uint32_t>(indexes.size()),
+        static_cast<std::uint32_t>(clusters.size()),
+    };
+    fout.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+
+    write_array(fout, vertices);
+    write_array(fout, indexes);
+
+    for (const auto& cluster : clusters)
+    {
+        fout.write(reinterpret_cast<const char*>(&cluster.index_offset), sizeof(std::uint32_t));
+        fout.write(reinterpret_cast<const char*>(&cluster.index_count), sizeof(std::uint32_t));
+        fout.write(reinterpret_cast<const char*>(&cluster.lod_bounds), sizeof(sphere3f));
+        fout.write(reinterpret_cast<const char*>(&cluster.lod_error), sizeof(float));
+    }
+}
+
+bool cluster_streamer::read_top_level(
+    const top_level& top,
+    std::vector<vertex>& vertices,
+    std::vector<std::uint32_t>& indexes,
+    std::vector<cluster_builder::cluster>& clusters)
+{
+    std::ifstream fin(top.path, std::ios::binary);
+
+    std::uint32_t counts[3] = {};
+    fin.read(reinterpret_cast<char*>(counts), sizeof(counts));
+
+    auto vertex_offset = static_cast<std::uint32_t>(vertices.size());
+    auto index_offset = static_cast<std::uint32_t>(indexes.size());
+
+    read_array(fin, vertices, counts[0]);
+    read_array(fin, indexes, counts[1]);
+
+    for (std::size_t i = index_offset; i < indexes.size(); ++i)
+    {
+        indexes[i] += vertex_offset;
+    }
+
+    for (std::uint32_t i = 0; i < counts[2]; ++i)
+    {
+        auto& cluster = clusters.emplace_back();
+        fin.read(reinterpret_cast<char*>(&cluster.index_offset), sizeof(std::uint32_t));
+        fin.read(reinterpret_cast<char*>(&cluster.index_count), sizeof(std::uint32_t));
+        fin.read(reinterpret_cast<char*>(&cluster.lod_bounds), sizeof(sphere3f));
+        fin.read(reinterpret_cast<char*>(&cluster.lod_error), sizeof(float));
+
+        cluster.index_offset += index_offset;
+    }
+
+    bool succeeded = !fin.fail();
+    fin.close();
+    std::filesystem::remove(top.path);
+
+    return succeeded;
+}
+
+std::filesystem::path cluster_streamer::create_temp_path(std::string_view name)
+{
+    return m_directory / (std::string(name) + "_" + std::to_string(m_temp_file_count++));
+}
+} // namespace violet
\ No newline at end of file
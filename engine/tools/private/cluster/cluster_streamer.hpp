@@ -0,0 +1,129 @@
+#pragma once
+
+#include "cluster/cluster_builder.hpp"
+#include "tools/geometry_tool.hpp"
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+namespace violet
+{
+/**
+ * @brief Builds the clusters of a mesh that does not fit in memory. Triangles are spilled into
+ * spatial bricks on disk and every brick is clustered and simplified with its borders locked. The
+ * top levels of sibling bricks are then merged and simplified again, up to a single root cluster.
+ */
+class cluster_streamer
+{
+public:
+    using vertex = geometry_tool::cluster_stream_input::vertex;
+
+    cluster_streamer() = default;
+    cluster_streamer(const cluster_streamer&) = delete;
+    ~cluster_streamer();
+
+    void set_executor(task_executor* executor) noexcept
+    {
+        m_executor = executor;
+    }
+
+    /**
+     * @brief Bricks are sized so that building one of them stays under the budget.
+     */
+    void set_memory_budget(std::size_t memory_budget) noexcept;
+
+    void set_temp_directory(const std::filesystem::path& temp_directory)
+    {
+        m_temp_directory = temp_directory;
+    }
+
+    void set_attributes(bool has_normal, bool has_tangent, bool has_texcoord) noexcept
+    {
+        m_has_normal = has_normal;
+        m_has_tangent = has_tangent;
+        m_has_texcoord = has_texcoord;
+    }
+
+    /**
+     * @brief Reads the whole mesh once and writes the built clusters to one file per lod. Groups
+     * reference their clusters by the rank of the first one within its lod.
+     */
+    bool build(const std::function<std::size_t(std::span<vertex>)>& read);
+
+    std::uint32_t get_lod_count() const noexcept
+    {
+        return static_cast<std::uint32_t>(m_lod_cluster_counts.size());
+    }
+
+    std::uint32_t get_lod_cluster_count(std::uint32_t lod) const noexcept
+    {
+        return m_lod_cluster_counts[lod];
+    }
+
+    const std::vector<cluster_builder::cluster_group>& get_groups() const noexcept
+    {
+        return m_groups;
+    }
+
+    /**
+     * @brief Reads back the clusters of a lod in the order of their rank. The vertices belong to
+     * the cluster alone and its indexes point into them.
+     */
+    bool for_each_cluster(
+        std::uint32_t lod,
+        const std::function<
+            void(const cluster&, std::span<const vertex>, std::span<const std::uint32_t>)>&
+            callback) const;
+
+private:
+    struct brick
+    {
+        std::filesystem::path path;
+        std::uint64_t triangle_count;
+
+        // Bounds of the triangle centroids.
+        box3f bounds;
+
+        std::vector<brick> children;
+    };
+
+    // The ungrouped top level of a brick, carried over to the build of its parent.
+    struct top_level
+    {
+        std::filesystem::path path;
+        std::uint32_t lod;
+    };
+
+    bool spill_triangles(const std::function<std::size_t(std::span<vertex>)>& read, brick& root);
+    void split_brick(brick& brick, std::uint32_t depth);
+
+    bool build_brick(brick& brick, bool root, top_level& top);
+    bool write_groups(const cluster_builder& builder);
+    void write_top_level(const cluster_builder& builder, top_level& top);
+    bool read_top_level(
+        const top_level& top,
+        std::vector<vertex>& vertices,
+        std::vector<std::uint32_t>& indexes,
+        std::vector<cluster_builder::cluster>& clusters);
+
+    std::filesystem::path create_temp_path(std::string_view name);
+
+    task_executor* m_executor{nullptr};
+
+    std::uint64_t m_brick_triangle_count{0};
+    std::uint32_t m_stop_cluster_count{0};
+
+    bool m_has_normal{false};
+    bool m_has_tangent{false};
+    bool m_has_texcoord{false};
+
+    std::filesystem::path m_temp_directory;
+    std::filesystem::path m_directory;
+    std::uint32_t m_temp_file_count{0};
+
+    std::vector<std::filesystem::path> m_lod_paths;
+    std::vector<std::ofstream> m_lod_files;
+    std::vector<std::uint32_t> m_lod_cluster_counts;
+    std::vector<cluster_builder::cluster_group> m_groups;
+};
+} // namespace violet
\ No newline at end of file
@@ -35,13 +35,10 @@ public:
             }
 
             std::iota(sorted_to_index.begin(), sorted_to_index.end(), 0);
-            radix_sort_32(
-                sorted_to_index.begin(),
-                sorted_to_index.end(),
-                [&](std::uint32_t index)
-                {
-                    return sort_keys[index];
-                });
+
+            std::vector<std::uint32_t> key_scratch(element_count);
+            std::vector<std::uint32_t> index_scratch(element_count);
+            radix_sort(sort_keys, sorted_to_index, key_scratch, index_scratch);
         }
 
         std::unordered_map<std::uint32_t, std::uint32_t> island_size;
@@ -1,6 +1,7 @@
 #include "cluster/graph_partitioner.hpp"
 #include "metis.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <mutex>
@@ -8,6 +9,94 @@
 
 namespace violet
 {
+namespace
+{
+// Subgraphs with up to this many times max_count vertices are bisected without METIS.
+constexpr std::uint32_t GROW_BISECT_FACTOR = 2;
+
+// Halves of bisections with at least this many vertices are partitioned in parallel.
+constexpr std::uint32_t PARALLEL_VERTEX_COUNT = 1024;
+
+/**
+ * @brief Buffers for the subgraph of a bisection, reused by every bisection on the same thread.
+ */
+struct bisect_scratch
+{
+    std::vector<idx_t> adjacency;
+    std::vector<idx_t> adjacency_cost;
+    std::vector<idx_t> adjacency_offset;
+    std::vector<idx_t> parts;
+
+    std::vector<idx_t> gains;
+    std::vector<std::uint32_t> queue;
+};
+
+bisect_scratch& get_bisect_scratch()
+{
+    thread_local bisect_scratch scratch;
+    return scratch;
+}
+
+/**
+ * @brief Greedy graph growing bisection. Starts from a pseudo-peripheral vertex and keeps adding
+ * the vertex with the heaviest connection to the region until it holds left_count vertices.
+ */
+void grow_bisect(bisect_scratch& scratch, std::uint32_t left_count)
+{
+    auto vertex_count = static_cast<std::uint32_t>(scratch.adjacency_offset.size() - 1);
+
+    auto& adjacency = scratch.adjacency;
+    auto& adjacency_cost = scratch.adjacency_cost;
+    auto& adjacency_offset = scratch.adjacency_offset;
+    auto& parts = scratch.parts;
+    auto& gains = scratch.gains;
+    auto& queue = scratch.queue;
+
+    // The last vertex reached by a breadth-first search is far from the first one.
+    parts.assign(vertex_count, 0);
+    parts[0] = 1;
+    queue.clear();
+    queue.push_back(0);
+    for (std::size_t i = 0; i < queue.size(); ++i)
+    {
+        std::uint32_t vertex = queue[i];
+        for (idx_t j = adjacency_offset[vertex]; j < adjacency_offset[vertex + 1]; ++j)
+        {
+            if (parts[adjacency[j]] == 0)
+            {
+                parts[adjacency[j]] = 1;
+                queue.push_back(static_cast<std::uint32_t>(adjacency[j]));
+            }
+        }
+    }
+
+    parts.assign(vertex_count, 1);
+    gains.assign(vertex_count, 0);
+
+    std::uint32_t vertex = queue.back();
+    for (std::uint32_t count = 1; count < left_count; ++count)
+    {
+        parts[vertex] = 0;
+
+        for (idx_t j = adjacency_offset[vertex]; j < adjacency_offset[vertex + 1]; ++j)
+        {
+            gains[adjacency[j]] += adjacency_cost[j];
+        }
+
+        // Vertices not connected to the region have no gain, the first of them is taken then.
+        vertex = vertex_count;
+        for (std::uint32_t i = 0; i < vertex_count; ++i)
+        {
+            if (parts[i] == 1 && (vertex == vertex_count || gains[i] > gains[vertex]))
+            {
+                vertex = i;
+            }
+        }
+    }
+    parts[vertex] = 0;
+}
+} // namespace
+
 void graph_partitioner::partition(
     std::span<const std::uint32_t> adjacency,
     std::span<const std::uint32_t> adjacency_cost,
@@ -34,6 +123,9 @@ void graph_partitioner::partition(
     m_adjacency_offset = adjacency_offset;
 
     partition_recursive(0, vertex_count, min_count, max_count);
+
+    // Parts are added in completion order, sorting the ranges restores the depth-first order.
+    std::ranges::sort(m_parts);
 }
 
 std::uint32_t graph_partitioner::bisect_graph(
@@ -42,9 +134,16 @@ std::uint32_t graph_partitioner::bisect_graph(
     std::uint32_t min_count,
     std::uint32_t max_count)
 {
-    std::vector<idx_t> adjacency;
-    std::vector<idx_t> adjacency_cost;
-    std::vector<idx_t> adjacency_offset;
+    bisect_scratch& scratch = get_bisect_scratch();
+
+    auto& adjacency = scratch.adjacency;
+    auto& adjacency_cost = scratch.adjacency_cost;
+    auto& adjacency_offset = scratch.adjacency_offset;
+    auto& parts = scratch.parts;
+
+    adjacency.clear();
+    adjacency_cost.clear();
+    adjacency_offset.clear();
 
     for (std::uint32_t i = start; i < end; ++i)
     {
@@ -54,7 +153,10 @@ std::uint32_t graph_partitioner::bisect_graph(
              j < m_adjacency_offset[m_vertices[i] + 1];
              ++j)
         {
-            std::uint32_t adjacency_index = m_vertex_map[m_adjacency[j]];
+            // Vertices of the other half may be moved by a concurrent bisection, but they stay
+            // outside of [start, end).
+            std::uint32_t adjacency_index =
+                std::atomic_ref(m_vertex_map[m_adjacency[j]]).load(std::memory_order_relaxed);
             if (adjacency_index >= start && adjacency_index < end)
             {
                 adjacency.push_back(static_cast<idx_t>(adjacency_index - start));
@@ -64,15 +166,6 @@ std::uint32_t graph_partitioner::bisect_graph(
     }
     adjacency_offset.push_back(static_cast<idx_t>(adjacency.size()));
 
-    idx_t options[METIS_NOPTIONS];
-    METIS_SetDefaultOptions(options);
-    options[METIS_OPTION_UFACTOR] = 200;
-
-    auto vertex_count = static_cast<idx_t>(adjacency_offset.size() - 1);
-    idx_t part_count = 2;
-    idx_t constraints_count = 1;
-    idx_t edges_cut = 0;
-
     auto target_part_count = static_cast<std::uint32_t>(std::ceil(
         static_cast<float>(end - start) / (static_cast<float>(min_count + max_count) / 2.0f)));
     target_part_count = std::max(2u, target_part_count);
@@ -84,13 +177,31 @@ std::uint32_t graph_partitioner::bisect_graph(
         1.0f - (static_cast<float>(left_part_count) / static_cast<float>(target_part_count)),
     };
 
-    std::vector<idx_t> parts(vertex_count);
-
+    if (end - start <= max_count * GROW_BISECT_FACTOR)
     {
+        auto left_count = static_cast<std::uint32_t>(
+            std::lround(weights[0] * static_cast<float>(end - start)));
+        grow_bisect(scratch, std::clamp(left_count, 1u, end - start - 1));
+    }
+    else
+    {
+        idx_t options[METIS_NOPTIONS];
+        METIS_SetDefaultOptions(options);
+        options[METIS_OPTION_UFACTOR] = 200;
+
+        auto vertex_count = static_cast<idx_t>(adjacency_offset.size() - 1);
+        idx_t part_count = 2;
+        idx_t constraints_count = 1;
+        idx_t edges_cut = 0;
+
+        parts.resize(vertex_count);
+
+#ifndef VIOLET_METIS_THREAD_SAFE
         // METIS_PartGraphRecursive may crash when called from multiple threads. The root cause is
         // currently unknown.
         static std::mutex mutex;
         std::scoped_lock lock(mutex);
+#endif
 
         int result = METIS_PartGraphRecursive(
             &vertex_count,
@@ -128,8 +239,10 @@ std::uint32_t graph_partitioner::bisect_graph(
         {
             std::swap(parts[left], parts[right]);
             std::swap(m_vertices[start + left], m_vertices[start + right]);
-            m_vertex_map[m_vertices[start + left]] = start + left;
-            m_vertex_map[m_vertices[start + right]] = start + right;
+            std::atomic_ref(m_vertex_map[m_vertices[start + left]])
+                .store(start + left, std::memory_order_relaxed);
+            std::atomic_ref(m_vertex_map[m_vertices[start + right]])
+                .store(start + right, std::memory_order_relaxed);
         }
     }
 
@@ -144,22 +257,48 @@ void graph_partitioner::partition_recursive(
 {
     std::uint32_t split = bisect_graph(start, end, min_count, max_count);
 
-    if (split - start > max_count)
-    {
-        partition_recursive(start, split, min_count, max_count);
-    }
-    else
+    auto partition_half = [&](std::uint32_t half_start, std::uint32_t half_end)
     {
-        m_parts.emplace_back(start, split);
-    }
+        if (half_end - half_start > max_count)
+        {
+            partition_recursive(half_start, half_end, min_count, max_count);
+        }
+        else
+        {
+            add_part(half_start, half_end);
+        }
+    };
 
-    if (end - split > max_count)
+    if (m_executor != nullptr && end - start >= PARALLEL_VERTEX_COUNT)
     {
-        partition_recursive(split, end, min_count, max_count);
+        m_executor->parallel_for(
+            2,
+            1,
+            [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t i = first; i < last; ++i)
+                {
+                    if (i == 0)
+                    {
+                        partition_half(start, split);
+                    }
+                    else
+                    {
+                        partition_half(split, end);
+                    }
+                }
+            });
     }
     else
     {
-        m_parts.emplace_back(split, end);
+        partition_half(start, split);
+        partition_half(split, end);
     }
 }
+
+void graph_partitioner::add_part(std::uint32_t start, std::uint32_t end)
+{
+    std::lock_guard lock(m_parts_mutex);
+    m_parts.emplace_back(start, end);
+}
 } // namespace violet
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "task/task_executor.hpp"
+#include <cstdint>
+#include <mutex>
 #include <span>
 #include <vector>
 
@@ -8,6 +11,15 @@ namespace violet
 class graph_partitioner
 {
 public:
+    /**
+     * @brief The two halves of large bisections are partitioned in parallel on the executor. Parts
+     * are sorted afterwards, so the result does not depend on the thread count.
+     */
+    void set_executor(task_executor* executor) noexcept
+    {
+        m_executor = executor;
+    }
+
     void partition(
         std::span<const std::uint32_t> adjacency,
         std::span<const std::uint32_t> adjacency_cost,
@@ -38,6 +50,8 @@ private:
         std::uint32_t min_count,
         std::uint32_t max_count);
 
+    void add_part(std::uint32_t start, std::uint32_t end);
+
     std::vector<std::uint32_t> m_vertices;
     std::vector<std::uint32_t> m_vertex_map;
 
@@ -46,5 +60,8 @@ private:
     std::span<const std::uint32_t> m_adjacency_offset;
 
     std::vector<std::pair<std::uint32_t, std::uint32_t>> m_parts;
+    std::mutex m_parts_mutex;
+
+    task_executor* m_executor{nullptr};
 };
 } // namespace violet
\ No newline at end of file
@@ -0,0 +1,739 @@
+#include "tools/cluster_file.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace violet
+{
+namespace
+{
+// Tables and pages are stored as raw structs and viewed in place, so their layout is the format.
+static_assert(std::is_trivially_copyable_v<cluster>);
+static_assert(std::is_trivially_copyable_v<cluster_node>);
+static_assert(std::is_standard_layout_v<cluster_node>);
+static_assert(sizeof(cluster_file::page) == 48);
+
+constexpr std::uint64_t ARRAY_ALIGNMENT = 16;
+
+struct file_header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t page_size;
+    cluster_file::flags flags;
+
+    std::uint32_t vertex_count;
+    std::uint32_t index_count;
+
+    std::uint32_t submesh_count;
+    std::uint32_t level_count;
+    std::uint32_t page_count;
+    std::uint32_t cluster_node_count;
+
+    // Offsets table.
+    std::uint64_t submesh_offset;
+    std::uint64_t level_offset;
+    std::uint64_t page_offset;
+    std::uint64_t cluster_node_offset;
+
+    // The file ends after the last table.
+    std::uint64_t file_size;
+};
+
+std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment) noexcept
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Byte offsets of the arrays of a page. Clusters come first, then one array per attribute.
+struct page_layout
+{
+    std::uint64_t positions;
+    std::uint64_t normals;
+    std::uint64_t tangents;
+    std::uint64_t texcoords;
+    std::uint64_t indexes;
+    std::uint64_t size;
+};
+
+page_layout get_page_layout(
+    cluster_file::flags flags,
+    std::uint64_t cluster_count,
+    std::uint64_t vertex_count,
+    std::uint64_t index_count) noexcept
+{
+    page_layout layout = {};
+
+    std::uint64_t offset = align_up(cluster_count * sizeof(cluster), ARRAY_ALIGNMENT);
+
+    layout.positions = offset;
+    offset = align_up(offset + (vertex_count * sizeof(vec3f)), ARRAY_ALIGNMENT);
+
+    layout.normals = offset;
+    if (flags & cluster_file::FLAG_NORMAL)
+    {
+        offset = align_up(offset + (vertex_count * sizeof(vec3f)), ARRAY_ALIGNMENT);
+    }
+
+    layout.tangents = offset;
+    if (flags & cluster_file::FLAG_TANGENT)
+    {
+        offset = align_up(offset + (vertex_count * sizeof(vec4f)), ARRAY_ALIGNMENT);
+    }
+
+    layout.texcoords = offset;
+    if (flags & cluster_file::FLAG_TEXCOORD)
+    {
+        offset = align_up(offset + (vertex_count * sizeof(vec2f)), ARRAY_ALIGNMENT);
+    }
+
+    layout.indexes = offset;
+    layout.size = offset + (index_count * sizeof(std::uint32_t));
+
+    return layout;
+}
+
+template <typename T>
+bool is_table_valid(std::uint64_t offset, std::uint64_t count, std::uint64_t file_size) noexcept
+{
+    return offset % alignof(T) == 0 && offset <= file_size &&
+           count <= (file_size - offset) / sizeof(T);
+}
+
+template <typename T>
+std::span<const T> get_table(
+    std::span<const std::byte> data,
+    std::uint64_t offset,
+    std::size_t count) noexcept
+{
+    return {reinterpret_cast<const T*>(data.data() + offset), count};
+}
+
+template <typename T>
+void write_table(std::ofstream& fout, std::uint64_t& offset, const std::vector<T>& table)
+{
+    static constexpr char padding[ARRAY_ALIGNMENT] = {};
+
+    std::uint64_t aligned_offset = align_up(offset, ARRAY_ALIGNMENT);
+    fout.write(padding, static_cast<std::streamsize>(aligned_offset - offset));
+
+    fout.write(
+        reinterpret_cast<const char*>(table.data()),
+        static_cast<std::streamsize>(table.size() * sizeof(T)));
+
+    offset = aligned_offset + (table.size() * sizeof(T));
+}
+} // namespace
+
+cluster_file::~cluster_file()
+{
+    close();
+}
+
+bool cluster_file::open(std::string_view path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(
+        std::string(path).c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (file_mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file_mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = reinterpret_cast<std::intptr_t>(file);
+    m_file_mapping = reinterpret_cast<std::intptr_t>(file_mapping);
+    m_mapping = mapping;
+    m_mapping_size = static_cast<std::size_t>(size.QuadPart);
+#else
+    int file = ::open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat info = {};
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    auto mapping_size = static_cast<std::size_t>(info.st_size);
+
+    // The mapping keeps the file referenced, so the descriptor is not needed afterwards.
+    void* mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mapping_size = mapping_size;
+#endif
+
+    if (!read({static_cast<const std::byte*>(m_mapping), m_mapping_size}))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool cluster_file::open(std::span<const std::byte> data)
+{
+    close();
+
+    return read(data);
+}
+
+bool cluster_file::open(std::ifstream& fin)
+{
+    close();
+
+    std::streampos begin = fin.tellg();
+    fin.seekg(0, std::ios::end);
+    std::streampos end = fin.tellg();
+    fin.seekg(begin);
+
+    file_header header = {};
+    fin.read(reinterpret_cast<char*>(&header), sizeof(file_header));
+
+    // The size is checked against the stream before anything is allocated for it.
+    if (fin.fail() || header.magic != MAGIC || header.version != VERSION ||
+        header.file_size < sizeof(file_header) ||
+        header.file_size > static_cast<std::uint64_t>(end - begin))
+    {
+        return false;
+    }
+
+    m_buffer.resize(header.file_size);
+    std::memcpy(m_buffer.data(), &header, sizeof(file_header));
+    fin.read(
+        reinterpret_cast<char*>(m_buffer.data() + sizeof(file_header)),
+        static_cast<std::streamsize>(header.file_size - sizeof(file_header)));
+
+    if (fin.fail() || !read(m_buffer))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool cluster_file::read(std::span<const std::byte> data)
+{
+    if (data.size() < sizeof(file_header))
+    {
+        return false;
+    }
+
+    file_header header = {};
+    std::memcpy(&header, data.data(), sizeof(file_header));
+
+    if (header.magic != MAGIC || header.version != VERSION || header.page_size != PAGE_SIZE ||
+        header.file_size < sizeof(file_header) || header.file_size > data.size())
+    {
+        return false;
+    }
+
+    data = data.first(header.file_size);
+
+    if (!is_table_valid<submesh>(header.submesh_offset, header.submesh_count, data.size()) ||
+        !is_table_valid<level>(header.level_offset, header.level_count, data.size()) ||
+        !is_table_valid<page>(header.page_offset, header.page_count, data.size()) ||
+        !is_table_valid<cluster_node>(
+            header.cluster_node_offset,
+            header.cluster_node_count,
+            data.size()))
+    {
+        return false;
+    }
+
+    auto submeshes = get_table<submesh>(data, header.submesh_offset, header.submesh_count);
+    auto levels = get_table<level>(data, header.level_offset, header.level_count);
+    auto pages = get_table<page>(data, header.page_offset, header.page_count);
+    auto cluster_nodes =
+        get_table<cluster_node>(data, header.cluster_node_offset, header.cluster_node_count);
+
+    // Tables are trusted once checked, views of pages are not bounds checked again.
+    for (const auto& page : pages)
+    {
+        page_layout layout =
+            get_page_layout(header.flags, page.cluster_count, page.vertex_count, page.index_count);
+
+        if (page.offset % PAGE_SIZE != 0 || page.size < layout.size ||
+            page.offset > data.size() || page.size > data.size() - page.offset)
+        {
+            return false;
+        }
+    }
+
+    for (const auto& level : levels)
+    {
+        if (level.page_offset > pages.size() || level.page_count > pages.size() - level.page_offset)
+        {
+            return false;
+        }
+    }
+
+    for (const auto& submesh : submeshes)
+    {
+        if (submesh.level_offset > levels.size() ||
+            submesh.level_count > levels.size() - submesh.level_offset ||
+            submesh.cluster_node_offset > cluster_nodes.size() ||
+            submesh.cluster_node_count > cluster_nodes.size() - submesh.cluster_node_offset)
+        {
+            return false;
+        }
+    }
+
+    m_data = data;
+    m_flags = header.flags;
+    m_vertex_count = header.vertex_count;
+    m_index_count = header.index_count;
+
+    m_submeshes = submeshes;
+    m_levels = levels;
+    m_pages = pages;
+    m_cluster_nodes = cluster_nodes;
+
+    return true;
+}
+
+void cluster_file::close()
+{
+    if (m_mapping != nullptr)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_mapping);
+        CloseHandle(reinterpret_cast<HANDLE>(m_file_mapping));
+        CloseHandle(reinterpret_cast<HANDLE>(m_file));
+
+        m_file = -1;
+        m_file_mapping = 0;
+#else
+        munmap(m_mapping, m_mapping_size);
+#endif
+        m_mapping = nullptr;
+        m_mapping_size = 0;
+    }
+
+    m_data = {};
+    m_buffer = {};
+    m_flags = 0;
+    m_vertex_count = 0;
+    m_index_count = 0;
+
+    m_submeshes = {};
+    m_levels = {};
+    m_pages = {};
+    m_cluster_nodes = {};
+}
+
+cluster_file::page_data cluster_file::get_page_data(const page& page) const noexcept
+{
+    page_layout layout =
+        get_page_layout(m_flags, page.cluster_count, page.vertex_count, page.index_count);
+
+    page_data data = {
+        .clusters = get_array<cluster>(page.offset, page.cluster_count),
+        .positions = get_array<vec3f>(page.offset + layout.positions, page.vertex_count),
+        .indexes = get_array<std::uint32_t>(page.offset + layout.indexes, page.index_count),
+    };
+
+    if (m_flags & FLAG_NORMAL)
+    {
+        data.normals = get_array<vec3f>(page.offset + layout.normals, page.vertex_count);
+    }
+
+    if (m_flags & FLAG_TANGENT)
+    {
+        data.tangents = get_array<vec4f>(page.offset + layout.tangents, page.vertex_count);
+    }
+
+    if (m_flags & FLAG_TEXCOORD)
+    {
+        data.texcoords = get_array<vec2f>(page.offset + layout.texcoords, page.vertex_count);
+    }
+
+    return data;
+}
+
+std::span<const cluster> cluster_file::get_clusters(const page& page) const noexcept
+{
+    return get_array<cluster>(page.offset, page.cluster_count);
+}
+
+std::span<const vec3f> cluster_file::get_positions(const page& page) const noexcept
+{
+    page_layout layout =
+        get_page_layout(m_flags, page.cluster_count, page.vertex_count, page.index_count);
+    return get_array<vec3f>(page.offset + layout.positions, page.vertex_count);
+}
+
+std::span<const vec3f> cluster_file::get_normals(const page& page) const noexcept
+{
+    if ((m_flags & FLAG_NORMAL) == 0)
+    {
+        return {};
+    }
+
+    page_layout layout =
+        get_page_layout(m_flags, page.cluster_count, page.vertex_count, page.index_count);
+    return get_array<vec3f>(page.offset + layout.normals, page.vertex_count);
+}
+
+std::span<const vec4f> cluster_file::get_tangents(const page& page) const noexcept
+{
+    if ((m_flags & FLAG_TANGENT) == 0)
+    {
+        return {};
+    }
+
+    page_layout layout =
+        get_page_layout(m_flags, page.cluster_count, page.vertex_count, page.index_count);
+    return get_array<vec4f>(page.offset + layout.tangents, page.vertex_count);
+}
+
+std::span<const vec2f> cluster_file::get_texcoords(const page& page) const noexcept
+{
+    if ((m_flags & FLAG_TEXCOORD) == 0)
+    {
+        return {};
+    }
+
+    page_layout layout =
+        get_page_layout(m_flags, page.cluster_count, page.vertex_count, page.index_count);
+    return get_array<vec2f>(page.offset + layout.texcoords, page.vertex_count);
+}
+
+std::span<const std::uint32_t> cluster_file::get_indexes(const page& page) const noexcept
+{
+    page_layout layout =
+        get_page_layout(m_flags, page.cluster_count, page.vertex_count, page.index_count);
+    return get_array<std::uint32_t>(page.offset + layout.indexes, page.index_count);
+}
+
+void cluster_file::prefetch(const page& page) const noexcept
+{
+    if (m_mapping == nullptr)
+    {
+        return;
+    }
+
+    void* address = static_cast<std::byte*>(m_mapping) + page.offset;
+
+#ifdef _WIN32
+    WIN32_MEMORY_RANGE_ENTRY range = {
+        .VirtualAddress = address,
+        .NumberOfBytes = page.size,
+    };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    madvise(address, page.size, MADV_WILLNEED);
+#endif
+}
+
+void cluster_file::evict(const page& page) const noexcept
+{
+    if (m_mapping == nullptr)
+    {
+        return;
+    }
+
+    void* address = static_cast<std::byte*>(m_mapping) + page.offset;
+
+#ifdef _WIN32
+    // Unlocking memory that is not locked removes it from the working set.
+    VirtualUnlock(address, page.size);
+#else
+    madvise(address, page.size, MADV_DONTNEED);
+#endif
+}
+
+bool cluster_file_writer::open(std::ofstream& fout, cluster_file::flags flags)
+{
+    m_fout = &fout;
+    m_flags = flags;
+
+    m_page = {};
+    m_offset = 0;
+    m_vertex_count = 0;
+    m_index_count = 0;
+    m_cluster_count = 0;
+    m_submesh_level_offset = 0;
+
+    m_submeshes.clear();
+    m_levels.clear();
+    m_pages.clear();
+    m_cluster_nodes.clear();
+
+    // The header is written on close, pages start at the first page boundary.
+    std::vector<char> header_page(cluster_file::PAGE_SIZE);
+    fout.write(header_page.data(), static_cast<std::streamsize>(header_page.size()));
+    m_offset = header_page.size();
+
+    return !fout.fail();
+}
+
+void cluster_file_writer::add_cluster(
+    const cluster& cluster,
+    std::span<const vec3f> positions,
+    std::span<const vec3f> normals,
+    std::span<const vec4f> tangents,
+    std::span<const vec2f> texcoords,
+    std::span<const std::uint32_t> indexes)
+{
+    bool new_level =
+        m_levels.size() == m_submesh_level_offset || m_levels.back().lod != cluster.lod;
+    assert(new_level == false || m_levels.size() == m_submesh_level_offset ||
+           m_levels.back().lod > cluster.lod);
+
+    if (!m_page_clusters.empty())
+    {
+        page_layout layout = get_page_layout(
+            m_flags,
+            m_page_clusters.size() + 1,
+            m_page_positions.size() + positions.size(),
+            m_page_indexes.size() + indexes.size());
+
+        // A page holds the clusters of one lod, so a lod can be loaded without its neighbours.
+        if (new_level || layout.size > cluster_file::PAGE_SIZE)
+        {
+            flush_page();
+        }
+    }
+
+    if (new_level)
+    {
+        m_levels.push_back({
+            .lod = cluster.lod,
+            .page_offset = static_cast<std::uint32_t>(m_pages.size()),
+            .page_count = 0,
+            .cluster_offset = m_cluster_count,
+            .cluster_count = 0,
+        });
+    }
+
+    if (m_page_clusters.empty())
+    {
+        m_page = {
+            .submesh_index = static_cast<std::uint32_t>(m_submeshes.size()),
+            .lod = cluster.lod,
+            .cluster_offset = m_cluster_count,
+            .vertex_offset = static_cast<std::uint32_t>(m_vertex_count),
+            .index_offset = static_cast<std::uint32_t>(m_index_count),
+        };
+    }
+
+    auto& page_cluster = m_page_clusters.emplace_back(cluster);
+    page_cluster.index_offset = static_cast<std::uint32_t>(m_index_count);
+    page_cluster.index_count = static_cast<std::uint32_t>(indexes.size());
+
+    m_page_positions.insert(m_page_positions.end(), positions.begin(), positions.end());
+
+    if (m_flags & cluster_file::FLAG_NORMAL)
+    {
+        assert(normals.size() == positions.size());
+        m_page_normals.insert(m_page_normals.end(), normals.begin(), normals.end());
+    }
+
+    if (m_flags & cluster_file::FLAG_TANGENT)
+    {
+        assert(tangents.size() == positions.size());
+        m_page_tangents.insert(m_page_tangents.end(), tangents.begin(), tangents.end());
+    }
+
+    if (m_flags & cluster_file::FLAG_TEXCOORD)
+    {
+        assert(texcoords.size() == positions.size());
+        m_page_texcoords.insert(m_page_texcoords.end(), texcoords.begin(), texcoords.end());
+    }
+
+    for (std::uint32_t index : indexes)
+    {
+        m_page_indexes.push_back(static_cast<std::uint32_t>(m_vertex_count + index));
+    }
+
+    m_vertex_count += positions.size();
+    m_index_count += indexes.size();
+
+    ++m_cluster_count;
+    ++m_levels.back().cluster_count;
+}
+
+void cluster_file_writer::add_submesh(std::span<const cluster_node> cluster_nodes)
+{
+    flush_page();
+
+    m_submeshes.push_back({
+        .level_offset = m_submesh_level_offset,
+        .level_count = static_cast<std::uint32_t>(m_levels.size()) - m_submesh_level_offset,
+        .cluster_count = m_cluster_count,
+        .cluster_node_offset = static_cast<std::uint32_t>(m_cluster_nodes.size()),
+        .cluster_node_count = static_cast<std::uint32_t>(cluster_nodes.size()),
+    });
+
+    // Zero the padding after is_leaf, so the same clusters always give the same file.
+    constexpr std::size_t padding_offset = offsetof(cluster_node, is_leaf) + sizeof(bool);
+    constexpr std::size_t padding_size = offsetof(cluster_node, depth) - padding_offset;
+
+    for (const auto& cluster_node : cluster_nodes)
+    {
+        auto& node = m_cluster_nodes.emplace_back();
+        node.bounding_sphere = cluster_node.bounding_sphere;
+        node.lod_bounds = cluster_node.lod_bounds;
+        node.min_lod_error = cluster_node.min_lod_error;
+        node.max_parent_lod_error = cluster_node.max_parent_lod_error;
+        node.is_leaf = cluster_node.is_leaf;
+        node.depth = cluster_node.depth;
+        node.child_offset = cluster_node.child_offset;
+        node.child_count = cluster_node.child_count;
+
+        std::memset(reinterpret_cast<std::byte*>(&node) + padding_offset, 0, padding_size);
+    }
+
+    m_cluster_count = 0;
+    m_submesh_level_offset = static_cast<std::uint32_t>(m_levels.size());
+}
+
+bool cluster_file_writer::close()
+{
+    assert(m_page_clusters.empty());
+
+    std::ofstream& fout = *m_fout;
+
+    file_header header = {
+        .magic = cluster_file::MAGIC,
+        .version = cluster_file::VERSION,
+        .page_size = cluster_file::PAGE_SIZE,
+        .flags = m_flags,
+        .vertex_count = static_cast<std::uint32_t>(m_vertex_count),
+        .index_count = static_cast<std::uint32_t>(m_index_count),
+        .submesh_count = static_cast<std::uint32_t>(m_submeshes.size()),
+        .level_count = static_cast<std::uint32_t>(m_levels.size()),
+        .page_count = static_cast<std::uint32_t>(m_pages.size()),
+        .cluster_node_count = static_cast<std::uint32_t>(m_cluster_nodes.size()),
+    };
+
+    header.submesh_offset = align_up(m_offset, ARRAY_ALIGNMENT);
+    write_table(fout, m_offset, m_submeshes);
+    header.level_offset = align_up(m_offset, ARRAY_ALIGNMENT);
+    write_table(fout, m_offset, m_levels);
+    header.page_offset = align_up(m_offset, ARRAY_ALIGNMENT);
+    write_table(fout, m_offset, m_pages);
+    header.cluster_node_offset = align_up(m_offset, ARRAY_ALIGNMENT);
+    write_table(fout, m_offset, m_cluster_nodes);
+    header.file_size = m_offset;
+
+    fout.seekp(0);
+    fout.write(reinterpret_cast<const char*>(&header), sizeof(file_header));
+    fout.seekp(0, std::ios::end);
+
+    m_fout = nullptr;
+
+    // Vertex indexes and cluster index offsets are 32 bits wide.
+    return !fout.fail() && m_vertex_count <= std::numeric_limits<std::uint32_t>::max() &&
+           m_index_count <= std::numeric_limits<std::uint32_t>::max();
+}
+
+void cluster_file_writer::flush_page()
+{
+    if (m_page_clusters.empty())
+    {
+        return;
+    }
+
+    m_page.cluster_count = static_cast<std::uint32_t>(m_page_clusters.size());
+    m_page.vertex_count = static_cast<std::uint32_t>(m_page_positions.size());
+    m_page.index_count = static_cast<std::uint32_t>(m_page_indexes.size());
+
+    page_layout layout = get_page_layout(
+        m_flags,
+        m_page.cluster_count,
+        m_page.vertex_count,
+        m_page.index_count);
+
+    m_page.offset = m_offset;
+    m_page.size = static_cast<std::uint32_t>(layout.size);
+
+    // A single cluster larger than a page spans several, the next page still starts on a boundary.
+    std::vector<std::byte> data(align_up(layout.size, cluster_file::PAGE_SIZE));
+
+    auto copy_array = [&](std::uint64_t offset, const auto& array)
+    {
+        std::memcpy(data.data() + offset, array.data(), array.size() * sizeof(array[0]));
+    };
+
+    copy_array(0, m_page_clusters);
+    copy_array(layout.positions, m_page_positions);
+    copy_array(layout.normals, m_page_normals);
+    copy_array(layout.tangents, m_page_tangents);
+    copy_array(layout.texcoords, m_page_texcoords);
+    copy_array(layout.indexes, m_page_indexes);
+
+    m_fout->write(
+        reinterpret_cast<const char*>(data.data()),
+        static_cast<std::streamsize>(data.size()));
+    m_offset += data.size();
+
+    m_pages.push_back(m_page);
+    ++m_levels.back().page_count;
+
+    m_page_clusters.clear();
+    m_page_positions.clear();
+    m_page_normals.clear();
+    m_page_tangents.clear();
+    m_page_texcoords.clear();
+    m_page_indexes.clear();
+}
+} // namespace violet
\ No newline at end of file
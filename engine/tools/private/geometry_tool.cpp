@@ -1,9 +1,14 @@
 #include "tools/geometry_tool.hpp"
 #include "algorithm/hash.hpp"
 #include "cluster/cluster_builder.hpp"
+#include "cluster/cluster_streamer.hpp"
 #include "math/vector.hpp"
 #include "mesh_simplifier/mesh_simplifier.hpp"
 #include "mikktspace.h"
+#include "tools/cluster_file.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
 #include <queue>
 #include <unordered_map>
 
@@ -11,24 +16,114 @@ namespace violet
 {
 namespace
 {
-enum cluster_flag : std::uint8_t
+constexpr std::uint32_t INVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+// Flattens the cluster nodes breadth first, so the children of a node are contiguous. Leaves point
+// at the clusters of their group.
+std::vector<cluster_node> flatten_cluster_nodes(const cluster_builder& builder)
 {
-    CLUSTER_HAS_NORMAL = 1 << 0,
-    CLUSTER_HAS_TANGENT = 1 << 1,
-    CLUSTER_HAS_TEXCOORD = 1 << 2,
-};
-using cluster_flags = std::uint32_t;
+    const auto& groups = builder.get_groups();
+    const auto& cluster_nodes = builder.get_cluster_nodes();
+
+    std::vector<cluster_node> result;
+    std::uint32_t bvh_node_count = 0;
+
+    std::queue<std::uint32_t> queue;
+    queue.push(static_cast<std::uint32_t>(cluster_nodes.size() - 1));
+    while (!queue.empty())
+    {
+        const auto& cluster_node = cluster_nodes[queue.front()];
+        queue.pop();
+
+        result.push_back({
+            .bounding_sphere = cluster_node.bounding_sphere,
+            .lod_bounds = cluster_node.lod_bounds,
+            .min_lod_error = cluster_node.min_lod_error,
+            .max_parent_lod_error = cluster_node.max_parent_lod_error,
+            .is_leaf = cluster_node.is_leaf,
+            .depth = cluster_node.depth,
+        });
+
+        ++bvh_node_count;
+
+        if (cluster_node.is_leaf)
+        {
+            const auto& group = groups[cluster_node.children[0]];
+            result.back().child_offset = group.cluster_offset;
+            result.back().child_count = group.cluster_count;
+        }
+        else
+        {
+            result.back().child_offset = static_cast<std::uint32_t>(queue.size() + bvh_node_count);
+            result.back().child_count = static_cast<std::uint32_t>(cluster_node.children.size());
+
+            for (std::uint32_t child : cluster_node.children)
+            {
+                queue.push(child);
+            }
+        }
+    }
+
+    return result;
+}
+
+// Copies the pages back into flat arrays. Pages are stored in the order of their vertices and
+// indexes, so appending them restores the numbering of the file.
+bool read_cluster_file(const cluster_file& file, geometry_tool::cluster_output& output)
+{
+    output = {};
+    output.submeshes.resize(file.get_submeshes().size());
+
+    output.positions.reserve(file.get_vertex_count());
+    output.indexes.reserve(file.get_index_count());
+
+    for (const auto& page : file.get_pages())
+    {
+        if (page.submesh_index >= output.submeshes.size())
+        {
+            return false;
+        }
+
+        auto& clusters = output.submeshes[page.submesh_index].clusters;
+        if (page.vertex_offset != output.positions.size() ||
+            page.index_offset != output.indexes.size() || page.cluster_offset != clusters.size())
+        {
+            return false;
+        }
+
+        auto append = [](auto& array, const auto& page_array)
+        {
+            array.insert(array.end(), page_array.begin(), page_array.end());
+        };
+
+        cluster_file::page_data data = file.get_page_data(page);
+        append(output.positions, data.positions);
+        append(output.normals, data.normals);
+        append(output.tangents, data.tangents);
+        append(output.texcoords, data.texcoords);
+        append(output.indexes, data.indexes);
+        append(clusters, data.clusters);
+    }
+
+    for (std::size_t i = 0; i < output.submeshes.size(); ++i)
+    {
+        auto cluster_nodes = file.get_cluster_nodes(file.get_submeshes()[i]);
+        output.submeshes[i].cluster_nodes.assign(cluster_nodes.begin(), cluster_nodes.end());
+    }
+
+    return true;
+}
 } // namespace
 
 bool geometry_tool::cluster_output::load(std::string_view path)
 {
-    std::ifstream fin(std::string(path), std::ios::binary);
-    if (!fin.is_open())
+    cluster_file file;
+    if (!file.open(path))
     {
         return false;
     }
 
-    return load(fin);
+    return read_cluster_file(file, *this);
 }
 
 bool geometry_tool::cluster_output::save(std::string_view path) const
@@ -44,177 +139,123 @@ bool geometry_tool::cluster_output::save(std::string_view path) const
 
 bool geometry_tool::cluster_output::load(std::ifstream& fin)
 {
-    std::uint32_t vertex_count = 0;
-    std::uint32_t index_count = 0;
-    std::uint32_t submesh_count = 0;
-
-    fin.read(reinterpret_cast<char*>(&vertex_count), sizeof(std::uint32_t));
-    fin.read(reinterpret_cast<char*>(&index_count), sizeof(std::uint32_t));
-    fin.read(reinterpret_cast<char*>(&submesh_count), sizeof(std::uint32_t));
-
-    cluster_flags flags = 0;
-    fin.read(reinterpret_cast<char*>(&flags), sizeof(cluster_flags));
-
-    positions.resize(vertex_count);
-    indexes.resize(index_count);
-    submeshes.resize(submesh_count);
-
-    fin.read(
-        reinterpret_cast<char*>(positions.data()),
-        static_cast<std::streamsize>(vertex_count * sizeof(vec3f)));
-    fin.read(
-        reinterpret_cast<char*>(indexes.data()),
-        static_cast<std::streamsize>(index_count * sizeof(std::uint32_t)));
-
-    if (flags & CLUSTER_HAS_NORMAL)
-    {
-        normals.resize(vertex_count);
-        fin.read(
-            reinterpret_cast<char*>(normals.data()),
-            static_cast<std::streamsize>(vertex_count * sizeof(vec3f)));
-    }
-
-    if (flags & CLUSTER_HAS_TANGENT)
+    cluster_file file;
+    if (!file.open(fin))
     {
-        tangents.resize(vertex_count);
-        fin.read(
-            reinterpret_cast<char*>(tangents.data()),
-            static_cast<std::streamsize>(vertex_count * sizeof(vec4f)));
+        return false;
     }
 
-    if (flags & CLUSTER_HAS_TEXCOORD)
+    return read_cluster_file(file, *this);
+}
+
+bool geometry_tool::cluster_output::save(std::ofstream& fout) const
+{
+    cluster_file::flags flags = 0;
+    flags |= normals.empty() ? 0 : cluster_file::FLAG_NORMAL;
+    flags |= tangents.empty() ? 0 : cluster_file::FLAG_TANGENT;
+    flags |= texcoords.empty() ? 0 : cluster_file::FLAG_TEXCOORD;
+
+    cluster_file_writer writer;
+    if (!writer.open(fout, flags))
     {
-        texcoords.resize(vertex_count);
-        fin.read(
-            reinterpret_cast<char*>(texcoords.data()),
-            static_cast<std::streamsize>(vertex_count * sizeof(vec2f)));
+        return false;
     }
 
-    for (std::uint32_t i = 0; i < submesh_count; ++i)
-    {
-        std::uint32_t cluster_count = 0;
-        std::uint32_t cluster_node_count = 0;
+    std::vector<std::uint32_t> vertex_remap(positions.size(), INVALID_INDEX);
 
-        fin.read(reinterpret_cast<char*>(&cluster_count), sizeof(std::uint32_t));
-        fin.read(reinterpret_cast<char*>(&cluster_node_count), sizeof(std::uint32_t));
+    std::vector<vec3f> cluster_positions;
+    std::vector<vec3f> cluster_normals;
+    std::vector<vec4f> cluster_tangents;
+    std::vector<vec2f> cluster_texcoords;
+    std::vector<std::uint32_t> cluster_vertices;
+    std::vector<std::uint32_t> cluster_indexes;
 
-        submeshes[i].clusters.resize(cluster_count);
-        submeshes[i].cluster_nodes.resize(cluster_node_count);
+    for (const auto& submesh : submeshes)
+    {
+        const auto& clusters = submesh.clusters;
+
+        // The file stores the coarsest lod first, leaves are renumbered to follow their clusters.
+        std::vector<std::uint32_t> order(clusters.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::ranges::stable_sort(
+            order,
+            [&](std::uint32_t a, std::uint32_t b)
+            {
+                return clusters[a].lod > clusters[b].lod;
+            });
 
-        for (auto& cluster : submeshes[i].clusters)
+        std::vector<std::uint32_t> new_index(clusters.size());
+        for (std::uint32_t i = 0; i < order.size(); ++i)
         {
-            fin.read(reinterpret_cast<char*>(&cluster.index_offset), sizeof(std::uint32_t));
-            fin.read(reinterpret_cast<char*>(&cluster.index_count), sizeof(std::uint32_t));
-            fin.read(reinterpret_cast<char*>(&cluster.bounding_sphere), sizeof(sphere3f));
-            fin.read(reinterpret_cast<char*>(&cluster.lod_bounds), sizeof(sphere3f));
-            fin.read(reinterpret_cast<char*>(&cluster.lod_error), sizeof(float));
-            fin.read(reinterpret_cast<char*>(&cluster.parent_lod_bounds), sizeof(sphere3f));
-            fin.read(reinterpret_cast<char*>(&cluster.parent_lod_error), sizeof(float));
-            fin.read(reinterpret_cast<char*>(&cluster.lod), sizeof(std::uint32_t));
+            new_index[order[i]] = i;
         }
 
-        for (auto& cluster_node : submeshes[i].cluster_nodes)
+        for (std::uint32_t cluster_index : order)
         {
-            fin.read(reinterpret_cast<char*>(&cluster_node.bounding_sphere), sizeof(sphere3f));
-            fin.read(reinterpret_cast<char*>(&cluster_node.lod_bounds), sizeof(sphere3f));
-            fin.read(reinterpret_cast<char*>(&cluster_node.min_lod_error), sizeof(float));
-            fin.read(reinterpret_cast<char*>(&cluster_node.max_parent_lod_error), sizeof(float));
-            fin.read(reinterpret_cast<char*>(&cluster_node.is_leaf), sizeof(bool));
-            fin.read(reinterpret_cast<char*>(&cluster_node.depth), sizeof(std::uint32_t));
-            fin.read(reinterpret_cast<char*>(&cluster_node.child_offset), sizeof(std::uint32_t));
-            fin.read(reinterpret_cast<char*>(&cluster_node.child_count), sizeof(std::uint32_t));
-        }
-    }
+            const auto& cluster = clusters[cluster_index];
 
-    return true;
-}
+            cluster_vertices.clear();
+            cluster_indexes.clear();
 
-bool geometry_tool::cluster_output::save(std::ofstream& fout) const
-{
-    auto vertex_count = static_cast<std::uint32_t>(positions.size());
-    auto index_count = static_cast<std::uint32_t>(indexes.size());
-    auto submesh_count = static_cast<std::uint32_t>(submeshes.size());
-
-    fout.write(reinterpret_cast<const char*>(&vertex_count), sizeof(std::uint32_t));
-    fout.write(reinterpret_cast<const char*>(&index_count), sizeof(std::uint32_t));
-    fout.write(reinterpret_cast<const char*>(&submesh_count), sizeof(std::uint32_t));
-
-    cluster_flags flags = 0;
-    flags |= normals.empty() ? 0 : CLUSTER_HAS_NORMAL;
-    flags |= tangents.empty() ? 0 : CLUSTER_HAS_TANGENT;
-    flags |= texcoords.empty() ? 0 : CLUSTER_HAS_TEXCOORD;
-    fout.write(reinterpret_cast<const char*>(&flags), sizeof(cluster_flags));
-
-    fout.write(
-        reinterpret_cast<const char*>(positions.data()),
-        static_cast<std::streamsize>(vertex_count * sizeof(vec3f)));
-    fout.write(
-        reinterpret_cast<const char*>(indexes.data()),
-        static_cast<std::streamsize>(index_count * sizeof(std::uint32_t)));
-
-    if (!normals.empty())
-    {
-        fout.write(
-            reinterpret_cast<const char*>(normals.data()),
-            static_cast<std::streamsize>(vertex_count * sizeof(vec3f)));
-    }
+            for (std::uint32_t i = 0; i < cluster.index_count; ++i)
+            {
+                std::uint32_t index = indexes[cluster.index_offset + i];
+                if (vertex_remap[index] == INVALID_INDEX)
+                {
+                    vertex_remap[index] = static_cast<std::uint32_t>(cluster_vertices.size());
+                    cluster_vertices.push_back(index);
+                }
 
-    if (!tangents.empty())
-    {
-        fout.write(
-            reinterpret_cast<const char*>(tangents.data()),
-            static_cast<std::streamsize>(vertex_count * sizeof(vec4f)));
-    }
+                cluster_indexes.push_back(vertex_remap[index]);
+            }
 
-    if (!texcoords.empty())
-    {
-        fout.write(
-            reinterpret_cast<const char*>(texcoords.data()),
-            static_cast<std::streamsize>(vertex_count * sizeof(vec2f)));
-    }
+            auto gather = [&](auto& cluster_attributes, const auto& attributes)
+            {
+                cluster_attributes.clear();
+                if (attributes.empty())
+                {
+                    return;
+                }
 
-    for (const auto& submesh : submeshes)
-    {
-        auto cluster_count = static_cast<std::uint32_t>(submesh.clusters.size());
-        auto cluster_node_count = static_cast<std::uint32_t>(submesh.cluster_nodes.size());
+                for (std::uint32_t index : cluster_vertices)
+                {
+                    cluster_attributes.push_back(attributes[index]);
+                }
+            };
 
-        fout.write(reinterpret_cast<const char*>(&cluster_count), sizeof(std::uint32_t));
-        fout.write(reinterpret_cast<const char*>(&cluster_node_count), sizeof(std::uint32_t));
+            gather(cluster_positions, positions);
+            gather(cluster_normals, normals);
+            gather(cluster_tangents, tangents);
+            gather(cluster_texcoords, texcoords);
 
-        for (const auto& cluster : submesh.clusters)
-        {
-            fout.write(reinterpret_cast<const char*>(&cluster.index_offset), sizeof(std::uint32_t));
-            fout.write(reinterpret_cast<const char*>(&cluster.index_count), sizeof(std::uint32_t));
-            fout.write(reinterpret_cast<const char*>(&cluster.bounding_sphere), sizeof(sphere3f));
-            fout.write(reinterpret_cast<const char*>(&cluster.lod_bounds), sizeof(sphere3f));
-            fout.write(reinterpret_cast<const char*>(&cluster.lod_error), sizeof(float));
-            fout.write(reinterpret_cast<const char*>(&cluster.parent_lod_bounds), sizeof(sphere3f));
-            fout.write(reinterpret_cast<const char*>(&cluster.parent_lod_error), sizeof(float));
-            fout.write(reinterpret_cast<const char*>(&cluster.lod), sizeof(std::uint32_t));
+            for (std::uint32_t index : cluster_vertices)
+            {
+                vertex_remap[index] = INVALID_INDEX;
+            }
+
+            writer.add_cluster(
+                cluster,
+                cluster_positions,
+                cluster_normals,
+                cluster_tangents,
+                cluster_texcoords,
+                cluster_indexes);
         }
 
-        for (const auto& cluster_node : submesh.cluster_nodes)
+        // Clusters of a group stay contiguous, their lod is the same.
+        std::vector<cluster_node> cluster_nodes = submesh.cluster_nodes;
+        for (auto& cluster_node : cluster_nodes)
         {
-            fout.write(
-                reinterpret_cast<const char*>(&cluster_node.bounding_sphere),
-                sizeof(sphere3f));
-            fout.write(reinterpret_cast<const char*>(&cluster_node.lod_bounds), sizeof(sphere3f));
-            fout.write(reinterpret_cast<const char*>(&cluster_node.min_lod_error), sizeof(float));
-            fout.write(
-                reinterpret_cast<const char*>(&cluster_node.max_parent_lod_error),
-                sizeof(float));
-            fout.write(reinterpret_cast<const char*>(&cluster_node.is_leaf), sizeof(bool));
-            fout.write(reinterpret_cast<const char*>(&cluster_node.depth), sizeof(std::uint32_t));
-            fout.write(
-                reinterpret_cast<const char*>(&cluster_node.child_offset),
-                sizeof(std::uint32_t));
-            fout.write(
-                reinterpret_cast<const char*>(&cluster_node.child_count),
-                sizeof(std::uint32_t));
+            if (cluster_node.is_leaf && cluster_node.child_count != 0)
+            {
+                cluster_node.child_offset = new_index[cluster_node.child_offset];
+            }
         }
+
+        writer.add_submesh(cluster_nodes);
     }
 
-    return true;
+    return writer.close();
 }
 
 std::vector<vec4f> geometry_tool::generate_tangents(
@@ -548,6 +589,7 @@ geometry_tool::cluster_output geometry_tool::generate_clusters(const cluster_inp
         }
 
         cluster_builder builder;
+        builder.set_executor(input.executor);
         builder.set_positions(positions);
         builder.set_indexes(indexes);
 
@@ -621,50 +663,111 @@ geometry_tool::cluster_output geometry_tool::generate_clusters(const cluster_inp
             }
         }
 
-        const auto& cluster_nodes = builder.get_cluster_nodes();
-        std::uint32_t bvh_node_count = 0;
+        submesh_output.cluster_nodes = flatten_cluster_nodes(builder);
 
-        std::queue<std::uint32_t> queue;
-        queue.push(static_cast<std::uint32_t>(cluster_nodes.size() - 1));
-        while (!queue.empty())
-        {
-            const auto& cluster_node = cluster_nodes[queue.front()];
-            queue.pop();
-
-            submesh_output.cluster_nodes.push_back({
-                .bounding_sphere = cluster_node.bounding_sphere,
-                .lod_bounds = cluster_node.lod_bounds,
-                .min_lod_error = cluster_node.min_lod_error,
-                .max_parent_lod_error = cluster_node.max_parent_lod_error,
-                .is_leaf = cluster_node.is_leaf,
-                .depth = cluster_node.depth,
-            });
+        output.submeshes.push_back(submesh_output);
+    }
+
+    return output;
+}
+
+bool geometry_tool::generate_clusters(const cluster_stream_input& input, std::string_view path)
+{
+    cluster_streamer streamer;
+    streamer.set_executor(input.executor);
+    streamer.set_memory_budget(input.memory_budget);
+    streamer.set_temp_directory(input.temp_directory);
+    streamer.set_attributes(input.has_normal, input.has_tangent, input.has_texcoord);
 
-            ++bvh_node_count;
+    if (!streamer.build(input.read))
+    {
+        return false;
+    }
+
+    // Clusters are written from the coarsest lod to the finest, groups are renumbered to match.
+    std::vector<std::uint32_t> lod_cluster_offsets(streamer.get_lod_count());
+    std::uint32_t cluster_count = 0;
+    for (std::uint32_t lod = streamer.get_lod_count(); lod-- > 0;)
+    {
+        lod_cluster_offsets[lod] = cluster_count;
+        cluster_count += streamer.get_lod_cluster_count(lod);
+    }
 
-            if (cluster_node.is_leaf)
+    std::vector<cluster_builder::cluster_group> groups = streamer.get_groups();
+    for (auto& group : groups)
+    {
+        group.cluster_offset += lod_cluster_offsets[group.lod];
+    }
+
+    // Only group bounds are kept in memory, the hierarchy is built over the groups of all bricks.
+    cluster_builder hierarchy;
+    hierarchy.build_hierarchy(std::move(groups));
+    std::vector<cluster_node> cluster_nodes = flatten_cluster_nodes(hierarchy);
+
+    std::ofstream fout(std::string(path), std::ios::binary);
+    if (!fout.is_open())
+    {
+        return false;
+    }
+
+    cluster_file::flags flags = 0;
+    flags |= input.has_normal ? cluster_file::FLAG_NORMAL : 0;
+    flags |= input.has_tangent ? cluster_file::FLAG_TANGENT : 0;
+    flags |= input.has_texcoord ? cluster_file::FLAG_TEXCOORD : 0;
+
+    cluster_file_writer writer;
+    if (!writer.open(fout, flags))
+    {
+        return false;
+    }
+
+    std::vector<vec3f> positions;
+    std::vector<vec3f> normals;
+    std::vector<vec4f> tangents;
+    std::vector<vec2f> texcoords;
+
+    auto add_cluster = [&](const cluster& cluster,
+                           std::span<const cluster_streamer::vertex> vertices,
+                           std::span<const std::uint32_t> indexes)
+    {
+        positions.clear();
+        normals.clear();
+        tangents.clear();
+        texcoords.clear();
+
+        for (const auto& vertex : vertices)
+        {
+            positions.push_back(vertex.position);
+
+            if (input.has_normal)
             {
-                const auto& group = groups[cluster_node.children[0]];
-                submesh_output.cluster_nodes.back().child_offset = group.cluster_offset;
-                submesh_output.cluster_nodes.back().child_count = group.cluster_count;
+                normals.push_back(vertex.normal);
             }
-            else
+
+            if (input.has_tangent)
             {
-                submesh_output.cluster_nodes.back().child_offset =
-                    static_cast<std::uint32_t>(queue.size() + bvh_node_count);
-                submesh_output.cluster_nodes.back().child_count =
-                    static_cast<std::uint32_t>(cluster_node.children.size());
+                tangents.push_back(vertex.tangent);
+            }
 
-                for (std::uint32_t child : cluster_node.children)
-                {
-                    queue.push(child);
-                }
+            if (input.has_texcoord)
+            {
+                texcoords.push_back(vertex.texcoord);
             }
         }
 
-        output.submeshes.push_back(submesh_output);
+        writer.add_cluster(cluster, positions, normals, tangents, texcoords, indexes);
+    };
+
+    for (std::uint32_t lod = streamer.get_lod_count(); lod-- > 0;)
+    {
+        if (!streamer.for_each_cluster(lod, add_cluster))
+        {
+            return false;
+        }
     }
 
-    return output;
+    writer.add_submesh(cluster_nodes);
+
+    return writer.close();
 }
 } // namespace violet
\ No newline at end of file
@@ -1,11 +1,16 @@
 #pragma once
 
-#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <limits>
 #include <vector>
 
 namespace violet
 {
+/**
+ * @brief Min heap of edge collapses keyed by error. The heap position of every edge is tracked, so
+ * update and erase are O(log n) instead of a linear search.
+ */
 class collapse_heap
 {
 public:
@@ -15,57 +20,70 @@ public:
         float error;
     };
 
+    void reserve(std::size_t edge_count)
+    {
+        m_heap.reserve(edge_count);
+        m_indexes.reserve(edge_count);
+    }
+
     void push(const element& element)
     {
+        if (element.edge >= m_indexes.size())
+        {
+            m_indexes.resize(element.edge + 1, INVALID_INDEX);
+        }
+
+        assert(m_indexes[element.edge] == INVALID_INDEX);
+
         m_heap.push_back(element);
-        std::ranges::push_heap(m_heap, element_greater());
+        m_indexes[element.edge] = static_cast<std::uint32_t>(m_heap.size() - 1);
+        sift_up(m_heap.size() - 1);
     }
 
     void pop()
     {
-        std::ranges::pop_heap(m_heap, element_greater());
-        m_heap.pop_back();
+        remove(0);
     }
 
     bool erase(std::uint32_t edge)
     {
-        if (update(edge, std::numeric_limits<float>::lowest()))
+        if (!contains(edge))
         {
-            pop();
-            return true;
+            return false;
         }
 
-        return false;
+        remove(m_indexes[edge]);
+        return true;
     }
 
     bool update(std::uint32_t edge, float error)
     {
-        auto iter = std::ranges::find_if(
-            m_heap,
-            [edge](const element& e)
-            {
-                return e.edge == edge;
-            });
-
-        if (iter == m_heap.end())
+        if (!contains(edge))
         {
             return false;
         }
 
-        if (iter->error > error)
+        std::size_t index = m_indexes[edge];
+        float old_error = m_heap[index].error;
+        m_heap[index].error = error;
+
+        if (error < old_error)
         {
-            iter->error = error;
-            sift_up(std::distance(m_heap.begin(), iter));
+            sift_up(index);
         }
         else
         {
-            iter->error = error;
-            sift_down(std::distance(m_heap.begin(), iter));
+            sift_down(index);
         }
 
         return true;
     }
 
+    bool contains(std::uint32_t edge) const noexcept
+    {
+        return edge < m_indexes.size() && m_indexes[edge] != INVALID_INDEX;
+    }
+
     const element& top() const
     {
         return m_heap.front();
@@ -82,23 +100,53 @@ public:
     }
 
 private:
-    struct element_greater
+    static constexpr std::uint32_t INVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+    void remove(std::size_t index)
     {
-        bool operator()(const element& a, const element& b) const noexcept
+        assert(index < m_heap.size());
+
+        m_indexes[m_heap[index].edge] = INVALID_INDEX;
+
+        std::size_t last = m_heap.size() - 1;
+        if (index != last)
         {
-            return a.error > b.error;
+            float error = m_heap[index].error;
+            set(index, m_heap[last]);
+            m_heap.pop_back();
+
+            if (m_heap[index].error < error)
+            {
+                sift_up(index);
+            }
+            else
+            {
+                sift_down(index);
+            }
         }
-    };
+        else
+        {
+            m_heap.pop_back();
+        }
+    }
+
+    void set(std::size_t index, const element& element) noexcept
+    {
+        m_heap[index] = element;
+        m_indexes[element.edge] = static_cast<std::uint32_t>(index);
+    }
 
     void sift_up(std::size_t index)
     {
+        element current = m_heap[index];
+
         while (index > 0)
         {
             std::size_t parent = (index - 1) / 2;
 
-            if (m_heap[index].error < m_heap[parent].error)
+            if (current.error < m_heap[parent].error)
             {
-                std::swap(m_heap[index], m_heap[parent]);
+                set(index, m_heap[parent]);
                 index = parent;
             }
             else
@@ -106,10 +154,13 @@ private:
                 break;
             }
         }
+
+        set(index, current);
     }
 
     void sift_down(std::size_t index)
     {
+        element current = m_heap[index];
         std::size_t size = m_heap.size();
 
         std::size_t child = (index * 2) + 1;
@@ -120,19 +171,24 @@ private:
                 ++child;
             }
 
-            if (m_heap[index].error > m_heap[child].error)
+            if (current.error > m_heap[child].error)
             {
-                std::swap(m_heap[index], m_heap[child]);
+                set(index, m_heap[child]);
                 index = child;
-                child = index * 2 + 1;
+                child = (index * 2) + 1;
             }
             else
             {
                 break;
             }
         }
+
+        set(index, current);
     }
 
     std::vector<element> m_heap;
+
+    // Heap position of every edge, INVALID_INDEX if the edge is not in the heap.
+    std::vector<std::uint32_t> m_indexes;
 };
 } // namespace violet
\ No newline at end of file
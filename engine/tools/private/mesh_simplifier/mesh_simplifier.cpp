@@ -20,6 +20,10 @@ std::uint32_t cycle_3(std::uint32_t value)
 float mesh_simplifier::simplify(std::uint32_t target_triangle_count, float target_error)
 {
     m_vertex_map.clear();
+    m_vertex_map.reserve(m_positions.size());
+    m_corner_map.reserve(m_indexes.size());
+    m_edge_map0.reserve(m_indexes.size());
+    m_edge_map1.reserve(m_indexes.size());
     for (std::uint32_t i = 0; i < m_positions.size(); ++i)
     {
         m_vertex_map.insert({m_positions[i], i});
@@ -75,6 +79,7 @@ float mesh_simplifier::simplify(std::uint32_t target_triangle_count, float targe
             m_attribute_weights);
     }
 
+    m_heap.reserve(m_edges.size());
     for (std::uint32_t edge = 0; edge < m_edges.size(); ++edge)
     {
         float error = evaluate_edge(edge);
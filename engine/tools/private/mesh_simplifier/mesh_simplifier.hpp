@@ -1,12 +1,12 @@
 #pragma once
 
 #include "algorithm/hash.hpp"
+#include "common/flat_map.hpp"
 #include "math/types.hpp"
 #include "mesh_simplifier/collapse_heap.hpp"
 #include "mesh_simplifier/quadric.hpp"
 #include <functional>
 #include <limits>
-#include <unordered_map>
 
 namespace violet
 {
@@ -151,14 +151,14 @@ private:
 
     std::vector<float> m_wedge_attributes;
 
-    std::unordered_multimap<vec3f, std::uint32_t, vertex_hash> m_vertex_map;
-    std::unordered_multimap<vec3f, std::uint32_t, vertex_hash> m_corner_map;
+    flat_multimap<vec3f, std::uint32_t, vertex_hash> m_vertex_map;
+    flat_multimap<vec3f, std::uint32_t, vertex_hash> m_corner_map;
     std::vector<corner_flags> m_corner_flags;
     std::vector<quadric_edge> m_edge_quadrics;
 
     std::vector<edge> m_edges;
-    std::unordered_multimap<vec3f, std::uint32_t, vertex_hash> m_edge_map0;
-    std::unordered_multimap<vec3f, std::uint32_t, vertex_hash> m_edge_map1;
+    flat_multimap<vec3f, std::uint32_t, vertex_hash> m_edge_map0;
+    flat_multimap<vec3f, std::uint32_t, vertex_hash> m_edge_map1;
 
     quadric_pool m_triangle_quadrics;
     std::uint32_t m_triangle_count{0};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "graphics/cluster.hpp"
+#include "math/types.hpp"
+#include <cstddef>
+#include <fstream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace violet
+{
+/**
+ * @brief A read-only view of a cluster file. Clusters and their vertices are stored in pages
+ * aligned to PAGE_SIZE, ordered per submesh from the coarsest lod to the finest. The header, the
+ * offsets table and the page table are small and read up front. Pages are only touched once their
+ * lod is needed, so a runtime can upload the coarse levels first and fetch finer pages on demand.
+ */
+class cluster_file
+{
+public:
+    static constexpr std::uint32_t MAGIC = 0x534c4356; // "VCLS"
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint32_t PAGE_SIZE = 64 * 1024;
+
+    enum flag : std::uint32_t
+    {
+        FLAG_NORMAL = 1 << 0,
+        FLAG_TANGENT = 1 << 1,
+        FLAG_TEXCOORD = 1 << 2,
+    };
+    using flags = std::uint32_t;
+
+    /**
+     * @brief Clusters are numbered per submesh. Vertices and indexes are numbered across the file,
+     * and the indexes of a page already point at the vertex offset of the page.
+     */
+    struct page
+    {
+        std::uint64_t offset;
+        std::uint32_t size;
+
+        std::uint32_t submesh_index;
+        std::uint32_t lod;
+
+        std::uint32_t cluster_offset;
+        std::uint32_t cluster_count;
+        std::uint32_t vertex_offset;
+        std::uint32_t vertex_count;
+        std::uint32_t index_offset;
+        std::uint32_t index_count;
+    };
+
+    struct level
+    {
+        std::uint32_t lod;
+
+        std::uint32_t page_offset;
+        std::uint32_t page_count;
+        std::uint32_t cluster_offset;
+        std::uint32_t cluster_count;
+    };
+
+    struct submesh
+    {
+        std::uint32_t level_offset;
+        std::uint32_t level_count;
+        std::uint32_t cluster_count;
+        std::uint32_t cluster_node_offset;
+        std::uint32_t cluster_node_count;
+    };
+
+    cluster_file() = default;
+    cluster_file(const cluster_file&) = delete;
+    ~cluster_file();
+
+    /**
+     * @brief Maps the file read-only.
+     */
+    bool open(std::string_view path);
+
+    /**
+     * @brief Reads a file image owned by the caller, which must outlive the cluster file.
+     */
+    bool open(std::span<const std::byte> data);
+
+    /**
+     * @brief Reads the file that starts at the stream position into memory owned by the cluster
+     * file. Reading stops at the size recorded in the header, so the file may be embedded in a
+     * larger stream.
+     */
+    bool open(std::ifstream& fin);
+
+    void close();
+
+    bool is_open() const noexcept
+    {
+        return !m_data.empty();
+    }
+
+    flags get_flags() const noexcept
+    {
+        return m_flags;
+    }
+
+    std::uint32_t get_vertex_count() const noexcept
+    {
+        return m_vertex_count;
+    }
+
+    std::uint32_t get_index_count() const noexcept
+    {
+        return m_index_count;
+    }
+
+    std::span<const submesh> get_submeshes() const noexcept
+    {
+        return m_submeshes;
+    }
+
+    std::span<const level> get_levels(const submesh& submesh) const noexcept
+    {
+        return m_levels.subspan(submesh.level_offset, submesh.level_count);
+    }
+
+    std::span<const page> get_pages() const noexcept
+    {
+        return m_pages;
+    }
+
+    std::span<const page> get_pages(const level& level) const noexcept
+    {
+        return m_pages.subspan(level.page_offset, level.page_count);
+    }
+
+    std::span<const cluster_node> get_cluster_nodes(const submesh& submesh) const noexcept
+    {
+        return m_cluster_nodes.subspan(submesh.cluster_node_offset, submesh.cluster_node_count);
+    }
+
+    /**
+     * @brief The arrays of a page. Attributes the file does not have are empty.
+     */
+    struct page_data
+    {
+        std::span<const cluster> clusters;
+        std::span<const vec3f> positions;
+        std::span<const vec3f> normals;
+        std::span<const vec4f> tangents;
+        std::span<const vec2f> texcoords;
+        std::span<const std::uint32_t> indexes;
+    };
+
+    /**
+     * @brief The page views point into the file, so they can be copied into upload buffers without
+     * an intermediate copy.
+     */
+    page_data get_page_data(const page& page) const noexcept;
+
+    std::span<const cluster> get_clusters(const page& page) const noexcept;
+    std::span<const vec3f> get_positions(const page& page) const noexcept;
+    std::span<const vec3f> get_normals(const page& page) const noexcept;
+    std::span<const vec4f> get_tangents(const page& page) const noexcept;
+    std::span<const vec2f> get_texcoords(const page& page) const noexcept;
+    std::span<const std::uint32_t> get_indexes(const page& page) const noexcept;
+
+    /**
+     * @brief Asks the system to read a mapped page ahead of use, or to drop it once its lod is no
+     * longer drawn. Does nothing for caller owned images.
+     */
+    void prefetch(const page& page) const noexcept;
+    void evict(const page& page) const noexcept;
+
+private:
+    bool read(std::span<const std::byte> data);
+
+    template <typename T>
+    std::span<const T> get_array(std::uint64_t offset, std::size_t count) const noexcept
+    {
+        return {reinterpret_cast<const T*>(m_data.data() + offset), count};
+    }
+
+    std::span<const std::byte> m_data;
+    std::vector<std::byte> m_buffer;
+
+    void* m_mapping{nullptr};
+    std::size_t m_mapping_size{0};
+    std::intptr_t m_file{-1};
+    std::intptr_t m_file_mapping{0};
+
+    flags m_flags{0};
+    std::uint32_t m_vertex_count{0};
+    std::uint32_t m_index_count{0};
+
+    std::span<const submesh> m_submeshes;
+    std::span<const level> m_levels;
+    std::span<const page> m_pages;
+    std::span<const cluster_node> m_cluster_nodes;
+};
+
+/**
+ * @brief Writes a cluster file page by page, so only the current page and the tables are held in
+ * memory.
+ */
+class cluster_file_writer
+{
+public:
+    bool open(std::ofstream& fout, cluster_file::flags flags);
+
+    /**
+     * @brief Clusters of a submesh are added from its coarsest lod to its finest. The vertices
+     * belong to the cluster alone and its indexes point into them.
+     */
+    void add_cluster(
+        const cluster& cluster,
+        std::span<const vec3f> positions,
+        std::span<const vec3f> normals,
+        std::span<const vec4f> tangents,
+        std::span<const vec2f> texcoords,
+        std::span<const std::uint32_t> indexes);
+
+    /**
+     * @brief Ends the submesh of the clusters added so far. Leaf nodes reference the clusters in
+     * the order they were added.
+     */
+    void add_submesh(std::span<const cluster_node> cluster_nodes);
+
+    bool close();
+
+private:
+    void flush_page();
+
+    std::ofstream* m_fout{nullptr};
+    cluster_file::flags m_flags{0};
+
+    cluster_file::page m_page{};
+    std::vector<cluster> m_page_clusters;
+    std::vector<vec3f> m_page_positions;
+    std::vector<vec3f> m_page_normals;
+    std::vector<vec4f> m_page_tangents;
+    std::vector<vec2f> m_page_texcoords;
+    std::vector<std::uint32_t> m_page_indexes;
+
+    std::uint64_t m_offset{0};
+    std::uint64_t m_vertex_count{0};
+    std::uint64_t m_index_count{0};
+    std::uint32_t m_cluster_count{0};
+    std::uint32_t m_submesh_level_offset{0};
+
+    std::vector<cluster_file::submesh> m_submeshes;
+    std::vector<cluster_file::level> m_levels;
+    std::vector<cluster_file::page> m_pages;
+    std::vector<cluster_node> m_cluster_nodes;
+};
+} // namespace violet
\ No newline at end of file
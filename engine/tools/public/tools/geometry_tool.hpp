@@ -3,11 +3,15 @@
 #include "graphics/cluster.hpp"
 #include "math/types.hpp"
 #include <fstream>
+#include <functional>
 #include <span>
+#include <string>
 #include <vector>
 
 namespace violet
 {
+class task_executor;
+
 class geometry_tool
 {
 public:
@@ -59,6 +63,9 @@ public:
         std::span<const vec2f> texcoords;
         std::span<const std::uint32_t> indexes;
         std::vector<submesh> submeshes;
+
+        // Optional, clusters are built on the calling thread if null.
+        task_executor* executor{nullptr};
     };
 
     struct cluster_output
@@ -76,6 +83,11 @@ public:
         std::vector<std::uint32_t> indexes;
         std::vector<submesh> submeshes;
 
+        /**
+         * @brief Stored as a cluster_file. Saving reorders the clusters of each submesh from the
+         * coarsest lod to the finest, loading a mapped file keeps that order. Loading copies the
+         * pages into the arrays, open a cluster_file to use them in place.
+         */
         bool load(std::string_view path);
         bool save(std::string_view path) const;
 
@@ -84,5 +96,40 @@ public:
     };
 
     static cluster_output generate_clusters(const cluster_input& input);
+
+    struct cluster_stream_input
+    {
+        struct vertex
+        {
+            vec3f position;
+            vec3f normal;
+            vec4f tangent;
+            vec2f texcoord;
+        };
+
+        // Fills the span with the corners of whole triangles and returns how many were written, 0
+        // once the mesh is exhausted. The mesh is read only once.
+        std::function<std::size_t(std::span<vertex> vertices)> read;
+
+        bool has_normal{false};
+        bool has_tangent{false};
+        bool has_texcoord{false};
+
+        // Bricks are sized so that building one of them stays under the budget.
+        std::size_t memory_budget{std::size_t{1} << 30};
+
+        // Bricks are spilled to a subdirectory that is removed afterwards. The system temporary
+        // directory is used if empty.
+        std::string temp_directory;
+
+        // Optional, clusters are built on the calling thread if null.
+        task_executor* executor{nullptr};
+    };
+
+    /**
+     * @brief Builds the clusters of a mesh that does not fit in memory and writes them to the path
+     * in the format of cluster_output::save, as a single submesh.
+     */
+    static bool generate_clusters(const cluster_stream_input& input, std::string_view path);
 };
 } // namespace violet
\ No newline at end of file
@@ -2,8 +2,10 @@
 #include "assimp_loader.hpp"
 #include "common/log.hpp"
 #include "gltf_loader.hpp"
+#include "task/async_file.hpp"
 #include "tools/geometry_tool.hpp"
 #include "tools/texture_tool.hpp"
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 
@@ -28,16 +30,34 @@ enum geometry_flag
     GEOMETRY_HAS_TEXCOORD = 1 << 2,
 };
 
+// Cached meshes are read into memory in one go and parsed from there.
+struct mesh_reader
+{
+    std::span<const char> data;
+    std::size_t offset{0};
+    bool fail{false};
+};
+
 template <typename T>
-void read(std::ifstream& fin, T& value)
+void read(mesh_reader& reader, T* data, std::uint32_t count)
 {
-    fin.read(reinterpret_cast<char*>(&value), sizeof(T));
+    std::size_t size = sizeof(T) * count;
+    if (reader.fail || size > reader.data.size() - reader.offset)
+    {
+        // Counts read past the end are zero, so nothing is resized to garbage.
+        reader.fail = true;
+        std::memset(static_cast<void*>(data), 0, size);
+        return;
+    }
+
+    std::memcpy(static_cast<void*>(data), reader.data.data() + reader.offset, size);
+    reader.offset += size;
 }
 
 template <typename T>
-void read(std::ifstream& fin, T* data, std::uint32_t count)
+void read(mesh_reader& reader, T& value)
 {
-    fin.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+    read(reader, &value, 1);
 }
 
 template <typename T>
@@ -54,49 +74,49 @@ void write(std::ofstream& fout, const T* data, std::uint32_t count)
         static_cast<std::streamsize>(sizeof(T) * count));
 }
 
-bool read_node(std::ifstream& fin, mesh_loader::scene_data& scene_data)
+bool read_node(mesh_reader& reader, mesh_loader::scene_data& scene_data)
 {
     std::uint32_t node_count;
-    read(fin, node_count);
+    read(reader, node_count);
     scene_data.nodes.resize(node_count);
 
     for (auto& node : scene_data.nodes)
     {
         std::uint32_t name_length;
-        read(fin, name_length);
+        read(reader, name_length);
 
         node.name.resize(name_length);
-        read(fin, node.name.data(), name_length);
+        read(reader, node.name.data(), name_length);
 
-        read(fin, node.position);
-        read(fin, node.rotation);
-        read(fin, node.scale);
-        read(fin, node.parent);
-        read(fin, node.mesh);
+        read(reader, node.position);
+        read(reader, node.rotation);
+        read(reader, node.scale);
+        read(reader, node.parent);
+        read(reader, node.mesh);
     }
 
     std::uint32_t mesh_count;
-    read(fin, mesh_count);
+    read(reader, mesh_count);
     scene_data.meshes.resize(mesh_count);
 
     for (auto& mesh : scene_data.meshes)
     {
-        read(fin, mesh.geometry);
+        read(reader, mesh.geometry);
 
         std::uint32_t submesh_count;
-        read(fin, submesh_count);
+        read(reader, submesh_count);
 
         mesh.submeshes.resize(submesh_count);
         mesh.materials.resize(submesh_count);
 
         for (std::uint32_t i = 0; i < submesh_count; ++i)
         {
-            read(fin, mesh.submeshes[i]);
-            read(fin, mesh.materials[i]);
+            read(reader, mesh.submeshes[i]);
+            read(reader, mesh.materials[i]);
         }
     }
 
-    return true;
+    return !reader.fail;
 }
 
 bool write_node(std::ofstream& fout, const mesh_loader::scene_data& scene_data)
@@ -137,104 +157,104 @@ bool write_node(std::ofstream& fout, const mesh_loader::scene_data& scene_data)
     return true;
 }
 
-bool read_geometry(std::ifstream& fin, mesh_loader::scene_data& scene_data)
+bool read_geometry(mesh_reader& reader, mesh_loader::scene_data& scene_data)
 {
     std::uint32_t geometry_count;
-    read(fin, geometry_count);
+    read(reader, geometry_count);
     scene_data.geometries.resize(geometry_count);
 
     for (auto& geometry : scene_data.geometries)
     {
         std::uint32_t vertex_count;
-        read(fin, vertex_count);
+        read(reader, vertex_count);
 
         std::uint32_t index_count;
-        read(fin, index_count);
+        read(reader, index_count);
 
         std::uint32_t flags;
-        read(fin, flags);
+        read(reader, flags);
 
         geometry.positions.resize(vertex_count);
-        read(fin, geometry.positions.data(), vertex_count);
+        read(reader, geometry.positions.data(), vertex_count);
 
         geometry.indexes.resize(index_count);
-        read(fin, geometry.indexes.data(), index_count);
+        read(reader, geometry.indexes.data(), index_count);
 
         if (flags & GEOMETRY_HAS_NORMAL)
         {
             geometry.normals.resize(vertex_count);
-            read(fin, geometry.normals.data(), vertex_count);
+            read(reader, geometry.normals.data(), vertex_count);
         }
 
         if (flags & GEOMETRY_HAS_TANGENT)
         {
             geometry.tangents.resize(vertex_count);
-            read(fin, geometry.tangents.data(), vertex_count);
+            read(reader, geometry.tangents.data(), vertex_count);
         }
 
         if (flags & GEOMETRY_HAS_TEXCOORD)
         {
             geometry.texcoords.resize(vertex_count);
-            read(fin, geometry.texcoords.data(), vertex_count);
+            read(reader, geometry.texcoords.data(), vertex_count);
         }
 
         std::uint32_t submesh_count;
-        read(fin, submesh_count);
+        read(reader, submesh_count);
         geometry.submeshes.resize(submesh_count);
 
         for (auto& submesh : geometry.submeshes)
         {
             std::uint32_t submesh_type;
-            read(fin, submesh_type);
+            read(reader, submesh_type);
 
             if (submesh_type == 0)
             {
-                read(fin, submesh.vertex_offset);
-                read(fin, submesh.index_offset);
-                read(fin, submesh.index_count);
+                read(reader, submesh.vertex_offset);
+                read(reader, submesh.index_offset);
+                read(reader, submesh.index_count);
             }
             else
             {
                 std::uint32_t cluster_count;
-                read(fin, cluster_count);
+                read(reader, cluster_count);
                 submesh.clusters.resize(cluster_count);
 
                 for (auto& cluster : submesh.clusters)
                 {
-                    read(fin, cluster.index_offset);
-                    read(fin, cluster.index_count);
-                    read(fin, cluster.bounding_sphere);
-                    read(fin, cluster.lod_bounds);
-                    read(fin, cluster.lod_error);
-                    read(fin, cluster.parent_lod_bounds);
-                    read(fin, cluster.parent_lod_error);
-                    read(fin, cluster.lod);
+                    read(reader, cluster.index_offset);
+                    read(reader, cluster.index_count);
+                    read(reader, cluster.bounding_sphere);
+                    read(reader, cluster.lod_bounds);
+                    read(reader, cluster.lod_error);
+                    read(reader, cluster.parent_lod_bounds);
+                    read(reader, cluster.parent_lod_error);
+                    read(reader, cluster.lod);
                 }
 
                 std::uint32_t cluster_node_count;
-                read(fin, cluster_node_count);
+                read(reader, cluster_node_count);
                 submesh.cluster_nodes.resize(cluster_node_count);
 
                 for (auto& cluster_node : submesh.cluster_nodes)
                 {
-                    read(fin, cluster_node.bounding_sphere);
-                    read(fin, cluster_node.lod_bounds);
-                    read(fin, cluster_node.min_lod_error);
-                    read(fin, cluster_node.max_parent_lod_error);
+                    read(reader, cluster_node.bounding_sphere);
+                    read(reader, cluster_node.lod_bounds);
+                    read(reader, cluster_node.min_lod_error);
+                    read(reader, cluster_node.max_parent_lod_error);
 
                     std::uint32_t is_leaf;
-                    read(fin, is_leaf);
+                    read(reader, is_leaf);
                     cluster_node.is_leaf = is_leaf != 0;
 
-                    read(fin, cluster_node.depth);
-                    read(fin, cluster_node.child_offset);
-                    read(fin, cluster_node.child_count);
+                    read(reader, cluster_node.depth);
+                    read(reader, cluster_node.child_offset);
+                    read(reader, cluster_node.child_count);
                 }
             }
         }
     }
 
-    return true;
+    return !reader.fail;
 }
 
 bool write_geometry(std::ofstream& fout, const mesh_loader::scene_data& scene_data)
@@ -326,32 +346,32 @@ bool write_geometry(std::ofstream& fout, const mesh_loader::scene_data& scene_da
     return true;
 }
 
-bool read_material(std::ifstream& fin, mesh_loader::scene_data& scene_data)
+bool read_material(mesh_reader& reader, mesh_loader::scene_data& scene_data)
 {
     std::uint32_t material_count;
-    read(fin, material_count);
+    read(reader, material_count);
     scene_data.materials.resize(material_count);
 
     for (auto& material : scene_data.materials)
     {
-        read(fin, material.albedo);
-        read(fin, material.roughness);
-        read(fin, material.metallic);
-        read(fin, material.emissive);
+        read(reader, material.albedo);
+        read(reader, material.roughness);
+        read(reader, material.metallic);
+        read(reader, material.emissive);
 
-        read(fin, material.albedo_texture);
-        read(fin, material.roughness_metallic_texture);
-        read(fin, material.emissive_texture);
-        read(fin, material.normal_texture);
+        read(reader, material.albedo_texture);
+        read(reader, material.roughness_metallic_texture);
+        read(reader, material.emissive_texture);
+        read(reader, material.normal_texture);
 
         std::uint32_t cull_mode;
-        read(fin, cull_mode);
+        read(reader, cull_mode);
         material.cull_mode = static_cast<rhi_cull_mode>(cull_mode);
 
-        read(fin, material.opacity_cutoff);
+        read(reader, material.opacity_cutoff);
     }
 
-    return true;
+    return !reader.fail;
 }
 
 bool write_material(std::ofstream& fout, const mesh_loader::scene_data& scene_data)
@@ -378,31 +398,31 @@ bool write_material(std::ofstream& fout, const mesh_loader::scene_data& scene_da
     return true;
 }
 
-bool read_texture(std::ifstream& fin, mesh_loader::scene_data& scene_data)
+bool read_texture(mesh_reader& reader, mesh_loader::scene_data& scene_data)
 {
     std::uint32_t texture_count;
-    read(fin, texture_count);
+    read(reader, texture_count);
     scene_data.textures.resize(texture_count);
 
     for (auto& texture : scene_data.textures)
     {
         std::uint32_t format;
-        read(fin, format);
+        read(reader, format);
         texture.format = static_cast<rhi_format>(format);
 
-        read(fin, texture.extent.width);
-        read(fin, texture.extent.height);
-        read(fin, texture.layer_count);
-        read(fin, texture.level_count);
+        read(reader, texture.extent.width);
+        read(reader, texture.extent.height);
+        read(reader, texture.layer_count);
+        read(reader, texture.level_count);
 
         std::uint32_t pixel_size;
-        read(fin, pixel_size);
+        read(reader, pixel_size);
 
         texture.pixels.resize(pixel_size);
-        read(fin, texture.pixels.data(), static_cast<std::streamsize>(pixel_size));
+        read(reader, texture.pixels.data(), pixel_size);
     }
 
-    return true;
+    return !reader.fail;
 }
 
 bool write_texture(std::ofstream& fout, const mesh_loader::scene_data& scene_data)
@@ -550,10 +570,60 @@ bool mesh_loader_compress_textures(mesh_loader::scene_data& scene_data)
 
     return true;
 }
+
+bool read_scene(std::span<const char> data, mesh_loader::scene_data& scene_data)
+{
+    mesh_reader reader = {.data = data};
+
+    std::uint32_t magic_number;
+    read(reader, magic_number);
+
+    if (magic_number != MAGIC_NUMBER)
+    {
+        return false;
+    }
+
+    std::uint32_t block_count;
+    read(reader, block_count);
+
+    for (std::uint32_t i = 0; i < block_count; ++i)
+    {
+        std::uint32_t block_type;
+        read(reader, block_type);
+
+        bool result = true;
+
+        switch (block_type)
+        {
+        case BLOCK_NODE:
+            result = read_node(reader, scene_data);
+            break;
+        case BLOCK_GEOMETRY:
+            result = read_geometry(reader, scene_data);
+            break;
+        case BLOCK_MATERIAL:
+            result = read_material(reader, scene_data);
+            break;
+        case BLOCK_TEXTURE:
+            result = read_texture(reader, scene_data);
+            break;
+        default:
+            return false;
+        }
+
+        if (!result)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
 } // namespace
 
-bool mesh_loader::load(
-    std::string_view path,
+async_task<bool> mesh_loader::load_async(
+    task_executor& executor,
+    std::string path,
     scene_data& scene_data,
     bool generate_clusters,
     bool generate_mipmaps,
@@ -576,7 +646,7 @@ bool mesh_loader::load(
 
     if (fs::exists(cache_path))
     {
-        return load(cache_path, scene_data);
+        co_return co_await load_async(executor, std::move(cache_path), scene_data);
     }
 
     bool result = true;
@@ -612,7 +682,7 @@ bool mesh_loader::load(
         save(cache_path, scene_data);
     }
 
-    return result;
+    co_return result;
 }
 
 bool mesh_loader::load(std::string_view path, scene_data& scene_data)
@@ -623,49 +693,27 @@ bool mesh_loader::load(std::string_view path, scene_data& scene_data)
         return false;
     }
 
-    std::uint32_t magic_number;
-    read(fin, magic_number);
+    fin.seekg(0, std::ios::end);
 
-    if (magic_number != MAGIC_NUMBER)
-    {
-        return false;
-    }
+    std::vector<char> data(fin.tellg());
+    fin.seekg(0);
+    fin.read(data.data(), static_cast<std::streamsize>(data.size()));
 
-    std::uint32_t block_count;
-    read(fin, block_count);
+    return !fin.fail() && read_scene(data, scene_data);
+}
 
-    for (std::uint32_t i = 0; i < block_count; ++i)
+async_task<bool> mesh_loader::load_async(
+    task_executor& executor,
+    std::string path,
+    scene_data& scene_data)
+{
+    std::vector<char> data;
+    if (!co_await async_file::read(executor, std::move(path), data))
     {
-        std::uint32_t block_type;
-        read(fin, block_type);
-
-        bool result = true;
-
-        switch (block_type)
-        {
-        case BLOCK_NODE:
-            result = read_node(fin, scene_data);
-            break;
-        case BLOCK_GEOMETRY:
-            result = read_geometry(fin, scene_data);
-            break;
-        case BLOCK_MATERIAL:
-            result = read_material(fin, scene_data);
-            break;
-        case BLOCK_TEXTURE:
-            result = read_texture(fin, scene_data);
-            break;
-        default:
-            return false;
-        }
-
-        if (!result)
-        {
-            return false;
-        }
+        co_return false;
     }
 
-    return true;
+    co_return read_scene(data, scene_data);
 }
 
 bool mesh_loader::save(std::string_view path, const scene_data& scene_data)
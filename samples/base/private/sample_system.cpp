@@ -123,12 +123,17 @@ entity sample_system::load_model(std::string_view model_path, load_options optio
 
     mesh_loader::scene_data scene_data;
 
-    bool result = mesh_loader::load(
-        model_path,
-        scene_data,
-        options & LOAD_OPTION_GENERATE_CLUSTERS,
-        options & LOAD_OPTION_GENERATE_MIPMAPS,
-        options & LOAD_OPTION_COMPRESS_TEXTURES);
+    // The load never resumes on the main thread, so waiting for it here is safe.
+    auto& executor = get_task_executor();
+    bool result = executor
+                      .execute(mesh_loader::load_async(
+                          executor,
+                          std::string(model_path),
+                          scene_data,
+                          options & LOAD_OPTION_GENERATE_CLUSTERS,
+                          options & LOAD_OPTION_GENERATE_MIPMAPS,
+                          options & LOAD_OPTION_COMPRESS_TEXTURES))
+                      .get();
 
     if (!result)
     {
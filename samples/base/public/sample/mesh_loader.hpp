@@ -2,6 +2,7 @@
 
 #include "graphics/cluster.hpp"
 #include "graphics/resources/texture.hpp"
+#include "task/task_executor.hpp"
 
 namespace violet
 {
@@ -75,13 +76,23 @@ public:
         std::vector<node_data> nodes;
     };
 
-    static bool load(
-        std::string_view path,
+    /**
+     * @brief Imports a model, or loads its cached mesh file if one was saved with the same options.
+     * The cache is read through the executor's io service and everything runs on worker threads.
+     */
+    static async_task<bool> load_async(
+        task_executor& executor,
+        std::string path,
         scene_data& scene_data,
         bool generate_clusters,
         bool generate_mipmaps,
         bool compress_textures);
 
+    static async_task<bool> load_async(
+        task_executor& executor,
+        std::string path,
+        scene_data& scene_data);
+
     static bool load(std::string_view path, scene_data& scene_data);
     static bool save(std::string_view path, const scene_data& scene_data);
 };
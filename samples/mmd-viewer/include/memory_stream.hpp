@@ -0,0 +1,33 @@
+#pragma once
+
+#include <istream>
+#include <span>
+#include <streambuf>
+
+namespace violet
+{
+class memory_buffer : public std::streambuf
+{
+public:
+    memory_buffer(std::span<const char> data)
+    {
+        // Only read from, get areas take a mutable pointer.
+        char* begin = const_cast<char*>(data.data());
+        setg(begin, begin, begin + data.size());
+    }
+};
+
+/**
+ * @brief An input stream over a file that is already in memory, e.g. read with async_file::read.
+ * Reads past the end set eof and fail like on a file stream.
+ */
+class memory_stream : private memory_buffer, public std::istream
+{
+public:
+    memory_stream(std::span<const char> data)
+        : memory_buffer(data),
+          std::istream(static_cast<memory_buffer*>(this))
+    {
+    }
+};
+} // namespace violet
\ No newline at end of file
@@ -31,7 +31,14 @@ public:
     mmd_loader(const std::vector<texture_2d*>& internal_toons);
     ~mmd_loader();
 
-    std::optional<scene_data> load(std::string_view pmx, std::string_view vmd, world& world);
+    /**
+     * @brief The model and the motion are read and parsed concurrently on the executor.
+     */
+    std::optional<scene_data> load(
+        std::string_view pmx,
+        std::string_view vmd,
+        world& world,
+        task_executor& executor);
 
 private:
     void load_mesh(scene_data& scene, world& world);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "math/types.hpp"
+#include "task/task_executor.hpp"
+#include <istream>
 #include <string>
 #include <vector>
 
@@ -327,7 +329,13 @@ class pmx
 public:
     pmx();
 
-    bool load(std::string_view path, bool flip_winding = true);
+    /**
+     * @brief Reads the file through the executor's io service and parses it on a worker thread.
+     */
+    async_task<bool> load_async(
+        task_executor& executor,
+        std::string path,
+        bool flip_winding = true);
 
     struct submesh
     {
@@ -382,13 +390,15 @@ public:
     std::vector<pmx_joint> joints;
 
 private:
-    bool load_header(std::ifstream& fin);
-    bool load_mesh(std::ifstream& fin);
-    bool load_material(std::ifstream& fin, std::string_view root_path);
-    bool load_bone(std::ifstream& fin);
-    bool load_morph(std::ifstream& fin);
-    bool load_display(std::ifstream& fin);
-    bool load_physics(std::ifstream& fin);
+    bool load(std::istream& fin, std::string_view root_path);
+
+    bool load_header(std::istream& fin);
+    bool load_mesh(std::istream& fin);
+    bool load_material(std::istream& fin, std::string_view root_path);
+    bool load_bone(std::istream& fin);
+    bool load_morph(std::istream& fin);
+    bool load_display(std::istream& fin);
+    bool load_physics(std::istream& fin);
 
     bool m_flip_winding;
 };
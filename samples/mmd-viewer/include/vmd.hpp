@@ -1,8 +1,9 @@
 #pragma once
 
 #include "math/types.hpp"
+#include "task/task_executor.hpp"
 #include <array>
-#include <fstream>
+#include <istream>
 #include <string>
 #include <vector>
 
@@ -73,7 +74,10 @@ class vmd
 public:
     vmd();
 
-    bool load(std::string_view path);
+    /**
+     * @brief Reads the file through the executor's io service and parses it on a worker thread.
+     */
+    async_task<bool> load_async(task_executor& executor, std::string path);
 
     vmd_header header;
     std::vector<vmd_motion> motions;
@@ -84,12 +88,14 @@ public:
     std::vector<vmd_ik> iks;
 
 private:
-    void load_header(std::ifstream& fin);
-    void load_motion(std::ifstream& fin);
-    void load_morph(std::ifstream& fin);
-    void load_camera(std::ifstream& fin);
-    void load_light(std::ifstream& fin);
-    void load_shadow(std::ifstream& fin);
-    void load_ik(std::ifstream& fin);
+    void load(std::istream& fin);
+
+    void load_header(std::istream& fin);
+    void load_motion(std::istream& fin);
+    void load_morph(std::istream& fin);
+    void load_camera(std::istream& fin);
+    void load_light(std::istream& fin);
+    void load_shadow(std::istream& fin);
+    void load_ik(std::istream& fin);
 };
 } // namespace violet
\ No newline at end of file
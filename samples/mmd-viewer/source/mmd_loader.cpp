@@ -38,14 +38,20 @@ mmd_loader::~mmd_loader() {}
 std::optional<mmd_loader::scene_data> mmd_loader::load(
     std::string_view pmx,
     std::string_view vmd,
-    world& world)
+    world& world,
+    task_executor& executor)
 {
-    if (!m_pmx.load(pmx))
+    auto pmx_result = executor.execute(m_pmx.load_async(executor, std::string(pmx)));
+
+    std::future<bool> vmd_result;
+    if (!vmd.empty())
     {
-        return std::nullopt;
+        vmd_result = executor.execute(m_vmd.load_async(executor, std::string(vmd)));
     }
 
-    if (!vmd.empty() && !m_vmd.load(vmd))
+    bool pmx_loaded = pmx_result.get();
+    bool vmd_loaded = vmd.empty() || vmd_result.get();
+    if (!pmx_loaded || !vmd_loaded)
     {
         return std::nullopt;
     }
@@ -172,7 +172,11 @@ void mmd_viewer::initialize_scene(
         });
 
     mmd_loader loader(internal_toons);
-    if (auto result = loader.load(pmx_path.string(), vmd_path.string(), get_world()))
+    if (auto result = loader.load(
+            pmx_path.string(),
+            vmd_path.string(),
+            get_world(),
+            get_task_executor()))
     {
         m_model = std::move(*result);
     }
@@ -2,7 +2,8 @@
 #include "encode.hpp"
 #include "math/quaternion.hpp"
 #include "math/vector.hpp"
-#include <fstream>
+#include "memory_stream.hpp"
+#include "task/async_file.hpp"
 
 namespace violet
 {
@@ -14,7 +15,7 @@ void read(std::istream& fin, T& dest)
     fin.read(reinterpret_cast<char*>(&dest), sizeof(T));
 }
 
-std::int32_t read_index(std::ifstream& fin, std::uint8_t size)
+std::int32_t read_index(std::istream& fin, std::uint8_t size)
 {
     switch (size)
     {
@@ -38,7 +39,7 @@ std::int32_t read_index(std::ifstream& fin, std::uint8_t size)
     }
 }
 
-std::string read_text(std::ifstream& fin, std::uint8_t text_encoding)
+std::string read_text(std::istream& fin, std::uint8_t text_encoding)
 {
     std::int32_t len;
     read<std::int32_t>(fin, len);
@@ -65,31 +66,27 @@ std::string read_text(std::ifstream& fin, std::uint8_t text_encoding)
 
 pmx::pmx() = default;
 
-bool pmx::load(std::string_view path, bool flip_winding)
+async_task<bool> pmx::load_async(task_executor& executor, std::string path, bool flip_winding)
 {
     m_flip_winding = flip_winding;
 
-    std::ifstream fin(path.data(), std::ios::binary);
-    if (!fin.is_open())
+    std::vector<char> data;
+    if (!co_await async_file::read(executor, path, data))
     {
-        return false;
+        co_return false;
     }
 
-    bool result = false;
-
-    if (load_header(fin) && load_mesh(fin) &&
-        load_material(fin, path.substr(0, path.find_last_of('/'))) && load_bone(fin) &&
-        load_morph(fin) && load_display(fin) && load_physics(fin))
-    {
-        result = true;
-    }
-
-    fin.close();
+    memory_stream fin(data);
+    co_return load(fin, std::string_view(path).substr(0, path.find_last_of('/')));
+}
 
-    return result;
+bool pmx::load(std::istream& fin, std::string_view root_path)
+{
+    return load_header(fin) && load_mesh(fin) && load_material(fin, root_path) && load_bone(fin) &&
+           load_morph(fin) && load_display(fin) && load_physics(fin);
 }
 
-bool pmx::load_header(std::ifstream& fin)
+bool pmx::load_header(std::istream& fin)
 {
     char magic[4];
     fin.read(magic, 4);
@@ -115,7 +112,7 @@ bool pmx::load_header(std::ifstream& fin)
     return true;
 }
 
-bool pmx::load_mesh(std::ifstream& fin)
+bool pmx::load_mesh(std::istream& fin)
 {
     std::int32_t vertex_count;
     read<std::int32_t>(fin, vertex_count);
@@ -255,7 +252,7 @@ bool pmx::load_mesh(std::ifstream& fin)
     return true;
 }
 
-bool pmx::load_material(std::ifstream& fin, std::string_view root_path)
+bool pmx::load_material(std::istream& fin, std::string_view root_path)
 {
     std::int32_t texture_count;
     read<std::int32_t>(fin, texture_count);
@@ -321,7 +318,7 @@ bool pmx::load_material(std::ifstream& fin, std::string_view root_path)
     return true;
 }
 
-bool pmx::load_bone(std::ifstream& fin)
+bool pmx::load_bone(std::istream& fin)
 {
     std::int32_t bone_count;
     read<std::int32_t>(fin, bone_count);
@@ -403,7 +400,7 @@ bool pmx::load_bone(std::ifstream& fin)
     return true;
 }
 
-bool pmx::load_morph(std::ifstream& fin)
+bool pmx::load_morph(std::istream& fin)
 {
     std::int32_t morph_count;
     read<std::int32_t>(fin, morph_count);
@@ -509,7 +506,7 @@ bool pmx::load_morph(std::ifstream& fin)
     return true;
 }
 
-bool pmx::load_display(std::ifstream& fin)
+bool pmx::load_display(std::istream& fin)
 {
     std::int32_t display_count;
     read<std::int32_t>(fin, display_count);
@@ -546,7 +543,7 @@ bool pmx::load_display(std::ifstream& fin)
     return true;
 }
 
-bool pmx::load_physics(std::ifstream& fin)
+bool pmx::load_physics(std::istream& fin)
 {
     std::int32_t rigidbody_count;
     read<std::int32_t>(fin, rigidbody_count);
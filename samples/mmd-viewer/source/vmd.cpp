@@ -1,5 +1,7 @@
 #include "vmd.hpp"
 #include "encode.hpp"
+#include "memory_stream.hpp"
+#include "task/async_file.hpp"
 
 namespace violet
 {
@@ -11,14 +13,22 @@ static void read(std::istream& fin, T& dest)
 
 vmd::vmd() = default;
 
-bool vmd::load(std::string_view path)
+async_task<bool> vmd::load_async(task_executor& executor, std::string path)
 {
-    std::ifstream fin(path.data(), std::ios::binary);
-    if (!fin.is_open())
+    std::vector<char> data;
+    if (!co_await async_file::read(executor, std::move(path), data))
     {
-        return false;
+        co_return false;
     }
 
+    memory_stream fin(data);
+    load(fin);
+
+    co_return true;
+}
+
+void vmd::load(std::istream& fin)
+{
     load_header(fin);
     load_motion(fin);
 
@@ -46,11 +56,9 @@ bool vmd::load(std::string_view path)
     {
         load_ik(fin);
     }
-
-    return true;
 }
 
-void vmd::load_header(std::ifstream& fin)
+void vmd::load_header(std::istream& fin)
 {
     char version[30] = {};
     fin.read(version, 30);
@@ -61,7 +69,7 @@ void vmd::load_header(std::ifstream& fin)
     header.model_name = model_name;
 }
 
-void vmd::load_motion(std::ifstream& fin)
+void vmd::load_motion(std::istream& fin)
 {
     std::uint32_t size;
     read(fin, size);
@@ -84,7 +92,7 @@ void vmd::load_motion(std::ifstream& fin)
     }
 }
 
-void vmd::load_morph(std::ifstream& fin)
+void vmd::load_morph(std::istream& fin)
 {
     std::uint32_t size;
     read(fin, size);
@@ -104,7 +112,7 @@ void vmd::load_morph(std::ifstream& fin)
     }
 }
 
-void vmd::load_camera(std::ifstream& fin)
+void vmd::load_camera(std::istream& fin)
 {
     std::uint32_t size;
     read(fin, size);
@@ -124,7 +132,7 @@ void vmd::load_camera(std::ifstream& fin)
     }
 }
 
-void vmd::load_light(std::ifstream& fin)
+void vmd::load_light(std::istream& fin)
 {
     std::uint32_t size;
     read(fin, size);
@@ -140,7 +148,7 @@ void vmd::load_light(std::ifstream& fin)
     }
 }
 
-void vmd::load_shadow(std::ifstream& fin)
+void vmd::load_shadow(std::istream& fin)
 {
     std::uint32_t size;
     read(fin, size);
@@ -156,7 +164,7 @@ void vmd::load_shadow(std::ifstream& fin)
     }
 }
 
-void vmd::load_ik(std::ifstream& fin)
+void vmd::load_ik(std::istream& fin)
 {
     std::uint32_t size;
     read(fin, size);
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <catch2/catch_all.hpp>
+
+namespace violet::test
+{
+constexpr std::size_t NUM_THREAD = 4;
+}
\ No newline at end of file
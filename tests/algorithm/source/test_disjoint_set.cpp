@@ -0,0 +1,192 @@
+#include "algorithm/concurrent_disjoint_set.hpp"
+#include "algorithm/disjoint_set.hpp"
+#include "task/task_executor.hpp"
+#include "test_algorithm_common.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace violet::test
+{
+namespace
+{
+class timer
+{
+public:
+    void start() noexcept
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    double elapse() const noexcept
+    {
+        auto duration = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double>(duration).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * @brief Triangulated grid cut into horizontal strips, so the mesh has strip_count islands.
+ */
+std::vector<std::uint32_t> make_grid_indexes(
+    std::uint32_t width,
+    std::uint32_t height,
+    std::uint32_t strip_count)
+{
+    std::vector<std::uint32_t> indexes;
+    indexes.reserve(static_cast<std::size_t>(width - 1) * (height - 1) * 6);
+
+    std::uint32_t strip_height = height / strip_count;
+    for (std::uint32_t y = 0; y + 1 < height; ++y)
+    {
+        if ((y + 1) % strip_height == 0)
+        {
+            continue;
+        }
+
+        for (std::uint32_t x = 0; x + 1 < width; ++x)
+        {
+            std::uint32_t v0 = (y * width) + x;
+            std::uint32_t v1 = v0 + 1;
+            std::uint32_t v2 = v0 + width;
+            std::uint32_t v3 = v2 + 1;
+
+            indexes.insert(indexes.end(), {v0, v2, v1, v1, v2, v3});
+        }
+    }
+
+    // Shuffle triangles so merges do not arrive in index order.
+    std::mt19937 engine(width);
+    std::uint32_t triangle_count = static_cast<std::uint32_t>(indexes.size() / 3);
+    for (std::uint32_t i = triangle_count - 1; i > 0; --i)
+    {
+        std::uint32_t j = engine() % (i + 1);
+        for (std::uint32_t k = 0; k < 3; ++k)
+        {
+            std::swap(indexes[(i * 3) + k], indexes[(j * 3) + k]);
+        }
+    }
+
+    return indexes;
+}
+
+void merge_triangles(
+    task_executor& executor,
+    concurrent_disjoint_set<std::uint32_t>& disjoint_set,
+    const std::vector<std::uint32_t>& indexes)
+{
+    executor.parallel_for(
+        indexes.size() / 3,
+        4096,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                disjoint_set.merge(indexes[(i * 3) + 0], indexes[(i * 3) + 1]);
+                disjoint_set.merge(indexes[(i * 3) + 0], indexes[(i * 3) + 2]);
+            }
+        });
+}
+} // namespace
+
+TEST_CASE("concurrent_disjoint_set serial", "[disjoint_set]")
+{
+    concurrent_disjoint_set<std::uint32_t> disjoint_set(10);
+
+    CHECK(disjoint_set.merge(7, 3));
+    CHECK(disjoint_set.merge(9, 7));
+    CHECK(!disjoint_set.merge(3, 9));
+    CHECK(disjoint_set.merge(5, 4));
+
+    CHECK(disjoint_set.get_set_count() == 7);
+    CHECK(disjoint_set.find(9) == 3);
+    CHECK(disjoint_set.find(7) == 3);
+    CHECK(disjoint_set.find(5) == 4);
+    CHECK(disjoint_set.find(0) == 0);
+
+    disjoint_set.reset();
+    CHECK(disjoint_set.get_set_count() == 10);
+    CHECK(disjoint_set.find(9) == 9);
+}
+
+TEST_CASE("concurrent_disjoint_set parallel", "[disjoint_set]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    auto indexes = make_grid_indexes(300, 400, 8);
+
+    disjoint_set<std::uint32_t> expected(300 * 400);
+    for (std::size_t i = 0; i < indexes.size(); i += 3)
+    {
+        expected.merge(indexes[i + 0], indexes[i + 1]);
+        expected.merge(indexes[i + 0], indexes[i + 2]);
+    }
+
+    // The smallest element of each set is its deterministic id.
+    std::vector<std::uint32_t> min_element(expected.get_size(), 0xFFFFFFFF);
+    for (std::uint32_t i = 0; i < expected.get_size(); ++i)
+    {
+        std::uint32_t& root_min = min_element[expected.find(i)];
+        root_min = std::min(root_min, i);
+    }
+
+    for (std::size_t run = 0; run < 4; ++run)
+    {
+        concurrent_disjoint_set<std::uint32_t> disjoint_set(300 * 400);
+        merge_triangles(executor, disjoint_set, indexes);
+
+        CHECK(disjoint_set.get_set_count() == expected.get_set_count());
+
+        bool match = true;
+        for (std::uint32_t i = 0; i < disjoint_set.get_size(); ++i)
+        {
+            match = match && disjoint_set.find(i) == min_element[expected.find(i)];
+        }
+        CHECK(match);
+    }
+
+    executor.stop();
+}
+
+TEST_CASE("concurrent_disjoint_set throughput", "[benchmark]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    for (std::uint32_t size : {1024, 2048})
+    {
+        auto indexes = make_grid_indexes(size, size, 16);
+        std::uint32_t vertex_count = size * size;
+
+        timer timer;
+
+        timer.start();
+        disjoint_set<std::uint32_t> serial(vertex_count);
+        for (std::size_t i = 0; i < indexes.size(); i += 3)
+        {
+            serial.merge(indexes[i + 0], indexes[i + 1]);
+            serial.merge(indexes[i + 0], indexes[i + 2]);
+        }
+        double serial_time = timer.elapse();
+
+        timer.start();
+        concurrent_disjoint_set<std::uint32_t> concurrent(vertex_count);
+        merge_triangles(executor, concurrent, indexes);
+        double concurrent_time = timer.elapse();
+
+        CHECK(serial.get_set_count() == concurrent.get_set_count());
+
+        std::cout << "disjoint_set " << vertex_count << " vertices: serial "
+                  << serial_time * 1000.0 << "ms, concurrent " << concurrent_time * 1000.0
+                  << "ms" << std::endl;
+    }
+
+    executor.stop();
+}
+} // namespace violet::test
\ No newline at end of file
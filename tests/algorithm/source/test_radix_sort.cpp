@@ -0,0 +1,194 @@
+#include "algorithm/radix_sort.hpp"
+#include "task/task_executor.hpp"
+#include "test_algorithm_common.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace violet::test
+{
+namespace
+{
+class timer
+{
+public:
+    void start() noexcept
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    double elapse() const noexcept
+    {
+        auto duration = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double>(duration).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+template <typename Key>
+std::vector<Key> make_keys(std::size_t count, Key max_key = std::numeric_limits<Key>::max())
+{
+    std::mt19937_64 engine(count);
+    std::uniform_int_distribution<Key> distribution(0, max_key);
+
+    std::vector<Key> keys(count);
+    for (Key& key : keys)
+    {
+        key = distribution(engine);
+    }
+    return keys;
+}
+
+template <typename Key>
+void check_key_value_sort(const std::vector<Key>& keys, task_executor* executor)
+{
+    std::vector<Key> sorted_keys = keys;
+    std::vector<std::uint32_t> values(keys.size());
+    std::iota(values.begin(), values.end(), 0);
+
+    std::vector<Key> key_scratch(keys.size());
+    std::vector<std::uint32_t> value_scratch(keys.size());
+
+    if (executor != nullptr)
+    {
+        radix_sort(*executor, sorted_keys, values, key_scratch, value_scratch);
+    }
+    else
+    {
+        radix_sort(sorted_keys, values, key_scratch, value_scratch);
+    }
+
+    std::vector<std::uint32_t> expected(keys.size());
+    std::iota(expected.begin(), expected.end(), 0);
+    std::ranges::stable_sort(
+        expected,
+        [&](std::uint32_t a, std::uint32_t b)
+        {
+            return keys[a] < keys[b];
+        });
+
+    CHECK(values == expected);
+    CHECK(std::ranges::is_sorted(sorted_keys));
+}
+} // namespace
+
+TEST_CASE("radix_sort keys", "[radix_sort]")
+{
+    for (std::size_t count : {0, 1, 2, 100, 5000})
+    {
+        auto keys_32 = make_keys<std::uint32_t>(count);
+        auto expected_32 = keys_32;
+        std::ranges::sort(expected_32);
+
+        std::vector<std::uint32_t> scratch_32(count);
+        radix_sort(keys_32, scratch_32);
+        CHECK(keys_32 == expected_32);
+
+        auto keys_64 = make_keys<std::uint64_t>(count);
+        auto expected_64 = keys_64;
+        std::ranges::sort(expected_64);
+
+        std::vector<std::uint64_t> scratch_64(count);
+        radix_sort(keys_64, scratch_64);
+        CHECK(keys_64 == expected_64);
+    }
+}
+
+TEST_CASE("radix_sort key value", "[radix_sort]")
+{
+    // Few distinct keys check stability, small keys skip most digits.
+    check_key_value_sort(make_keys<std::uint32_t>(5000, 15), nullptr);
+    check_key_value_sort(make_keys<std::uint32_t>(5000, 1000), nullptr);
+    check_key_value_sort(make_keys<std::uint64_t>(5000), nullptr);
+    check_key_value_sort(std::vector<std::uint64_t>(100, 7), nullptr);
+}
+
+TEST_CASE("radix_sort float key", "[radix_sort]")
+{
+    std::vector<float> values = {3.5f, -1.0f, 0.0f, -0.5f, 1e10f, -1e10f, 0.25f, -0.0f};
+
+    std::vector<std::uint32_t> keys;
+    for (float value : values)
+    {
+        keys.push_back(radix_sort_key(value));
+    }
+
+    std::vector<std::uint32_t> key_scratch(keys.size());
+    std::vector<float> value_scratch(keys.size());
+    radix_sort(keys, values, key_scratch, value_scratch);
+
+    CHECK(std::ranges::is_sorted(values));
+}
+
+TEST_CASE("radix_sort parallel", "[radix_sort]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    check_key_value_sort(make_keys<std::uint32_t>(300000, 255), &executor);
+    check_key_value_sort(make_keys<std::uint32_t>(300000), &executor);
+    check_key_value_sort(make_keys<std::uint64_t>(300000), &executor);
+
+    auto keys = make_keys<std::uint64_t>(200000);
+    auto expected = keys;
+    std::ranges::sort(expected);
+
+    std::vector<std::uint64_t> scratch(keys.size());
+    radix_sort(executor, keys, scratch);
+    CHECK(keys == expected);
+
+    executor.stop();
+}
+
+TEST_CASE("radix_sort throughput", "[benchmark]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    auto report = [](std::string_view name, std::size_t count, double seconds)
+    {
+        std::cout << name << " " << count << ": " << seconds * 1000.0 << "ms, "
+                  << seconds * 1e9 / static_cast<double>(count) << "ns/element" << std::endl;
+    };
+
+    timer timer;
+
+    for (std::size_t count : {1000, 10000, 100000, 1000000, 10000000})
+    {
+        const auto keys = make_keys<std::uint64_t>(count);
+        std::vector<std::uint64_t> sorted(count);
+        std::vector<std::uint64_t> scratch(count);
+
+        sorted = keys;
+        timer.start();
+        std::sort(sorted.begin(), sorted.end());
+        report("std::sort", count, timer.elapse());
+
+        sorted = keys;
+        timer.start();
+        radix_sort(sorted, scratch);
+        report("radix_sort", count, timer.elapse());
+
+        sorted = keys;
+        timer.start();
+        radix_sort(executor, sorted, scratch);
+        report("radix_sort parallel", count, timer.elapse());
+
+        std::vector<std::uint32_t> values(count);
+        std::vector<std::uint32_t> value_scratch(count);
+        std::iota(values.begin(), values.end(), 0);
+
+        sorted = keys;
+        timer.start();
+        radix_sort(executor, sorted, values, scratch, value_scratch);
+        report("radix_sort parallel key value", count, timer.elapse());
+    }
+
+    executor.stop();
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace violet::test
+{
+class timer
+{
+public:
+    void start() noexcept
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    double elapse() const noexcept
+    {
+        auto duration = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double>(duration).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+inline std::string_view get_compiler_name()
+{
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(_MSC_VER)
+    return "msvc";
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#else
+    return "unknown";
+#endif
+}
+
+/**
+ * @brief Collects benchmark results and writes them as JSON on exit, so results can be compared
+ * between compilers and releases.
+ */
+class benchmark_report
+{
+public:
+    struct metric
+    {
+        std::string name;
+        double value;
+    };
+
+    benchmark_report(
+        std::string path,
+        std::vector<std::pair<std::string, std::string>> properties = {})
+        : m_path(std::move(path)),
+          m_properties(std::move(properties))
+    {
+        m_properties.insert(m_properties.begin(), {"compiler", std::string(get_compiler_name())});
+    }
+
+    benchmark_report(const benchmark_report&) = delete;
+
+    ~benchmark_report()
+    {
+        if (m_results.empty())
+        {
+            return;
+        }
+
+        std::ofstream fout(m_path);
+        fout << "{\n";
+        for (const auto& [name, value] : m_properties)
+        {
+            fout << "    \"" << name << "\": \"" << value << "\",\n";
+        }
+
+        fout << "    \"benchmarks\": [";
+        for (std::size_t i = 0; i < m_results.size(); ++i)
+        {
+            const result& result = m_results[i];
+            fout << (i == 0 ? "\n" : ",\n") << "        {\"name\": \"" << result.name
+                 << "\", \"operations\": " << result.operation_count
+                 << ", \"time_ms\": " << result.seconds * 1000.0 << ", \"ns_per_op\": "
+                 << get_ns_per_operation(result);
+            for (const metric& metric : result.metrics)
+            {
+                fout << ", \"" << metric.name << "\": " << metric.value;
+            }
+            fout << "}";
+        }
+        fout << "\n    ]\n}\n";
+    }
+
+    void add(
+        std::string_view name,
+        std::size_t operation_count,
+        double seconds,
+        std::vector<metric> metrics = {})
+    {
+        m_results.push_back({
+            .name = std::string(name),
+            .operation_count = operation_count,
+            .seconds = seconds,
+            .metrics = std::move(metrics),
+        });
+
+        const result& result = m_results.back();
+        std::cout << result.name << ": " << result.seconds * 1000.0 << "ms, "
+                  << get_ns_per_operation(result) << "ns/op";
+        for (const metric& metric : result.metrics)
+        {
+            std::cout << ", " << metric.name << " " << metric.value;
+        }
+        std::cout << std::endl;
+    }
+
+    benchmark_report& operator=(const benchmark_report&) = delete;
+
+private:
+    struct result
+    {
+        std::string name;
+        std::size_t operation_count;
+        double seconds;
+        std::vector<metric> metrics;
+    };
+
+    static double get_ns_per_operation(const result& result) noexcept
+    {
+        return result.seconds * 1e9 / static_cast<double>(result.operation_count);
+    }
+
+    std::string m_path;
+    std::vector<std::pair<std::string, std::string>> m_properties;
+
+    std::vector<result> m_results;
+};
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,6 @@
+// #define CATCH_CONFIG_MAIN
+#include <catch2/catch_all.hpp>
+
+int main(int argc, char * argv[]) {
+    return Catch::Session().run( argc, argv );
+}
\ No newline at end of file
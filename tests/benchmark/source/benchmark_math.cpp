@@ -0,0 +1,791 @@
+#include "benchmark_common.hpp"
+#include "math/batch.hpp"
+#include "math/matrix.hpp"
+#include "math/quaternion.hpp"
+#include "math/sphere.hpp"
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace violet::test
+{
+namespace
+{
+constexpr std::size_t ELEMENT_COUNT = 1024;
+constexpr std::size_t REPEAT_COUNT = 200;
+
+/**
+ * @brief Error of float results against a double precision reference, in units in the last place.
+ * The unit is taken from the largest component of the reference, so components that should be 0
+ * do not report an unbounded error.
+ */
+class ulp_error
+{
+public:
+    template <typename T, std::size_t N>
+    void add(const T& value, const std::array<double, N>& reference)
+    {
+        double scale = 0.0;
+        for (double r : reference)
+        {
+            scale = std::max(scale, std::abs(r));
+        }
+
+        float magnitude = static_cast<float>(std::max(scale, 1e-30));
+        double ulp = std::nextafter(magnitude, std::numeric_limits<float>::max()) - magnitude;
+
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            double error = std::abs(static_cast<double>(value[i]) - reference[i]) / ulp;
+            m_max = std::max(m_max, error);
+            m_sum += error;
+            ++m_count;
+        }
+    }
+
+    double get_max() const noexcept
+    {
+        return m_max;
+    }
+
+    double get_mean() const noexcept
+    {
+        return m_count == 0 ? 0.0 : m_sum / static_cast<double>(m_count);
+    }
+
+private:
+    double m_max{0.0};
+    double m_sum{0.0};
+    std::size_t m_count{0};
+};
+
+std::string_view get_simd_level_name(simd_level level)
+{
+    switch (level)
+    {
+    case SIMD_LEVEL_AVX2:
+        return "avx2";
+    case SIMD_LEVEL_AVX512:
+        return "avx512";
+    default:
+        return "sse";
+    }
+}
+
+void report(std::string_view name, double seconds, const ulp_error& error)
+{
+    static benchmark_report report(
+        "math_benchmark.json",
+        {{"simd_level", std::string(get_simd_level_name(batch::get_simd_level()))}});
+
+    report.add(
+        name,
+        ELEMENT_COUNT * REPEAT_COUNT,
+        seconds,
+        {
+            {"max_ulp", error.get_max()},
+            {"mean_ulp", error.get_mean()},
+        });
+}
+
+template <typename Functor>
+double measure(Functor&& functor)
+{
+    // Warm up, so page faults of the outputs are not measured.
+    functor();
+
+    timer timer;
+    timer.start();
+    for (std::size_t i = 0; i < REPEAT_COUNT; ++i)
+    {
+        functor();
+    }
+    return timer.elapse();
+}
+
+// Double precision references, written out where the library templates compute in float.
+namespace reference
+{
+using vec3d = std::array<double, 3>;
+using vec4d = std::array<double, 4>;
+using mat4d = std::array<double, 16>;
+
+vec3d load(const vec3f& v)
+{
+    return {v.x, v.y, v.z};
+}
+
+vec4d load(const vec4f& v)
+{
+    return {v.x, v.y, v.z, v.w};
+}
+
+mat4d load(const mat4f& m)
+{
+    mat4d result;
+    for (std::size_t i = 0; i < 16; ++i)
+    {
+        result[i] = m[i / 4][i % 4];
+    }
+    return result;
+}
+
+mat4d mul(const mat4d& a, const mat4d& b)
+{
+    mat4d result = {};
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        for (std::size_t j = 0; j < 4; ++j)
+        {
+            for (std::size_t k = 0; k < 4; ++k)
+            {
+                result[i * 4 + j] += a[i * 4 + k] * b[k * 4 + j];
+            }
+        }
+    }
+    return result;
+}
+
+mat4d inverse(const mat4d& m)
+{
+    mat4<double> md;
+    for (std::size_t i = 0; i < 16; ++i)
+    {
+        md[i / 4][i % 4] = m[i];
+    }
+
+    mat4<double> inverse = matrix::inverse(md);
+
+    mat4d result;
+    for (std::size_t i = 0; i < 16; ++i)
+    {
+        result[i] = inverse[i / 4][i % 4];
+    }
+    return result;
+}
+
+mat4d affine_transform(const vec3d& s, const vec4d& q, const vec3d& t)
+{
+    double xx = 2.0 * q[0] * q[0];
+    double xy = 2.0 * q[0] * q[1];
+    double xz = 2.0 * q[0] * q[2];
+    double xw = 2.0 * q[0] * q[3];
+    double yy = 2.0 * q[1] * q[1];
+    double yz = 2.0 * q[1] * q[2];
+    double yw = 2.0 * q[1] * q[3];
+    double zz = 2.0 * q[2] * q[2];
+    double zw = 2.0 * q[2] * q[3];
+
+    return {
+        s[0] * (1.0 - yy - zz),
+        s[0] * (xy + zw),
+        s[0] * (xz - yw),
+        0.0,
+        s[1] * (xy - zw),
+        s[1] * (1.0 - xx - zz),
+        s[1] * (yz + xw),
+        0.0,
+        s[2] * (xz + yw),
+        s[2] * (yz - xw),
+        s[2] * (1.0 - xx - yy),
+        0.0,
+        t[0],
+        t[1],
+        t[2],
+        1.0,
+    };
+}
+
+vec4d quaternion_mul(const vec4d& a, const vec4d& b)
+{
+    return {
+        a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+        a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+        a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+        a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2],
+    };
+}
+
+vec4d quaternion_slerp(const vec4d& a, vec4d b, double t)
+{
+    double cos_omega = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    if (cos_omega < 0.0)
+    {
+        for (double& v : b)
+        {
+            v = -v;
+        }
+        cos_omega = -cos_omega;
+    }
+
+    double k0 = 1.0 - t;
+    double k1 = t;
+    if (cos_omega < 1.0)
+    {
+        double omega = std::acos(cos_omega);
+        double sin_omega = std::sin(omega);
+        k0 = std::sin((1.0 - t) * omega) / sin_omega;
+        k1 = std::sin(t * omega) / sin_omega;
+    }
+
+    return {
+        a[0] * k0 + b[0] * k1,
+        a[1] * k0 + b[1] * k1,
+        a[2] * k0 + b[2] * k1,
+        a[3] * k0 + b[3] * k1,
+    };
+}
+
+vec4d quaternion_from_euler(const vec3d& euler)
+{
+    double p_sin = std::sin(euler[0] * 0.5);
+    double p_cos = std::cos(euler[0] * 0.5);
+    double h_sin = std::sin(euler[1] * 0.5);
+    double h_cos = std::cos(euler[1] * 0.5);
+    double b_sin = std::sin(euler[2] * 0.5);
+    double b_cos = std::cos(euler[2] * 0.5);
+
+    return {
+        h_cos * p_sin * b_cos + h_sin * p_cos * b_sin,
+        h_sin * p_cos * b_cos - h_cos * p_sin * b_sin,
+        h_cos * p_cos * b_sin - h_sin * p_sin * b_cos,
+        h_cos * p_cos * b_cos + h_sin * p_sin * b_sin,
+    };
+}
+
+// Same steps as sphere::create.
+vec4d sphere_create(std::span<const vec3f> points)
+{
+    auto distance_sq = [](const vec3d& a, const vec3d& b)
+    {
+        return (a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) +
+               (a[2] - b[2]) * (a[2] - b[2]);
+    };
+
+    std::size_t min_index[3] = {0, 0, 0};
+    std::size_t max_index[3] = {0, 0, 0};
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        for (std::size_t j = 0; j < 3; ++j)
+        {
+            min_index[j] = points[i][j] < points[min_index[j]][j] ? i : min_index[j];
+            max_index[j] = points[i][j] > points[max_index[j]][j] ? i : max_index[j];
+        }
+    }
+
+    double largest_distance_sq = 0.0;
+    std::size_t largest_axis = 0;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        double d = distance_sq(load(points[min_index[i]]), load(points[max_index[i]]));
+        if (d > largest_distance_sq)
+        {
+            largest_distance_sq = d;
+            largest_axis = i;
+        }
+    }
+
+    vec3d min_point = load(points[min_index[largest_axis]]);
+    vec3d max_point = load(points[max_index[largest_axis]]);
+    vec3d center = {
+        (min_point[0] + max_point[0]) * 0.5,
+        (min_point[1] + max_point[1]) * 0.5,
+        (min_point[2] + max_point[2]) * 0.5,
+    };
+    double radius = std::sqrt(largest_distance_sq) * 0.5;
+
+    for (const vec3f& point : points)
+    {
+        vec3d p = load(point);
+        double d = std::sqrt(distance_sq(p, center));
+        if (d <= radius)
+        {
+            continue;
+        }
+
+        double new_radius = (d + radius) * 0.5;
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            center[i] += (p[i] - center[i]) / d * (new_radius - radius);
+        }
+        radius = new_radius;
+    }
+
+    return {center[0], center[1], center[2], radius};
+}
+} // namespace reference
+
+class benchmark_data
+{
+public:
+    benchmark_data()
+    {
+        std::mt19937 engine(11);
+        std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> scale(0.1f, 10.0f);
+        std::uniform_real_distribution<float> angle(-math::PI, math::PI);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            euler.push_back({angle(engine), angle(engine), angle(engine)});
+            scales.push_back({scale(engine), scale(engine), scale(engine)});
+            translations.push_back({position(engine), position(engine), position(engine)});
+            points.push_back({position(engine), position(engine), position(engine)});
+            factors.push_back(unit(engine));
+        }
+
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            rotations.push_back(quaternion::from_euler(euler[i]));
+            matrices.push_back(
+                matrix::affine_transform(scales[i], rotations[i], translations[i]));
+        }
+    }
+
+    std::vector<vec3f> euler;
+    std::vector<vec3f> scales;
+    std::vector<vec4f> rotations;
+    std::vector<vec3f> translations;
+    std::vector<vec3f> points;
+    std::vector<float> factors;
+
+    std::vector<mat4f> matrices;
+};
+
+const benchmark_data& get_data()
+{
+    static benchmark_data data;
+    return data;
+}
+
+template <typename P, typename T>
+std::vector<P> make_packs(const std::vector<T>& values)
+{
+    std::vector<P> packs(values.size() / BATCH_WIDTH);
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        batch::set(packs[i / BATCH_WIDTH], i % BATCH_WIDTH, values[i]);
+    }
+    return packs;
+}
+
+template <typename P>
+auto get(const std::vector<P>& packs, std::size_t index)
+{
+    return batch::get(packs[index / BATCH_WIDTH], index % BATCH_WIDTH);
+}
+} // namespace
+
+TEST_CASE("matrix benchmark", "[math]")
+{
+    const benchmark_data& data = get_data();
+    std::vector<mat4f> result(ELEMENT_COUNT);
+
+    auto next = [](std::size_t i)
+    {
+        return (i + 1) % ELEMENT_COUNT;
+    };
+
+    {
+        double seconds = measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    result[i] = matrix::mul(data.matrices[i], data.matrices[next(i)]);
+                }
+            });
+
+        ulp_error error;
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            auto a = reference::load(data.matrices[i]);
+            auto b = reference::load(data.matrices[next(i)]);
+            error.add(reference::load(result[i]), reference::mul(a, b));
+        }
+        report("matrix::mul", seconds, error);
+    }
+
+    {
+        double seconds = measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    mat4f_simd a = math::load(data.matrices[i]);
+                    mat4f_simd b = math::load(data.matrices[next(i)]);
+                    math::store(matrix::mul(a, b), result[i]);
+                }
+            });
+
+        ulp_error error;
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            auto a = reference::load(data.matrices[i]);
+            auto b = reference::load(data.matrices[next(i)]);
+            error.add(reference::load(result[i]), reference::mul(a, b));
+        }
+        report("matrix::mul simd", seconds, error);
+    }
+
+    {
+        double seconds = measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    result[i] = matrix::inverse(data.matrices[i]);
+                }
+            });
+
+        ulp_error error;
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            auto m = reference::load(data.matrices[i]);
+            error.add(reference::load(result[i]), reference::inverse(m));
+        }
+        report("matrix::inverse", seconds, error);
+    }
+
+    {
+        double seconds = measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    math::store(matrix::inverse(math::load(data.matrices[i])), result[i]);
+                }
+            });
+
+        ulp_error error;
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            auto m = reference::load(data.matrices[i]);
+            error.add(reference::load(result[i]), reference::inverse(m));
+        }
+        report("matrix::inverse simd", seconds, error);
+    }
+
+    auto check_affine_transform = [&](std::string_view name, double seconds)
+    {
+        ulp_error error;
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            auto m = reference::affine_transform(
+                reference::load(data.scales[i]),
+                reference::load(data.rotations[i]),
+                reference::load(data.translations[i]));
+            error.add(reference::load(result[i]), m);
+        }
+        report(name, seconds, error);
+    };
+
+    check_affine_transform(
+        "matrix::affine_transform",
+        measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    result[i] = matrix::affine_transform(
+                        data.scales[i],
+                        data.rotations[i],
+                        data.translations[i]);
+                }
+            }));
+
+    check_affine_transform(
+        "matrix::affine_transform simd",
+        measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    mat4f_simd m = matrix::affine_transform(
+                        math::load(data.scales[i]),
+                        math::load(data.rotations[i]),
+                        math::load(data.translations[i]));
+                    math::store(m, result[i]);
+                }
+            }));
+}
+
+TEST_CASE("quaternion benchmark", "[math]")
+{
+    const benchmark_data& data = get_data();
+    std::vector<vec4f> result(ELEMENT_COUNT);
+
+    auto next = [](std::size_t i)
+    {
+        return (i + 1) % ELEMENT_COUNT;
+    };
+
+    auto check_mul = [&](std::string_view name, double seconds)
+    {
+        ulp_error error;
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            auto a = reference::load(data.rotations[i]);
+            auto b = reference::load(data.rotations[next(i)]);
+            error.add(result[i], reference::quaternion_mul(a, b));
+        }
+        report(name, seconds, error);
+    };
+
+    check_mul(
+        "quaternion::mul",
+        measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    result[i] = quaternion::mul(data.rotations[i], data.rotations[next(i)]);
+                }
+            }));
+
+    check_mul(
+        "quaternion::mul simd",
+        measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    vec4f_simd a = math::load(data.rotations[i]);
+                    vec4f_simd b = math::load(data.rotations[next(i)]);
+                    math::store(quaternion::mul(a, b), result[i]);
+                }
+            }));
+
+    auto check_slerp = [&](std::string_view name, double seconds)
+    {
+        ulp_error error;
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            auto a = reference::load(data.rotations[i]);
+            auto b = reference::load(data.rotations[next(i)]);
+            error.add(result[i], reference::quaternion_slerp(a, b, data.factors[i]));
+        }
+        report(name, seconds, error);
+    };
+
+    check_slerp(
+        "quaternion::slerp",
+        measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    result[i] = quaternion::slerp(
+                        data.rotations[i],
+                        data.rotations[next(i)],
+                        data.factors[i]);
+                }
+            }));
+
+    check_slerp(
+        "quaternion::slerp simd",
+        measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    vec4f_simd a = math::load(data.rotations[i]);
+                    vec4f_simd b = math::load(data.rotations[next(i)]);
+                    math::store(quaternion::slerp(a, b, data.factors[i]), result[i]);
+                }
+            }));
+
+    auto check_from_euler = [&](std::string_view name, double seconds)
+    {
+        ulp_error error;
+        for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            error.add(result[i], reference::quaternion_from_euler(reference::load(data.euler[i])));
+        }
+        report(name, seconds, error);
+    };
+
+    check_from_euler(
+        "quaternion::from_euler",
+        measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    result[i] = quaternion::from_euler(data.euler[i]);
+                }
+            }));
+
+    check_from_euler(
+        "quaternion::from_euler simd",
+        measure(
+            [&]()
+            {
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    vec4f_simd euler = math::load(data.euler[i]);
+                    math::store(quaternion::from_euler(euler), result[i]);
+                }
+            }));
+}
+
+TEST_CASE("sphere benchmark", "[math]")
+{
+    static constexpr std::size_t point_count = 64;
+
+    const benchmark_data& data = get_data();
+    std::span<const vec3f> points = data.points;
+
+    std::vector<sphere3f> result(ELEMENT_COUNT);
+    double seconds = measure(
+        [&]()
+        {
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                std::size_t offset = i % (points.size() - point_count);
+                result[i] = sphere::create(points.subspan(offset, point_count));
+            }
+        });
+
+    ulp_error error;
+    for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        std::size_t offset = i % (points.size() - point_count);
+        error.add(
+            vec4f(result[i]),
+            reference::sphere_create(points.subspan(offset, point_count)));
+    }
+    report("sphere::create 64 points", seconds, error);
+}
+
+TEST_CASE("batch benchmark", "[math]")
+{
+    const benchmark_data& data = get_data();
+
+    auto a = make_packs<mat4f_x8>(data.matrices);
+    auto scales = make_packs<vec3f_x8>(data.scales);
+    auto rotations = make_packs<vec4f_x8>(data.rotations);
+    auto translations = make_packs<vec3f_x8>(data.translations);
+
+    // Shifted by one pack, so every lane multiplies two different matrices.
+    std::vector<mat4f_x8> b(a.begin() + 1, a.end());
+    b.push_back(a.front());
+
+    std::vector<vec4f_x8> c(rotations.begin() + 1, rotations.end());
+    c.push_back(rotations.front());
+
+    auto next = [](std::size_t i)
+    {
+        return (i + BATCH_WIDTH) % ELEMENT_COUNT;
+    };
+
+    std::vector<mat4f_x8> matrix_result(a.size());
+    std::vector<vec4f_x8> quaternion_result(a.size());
+
+    simd_level supported = batch::get_simd_level();
+    for (simd_level level : {SIMD_LEVEL_SSE, SIMD_LEVEL_AVX2, SIMD_LEVEL_AVX512})
+    {
+        if (level > supported)
+        {
+            break;
+        }
+        batch::set_simd_level(level);
+
+        std::string suffix = " " + std::string(get_simd_level_name(level));
+
+        {
+            double seconds = measure(
+                [&]()
+                {
+                    batch::mul(a, b, matrix_result);
+                });
+
+            ulp_error error;
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                auto ma = reference::load(data.matrices[i]);
+                auto mb = reference::load(data.matrices[next(i)]);
+                error.add(reference::load(get(matrix_result, i)), reference::mul(ma, mb));
+            }
+            report("batch::mul" + suffix, seconds, error);
+        }
+
+        {
+            double seconds = measure(
+                [&]()
+                {
+                    batch::inverse(a, matrix_result);
+                });
+
+            ulp_error error;
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                auto m = reference::load(data.matrices[i]);
+                error.add(reference::load(get(matrix_result, i)), reference::inverse(m));
+            }
+            report("batch::inverse" + suffix, seconds, error);
+        }
+
+        {
+            double seconds = measure(
+                [&]()
+                {
+                    batch::affine_transform(scales, rotations, translations, matrix_result);
+                });
+
+            ulp_error error;
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                auto m = reference::affine_transform(
+                    reference::load(data.scales[i]),
+                    reference::load(data.rotations[i]),
+                    reference::load(data.translations[i]));
+                error.add(reference::load(get(matrix_result, i)), m);
+            }
+            report("batch::affine_transform" + suffix, seconds, error);
+        }
+
+        {
+            double seconds = measure(
+                [&]()
+                {
+                    batch::quaternion_mul(rotations, c, quaternion_result);
+                });
+
+            ulp_error error;
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                auto qa = reference::load(data.rotations[i]);
+                auto qb = reference::load(data.rotations[next(i)]);
+                error.add(get(quaternion_result, i), reference::quaternion_mul(qa, qb));
+            }
+            report("batch::quaternion_mul" + suffix, seconds, error);
+        }
+
+        {
+            static constexpr float t = 0.3f;
+
+            double seconds = measure(
+                [&]()
+                {
+                    batch::quaternion_slerp(rotations, c, t, quaternion_result);
+                });
+
+            ulp_error error;
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                auto qa = reference::load(data.rotations[i]);
+                auto qb = reference::load(data.rotations[next(i)]);
+                error.add(get(quaternion_result, i), reference::quaternion_slerp(qa, qb, t));
+            }
+            report("batch::quaternion_slerp" + suffix, seconds, error);
+        }
+    }
+    batch::set_simd_level(supported);
+}
+} // namespace violet::test
\ No newline at end of file
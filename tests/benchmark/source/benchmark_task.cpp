@@ -0,0 +1,268 @@
+#include "benchmark_common.hpp"
+#include "task/task_executor.hpp"
+#include <string_view>
+
+namespace violet::test
+{
+namespace
+{
+constexpr std::size_t NUM_THREAD = 4;
+constexpr std::size_t NUM_DATA_PER_THREAD = 10000;
+
+benchmark_report& get_report()
+{
+    static benchmark_report report("task_benchmark.json");
+    return report;
+}
+
+void run_graph(std::string_view name, task_graph& graph, std::size_t task_count)
+{
+    static constexpr std::size_t frame_count = 100;
+
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    // Warm up, so allocations and compilation are not measured.
+    executor.execute_sync(graph);
+
+    timer timer;
+    timer.start();
+    for (std::size_t i = 0; i < frame_count; ++i)
+    {
+        executor.execute_sync(graph);
+    }
+    get_report().add(name, task_count * frame_count, timer.elapse());
+
+    executor.stop();
+}
+
+template <typename Queue>
+void run_queue(std::string_view name)
+{
+    static constexpr std::size_t producer_count = 2;
+    static constexpr std::size_t consumer_count = 2;
+    static constexpr std::size_t item_count = NUM_DATA_PER_THREAD * 20;
+
+    Queue queue;
+    std::atomic<std::size_t> consumed{0};
+
+    timer timer;
+    timer.start();
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < producer_count; ++i)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                for (std::size_t j = 0; j < item_count; ++j)
+                {
+                    queue.push(j);
+                }
+            });
+    }
+
+    for (std::size_t i = 0; i < consumer_count; ++i)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                std::size_t value = 0;
+                while (consumed < producer_count * item_count)
+                {
+                    if (queue.pop(value) && ++consumed == producer_count * item_count)
+                    {
+                        if constexpr (requires { queue.close(); })
+                        {
+                            queue.close();
+                        }
+                    }
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    get_report().add(name, producer_count * item_count, timer.elapse());
+}
+} // namespace
+
+TEST_CASE("Task throughput", "[task]")
+{
+    static constexpr std::size_t task_count = 10000;
+
+    std::atomic<std::size_t> counter{0};
+
+    task_graph graph;
+    for (std::size_t i = 0; i < task_count; ++i)
+    {
+        graph.add_task().set_execute(
+            [&counter]()
+            {
+                counter.fetch_add(1, std::memory_order_relaxed);
+            });
+    }
+
+    run_graph("Independent tasks", graph, task_count);
+}
+
+TEST_CASE("Fan-out and fan-in", "[task]")
+{
+    static constexpr std::size_t task_count = 1000;
+
+    std::atomic<std::size_t> counter{0};
+
+    task_graph graph;
+    task& root = graph.add_task().set_execute(
+        [&counter]()
+        {
+            counter = 0;
+        });
+    task& sink = graph.add_task().set_execute(
+        [&counter]()
+        {
+            CHECK(counter == task_count);
+        });
+
+    for (std::size_t i = 0; i < task_count; ++i)
+    {
+        task& middle = graph.add_task()
+                           .set_execute(
+                               [&counter]()
+                               {
+                                   counter.fetch_add(1, std::memory_order_relaxed);
+                               })
+                           .add_dependency(root);
+        sink.add_dependency(middle);
+    }
+
+    run_graph("Fan-out and fan-in", graph, task_count + 2);
+}
+
+TEST_CASE("Long chain", "[task]")
+{
+    static constexpr std::size_t task_count = 1000;
+
+    std::size_t counter = 0;
+
+    task_graph graph;
+    task* prev = nullptr;
+    for (std::size_t i = 0; i < task_count; ++i)
+    {
+        task& current = graph.add_task().set_execute(
+            [&counter]()
+            {
+                ++counter;
+            });
+        if (prev != nullptr)
+        {
+            current.add_dependency(*prev);
+        }
+        prev = &current;
+    }
+
+    run_graph("Long chain", graph, task_count);
+}
+
+TEST_CASE("Main thread task latency", "[task]")
+{
+    static constexpr std::size_t task_count = 1000;
+    static constexpr std::size_t frame_count = 10;
+
+    // Alternate between workers and the main thread, so every main thread task is enqueued by a
+    // worker while the main thread waits for it.
+    task_graph graph;
+    task* prev = nullptr;
+    for (std::size_t i = 0; i < task_count; ++i)
+    {
+        task& current = graph.add_task().set_execute([]() {});
+        if (i % 2 == 1)
+        {
+            current.set_options(TASK_OPTION_MAIN_THREAD);
+        }
+        if (prev != nullptr)
+        {
+            current.add_dependency(*prev);
+        }
+        prev = &current;
+    }
+
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    profiler::set_enabled(true);
+
+    std::uint32_t first_frame = profiler::get_frame() + 1;
+    for (std::size_t i = 0; i < frame_count; ++i)
+    {
+        profiler::begin_frame(profiler::now());
+        executor.execute_sync(graph);
+    }
+
+    // Main thread tasks run on this thread, unnamed tasks are recorded as "Task" zones.
+    double latency = 0.0;
+    std::size_t main_thread_task_count = 0;
+    for (const auto& zone : profiler::get_zones(first_frame, profiler::get_frame(), true))
+    {
+        if (std::string_view(zone.name) == "Task")
+        {
+            latency += static_cast<double>(zone.begin_time - zone.enqueue_time) * 1e-9;
+            ++main_thread_task_count;
+        }
+    }
+
+    profiler::set_enabled(false);
+    executor.stop();
+
+    CHECK(main_thread_task_count == task_count / 2 * frame_count);
+    get_report().add("Main thread task latency", main_thread_task_count, latency);
+}
+
+TEST_CASE("Coroutine scheduling", "[task]")
+{
+    static constexpr std::size_t coroutine_count = 1000;
+    static constexpr std::size_t schedule_count = 100;
+
+    auto hop = [](task_executor& executor) -> async_task<void>
+    {
+        for (std::size_t i = 0; i < schedule_count; ++i)
+        {
+            co_await executor.schedule();
+        }
+    };
+
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    timer timer;
+    timer.start();
+
+    std::vector<std::future<void>> futures;
+    for (std::size_t i = 0; i < coroutine_count; ++i)
+    {
+        futures.push_back(executor.execute(hop(executor)));
+    }
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+
+    get_report().add(
+        "Coroutine scheduling",
+        coroutine_count * schedule_count,
+        timer.elapse());
+
+    executor.stop();
+}
+
+TEST_CASE("Task queues", "[task]")
+{
+    run_queue<lock_free_queue<std::size_t>>("lock_free_queue");
+    run_queue<task_queue_lock_free<std::size_t>>("task_queue_lock_free");
+    run_queue<task_queue_thread_safe<std::size_t>>("task_queue_thread_safe");
+    run_queue<task_priority_queue_thread_safe<std::size_t>>("task_priority_queue_thread_safe");
+}
+} // namespace violet::test
\ No newline at end of file
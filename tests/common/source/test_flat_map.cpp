@@ -0,0 +1,379 @@
+#include "common/container.hpp"
+#include "common/flat_map.hpp"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace violet::test
+{
+namespace
+{
+class timer
+{
+public:
+    void start() noexcept
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    double elapse() const noexcept
+    {
+        auto duration = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double>(duration).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+struct position
+{
+    float x;
+    float y;
+    float z;
+
+    bool operator==(const position& other) const noexcept = default;
+};
+
+struct position_hash
+{
+    std::size_t operator()(const position& p) const noexcept
+    {
+        std::hash<float> hasher;
+        return hasher(p.x) ^ (hasher(p.y) << 1) ^ (hasher(p.z) << 2);
+    }
+};
+} // namespace
+
+TEST_CASE("flat_map matches std::unordered_map", "[flat_map]")
+{
+    std::mt19937 engine(1);
+
+    flat_map<std::uint32_t, std::uint32_t> map;
+    std::unordered_map<std::uint32_t, std::uint32_t> expected;
+
+    for (std::uint32_t i = 0; i < 100000; ++i)
+    {
+        std::uint32_t key = engine() % 5000;
+        switch (engine() % 4)
+        {
+        case 0:
+            map[key] = i;
+            expected[key] = i;
+            break;
+        case 1:
+            CHECK(map.erase(key) == expected.erase(key));
+            break;
+        case 2:
+            map.insert({key, i});
+            expected.insert({key, i});
+            break;
+        default: {
+            auto iter = map.find(key);
+            auto expected_iter = expected.find(key);
+            REQUIRE((iter == map.end()) == (expected_iter == expected.end()));
+            if (iter != map.end())
+            {
+                CHECK(iter->second == expected_iter->second);
+            }
+            break;
+        }
+        }
+    }
+
+    REQUIRE(map.size() == expected.size());
+
+    std::size_t count = 0;
+    for (const auto& [key, value] : map)
+    {
+        CHECK(expected.at(key) == value);
+        ++count;
+    }
+    CHECK(count == expected.size());
+
+    auto copy = map;
+    CHECK(copy.size() == map.size());
+
+    map.clear();
+    CHECK(map.empty());
+    CHECK(map.begin() == map.end());
+    CHECK(copy.size() == expected.size());
+}
+
+TEST_CASE("flat_map move only values", "[flat_map]")
+{
+    flat_map<int, std::unique_ptr<int>> map;
+    for (int i = 0; i < 100; ++i)
+    {
+        map[i] = std::make_unique<int>(i);
+    }
+
+    map.erase(50);
+
+    auto moved = std::move(map);
+    CHECK(map.empty());
+    CHECK(moved.size() == 99);
+    CHECK(!moved.contains(50));
+    CHECK(*moved[99] == 99);
+}
+
+TEST_CASE("flat_map at", "[flat_map]")
+{
+    flat_map<int, int> map = {{1, 2}};
+    const auto& const_map = map;
+
+    CHECK(map.at(1) == 2);
+    CHECK(const_map.at(1) == 2);
+    CHECK_THROWS_AS(map.at(3), std::out_of_range);
+    CHECK_THROWS_AS(const_map.at(3), std::out_of_range);
+}
+
+TEST_CASE("flat_multimap equal_range", "[flat_map]")
+{
+    std::mt19937 engine(2);
+
+    flat_multimap<position, std::uint32_t, position_hash> map;
+    std::unordered_multimap<position, std::uint32_t, position_hash> expected;
+
+    for (std::uint32_t i = 0; i < 50000; ++i)
+    {
+        position key = {static_cast<float>(engine() % 300), 1.0f, 2.0f};
+        switch (engine() % 4)
+        {
+        case 0:
+        case 1:
+            map.insert({key, i});
+            expected.insert({key, i});
+            break;
+        case 2:
+            CHECK(map.erase(key) == expected.erase(key));
+            break;
+        default: {
+            std::multiset<std::uint32_t> values;
+            for (const auto& [_, value] : map.equal_range(key))
+            {
+                values.insert(value);
+            }
+
+            std::multiset<std::uint32_t> expected_values;
+            auto range = expected.equal_range(key);
+            for (auto iter = range.first; iter != range.second; ++iter)
+            {
+                expected_values.insert(iter->second);
+            }
+
+            CHECK(values == expected_values);
+            break;
+        }
+        }
+    }
+
+    CHECK(map.size() == expected.size());
+
+    // Erase single values through a key iterator.
+    position key = {0.0f, 0.0f, 0.0f};
+    for (std::uint32_t i = 0; i < 10; ++i)
+    {
+        map.insert({key, i});
+    }
+
+    auto range = map.equal_range(key);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        if (iter->second == 5)
+        {
+            map.erase(iter);
+            break;
+        }
+    }
+    CHECK(map.count(key) == 9);
+}
+
+TEST_CASE("flat_map heterogeneous lookup", "[flat_map]")
+{
+    string_map<int> map;
+    map.insert_or_assign(std::string("position"), 0);
+    map["normal"] = 1;
+    map.insert_or_assign(std::string("position"), 2);
+
+    std::string_view name = "normal";
+    CHECK(map.find(name)->second == 1);
+    CHECK(map.find(std::string_view("position"))->second == 2);
+    CHECK(map.contains(std::string_view("position")));
+    CHECK(!map.contains(std::string_view("color")));
+
+    CHECK(map.erase(name) == 1);
+    CHECK(map.size() == 1);
+}
+
+TEST_CASE("flat_set", "[flat_map]")
+{
+    flat_set<int> set = {1, 2, 3};
+    CHECK(!set.insert(2).second);
+    CHECK(set.insert(4).second);
+    CHECK(set.size() == 4);
+    CHECK(set.contains(4));
+    CHECK(set.erase(1) == 1);
+    CHECK(!set.contains(1));
+}
+
+TEST_CASE("flat_map benchmark", "[benchmark]")
+{
+    static constexpr std::size_t REPEAT_COUNT = 10;
+
+    auto report = [](std::string_view name, double flat_time, double std_time)
+    {
+        std::cout << name << ": flat " << flat_time * 1000.0 << "ms, std "
+                  << std_time * 1000.0 << "ms, speedup " << std_time / flat_time << std::endl;
+    };
+
+    timer timer;
+
+    // Pointer keys, as in gpu_buffer_uploader and task_graph.
+    {
+        std::vector<std::unique_ptr<int>> objects(10000);
+        for (auto& object : objects)
+        {
+            object = std::make_unique<int>();
+        }
+
+        std::size_t flat_sum = 0;
+        timer.start();
+        for (std::size_t i = 0; i < REPEAT_COUNT; ++i)
+        {
+            flat_map<int*, std::size_t> map;
+            for (std::size_t j = 0; j < objects.size() * 4; ++j)
+            {
+                ++map[objects[(j * 7919) % objects.size()].get()];
+            }
+            for (const auto& object : objects)
+            {
+                flat_sum += map.find(object.get())->second;
+            }
+        }
+        double flat_time = timer.elapse();
+
+        std::size_t std_sum = 0;
+        timer.start();
+        for (std::size_t i = 0; i < REPEAT_COUNT; ++i)
+        {
+            std::unordered_map<int*, std::size_t> map;
+            for (std::size_t j = 0; j < objects.size() * 4; ++j)
+            {
+                ++map[objects[(j * 7919) % objects.size()].get()];
+            }
+            for (const auto& object : objects)
+            {
+                std_sum += map.find(object.get())->second;
+            }
+        }
+        double std_time = timer.elapse();
+
+        CHECK(flat_sum == std_sum);
+        report("pointer map", flat_time, std_time);
+    }
+
+    // Half-edge positions with duplicates, as in cluster_builder and mesh_simplifier.
+    {
+        std::mt19937 engine(3);
+        std::vector<position> positions(100000);
+        for (auto& p : positions)
+        {
+            p = {static_cast<float>(engine() % 20000), 0.5f, static_cast<float>(engine() % 4)};
+        }
+
+        std::size_t flat_count = 0;
+        timer.start();
+        for (std::size_t i = 0; i < REPEAT_COUNT; ++i)
+        {
+            flat_multimap<position, std::uint32_t, position_hash> map;
+            map.reserve(positions.size());
+            for (std::uint32_t j = 0; j < positions.size(); ++j)
+            {
+                map.insert({positions[j], j});
+            }
+            for (const auto& p : positions)
+            {
+                auto range = map.equal_range(p);
+                for (auto iter = range.first; iter != range.second; ++iter)
+                {
+                    ++flat_count;
+                }
+            }
+        }
+        double flat_time = timer.elapse();
+
+        std::size_t std_count = 0;
+        timer.start();
+        for (std::size_t i = 0; i < REPEAT_COUNT; ++i)
+        {
+            std::unordered_multimap<position, std::uint32_t, position_hash> map;
+            map.reserve(positions.size());
+            for (std::uint32_t j = 0; j < positions.size(); ++j)
+            {
+                map.insert({positions[j], j});
+            }
+            for (const auto& p : positions)
+            {
+                auto range = map.equal_range(p);
+                for (auto iter = range.first; iter != range.second; ++iter)
+                {
+                    ++std_count;
+                }
+            }
+        }
+        double std_time = timer.elapse();
+
+        CHECK(flat_count == std_count);
+        report("position multimap", flat_time, std_time);
+    }
+
+    // Name lookup through string_view, as in geometry.
+    {
+        std::vector<std::string> names;
+        for (std::size_t i = 0; i < 1000; ++i)
+        {
+            names.push_back("attribute_" + std::to_string(i));
+        }
+
+        string_map<std::size_t> flat_names;
+        std::unordered_map<std::string, std::size_t> std_names;
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            flat_names[names[i]] = i;
+            std_names[names[i]] = i;
+        }
+
+        std::size_t flat_sum = 0;
+        timer.start();
+        for (std::size_t i = 0; i < REPEAT_COUNT * 100; ++i)
+        {
+            for (const auto& name : names)
+            {
+                flat_sum += flat_names.find(std::string_view(name))->second;
+            }
+        }
+        double flat_time = timer.elapse();
+
+        std::size_t std_sum = 0;
+        timer.start();
+        for (std::size_t i = 0; i < REPEAT_COUNT * 100; ++i)
+        {
+            for (const auto& name : names)
+            {
+                std_sum += std_names.find(name)->second;
+            }
+        }
+        double std_time = timer.elapse();
+
+        CHECK(flat_sum == std_sum);
+        report("string map", flat_time, std_time);
+    }
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "common/frame_allocator.hpp"
+#include <catch2/catch_all.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace violet::test
+{
+TEST_CASE("linear_arena", "[frame_allocator]")
+{
+    linear_arena arena(1024);
+
+    auto* a = static_cast<std::uint8_t*>(arena.allocate(3, 1));
+    auto* b = arena.allocate(16, 16);
+    CHECK(reinterpret_cast<std::uintptr_t>(b) % 16 == 0);
+    CHECK(static_cast<void*>(a + 3) <= b);
+
+    // Larger than a block, and overflowing into a second block.
+    CHECK(arena.allocate(4096, 64) != nullptr);
+    CHECK(arena.allocate(1000, 8) != nullptr);
+    CHECK(arena.get_block_allocation_count() == 3);
+
+    std::size_t capacity = arena.get_capacity();
+    arena.reset();
+    CHECK(arena.get_used_size() == 0);
+    CHECK(arena.get_capacity() == capacity);
+    CHECK(arena.get_block_allocation_count() == 4);
+
+    // The merged block holds the same round again without touching the heap.
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        CHECK(arena.allocate(3, 1) != nullptr);
+        CHECK(arena.allocate(16, 16) != nullptr);
+        CHECK(arena.allocate(4096, 64) != nullptr);
+        CHECK(arena.allocate(1000, 8) != nullptr);
+        arena.reset();
+    }
+    CHECK(arena.get_block_allocation_count() == 4);
+}
+
+TEST_CASE("frame_allocator steady state", "[frame_allocator]")
+{
+    auto simulate_frame = []()
+    {
+        frame_vector<std::uint32_t> values;
+        for (std::uint32_t i = 0; i < 10000; ++i)
+        {
+            values.push_back(i);
+        }
+
+        frame_unordered_map<std::uint32_t, float> map;
+        for (std::uint32_t i = 0; i < 100; ++i)
+        {
+            map[values[i * 7]] = static_cast<float>(i);
+        }
+
+        return values.size() + map.size();
+    };
+
+    // Warm up, the arena grows until a frame fits in one block.
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        CHECK(simulate_frame() == 10100);
+        frame_arena::reset();
+    }
+
+    std::size_t block_count = frame_arena::get_block_allocation_count();
+    std::uint64_t allocation_count = allocation_counter::get_thread_count();
+
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        CHECK(simulate_frame() == 10100);
+        frame_arena::reset();
+    }
+
+    CHECK(frame_arena::get_block_allocation_count() == block_count);
+    if (allocation_counter::is_enabled())
+    {
+        CHECK(allocation_counter::get_thread_count() == allocation_count);
+    }
+}
+
+TEST_CASE("frame_allocator threads", "[frame_allocator]")
+{
+    frame_vector<int> main_values(100, 1);
+
+    std::size_t worker_sum = 0;
+    std::thread worker(
+        [&worker_sum]()
+        {
+            frame_vector<int> values(100, 2);
+            for (int value : values)
+            {
+                worker_sum += value;
+            }
+        });
+    worker.join();
+
+    std::size_t main_sum = 0;
+    for (int value : main_values)
+    {
+        main_sum += value;
+    }
+
+    CHECK(main_sum == 100);
+    CHECK(worker_sum == 200);
+
+    main_values = {};
+    frame_arena::reset();
+    CHECK(frame_arena::get_used_size() == 0);
+}
+
+TEST_CASE("frame_allocator reset on the owning thread", "[frame_allocator]")
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t step = 0;
+
+    auto wait_step = [&](std::size_t value)
+    {
+        std::unique_lock lock(mutex);
+        cv.wait(
+            lock,
+            [&]()
+            {
+                return step == value;
+            });
+    };
+
+    auto set_step = [&](std::size_t value)
+    {
+        {
+            std::lock_guard lock(mutex);
+            step = value;
+        }
+        cv.notify_all();
+    };
+
+    std::thread worker(
+        [&]()
+        {
+            for (std::size_t i = 0; i < 2; ++i)
+            {
+                frame_vector<int> values(1000, 1);
+                set_step(i * 2 + 1);
+                wait_step(i * 2 + 2);
+            }
+        });
+
+    // The worker still holds frame memory while the frame ends, only its own allocation in the
+    // next frame resets its arena.
+    wait_step(1);
+    std::size_t used_size = frame_arena::get_used_size();
+    CHECK(used_size >= 1000 * sizeof(int));
+    frame_arena::reset();
+    CHECK(frame_arena::get_used_size() == 0);
+    set_step(2);
+
+    wait_step(3);
+    CHECK(frame_arena::get_used_size() == used_size);
+    set_step(4);
+
+    worker.join();
+    frame_arena::reset();
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "common/log.hpp"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace violet::test
+{
+TEST_CASE("log threads", "[log]")
+{
+    log::set_overflow_policy(LOG_OVERFLOW_POLICY_BLOCK);
+    std::uint64_t dropped_count = log::get_dropped_count();
+
+    std::vector<std::thread> threads;
+    for (std::uint32_t i = 0; i < 4; ++i)
+    {
+        threads.emplace_back(
+            [i]()
+            {
+                std::string name = "worker " + std::to_string(i);
+                for (std::uint32_t j = 0; j < 8; ++j)
+                {
+                    log::debug("[test] {}: {} / {}", i, j, 8);
+                    log::debug("[test] {}: {}", name, j * 0.5f);
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    log::flush();
+    CHECK(log::get_dropped_count() == dropped_count);
+}
+
+TEST_CASE("log wrap around", "[log]")
+{
+    log::set_overflow_policy(LOG_OVERFLOW_POLICY_BLOCK);
+    std::uint64_t dropped_count = log::get_dropped_count();
+
+    // A new thread starts with an empty ring, short records of every length leave every possible
+    // gap at the end of the ring before it wraps.
+    std::thread thread(
+        []()
+        {
+            for (std::uint32_t i = 0; i < 1365; ++i)
+            {
+                log::info("{}", "0123456789abcdef");
+            }
+            log::flush();
+            log::info("{}", "0123456789abcdef");
+
+            std::string text;
+            for (std::uint32_t i = 0; i < 16 * 1024; ++i)
+            {
+                text.resize(i % 64, 'a');
+                log::debug("{}", text);
+            }
+        });
+    thread.join();
+
+    log::flush();
+    CHECK(log::get_dropped_count() == dropped_count);
+}
+
+TEST_CASE("log runtime format", "[log]")
+{
+    log::set_overflow_policy(LOG_OVERFLOW_POLICY_BLOCK);
+    std::uint64_t dropped_count = log::get_dropped_count();
+
+    // The format dies before the flush thread formats the deferred record.
+    {
+        std::string format = "[test] runtime format, long enough to live on the heap: {} {}";
+        log::info(fmt::runtime(format), 1, 2.5f);
+        format.assign(format.size(), 'x');
+    }
+
+    log::flush();
+    CHECK(log::get_dropped_count() == dropped_count);
+}
+
+TEST_CASE("log latency", "[benchmark]")
+{
+    log::flush();
+
+    // Stays below the capacity of the thread ring, so no call waits for the flush thread.
+    constexpr std::uint32_t count = 1000;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        log::debug("[test] generate cluster: {} / {}", i, count);
+    }
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    log::flush();
+
+    std::cout << "log latency: "
+              << std::chrono::duration<double, std::nano>(duration).count() / count << "ns"
+              << std::endl;
+}
+} // namespace violet::test
\ No newline at end of file
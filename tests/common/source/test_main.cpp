@@ -0,0 +1,6 @@
+#include <catch2/catch_all.hpp>
+
+int main(int argc, char* argv[])
+{
+    return Catch::Session().run(argc, argv);
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "common/profiler.hpp"
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace violet::test
+{
+namespace
+{
+template <typename T>
+T read_value(std::istream& in)
+{
+    T value;
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+} // namespace
+
+TEST_CASE("profiler zones", "[profiler]")
+{
+    profiler::set_enabled(true, 1024);
+    profiler::set_thread_name("Test Main");
+
+    profiler::begin_frame(profiler::now());
+    std::uint32_t frame = profiler::get_frame();
+
+    {
+        VIOLET_PROFILE_ZONE("Outer");
+        {
+            VIOLET_PROFILE_ZONE("Inner");
+        }
+        profiler::mark("Marker");
+    }
+
+    std::thread worker(
+        []()
+        {
+            profiler::set_thread_name("Test Worker");
+            VIOLET_PROFILE_ZONE("Worker Zone");
+        });
+    worker.join();
+
+    profiler::set_enabled(false);
+    {
+        VIOLET_PROFILE_ZONE("Disabled");
+    }
+
+    std::stringstream trace;
+    profiler::write_chrome_trace(trace, frame, frame);
+
+    std::string json = trace.str();
+    CHECK(json.find("\"name\":\"Outer\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"Inner\"") != std::string::npos);
+    CHECK(json.find("\"ph\":\"i\",\"s\":\"t\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"Marker\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"Worker Zone\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"Test Worker\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"Frame " + std::to_string(frame) + "\"") != std::string::npos);
+    CHECK(json.find("Disabled") == std::string::npos);
+
+    std::stringstream binary;
+    profiler::write_binary(binary, frame, frame);
+
+    char magic[4];
+    binary.read(magic, 4);
+    CHECK(std::memcmp(magic, "VPRF", 4) == 0);
+    CHECK(read_value<std::uint32_t>(binary) == 1);
+    read_value<std::int64_t>(binary);
+    CHECK(read_value<std::uint32_t>(binary) == 4);
+}
+
+TEST_CASE("profiler zone cost", "[benchmark]")
+{
+    constexpr std::uint32_t count = 100000;
+
+    auto measure = [count]()
+    {
+        std::int64_t start = profiler::now();
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            VIOLET_PROFILE_ZONE("Zone");
+        }
+        return static_cast<double>(profiler::now() - start) / count;
+    };
+
+    profiler::set_enabled(false);
+    double disabled_cost = measure();
+
+    profiler::set_enabled(true, 1024);
+    double enabled_cost = measure();
+    profiler::set_enabled(false);
+
+    std::cout << "profiler zone: disabled " << disabled_cost << "ns, enabled " << enabled_cost
+              << "ns" << std::endl;
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "common/flat_map.hpp"
+#include "common/string_id.hpp"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace violet::test
+{
+namespace
+{
+class timer
+{
+public:
+    void start() noexcept
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    double elapse() const noexcept
+    {
+        auto duration = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double>(duration).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+} // namespace
+
+TEST_CASE("string_id literal", "[string_id]")
+{
+    constexpr string_id update = "Update";
+    static_assert(update.get_value() == hash_string("Update"));
+    static_assert(update != string_id("PostUpdate"));
+    static_assert(string_id().is_empty());
+
+    std::string name = "Update";
+    CHECK(string_id(name) == update);
+    CHECK(update.get_string() == "Update");
+}
+
+TEST_CASE("string_id intern", "[string_id]")
+{
+    std::vector<std::thread> threads;
+    std::vector<std::vector<string_id>> ids(4);
+
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        threads.emplace_back(
+            [&result = ids[i]]()
+            {
+                for (std::size_t j = 0; j < 1000; ++j)
+                {
+                    result.emplace_back("name " + std::to_string(j));
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    bool match = true;
+    for (std::size_t j = 0; j < 1000; ++j)
+    {
+        std::string name = "name " + std::to_string(j);
+        for (const auto& result : ids)
+        {
+            match = match && result[j] == ids[0][j] && result[j].get_string() == name;
+        }
+    }
+    CHECK(match);
+
+    flat_map<string_id, int> map;
+    map["morph"] = 1;
+    map[string_id(std::string("skin"))] = 2;
+    CHECK(map.at(string_id(std::string("morph"))) == 1);
+    CHECK(map.at("skin") == 2);
+}
+
+TEST_CASE("string_id lookup", "[benchmark]")
+{
+    std::vector<std::string> names;
+    std::vector<string_id> ids;
+    for (std::size_t i = 0; i < 64; ++i)
+    {
+        names.push_back("Task Group " + std::to_string(i));
+        ids.emplace_back(names.back());
+    }
+
+    std::string_view target_name = names.back();
+    string_id target_id = ids.back();
+
+    timer timer;
+    std::size_t found = 0;
+
+    timer.start();
+    for (std::size_t i = 0; i < 100000; ++i)
+    {
+        for (const auto& name : names)
+        {
+            found += name == target_name ? 1 : 0;
+        }
+    }
+    double string_time = timer.elapse();
+
+    timer.start();
+    for (std::size_t i = 0; i < 100000; ++i)
+    {
+        for (string_id id : ids)
+        {
+            found += id == target_id ? 1 : 0;
+        }
+    }
+    double id_time = timer.elapse();
+
+    CHECK(found == 200000);
+
+    std::cout << "string_id lookup: string " << string_time * 1000.0 << "ms, id "
+              << id_time * 1000.0 << "ms" << std::endl;
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,505 @@
+#include "math/batch.hpp"
+#include "math/matrix.hpp"
+#include "math/quaternion.hpp"
+#include "test_common.hpp"
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace violet::test
+{
+namespace
+{
+// Odd, so AVX-512 also runs its tail.
+constexpr std::size_t PACK_COUNT = 3;
+constexpr std::size_t ELEMENT_COUNT = PACK_COUNT * BATCH_WIDTH;
+
+class timer
+{
+public:
+    void start() noexcept
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    double elapse() const noexcept
+    {
+        auto duration = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double>(duration).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+class batch_generator
+{
+public:
+    float value(float min, float max)
+    {
+        return std::uniform_real_distribution<float>(min, max)(m_engine);
+    }
+
+    vec3f position()
+    {
+        return {value(-10.0f, 10.0f), value(-10.0f, 10.0f), value(-10.0f, 10.0f)};
+    }
+
+    vec3f scale()
+    {
+        return {value(0.5f, 2.0f), value(0.5f, 2.0f), value(0.5f, 2.0f)};
+    }
+
+    vec4f rotation()
+    {
+        vec3f euler = {value(-3.0f, 3.0f), value(-3.0f, 3.0f), value(-3.0f, 3.0f)};
+        return quaternion::from_euler(euler);
+    }
+
+    mat4f transform()
+    {
+        return matrix::affine_transform(scale(), rotation(), position());
+    }
+
+    sphere3f sphere()
+    {
+        return {.center = position(), .radius = value(0.1f, 2.0f)};
+    }
+
+    box3f box()
+    {
+        box3f result;
+        box::expand(result, position());
+        box::expand(result, position());
+        return result;
+    }
+
+private:
+    std::mt19937 m_engine{7};
+};
+
+template <typename Pack, typename T>
+std::vector<Pack> make_packs(const std::vector<T>& values)
+{
+    std::vector<Pack> packs(values.size() / BATCH_WIDTH);
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        batch::set(packs[i / BATCH_WIDTH], i % BATCH_WIDTH, values[i]);
+    }
+    return packs;
+}
+
+template <typename Pack>
+auto get(const std::vector<Pack>& packs, std::size_t index)
+{
+    return batch::get(packs[index / BATCH_WIDTH], index % BATCH_WIDTH);
+}
+
+template <typename Functor>
+void for_each_level(Functor&& functor)
+{
+    simd_level supported = batch::get_simd_level();
+
+    for (simd_level level : {SIMD_LEVEL_SSE, SIMD_LEVEL_AVX2, SIMD_LEVEL_AVX512})
+    {
+        if (level > supported)
+        {
+            break;
+        }
+
+        batch::set_simd_level(level);
+        INFO("simd level " << level);
+        functor();
+    }
+
+    batch::set_simd_level(supported);
+}
+} // namespace
+
+TEST_CASE("batch::mul", "[batch]")
+{
+    batch_generator generator;
+
+    std::vector<mat4f> a;
+    std::vector<mat4f> b;
+    for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        a.push_back(generator.transform());
+        b.push_back(generator.transform());
+    }
+
+    auto a_packs = make_packs<mat4f_x8>(a);
+    auto b_packs = make_packs<mat4f_x8>(b);
+
+    for_each_level(
+        [&]()
+        {
+            std::vector<mat4f_x8> result(PACK_COUNT);
+            batch::mul(a_packs, b_packs, result);
+
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                CHECK(equal(get(result, i), matrix::mul(a[i], b[i])));
+            }
+
+            // In place, the result aliases a or b.
+            auto lhs = a_packs;
+            batch::mul(lhs, b_packs, lhs);
+            auto rhs = b_packs;
+            batch::mul(a_packs, rhs, rhs);
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                CHECK(equal(get(lhs, i), get(result, i)));
+                CHECK(equal(get(rhs, i), get(result, i)));
+            }
+        });
+}
+
+TEST_CASE("batch::inverse", "[batch]")
+{
+    batch_generator generator;
+
+    std::vector<mat4f> m;
+    for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        m.push_back(generator.transform());
+        m.back()[0][3] = generator.value(-0.1f, 0.1f);
+    }
+
+    auto packs = make_packs<mat4f_x8>(m);
+
+    for_each_level(
+        [&]()
+        {
+            std::vector<mat4f_x8> result(PACK_COUNT);
+            batch::inverse(packs, result);
+
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                CHECK(equal(get(result, i), matrix::inverse(m[i])));
+            }
+        });
+}
+
+TEST_CASE("batch::inverse_transform", "[batch]")
+{
+    batch_generator generator;
+
+    std::vector<mat4f> m;
+    for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        m.push_back(generator.transform());
+    }
+
+    auto packs = make_packs<mat4f_x8>(m);
+
+    for_each_level(
+        [&]()
+        {
+            std::vector<mat4f_x8> result(packs);
+            batch::inverse_transform(result, result);
+
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                CHECK(equal(get(result, i), matrix::inverse_transform(m[i])));
+            }
+        });
+}
+
+TEST_CASE("batch::affine_transform", "[batch]")
+{
+    batch_generator generator;
+
+    std::vector<vec3f> scale;
+    std::vector<vec4f> rotation;
+    std::vector<vec3f> translation;
+    for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        scale.push_back(generator.scale());
+        rotation.push_back(generator.rotation());
+        translation.push_back(generator.position());
+    }
+
+    auto scale_packs = make_packs<vec3f_x8>(scale);
+    auto rotation_packs = make_packs<vec4f_x8>(rotation);
+    auto translation_packs = make_packs<vec3f_x8>(translation);
+
+    for_each_level(
+        [&]()
+        {
+            std::vector<mat4f_x8> result(PACK_COUNT);
+            batch::affine_transform(scale_packs, rotation_packs, translation_packs, result);
+
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                CHECK(equal(
+                    get(result, i),
+                    matrix::affine_transform(scale[i], rotation[i], translation[i])));
+            }
+        });
+}
+
+TEST_CASE("batch::transform_point", "[batch]")
+{
+    batch_generator generator;
+
+    std::vector<vec3f> points;
+    std::vector<mat4f> m;
+    for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        points.push_back(generator.position());
+        m.push_back(generator.transform());
+    }
+
+    auto point_packs = make_packs<vec3f_x8>(points);
+    auto matrix_packs = make_packs<mat4f_x8>(m);
+
+    for_each_level(
+        [&]()
+        {
+            std::vector<vec3f_x8> result(PACK_COUNT);
+            batch::transform_point(point_packs, matrix_packs, result);
+
+            std::vector<vec3f_x8> uniform_result(PACK_COUNT);
+            batch::transform_point(point_packs, m[0], uniform_result);
+
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                vec4f p = {points[i].x, points[i].y, points[i].z, 1.0f};
+                CHECK(equal(get(result, i), vec3f(matrix::mul(p, m[i]))));
+                CHECK(equal(get(uniform_result, i), vec3f(matrix::mul(p, m[0]))));
+            }
+        });
+}
+
+TEST_CASE("batch::quaternion", "[batch]")
+{
+    batch_generator generator;
+
+    std::vector<vec4f> a;
+    std::vector<vec4f> b;
+    std::vector<vec3f> v;
+    for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        a.push_back(generator.rotation());
+        b.push_back(i % 4 == 0 ? a.back() : generator.rotation());
+        v.push_back(generator.position());
+    }
+
+    auto a_packs = make_packs<vec4f_x8>(a);
+    auto b_packs = make_packs<vec4f_x8>(b);
+    auto v_packs = make_packs<vec3f_x8>(v);
+
+    for_each_level(
+        [&]()
+        {
+            std::vector<vec4f_x8> mul_result(PACK_COUNT);
+            batch::quaternion_mul(a_packs, b_packs, mul_result);
+
+            std::vector<vec3f_x8> mul_vec_result(PACK_COUNT);
+            batch::quaternion_mul_vec(a_packs, v_packs, mul_vec_result);
+
+            std::vector<vec4f_x8> normalize_result(PACK_COUNT);
+            batch::quaternion_normalize(mul_result, normalize_result);
+
+            for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+            {
+                vec4f mul = quaternion::mul(a[i], b[i]);
+                CHECK(equal(get(mul_result, i), mul));
+                CHECK(equal(get(mul_vec_result, i), quaternion::mul_vec(a[i], v[i])));
+                CHECK(equal(get(normalize_result, i), vector::normalize(mul)));
+            }
+
+            for (float t : {0.0f, 0.3f, 0.5f, 1.0f})
+            {
+                std::vector<vec4f_x8> slerp_result(PACK_COUNT);
+                batch::quaternion_slerp(a_packs, b_packs, t, slerp_result);
+
+                for (std::size_t i = 0; i < ELEMENT_COUNT; ++i)
+                {
+                    CHECK(equal(get(slerp_result, i), quaternion::slerp(a[i], b[i], t)));
+                }
+            }
+        });
+}
+
+TEST_CASE("batch geometry", "[batch]")
+{
+    batch_generator generator;
+
+    mat4f m = generator.transform();
+    float scale = std::max({
+        vector::length(vec3f(m[0])),
+        vector::length(vec3f(m[1])),
+        vector::length(vec3f(m[2])),
+    });
+
+    // Covers empty spans and tails shorter than a register.
+    for (std::size_t count : {0, 1, 7, 37})
+    {
+        std::vector<vec3f> points;
+        std::vector<vec3f> normals;
+        std::vector<sphere3f> spheres;
+        std::vector<box3f> boxes;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            points.push_back(generator.position());
+            normals.push_back(vector::normalize(generator.position()));
+            spheres.push_back(generator.sphere());
+            boxes.push_back(generator.box());
+        }
+
+        box3f bounds;
+        for (const vec3f& point : points)
+        {
+            box::expand(bounds, point);
+        }
+
+        for_each_level(
+            [&]()
+            {
+                INFO("count " << count);
+
+                std::vector<vec3f> point_result(count);
+                batch::transform_points(points, m, point_result);
+
+                std::vector<vec3f> normal_result(count);
+                batch::transform_normals(normals, m, normal_result);
+
+                std::vector<sphere3f> sphere_result(count);
+                batch::transform_spheres(spheres, m, sphere_result);
+
+                std::vector<box3f> box_result(count);
+                batch::transform_boxes(boxes, m, box_result);
+
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    vec4f p = {points[i].x, points[i].y, points[i].z, 1.0f};
+                    CHECK(equal(point_result[i], vec3f(matrix::mul(p, m))));
+
+                    vec4f n = {normals[i].x, normals[i].y, normals[i].z, 0.0f};
+                    CHECK(equal(normal_result[i], vector::normalize(vec3f(matrix::mul(n, m)))));
+
+                    sphere3f sphere = sphere::transform(spheres[i], m, scale);
+                    CHECK(equal(sphere_result[i].center, sphere.center));
+                    CHECK(equal(sphere_result[i].radius, sphere.radius));
+
+                    box3f box = box::transform(boxes[i], m);
+                    CHECK(equal(box_result[i].min, box.min));
+                    CHECK(equal(box_result[i].max, box.max));
+                }
+
+                CHECK(batch::get_bounds(points) == bounds);
+            });
+    }
+
+    std::vector<vec3f> points = {
+        {1.0f, 2.0f, 3.0f},
+        {std::numeric_limits<float>::quiet_NaN(), -1.0f, 0.0f},
+        {-2.0f, 5.0f, std::numeric_limits<float>::quiet_NaN()},
+    };
+
+    box3f bounds;
+    for (const vec3f& point : points)
+    {
+        box::expand(bounds, point);
+    }
+
+    for_each_level(
+        [&]()
+        {
+            CHECK(batch::get_bounds(points) == bounds);
+        });
+}
+
+TEST_CASE("batch geometry throughput", "[benchmark]")
+{
+    static constexpr std::size_t element_count = 1000000;
+
+    batch_generator generator;
+
+    mat4f m = generator.transform();
+
+    std::vector<vec3f> points;
+    std::vector<sphere3f> spheres;
+    std::vector<box3f> boxes;
+    for (std::size_t i = 0; i < element_count; ++i)
+    {
+        points.push_back(generator.position());
+        spheres.push_back(generator.sphere());
+        boxes.push_back(generator.box());
+    }
+
+    std::vector<vec3f> point_result(element_count);
+    std::vector<sphere3f> sphere_result(element_count);
+    std::vector<box3f> box_result(element_count);
+
+    auto report = [](std::string_view name, double seconds)
+    {
+        std::cout << name << ": " << seconds * 1000.0 << "ms, "
+                  << seconds * 1e9 / static_cast<double>(element_count) << "ns/element"
+                  << std::endl;
+    };
+
+    timer timer;
+
+    timer.start();
+    for (std::size_t i = 0; i < element_count; ++i)
+    {
+        vec4f p = {points[i].x, points[i].y, points[i].z, 1.0f};
+        point_result[i] = matrix::mul(p, m);
+    }
+    report("points matrix::mul", timer.elapse());
+
+    timer.start();
+    mat4f_simd m_simd = math::load(m);
+    for (std::size_t i = 0; i < element_count; ++i)
+    {
+        vec4f_simd p = math::load(points[i], 1.0f);
+        math::store(matrix::mul(p, m_simd), point_result[i]);
+    }
+    report("points matrix::mul simd", timer.elapse());
+
+    timer.start();
+    batch::transform_points(points, m, point_result);
+    report("points batch::transform_points", timer.elapse());
+
+    timer.start();
+    for (std::size_t i = 0; i < element_count; ++i)
+    {
+        sphere_result[i] = sphere::transform(spheres[i], m);
+    }
+    report("spheres sphere::transform", timer.elapse());
+
+    timer.start();
+    batch::transform_spheres(spheres, m, sphere_result);
+    report("spheres batch::transform_spheres", timer.elapse());
+
+    timer.start();
+    for (std::size_t i = 0; i < element_count; ++i)
+    {
+        box_result[i] = box::transform(boxes[i], m);
+    }
+    report("boxes box::transform", timer.elapse());
+
+    timer.start();
+    batch::transform_boxes(boxes, m, box_result);
+    report("boxes batch::transform_boxes", timer.elapse());
+
+    timer.start();
+    box3f bounds;
+    for (const vec3f& point : points)
+    {
+        box::expand(bounds, point);
+    }
+    report("bounds box::expand", timer.elapse());
+
+    timer.start();
+    box3f batch_bounds = batch::get_bounds(points);
+    report("bounds batch::get_bounds", timer.elapse());
+
+    CHECK(bounds == batch_bounds);
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,3 @@
+#pragma once
+
+#include <catch2/catch_all.hpp>
\ No newline at end of file
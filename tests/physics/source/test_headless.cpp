@@ -0,0 +1,56 @@
+#include "graphics/graphics_system.hpp"
+#include "physics/physics_system.hpp"
+#include "scene/transform_system.hpp"
+#include "test_common.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace violet::test
+{
+TEST_CASE("Headless benchmark with physics", "[physics]")
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::filesystem::path config_path = directory / "test_headless_physics.json";
+    std::filesystem::path output_path = directory / "test_headless_physics_benchmark.json";
+
+    // Graphics is skipped, so the rendering group that physics orders itself before is missing.
+    dictionary config = {
+        {"engine",
+         {{"headless",
+           {
+               {"enable", true},
+               {"frame_count", 10},
+               {"delta_time", 1.0f / 60.0f},
+               {"output", output_path.string()},
+               {"skip_systems", {"window", "graphics"}},
+           }}}},
+        {"physics", {{"plugin", VIOLET_PHYSICS_PLUGIN_PATH}}},
+    };
+    {
+        std::ofstream fout(config_path);
+        fout << config.dump();
+    }
+
+    {
+        application app(config_path.string());
+        app.install<transform_system>();
+        app.install<graphics_system>();
+        app.install<physics_system>();
+        app.run();
+    }
+
+    dictionary report;
+    {
+        std::ifstream fin(output_path);
+        REQUIRE(fin.is_open());
+        fin >> report;
+    }
+
+    std::filesystem::remove(config_path);
+    std::filesystem::remove(output_path);
+
+    CHECK(report["frame_count"] == 10);
+    CHECK(report["systems"].contains("physics"));
+    CHECK(!report["systems"].contains("graphics"));
+}
+} // namespace violet::test
\ No newline at end of file
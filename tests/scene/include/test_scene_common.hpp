@@ -1,11 +1,7 @@
 #pragma once
 
-#include "components/transform.hpp"
-#include "core/node/node.hpp"
-#include "scene/scene_module.hpp"
-#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
 
 namespace violet::test
 {
-
 }
\ No newline at end of file
@@ -0,0 +1,446 @@
+#include "scene/bvh_tree.hpp"
+#include "test_scene_common.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+namespace violet::test
+{
+namespace
+{
+class timer
+{
+public:
+    void start() noexcept
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    double elapse() const noexcept
+    {
+        auto duration = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double>(duration).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+class scene_generator
+{
+public:
+    scene_generator(float extent)
+        : m_position(-extent, extent),
+          m_size(0.1f, 2.0f)
+    {
+    }
+
+    vec3f position()
+    {
+        return {m_position(m_engine), m_position(m_engine), m_position(m_engine)};
+    }
+
+    box3f box()
+    {
+        return box(position());
+    }
+
+    box3f box(const vec3f& center)
+    {
+        vec3f half = {m_size(m_engine), m_size(m_engine), m_size(m_engine)};
+
+        box3f result;
+        result.min = center - half;
+        result.max = center + half;
+        return result;
+    }
+
+    vec3f direction()
+    {
+        std::normal_distribution<float> normal;
+        return vector::normalize(vec3f{normal(m_engine), normal(m_engine), normal(m_engine)});
+    }
+
+private:
+    std::mt19937 m_engine{42};
+    std::uniform_real_distribution<float> m_position;
+    std::uniform_real_distribution<float> m_size;
+};
+
+bool overlap(const box3f& a, const box3f& b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y &&
+           a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+bool overlap(const box3f& box, const sphere3f& sphere)
+{
+    vec3f closest = vector::clamp(sphere.center, box.min, box.max);
+    return vector::length_sq(closest - sphere.center) <= sphere.radius * sphere.radius;
+}
+
+bool visible(const box3f& box, std::span<const vec4f, 6> planes)
+{
+    for (const vec4f& plane : planes)
+    {
+        vec3f corner = {
+            plane.x >= 0.0f ? box.max.x : box.min.x,
+            plane.y >= 0.0f ? box.max.y : box.min.y,
+            plane.z >= 0.0f ? box.max.z : box.min.z,
+        };
+
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+float raycast(const box3f& box, const bvh_tree::ray& ray)
+{
+    float t_near = 0.0f;
+    float t_far = ray.max_distance;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        float inverse = 1.0f / ray.direction[i];
+        float t1 = (box.min[i] - ray.origin[i]) * inverse;
+        float t2 = (box.max[i] - ray.origin[i]) * inverse;
+        t_near = std::max(t_near, std::min(t1, t2));
+        t_far = std::min(t_far, std::max(t1, t2));
+    }
+    return t_near <= t_far ? t_near : -1.0f;
+}
+
+std::array<vec4f, 6> get_frustum(const vec3f& position, const vec3f& target)
+{
+    mat4f view = matrix::look_at(position, target, vec3f{0.0f, 1.0f, 0.0f});
+    mat4f projection = matrix::perspective(math::to_radians(60.0f), 1.0f, 0.1f, 200.0f);
+    return bvh_tree::get_frustum_planes(matrix::mul(view, projection));
+}
+
+template <typename T>
+std::vector<T> sorted(std::vector<T> values)
+{
+    std::sort(values.begin(), values.end());
+    return values;
+}
+} // namespace
+
+TEST_CASE("bvh_tree queries", "[bvh_tree]")
+{
+    static constexpr std::size_t proxy_count = 2000;
+
+    scene_generator generator(50.0f);
+
+    bvh_tree tree;
+    std::vector<box3f> boxes;
+    std::vector<bvh_tree::proxy_id> proxies;
+    for (std::size_t i = 0; i < proxy_count; ++i)
+    {
+        boxes.push_back(generator.box());
+        proxies.push_back(tree.add(boxes.back(), static_cast<std::uint32_t>(i)));
+    }
+
+    // Move, remove and re-add proxies so the results also cover a modified tree.
+    for (std::size_t i = 0; i < proxy_count; i += 3)
+    {
+        boxes[i] = generator.box(box::get_center(boxes[i]) + vec3f{0.05f, 0.0f, 0.0f});
+        tree.update(proxies[i], boxes[i]);
+    }
+    for (std::size_t i = 1; i < proxy_count; i += 7)
+    {
+        boxes[i] = generator.box();
+        tree.update(proxies[i], boxes[i]);
+    }
+    for (std::size_t i = 2; i < proxy_count; i += 5)
+    {
+        tree.remove(proxies[i]);
+        proxies[i] = tree.add(boxes[i], static_cast<std::uint32_t>(i));
+    }
+
+    CHECK(tree.get_proxy_count() == proxy_count);
+
+    auto expected = [&](auto&& predicate)
+    {
+        std::vector<std::uint32_t> result;
+        for (std::size_t i = 0; i < proxy_count; ++i)
+        {
+            if (predicate(boxes[i]))
+            {
+                result.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+        return result;
+    };
+
+    auto user_data = [&](const std::vector<bvh_tree::proxy_id>& result)
+    {
+        std::vector<std::uint32_t> indices;
+        for (bvh_tree::proxy_id proxy : result)
+        {
+            indices.push_back(tree.get_user_data(proxy));
+        }
+        return sorted(indices);
+    };
+
+    SECTION("Box")
+    {
+        for (std::size_t i = 0; i < 20; ++i)
+        {
+            box3f query = generator.box();
+            query.max = query.max + vec3f{10.0f, 10.0f, 10.0f};
+
+            std::vector<bvh_tree::proxy_id> result;
+            tree.query_box(query, result);
+            CHECK(
+                user_data(result) == expected(
+                                         [&](const box3f& box)
+                                         {
+                                             return overlap(box, query);
+                                         }));
+        }
+    }
+
+    SECTION("Sphere")
+    {
+        for (std::size_t i = 0; i < 20; ++i)
+        {
+            sphere3f query = {.center = generator.position(), .radius = 15.0f};
+
+            std::vector<bvh_tree::proxy_id> result;
+            tree.query_sphere(query, result);
+            CHECK(
+                user_data(result) == expected(
+                                         [&](const box3f& box)
+                                         {
+                                             return overlap(box, query);
+                                         }));
+        }
+    }
+
+    SECTION("Frustum")
+    {
+        for (std::size_t i = 0; i < 20; ++i)
+        {
+            auto planes = get_frustum(generator.position(), generator.position());
+
+            std::vector<bvh_tree::proxy_id> result;
+            tree.frustum_culling(planes, result);
+            CHECK(
+                user_data(result) == expected(
+                                         [&](const box3f& box)
+                                         {
+                                             return visible(box, planes);
+                                         }));
+        }
+    }
+
+    SECTION("Ray")
+    {
+        std::vector<bvh_tree::ray> rays;
+        for (std::size_t i = 0; i < 100; ++i)
+        {
+            rays.push_back({
+                .origin = generator.position(),
+                .direction = generator.direction(),
+                .max_distance = 100.0f,
+            });
+        }
+        rays.push_back({
+            .origin = {-100.0f, 0.0f, 0.0f},
+            .direction = {1.0f, 0.0f, 0.0f},
+        });
+
+        std::vector<bvh_tree::ray_hit> hits(rays.size());
+        tree.raycast(rays, hits);
+
+        for (std::size_t i = 0; i < rays.size(); ++i)
+        {
+            float closest = rays[i].max_distance;
+            bool hit = false;
+            for (const box3f& box : boxes)
+            {
+                float distance = raycast(box, rays[i]);
+                if (distance >= 0.0f && distance <= closest)
+                {
+                    closest = distance;
+                    hit = true;
+                }
+            }
+
+            CHECK((hits[i].proxy != bvh_tree::INVALID_PROXY) == hit);
+            if (hit)
+            {
+                CHECK(hits[i].distance == Approx(closest).margin(1e-4f));
+            }
+        }
+    }
+
+    SECTION("Batched boxes")
+    {
+        std::vector<box3f> queries;
+        for (std::size_t i = 0; i < 20; ++i)
+        {
+            queries.push_back(generator.box());
+        }
+
+        std::vector<bvh_tree::overlap> overlaps;
+        tree.query_boxes(queries, overlaps);
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> result;
+        for (const auto& overlap : overlaps)
+        {
+            result.emplace_back(overlap.query, tree.get_user_data(overlap.proxy));
+        }
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> expected_result;
+        for (std::uint32_t i = 0; i < queries.size(); ++i)
+        {
+            for (std::uint32_t j = 0; j < proxy_count; ++j)
+            {
+                if (overlap(boxes[j], queries[i]))
+                {
+                    expected_result.emplace_back(i, j);
+                }
+            }
+        }
+
+        CHECK(sorted(result) == expected_result);
+    }
+
+    SECTION("Optimize")
+    {
+        float cost = tree.get_cost();
+        tree.optimize(1000000);
+        CHECK(tree.get_cost() <= cost);
+
+        box3f query = generator.box();
+        query.max = query.max + vec3f{20.0f, 20.0f, 20.0f};
+
+        std::vector<bvh_tree::proxy_id> result;
+        tree.query_box(query, result);
+        CHECK(
+            user_data(result) == expected(
+                                     [&](const box3f& box)
+                                     {
+                                         return overlap(box, query);
+                                     }));
+    }
+
+    SECTION("Remove all")
+    {
+        for (bvh_tree::proxy_id proxy : proxies)
+        {
+            tree.remove(proxy);
+        }
+
+        CHECK(tree.get_proxy_count() == 0);
+        CHECK(tree.get_height() == 0);
+
+        std::vector<bvh_tree::proxy_id> result;
+        tree.query_sphere({.center = {0.0f, 0.0f, 0.0f}, .radius = 1000.0f}, result);
+        CHECK(result.empty());
+    }
+}
+
+TEST_CASE("bvh_tree throughput", "[benchmark]")
+{
+    static constexpr std::size_t proxy_count = 100000;
+    static constexpr std::size_t query_count = 10000;
+
+    scene_generator generator(500.0f);
+
+    std::vector<box3f> boxes;
+    for (std::size_t i = 0; i < proxy_count; ++i)
+    {
+        boxes.push_back(generator.box());
+    }
+
+    auto report = [](std::string_view name, std::size_t operation_count, double seconds)
+    {
+        std::cout << name << ": " << seconds * 1000.0 << "ms, "
+                  << seconds * 1e9 / static_cast<double>(operation_count) << "ns/op" << std::endl;
+    };
+
+    timer timer;
+
+    bvh_tree tree;
+    std::vector<bvh_tree::proxy_id> proxies;
+
+    timer.start();
+    for (std::size_t i = 0; i < proxy_count; ++i)
+    {
+        proxies.push_back(tree.add(boxes[i], static_cast<std::uint32_t>(i)));
+    }
+    report("bvh_tree add", proxy_count, timer.elapse());
+    std::cout << "bvh_tree height: " << tree.get_height() << std::endl;
+
+    // Small movement stays inside the fat boxes.
+    timer.start();
+    for (std::size_t i = 0; i < proxy_count; ++i)
+    {
+        boxes[i].min = boxes[i].min + vec3f{0.01f, 0.0f, 0.0f};
+        boxes[i].max = boxes[i].max + vec3f{0.01f, 0.0f, 0.0f};
+        tree.update(proxies[i], boxes[i]);
+    }
+    report("bvh_tree update (refit)", proxy_count, timer.elapse());
+
+    // Every proxy leaves its fat box and is reinserted.
+    timer.start();
+    for (std::size_t i = 0; i < proxy_count; ++i)
+    {
+        boxes[i].min = boxes[i].min + vec3f{1.0f, 0.0f, 0.0f};
+        boxes[i].max = boxes[i].max + vec3f{1.0f, 0.0f, 0.0f};
+        tree.update(proxies[i], boxes[i]);
+    }
+    report("bvh_tree update (reinsert)", proxy_count, timer.elapse());
+
+    timer.start();
+    tree.optimize(proxy_count);
+    report("bvh_tree optimize", proxy_count, timer.elapse());
+
+    std::vector<bvh_tree::proxy_id> result;
+
+    timer.start();
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        result.clear();
+        tree.frustum_culling(get_frustum(generator.position(), generator.position()), result);
+    }
+    report("bvh_tree frustum culling", 100, timer.elapse());
+
+    timer.start();
+    for (std::size_t i = 0; i < query_count; ++i)
+    {
+        result.clear();
+        tree.query_sphere({.center = generator.position(), .radius = 10.0f}, result);
+    }
+    report("bvh_tree sphere query", query_count, timer.elapse());
+
+    std::vector<bvh_tree::ray> rays;
+    for (std::size_t i = 0; i < query_count; ++i)
+    {
+        rays.push_back({.origin = generator.position(), .direction = generator.direction()});
+    }
+    std::vector<bvh_tree::ray_hit> hits(rays.size());
+
+    timer.start();
+    tree.raycast(rays, hits);
+    report("bvh_tree raycast", query_count, timer.elapse());
+
+    std::vector<box3f> queries;
+    for (std::size_t i = 0; i < query_count; ++i)
+    {
+        queries.push_back(generator.box());
+    }
+    std::vector<bvh_tree::overlap> overlaps;
+
+    timer.start();
+    tree.query_boxes(queries, overlaps);
+    report("bvh_tree box query", query_count, timer.elapse());
+
+    CHECK(tree.get_proxy_count() == proxy_count);
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "task/async_file.hpp"
+#include "task/task_executor.hpp"
+#include "test_common.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace violet::test
+{
+namespace
+{
+async_task<int> delayed_double(task_executor& executor, int value)
+{
+    co_await executor.sleep_for(std::chrono::milliseconds(20));
+    co_return value * 2;
+}
+
+async_task<int> delayed_sum(task_executor& executor, int value)
+{
+    int a = co_await delayed_double(executor, value);
+    int b = co_await delayed_double(executor, value + 1);
+    co_return a + b;
+}
+
+async_task<void> throw_on_worker(task_executor& executor)
+{
+    co_await executor.schedule();
+    throw std::runtime_error("async task error");
+}
+} // namespace
+
+TEST_CASE("Await nested async tasks", "[task]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    CHECK(executor.execute(delayed_sum(executor, 1)).get() == 2 + 4);
+
+    executor.stop();
+}
+
+TEST_CASE("Sleeping coroutines do not occupy workers", "[task]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    constexpr int coroutine_count = 1000;
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < coroutine_count; ++i)
+    {
+        futures.push_back(executor.execute(delayed_sum(executor, i)));
+    }
+
+    int sum = 0;
+    for (auto& future : futures)
+    {
+        sum += future.get();
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+
+    executor.stop();
+
+    CHECK(sum == 2 * coroutine_count * coroutine_count);
+
+    // Blocking sleeps would take coroutine_count * 40ms / NUM_THREAD = 10s.
+    CHECK(elapsed < std::chrono::seconds(2));
+}
+
+TEST_CASE("Poll a condition", "[task]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    std::atomic<bool> signaled{false};
+
+    auto wait = [](task_executor& executor, std::atomic<bool>& signaled) -> async_task<bool>
+    {
+        co_await executor.poll(
+            [&signaled]()
+            {
+                return signaled.load();
+            });
+        co_return signaled.load();
+    };
+
+    std::future<bool> future = executor.execute(wait(executor, signaled));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    signaled = true;
+
+    CHECK(future.get());
+
+    executor.stop();
+}
+
+TEST_CASE("Read file asynchronously", "[task]")
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "violet_async_file.bin";
+
+    std::string content = "violet async file";
+    {
+        std::ofstream fout(path, std::ios::binary);
+        fout << content;
+    }
+
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    std::vector<char> data;
+    CHECK(executor.execute(async_file::read(executor, path.string(), data)).get());
+    CHECK(std::string(data.begin(), data.end()) == content);
+
+    std::vector<char> missing;
+    CHECK_FALSE(executor.execute(async_file::read(executor, "missing.bin", missing)).get());
+
+    executor.stop();
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Read into caller buffers", "[task]")
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "violet_async_read.bin";
+
+    std::vector<char> content(3 * 1024 * 1024 + 17);
+    for (std::size_t i = 0; i < content.size(); ++i)
+    {
+        content[i] = static_cast<char>(i * 31);
+    }
+    {
+        std::ofstream fout(path, std::ios::binary);
+        fout.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    SECTION("Whole file")
+    {
+        std::vector<char> data;
+        CHECK(executor.execute(async_file::read(executor, path.string(), data)).get());
+        CHECK(data == content);
+    }
+
+    SECTION("Batch")
+    {
+        async_file file;
+        REQUIRE(file.open(path.string()));
+        CHECK(file.get_size() == content.size());
+
+        std::vector<char> head(16);
+        std::vector<char> middle(4096);
+        std::vector<char> tail(64);
+
+        std::vector<async_file::io_request> requests = {
+            file.make_request(0, head),
+            file.make_request(1024 * 1024, middle),
+            file.make_request(content.size() - 32, tail),
+        };
+
+        auto read = [](task_executor& executor,
+                       std::vector<async_file::io_request>& requests) -> async_task<void>
+        {
+            co_await executor.read(requests);
+        };
+        executor.execute(read(executor, requests)).get();
+
+        CHECK(requests[0].result == 16);
+        CHECK(std::equal(head.begin(), head.end(), content.begin()));
+        CHECK(requests[1].result == 4096);
+        CHECK(std::equal(middle.begin(), middle.end(), content.begin() + 1024 * 1024));
+
+        // Reads past the end of the file are short.
+        CHECK(requests[2].result == 32);
+        CHECK(std::equal(tail.begin(), tail.begin() + 32, content.end() - 32));
+    }
+
+    executor.stop();
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Switch to the main thread", "[task]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    auto resume_on_main = [](task_executor& executor) -> async_task<std::thread::id>
+    {
+        co_await executor.sleep_for(std::chrono::milliseconds(5));
+        co_await executor.switch_to_main_thread();
+        co_return std::this_thread::get_id();
+    };
+
+    std::future<std::thread::id> future = executor.execute(resume_on_main(executor));
+
+    // Nothing resumes the coroutine until the main thread drains its queue.
+    while (future.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready)
+    {
+        executor.execute_main_thread_coroutines();
+    }
+
+    CHECK(future.get() == std::this_thread::get_id());
+
+    executor.stop();
+}
+
+TEST_CASE("Wait for a coroutine on a worker", "[task]")
+{
+    task_executor executor;
+    executor.run(1);
+
+    // The only worker waits, the coroutine resumes on it while it helps.
+    task_graph graph;
+    int result = 0;
+    graph.add_task().set_execute(
+        [&]()
+        {
+            result = executor.wait(executor.execute(delayed_sum(executor, 1)));
+        });
+    executor.execute_sync(graph);
+
+    CHECK(result == 2 + 4);
+
+    executor.stop();
+}
+
+TEST_CASE("Stop cancels waiting coroutines", "[task]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    auto sleep = [](task_executor& executor) -> async_task<void>
+    {
+        co_await executor.sleep_for(std::chrono::hours(1));
+    };
+
+    auto poll = [](task_executor& executor) -> async_task<void>
+    {
+        co_await executor.poll(
+            []()
+            {
+                return false;
+            });
+    };
+
+    auto switch_to_main_thread = [](task_executor& executor) -> async_task<void>
+    {
+        co_await executor.switch_to_main_thread();
+    };
+
+    std::atomic<bool> blocking_done{false};
+    auto blocking = [&blocking_done](task_executor& executor) -> async_task<void>
+    {
+        co_await executor.execute_blocking(
+            [&blocking_done]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                blocking_done = true;
+            });
+    };
+
+    std::future<void> sleep_result = executor.execute(sleep(executor));
+    std::future<void> poll_result = executor.execute(poll(executor));
+    std::future<void> main_thread_result = executor.execute(switch_to_main_thread(executor));
+    std::future<void> blocking_result = executor.execute(blocking(executor));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    executor.stop();
+
+    CHECK_THROWS_AS(sleep_result.get(), task_cancelled);
+    CHECK_THROWS_AS(poll_result.get(), task_cancelled);
+    CHECK_THROWS_AS(main_thread_result.get(), task_cancelled);
+
+    // Blocking calls are not interrupted, stop waits for them.
+    CHECK(blocking_done);
+    CHECK_NOTHROW(blocking_result.get());
+}
+
+TEST_CASE("Propagate exceptions from async tasks", "[task]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    CHECK_THROWS_AS(executor.execute(throw_on_worker(executor)).get(), std::runtime_error);
+
+    executor.stop();
+}
+} // namespace violet::test
\ No newline at end of file
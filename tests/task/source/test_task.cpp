@@ -4,6 +4,8 @@
 #include "test_common.hpp"
 #include <iostream>
 #include <queue>
+#include <sstream>
+#include <string_view>
 
 namespace violet::test
 {
@@ -119,4 +121,248 @@ TEST_CASE("Task dependency", "[task]")
 
     task_graph_printer::print(graph);
 }
+
+TEST_CASE("Critical path scheduling", "[task]")
+{
+    // A long chain is added after many short independent tasks. In FIFO order the chain would
+    // only start once the independent tasks are drained.
+    auto build_graph = [](task_graph& graph, task_priority chain_priority)
+    {
+        for (std::size_t i = 0; i < 63; ++i)
+        {
+            graph.add_task().set_execute(
+                []()
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                });
+        }
+
+        task* prev = nullptr;
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            task& chain = graph.add_task()
+                              .set_execute(
+                                  []()
+                                  {
+                                      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                                  })
+                              .set_priority(chain_priority);
+            if (prev != nullptr)
+            {
+                chain.add_dependency(*prev);
+            }
+            prev = &chain;
+        }
+    };
+
+    auto measure = [](task_executor& executor, task_graph& graph)
+    {
+        constexpr std::size_t frame_count = 5;
+
+        executor.execute_sync(graph);
+
+        auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < frame_count; ++i)
+        {
+            executor.execute_sync(graph);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::milli>(end - begin).count() / frame_count;
+    };
+
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    task_graph starved_graph;
+    build_graph(starved_graph, TASK_PRIORITY_LOW);
+    double starved_time = measure(executor, starved_graph);
+
+    task_graph critical_graph;
+    build_graph(critical_graph, TASK_PRIORITY_NORMAL);
+    double critical_time = measure(executor, critical_graph);
+
+    executor.stop();
+
+    std::cout << "chain starved: " << starved_time << " ms, critical path first: " << critical_time
+              << " ms" << std::endl;
+
+    CHECK(critical_time < starved_time);
+}
+
+TEST_CASE("Task profiler", "[task]")
+{
+    task_graph graph;
+
+    task& task_1 = graph.add_task()
+                       .set_name("Profiled \"1\"")
+                       .set_execute(
+                           []()
+                           {
+                               std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                           })
+                       .set_options(TASK_OPTION_MAIN_THREAD);
+    graph.add_task()
+        .set_name("Profiled 2")
+        .set_execute(
+            []()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            })
+        .add_dependency(task_1);
+
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    // Tasks are recorded as zones of the engine wide profiler.
+    profiler::set_enabled(true);
+
+    std::uint32_t first_frame = profiler::get_frame() + 1;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        profiler::begin_frame(profiler::now());
+        executor.execute_sync(graph);
+    }
+
+    auto count_tasks = [&](std::uint32_t first, std::uint32_t last)
+    {
+        std::size_t count = 0;
+        for (const auto& zone : profiler::get_zones(first, last))
+        {
+            if (std::string_view(zone.name).starts_with("Profiled"))
+            {
+                CHECK(zone.enqueue_time <= zone.begin_time);
+                CHECK(zone.begin_time <= zone.end_time);
+                ++count;
+            }
+        }
+        return count;
+    };
+
+    CHECK(count_tasks(first_frame + 1, first_frame + 1) == 2);
+    CHECK(count_tasks(first_frame, first_frame + 2) == 6);
+
+    std::stringstream trace;
+    profiler::write_chrome_trace(trace, first_frame + 2, first_frame + 2);
+    CHECK(trace.str().find("\"name\":\"Profiled \\\"1\\\"\"") != std::string::npos);
+    CHECK(trace.str().find("\"name\":\"Profiled 2\"") != std::string::npos);
+    CHECK(trace.str().find("\"name\":\"Idle\"") != std::string::npos);
+    // The second task is queued by the main thread when the first finishes, a worker takes it.
+    CHECK(trace.str().find("\"name\":\"Steal from Main Thread\"") != std::string::npos);
+
+    profiler::set_enabled(false);
+    executor.stop();
+}
+
+TEST_CASE("Parallel for", "[task]")
+{
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    std::vector<std::uint32_t> data(NUM_DATA_PER_THREAD * NUM_THREAD, 0);
+
+    task_graph graph;
+    graph.add_task().set_execute(
+        [&]()
+        {
+            executor.parallel_for(
+                data.size(),
+                100,
+                [&](std::size_t begin, std::size_t end)
+                {
+                    for (std::size_t i = begin; i < end; ++i)
+                    {
+                        data[i] += static_cast<std::uint32_t>(i);
+                    }
+                });
+        });
+    executor.execute_sync(graph);
+
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        REQUIRE(data[i] == i);
+    }
+
+    std::size_t empty_count = 0;
+    executor.parallel_for(
+        0,
+        100,
+        [&](std::size_t, std::size_t)
+        {
+            ++empty_count;
+        });
+    CHECK(empty_count == 0);
+
+    executor.stop();
+}
+
+TEST_CASE("Fixed rate groups", "[task]")
+{
+    task_graph graph;
+
+    task_group& physics = graph.add_group().set_name("Physics").set_tick_rate(60.0f, 3);
+    task_group& ai = graph.add_group().set_name("AI").set_tick_rate(10.0f);
+    task_group& ai_nested = graph.add_group().set_name("AI Nested").set_group(ai);
+
+    std::uint32_t physics_steps = 0;
+    std::uint32_t ai_runs = 0;
+    std::uint32_t ai_nested_runs = 0;
+    std::uint32_t render_runs = 0;
+
+    graph.add_task()
+        .set_group(physics)
+        .set_execute(
+            [&]()
+            {
+                physics_steps += physics.get_step_count();
+            });
+    graph.add_task()
+        .set_group(ai)
+        .set_execute(
+            [&]()
+            {
+                ++ai_runs;
+            });
+    graph.add_task()
+        .set_group(ai_nested)
+        .set_execute(
+            [&]()
+            {
+                ++ai_nested_runs;
+            });
+    graph.add_task()
+        .set_execute(
+            [&]()
+            {
+                ++render_runs;
+                CHECK(physics.get_interpolation() >= 0.0f);
+                CHECK(physics.get_interpolation() < 1.0f);
+            })
+        .add_dependency(physics, ai);
+
+    task_executor executor;
+    executor.run(NUM_THREAD);
+
+    // One second at 144 Hz.
+    for (std::uint32_t i = 0; i < 144; ++i)
+    {
+        graph.advance(1.0f / 144.0f);
+        executor.execute_sync(graph);
+    }
+
+    CHECK(render_runs == 144);
+    CHECK(physics_steps >= 59);
+    CHECK(physics_steps <= 60);
+    CHECK(ai_runs >= 9);
+    CHECK(ai_runs <= 10);
+    CHECK(ai_nested_runs == ai_runs);
+
+    // A long hitch is capped at the catch-up limit.
+    physics_steps = 0;
+    graph.advance(1.0f);
+    executor.execute_sync(graph);
+    CHECK(physics_steps == 3);
+
+    executor.stop();
+}
 } // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "math/types.hpp"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace violet::test
+{
+class timer
+{
+public:
+    void start() noexcept
+    {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    double elapse() const noexcept
+    {
+        auto duration = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double>(duration).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+struct grid_mesh
+{
+    std::vector<vec3f> positions;
+    std::vector<std::uint32_t> indexes;
+};
+
+/**
+ * @brief A size x size grid of quads with a noisy height, so every collapse has a different error.
+ */
+inline grid_mesh make_grid(std::uint32_t size)
+{
+    grid_mesh mesh;
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> height(0.0f, 0.05f);
+
+    mesh.positions.reserve(static_cast<std::size_t>(size + 1) * (size + 1));
+    for (std::uint32_t y = 0; y <= size; ++y)
+    {
+        for (std::uint32_t x = 0; x <= size; ++x)
+        {
+            mesh.positions.push_back({
+                static_cast<float>(x),
+                height(random),
+                static_cast<float>(y),
+            });
+        }
+    }
+
+    mesh.indexes.reserve(static_cast<std::size_t>(size) * size * 6);
+    for (std::uint32_t y = 0; y < size; ++y)
+    {
+        for (std::uint32_t x = 0; x < size; ++x)
+        {
+            std::uint32_t i0 = (y * (size + 1)) + x;
+            std::uint32_t i1 = i0 + 1;
+            std::uint32_t i2 = i0 + size + 1;
+            std::uint32_t i3 = i2 + 1;
+
+            mesh.indexes.insert(mesh.indexes.end(), {i0, i2, i1, i1, i2, i3});
+        }
+    }
+
+    return mesh;
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "cluster/cluster_builder.hpp"
+#include "test_common.hpp"
+#include <iostream>
+
+namespace violet::test
+{
+namespace
+{
+void build_clusters(cluster_builder& builder, const grid_mesh& mesh, task_executor* executor)
+{
+    builder.set_executor(executor);
+    builder.set_positions(mesh.positions);
+    builder.set_indexes(mesh.indexes);
+    builder.build();
+}
+} // namespace
+
+TEST_CASE("cluster builder", "[cluster builder]")
+{
+    grid_mesh mesh = make_grid(64);
+
+    cluster_builder builder;
+    build_clusters(builder, mesh, nullptr);
+
+    const auto& clusters = builder.get_clusters();
+    const auto& groups = builder.get_groups();
+
+    REQUIRE(!clusters.empty());
+    for (const auto& cluster : clusters)
+    {
+        CHECK(cluster.index_count / 3 <= 128);
+        CHECK(cluster.group_index < groups.size());
+    }
+
+    // The coarsest level is a single cluster.
+    CHECK(groups.back().cluster_count == 1);
+    CHECK(!builder.get_cluster_nodes().empty());
+}
+
+TEST_CASE("cluster builder determinism", "[cluster builder]")
+{
+    grid_mesh mesh = make_grid(64);
+
+    cluster_builder serial_builder;
+    build_clusters(serial_builder, mesh, nullptr);
+
+    task_executor executor;
+    executor.run(4);
+
+    cluster_builder parallel_builder;
+    build_clusters(parallel_builder, mesh, &executor);
+
+    executor.stop();
+
+    CHECK(serial_builder.get_positions() == parallel_builder.get_positions());
+    CHECK(serial_builder.get_indexes() == parallel_builder.get_indexes());
+
+    const auto& serial_clusters = serial_builder.get_clusters();
+    const auto& parallel_clusters = parallel_builder.get_clusters();
+    REQUIRE(serial_clusters.size() == parallel_clusters.size());
+    for (std::size_t i = 0; i < serial_clusters.size(); ++i)
+    {
+        CHECK(serial_clusters[i].index_offset == parallel_clusters[i].index_offset);
+        CHECK(serial_clusters[i].index_count == parallel_clusters[i].index_count);
+        CHECK(serial_clusters[i].lod_error == parallel_clusters[i].lod_error);
+        CHECK(serial_clusters[i].group_index == parallel_clusters[i].group_index);
+        CHECK(serial_clusters[i].child_group_index == parallel_clusters[i].child_group_index);
+    }
+
+    CHECK(serial_builder.get_cluster_nodes().size() == parallel_builder.get_cluster_nodes().size());
+}
+
+TEST_CASE("cluster builder benchmark", "[benchmark]")
+{
+    grid_mesh mesh = make_grid(256);
+
+    task_executor executor;
+    executor.run();
+
+    for (task_executor* current : {static_cast<task_executor*>(nullptr), &executor})
+    {
+        cluster_builder builder;
+
+        timer timer;
+        timer.start();
+        build_clusters(builder, mesh, current);
+        double seconds = timer.elapse();
+
+        std::cout << "cluster builder: " << mesh.indexes.size() / 3 << " triangles, "
+                  << (current == nullptr ? 1 : executor.get_thread_count()) << " threads, "
+                  << seconds * 1000.0 << "ms" << std::endl;
+    }
+
+    executor.stop();
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include "test_common.hpp"
+#include "tools/cluster_file.hpp"
+#include "tools/geometry_tool.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+namespace violet::test
+{
+namespace
+{
+geometry_tool::cluster_output build_grid_clusters(const grid_mesh& mesh)
+{
+    std::vector<vec3f> normals(mesh.positions.size(), vec3f{0.0f, 1.0f, 0.0f});
+
+    geometry_tool::cluster_input input = {
+        .positions = mesh.positions,
+        .normals = normals,
+        .indexes = mesh.indexes,
+        .submeshes = {{
+            .vertex_offset = 0,
+            .index_offset = 0,
+            .index_count = static_cast<std::uint32_t>(mesh.indexes.size()),
+        }},
+    };
+
+    return geometry_tool::generate_clusters(input);
+}
+
+// The order the file stores the clusters in, from the coarsest lod to the finest.
+std::vector<std::uint32_t> get_file_order(const std::vector<cluster>& clusters)
+{
+    std::vector<std::uint32_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(
+        order,
+        [&](std::uint32_t a, std::uint32_t b)
+        {
+            return clusters[a].lod > clusters[b].lod;
+        });
+
+    return order;
+}
+} // namespace
+
+TEST_CASE("cluster file roundtrip", "[cluster file]")
+{
+    grid_mesh mesh = make_grid(64);
+    geometry_tool::cluster_output built = build_grid_clusters(mesh);
+
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "test_cluster_file_roundtrip.clusters";
+    REQUIRE(built.save(path.string()));
+
+    geometry_tool::cluster_output loaded;
+    REQUIRE(loaded.load(path.string()));
+    std::filesystem::remove(path);
+
+    REQUIRE(loaded.submeshes.size() == 1);
+    CHECK(loaded.normals.size() == loaded.positions.size());
+    CHECK(loaded.tangents.empty());
+    CHECK(loaded.texcoords.empty());
+
+    const auto& built_clusters = built.submeshes[0].clusters;
+    const auto& loaded_clusters = loaded.submeshes[0].clusters;
+    REQUIRE(loaded_clusters.size() == built_clusters.size());
+
+    std::vector<std::uint32_t> order = get_file_order(built_clusters);
+    for (std::size_t i = 0; i < loaded_clusters.size(); ++i)
+    {
+        const auto& built_cluster = built_clusters[order[i]];
+        const auto& loaded_cluster = loaded_clusters[i];
+
+        CHECK(loaded_cluster.lod == built_cluster.lod);
+        CHECK(loaded_cluster.lod_error == built_cluster.lod_error);
+        REQUIRE(loaded_cluster.index_count == built_cluster.index_count);
+
+        // Vertices are stored per cluster, the triangles still reference the same positions.
+        bool same_triangles = true;
+        for (std::uint32_t j = 0; j < loaded_cluster.index_count; ++j)
+        {
+            std::uint32_t built_index = built.indexes[built_cluster.index_offset + j];
+            std::uint32_t loaded_index = loaded.indexes[loaded_cluster.index_offset + j];
+
+            same_triangles = same_triangles &&
+                             loaded.positions[loaded_index] == built.positions[built_index];
+        }
+        CHECK(same_triangles);
+    }
+
+    // Leaves reference the renumbered clusters of their group.
+    const auto& built_nodes = built.submeshes[0].cluster_nodes;
+    const auto& loaded_nodes = loaded.submeshes[0].cluster_nodes;
+    REQUIRE(loaded_nodes.size() == built_nodes.size());
+    for (std::size_t i = 0; i < loaded_nodes.size(); ++i)
+    {
+        if (!loaded_nodes[i].is_leaf)
+        {
+            CHECK(loaded_nodes[i].child_offset == built_nodes[i].child_offset);
+            continue;
+        }
+
+        REQUIRE(loaded_nodes[i].child_count == built_nodes[i].child_count);
+        for (std::uint32_t j = 0; j < loaded_nodes[i].child_count; ++j)
+        {
+            const auto& built_cluster = built_clusters[built_nodes[i].child_offset + j];
+            const auto& loaded_cluster = loaded_clusters[loaded_nodes[i].child_offset + j];
+            CHECK(loaded_cluster.lod_error == built_cluster.lod_error);
+        }
+    }
+}
+
+TEST_CASE("cluster file pages", "[cluster file]")
+{
+    grid_mesh mesh = make_grid(64);
+    geometry_tool::cluster_output built = build_grid_clusters(mesh);
+
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "test_cluster_file_pages.clusters";
+    REQUIRE(built.save(path.string()));
+
+    {
+        cluster_file file;
+        REQUIRE(file.open(path.string()));
+
+        REQUIRE(file.get_submeshes().size() == 1);
+        const auto& submesh = file.get_submeshes()[0];
+
+        auto levels = file.get_levels(submesh);
+        REQUIRE(!levels.empty());
+
+        std::uint32_t cluster_count = 0;
+        for (std::size_t i = 0; i < levels.size(); ++i)
+        {
+            // Coarse levels come first, so they can be loaded before the finer ones.
+            if (i != 0)
+            {
+                CHECK(levels[i].lod < levels[i - 1].lod);
+            }
+            CHECK(levels[i].cluster_offset == cluster_count);
+            cluster_count += levels[i].cluster_count;
+
+            for (const auto& page : file.get_pages(levels[i]))
+            {
+                CHECK(page.lod == levels[i].lod);
+                CHECK(page.offset % cluster_file::PAGE_SIZE == 0);
+                CHECK(page.size <= cluster_file::PAGE_SIZE);
+
+                CHECK(file.get_positions(page).size() == page.vertex_count);
+                CHECK(file.get_normals(page).size() == page.vertex_count);
+                CHECK(file.get_tangents(page).empty());
+
+                for (std::uint32_t index : file.get_indexes(page))
+                {
+                    CHECK(index >= page.vertex_offset);
+                    CHECK(index < page.vertex_offset + page.vertex_count);
+                }
+
+                for (const auto& cluster : file.get_clusters(page))
+                {
+                    CHECK(cluster.lod == page.lod);
+                    CHECK(cluster.index_offset >= page.index_offset);
+                    CHECK(
+                        cluster.index_offset + cluster.index_count <=
+                        page.index_offset + page.index_count);
+                }
+
+                file.prefetch(page);
+            }
+        }
+        CHECK(cluster_count == submesh.cluster_count);
+        CHECK(cluster_count == built.submeshes[0].clusters.size());
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("cluster file header", "[cluster file]")
+{
+    grid_mesh mesh = make_grid(16);
+    geometry_tool::cluster_output built = build_grid_clusters(mesh);
+
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "test_cluster_file_header.clusters";
+    REQUIRE(built.save(path.string()));
+
+    std::vector<std::byte> data(std::filesystem::file_size(path));
+    {
+        std::ifstream fin(path, std::ios::binary);
+        fin.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+    std::filesystem::remove(path);
+
+    cluster_file file;
+    CHECK(file.open(data));
+
+    std::vector<std::byte> bad_magic = data;
+    bad_magic[0] = std::byte{0};
+    CHECK(!file.open(bad_magic));
+
+    std::vector<std::byte> bad_version = data;
+    bad_version[4] = std::byte{0xff};
+    CHECK(!file.open(bad_version));
+
+    std::vector<std::byte> truncated(data.begin(), data.begin() + cluster_file::PAGE_SIZE);
+    CHECK(!file.open(truncated));
+
+    CHECK(!file.open(std::span<const std::byte>(data.data(), 16)));
+}
+
+TEST_CASE("cluster file in a stream", "[cluster file]")
+{
+    grid_mesh mesh = make_grid(16);
+    geometry_tool::cluster_output built = build_grid_clusters(mesh);
+
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "test_cluster_file_stream.clusters";
+    {
+        std::ofstream fout(path, std::ios::binary);
+        REQUIRE(built.save(fout));
+        fout << "trailer";
+    }
+    std::uint64_t file_size = std::filesystem::file_size(path) - 7;
+
+    // Reading stops at the end of the cluster file, the data after it is left in the stream.
+    {
+        std::ifstream fin(path, std::ios::binary);
+        geometry_tool::cluster_output loaded;
+        REQUIRE(loaded.load(fin));
+        CHECK(static_cast<std::uint64_t>(fin.tellg()) == file_size);
+        CHECK(loaded.indexes.size() == built.indexes.size());
+
+        std::string trailer;
+        fin >> trailer;
+        CHECK(trailer == "trailer");
+    }
+
+    std::ifstream fin(path, std::ios::binary);
+    cluster_file file;
+    REQUIRE(file.open(fin));
+    fin.close();
+    std::filesystem::remove(path);
+
+    for (const auto& page : file.get_pages())
+    {
+        cluster_file::page_data data = file.get_page_data(page);
+        CHECK(data.clusters.data() == file.get_clusters(page).data());
+        CHECK(data.clusters.size() == page.cluster_count);
+        CHECK(data.positions.data() == file.get_positions(page).data());
+        CHECK(data.normals.data() == file.get_normals(page).data());
+        CHECK(data.normals.size() == page.vertex_count);
+        CHECK(data.tangents.empty());
+        CHECK(data.texcoords.empty());
+        CHECK(data.indexes.data() == file.get_indexes(page).data());
+        CHECK(data.indexes.size() == page.index_count);
+    }
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "task/task_executor.hpp"
+#include "test_common.hpp"
+#include "tools/geometry_tool.hpp"
+#include <cmath>
+#include <filesystem>
+#include <set>
+
+namespace violet::test
+{
+namespace
+{
+using stream_vertex = geometry_tool::cluster_stream_input::vertex;
+
+geometry_tool::cluster_stream_input make_stream_input(const grid_mesh& mesh)
+{
+    geometry_tool::cluster_stream_input input = {};
+    input.read = [&mesh, offset = std::size_t{0}](std::span<stream_vertex> vertices) mutable
+    {
+        std::size_t count = std::min(vertices.size(), mesh.indexes.size() - offset);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            vertices[i] = {.position = mesh.positions[mesh.indexes[offset + i]]};
+        }
+        offset += count;
+
+        return count;
+    };
+
+    return input;
+}
+
+// The signed area of the cut projected onto the grid plane. A missing or duplicated cluster changes
+// it by far more than rounding does.
+double get_cut_area(const geometry_tool::cluster_output& output, float error)
+{
+    double area = 0.0;
+    for (const auto& cluster : output.submeshes[0].clusters)
+    {
+        if (cluster.lod_error > error || cluster.parent_lod_error <= error)
+        {
+            continue;
+        }
+
+        for (std::uint32_t i = 0; i < cluster.index_count; i += 3)
+        {
+            vec3f a = output.positions[output.indexes[cluster.index_offset + i + 0]];
+            vec3f b = output.positions[output.indexes[cluster.index_offset + i + 1]];
+            vec3f c = output.positions[output.indexes[cluster.index_offset + i + 2]];
+
+            area += 0.5 * (static_cast<double>(b.x - a.x) * (c.z - a.z) -
+                           static_cast<double>(b.z - a.z) * (c.x - a.x));
+        }
+    }
+
+    return std::abs(area);
+}
+} // namespace
+
+TEST_CASE("cluster streamer", "[cluster streamer]")
+{
+    const std::uint32_t size = 128;
+    grid_mesh mesh = make_grid(size);
+
+    task_executor executor;
+    executor.run(4);
+
+    // Small enough to split the grid into several bricks that are merged twice.
+    auto input = make_stream_input(mesh);
+    input.memory_budget = std::size_t{2048} * 1024;
+    input.executor = &executor;
+
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "test_cluster_streamer.clusters";
+    REQUIRE(geometry_tool::generate_clusters(input, path.string()));
+
+    executor.stop();
+
+    geometry_tool::cluster_output output;
+    REQUIRE(output.load(path.string()));
+    std::filesystem::remove(path);
+
+    REQUIRE(output.submeshes.size() == 1);
+    const auto& clusters = output.submeshes[0].clusters;
+    const auto& cluster_nodes = output.submeshes[0].cluster_nodes;
+
+    std::uint32_t root_count = 0;
+    std::set<float> errors = {0.0f};
+    for (const auto& cluster : clusters)
+    {
+        CHECK(cluster.index_count / 3 <= 128);
+        CHECK(cluster.index_offset + cluster.index_count <= output.indexes.size());
+        CHECK(cluster.lod_error <= cluster.parent_lod_error);
+
+        root_count += std::isinf(cluster.parent_lod_error) ? 1 : 0;
+        errors.insert(cluster.lod_error);
+    }
+    CHECK(root_count == 1);
+
+    for (std::uint32_t index : output.indexes)
+    {
+        CHECK(index < output.positions.size());
+    }
+
+    // Every cut of the DAG covers the grid once, across the borders of the bricks too.
+    for (float error : errors)
+    {
+        CHECK(std::abs(get_cut_area(output, error) - (size * size)) < 1.0);
+    }
+
+    REQUIRE(!cluster_nodes.empty());
+    for (const auto& cluster_node : cluster_nodes)
+    {
+        if (cluster_node.is_leaf)
+        {
+            CHECK(cluster_node.child_offset + cluster_node.child_count <= clusters.size());
+        }
+        else
+        {
+            CHECK(cluster_node.child_offset + cluster_node.child_count <= cluster_nodes.size());
+        }
+    }
+}
+
+TEST_CASE("cluster streamer single brick", "[cluster streamer]")
+{
+    grid_mesh mesh = make_grid(64);
+
+    // A mesh within the budget is a single brick, built as generate_clusters would build it.
+    auto input = make_stream_input(mesh);
+
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "test_cluster_streamer_single.clusters";
+    REQUIRE(geometry_tool::generate_clusters(input, path.string()));
+
+    geometry_tool::cluster_output streamed;
+    REQUIRE(streamed.load(path.string()));
+    std::filesystem::remove(path);
+
+    geometry_tool::cluster_input memory_input = {
+        .positions = mesh.positions,
+        .indexes = mesh.indexes,
+        .submeshes = {{
+            .vertex_offset = 0,
+            .index_offset = 0,
+            .index_count = static_cast<std::uint32_t>(mesh.indexes.size()),
+        }},
+    };
+    auto built = geometry_tool::generate_clusters(memory_input);
+
+    // Saving orders the clusters as the streamed file does.
+    REQUIRE(built.save(path.string()));
+    REQUIRE(built.load(path.string()));
+    std::filesystem::remove(path);
+
+    const auto& streamed_clusters = streamed.submeshes[0].clusters;
+    const auto& built_clusters = built.submeshes[0].clusters;
+    REQUIRE(streamed_clusters.size() == built_clusters.size());
+    for (std::size_t i = 0; i < streamed_clusters.size(); ++i)
+    {
+        CHECK(streamed_clusters[i].index_count == built_clusters[i].index_count);
+        CHECK(streamed_clusters[i].lod_error == built_clusters[i].lod_error);
+        CHECK(streamed_clusters[i].lod == built_clusters[i].lod);
+    }
+
+    CHECK(streamed.submeshes[0].cluster_nodes.size() == built.submeshes[0].cluster_nodes.size());
+}
+} // namespace violet::test
\ No newline at end of file
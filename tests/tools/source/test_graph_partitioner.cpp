@@ -0,0 +1,155 @@
+#include "cluster/graph_partitioner.hpp"
+#include "test_common.hpp"
+#include <iostream>
+
+namespace violet::test
+{
+namespace
+{
+struct grid_graph
+{
+    std::vector<std::uint32_t> adjacency;
+    std::vector<std::uint32_t> adjacency_cost;
+    std::vector<std::uint32_t> adjacency_offset;
+};
+
+grid_graph make_grid_graph(std::uint32_t size)
+{
+    grid_graph graph;
+
+    for (std::uint32_t y = 0; y < size; ++y)
+    {
+        for (std::uint32_t x = 0; x < size; ++x)
+        {
+            graph.adjacency_offset.push_back(static_cast<std::uint32_t>(graph.adjacency.size()));
+
+            auto add_edge = [&](std::uint32_t adjacency_x, std::uint32_t adjacency_y)
+            {
+                graph.adjacency.push_back((adjacency_y * size) + adjacency_x);
+                graph.adjacency_cost.push_back(1 + ((x + y) % 3));
+            };
+
+            if (x > 0)
+            {
+                add_edge(x - 1, y);
+            }
+            if (x + 1 < size)
+            {
+                add_edge(x + 1, y);
+            }
+            if (y > 0)
+            {
+                add_edge(x, y - 1);
+            }
+            if (y + 1 < size)
+            {
+                add_edge(x, y + 1);
+            }
+        }
+    }
+    graph.adjacency_offset.push_back(static_cast<std::uint32_t>(graph.adjacency.size()));
+
+    return graph;
+}
+
+void check_partition(const graph_partitioner& partitioner, std::uint32_t vertex_count)
+{
+    std::vector<std::uint32_t> vertices = partitioner.get_vertices();
+    std::ranges::sort(vertices);
+    for (std::uint32_t i = 0; i < vertex_count; ++i)
+    {
+        REQUIRE(vertices[i] == i);
+    }
+
+    std::uint32_t offset = 0;
+    for (auto [begin, end] : partitioner.get_parts())
+    {
+        CHECK(begin == offset);
+        CHECK(end > begin);
+        CHECK(end - begin <= 128);
+        offset = end;
+    }
+    CHECK(offset == vertex_count);
+}
+} // namespace
+
+TEST_CASE("graph partitioner", "[graph partitioner]")
+{
+    SECTION("small graph")
+    {
+        // Bisected without METIS.
+        grid_graph graph = make_grid_graph(15);
+
+        graph_partitioner partitioner;
+        partitioner.partition(
+            graph.adjacency,
+            graph.adjacency_cost,
+            graph.adjacency_offset,
+            124,
+            128);
+
+        check_partition(partitioner, 15 * 15);
+    }
+
+    SECTION("parallel")
+    {
+        grid_graph graph = make_grid_graph(100);
+
+        graph_partitioner serial_partitioner;
+        serial_partitioner.partition(
+            graph.adjacency,
+            graph.adjacency_cost,
+            graph.adjacency_offset,
+            124,
+            128);
+        check_partition(serial_partitioner, 100 * 100);
+
+        task_executor executor;
+        executor.run(4);
+
+        graph_partitioner parallel_partitioner;
+        parallel_partitioner.set_executor(&executor);
+        parallel_partitioner.partition(
+            graph.adjacency,
+            graph.adjacency_cost,
+            graph.adjacency_offset,
+            124,
+            128);
+
+        executor.stop();
+
+        CHECK(serial_partitioner.get_vertices() == parallel_partitioner.get_vertices());
+        CHECK(serial_partitioner.get_parts() == parallel_partitioner.get_parts());
+    }
+}
+
+TEST_CASE("graph partitioner benchmark", "[benchmark]")
+{
+    grid_graph graph = make_grid_graph(512);
+
+    task_executor executor;
+    executor.run();
+
+    for (task_executor* current : {static_cast<task_executor*>(nullptr), &executor})
+    {
+        graph_partitioner partitioner;
+        partitioner.set_executor(current);
+
+        timer timer;
+        timer.start();
+        partitioner.partition(
+            graph.adjacency,
+            graph.adjacency_cost,
+            graph.adjacency_offset,
+            124,
+            128);
+        double seconds = timer.elapse();
+
+        std::cout << "graph partitioner: " << graph.adjacency_offset.size() - 1 << " vertices, "
+                  << (current == nullptr ? 1 : executor.get_thread_count()) << " threads, "
+                  << seconds * 1000.0 << "ms" << std::endl;
+    }
+
+    executor.stop();
+}
+} // namespace violet::test
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "mesh_simplifier/mesh_simplifier.hpp"
+#include "test_common.hpp"
+#include <iostream>
+#include <random>
+
+namespace violet::test
+{
+TEST_CASE("collapse heap", "[mesh simplifier]")
+{
+    constexpr std::uint32_t edge_count = 1000;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> error(0.0f, 100.0f);
+
+    collapse_heap heap;
+    std::vector<float> errors(edge_count);
+    std::vector<bool> contained(edge_count, true);
+
+    for (std::uint32_t edge = 0; edge < edge_count; ++edge)
+    {
+        errors[edge] = error(random);
+        heap.push({.edge = edge, .error = errors[edge]});
+    }
+
+    for (std::uint32_t i = 0; i < edge_count; ++i)
+    {
+        std::uint32_t edge = random() % edge_count;
+        if (i % 4 == 0)
+        {
+            CHECK(heap.erase(edge) == contained[edge]);
+            contained[edge] = false;
+        }
+        else
+        {
+            errors[edge] = error(random);
+            CHECK(heap.update(edge, errors[edge]) == contained[edge]);
+        }
+    }
+
+    std::vector<float> expected;
+    for (std::uint32_t edge = 0; edge < edge_count; ++edge)
+    {
+        if (contained[edge])
+        {
+            expected.push_back(errors[edge]);
+        }
+    }
+    std::ranges::sort(expected);
+
+    REQUIRE(heap.size() == expected.size());
+    for (float expected_error : expected)
+    {
+        CHECK(errors[heap.top().edge] == expected_error);
+        CHECK(heap.top().error == expected_error);
+        heap.pop();
+    }
+    CHECK(heap.empty());
+}
+
+TEST_CASE("mesh simplifier", "[mesh simplifier]")
+{
+    grid_mesh mesh = make_grid(32);
+
+    mesh_simplifier simplifier;
+    simplifier.set_positions(mesh.positions);
+    simplifier.set_indexes(mesh.indexes);
+
+    std::uint32_t target_triangle_count = static_cast<std::uint32_t>(mesh.indexes.size() / 3 / 4);
+    simplifier.simplify(target_triangle_count);
+
+    CHECK(simplifier.get_index_count() / 3 <= target_triangle_count);
+    CHECK(simplifier.get_index_count() > 0);
+}
+
+TEST_CASE("mesh simplifier benchmark", "[benchmark]")
+{
+    for (std::uint32_t size : {256, 1024})
+    {
+        grid_mesh mesh = make_grid(size);
+        std::size_t triangle_count = mesh.indexes.size() / 3;
+
+        mesh_simplifier simplifier;
+        simplifier.set_positions(mesh.positions);
+        simplifier.set_indexes(mesh.indexes);
+
+        timer timer;
+        timer.start();
+        simplifier.simplify(static_cast<std::uint32_t>(triangle_count / 8));
+        double seconds = timer.elapse();
+
+        std::cout << "mesh simplifier: " << triangle_count << " triangles, " << seconds * 1000.0
+                  << "ms, " << seconds * 1e9 / static_cast<double>(triangle_count)
+                  << "ns/triangle" << std::endl;
+    }
+}
+} // namespace violet::test
\ No newline at end of file